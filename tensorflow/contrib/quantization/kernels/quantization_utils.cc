@@ -15,8 +15,82 @@ limitations under the License.
 
 #include "tensorflow/contrib/quantization/kernels/quantization_utils.h"
 
+#include <cmath>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 namespace tensorflow {
 
+namespace {
+
+// Bounds applied to the scaled value before it is rounded to an integer, so
+// that the conversion never overflows and values far outside the output range
+// still saturate in the right direction.
+const float kLowestScaledValue = -1.0e9f;
+const float kHighestScaledValue = 1.0e9f;
+
+}  // namespace
+
+Int32ToUint8RequantizeParams::Int32ToUint8RequantizeParams(float min_input,
+                                                           float max_input,
+                                                           float min_output,
+                                                           float max_output) {
+  // A qint32 value v represents
+  //   min_input + (v - lowest) * input_range / (2^32 - 1),
+  // and a float f is stored in quint8 as
+  //   round(f * 255 / output_range) - round(min_output * 255 / output_range),
+  // so the whole conversion folds into round(v * scale + offset).
+  const double input_steps = 4294967295.0;
+  const double output_range = max_output - min_output;
+  const double output_scale = output_range == 0.0 ? 0.0 : 255.0 / output_range;
+  const double input_scale = (max_input - min_input) / input_steps;
+  const double input_zero = min_input + 2147483648.0 * input_scale;
+  scale = static_cast<float>(input_scale * output_scale);
+  offset = static_cast<float>(input_zero * output_scale -
+                              std::round(min_output * output_scale));
+}
+
+void RequantizeInt32ToUint8(const Int32ToUint8RequantizeParams& params,
+                            const qint32* input, int64 count, quint8* output) {
+  const int32* input_data = &(input->value);
+  uint8* output_data = &(output->value);
+  int64 index = 0;
+#ifdef __AVX2__
+  const __m256 scale = _mm256_set1_ps(params.scale);
+  const __m256 offset = _mm256_set1_ps(params.offset);
+  const __m256 lowest = _mm256_set1_ps(kLowestScaledValue);
+  const __m256 highest = _mm256_set1_ps(kHighestScaledValue);
+  // The 32 to 8 bit packing instructions work within 128-bit lanes, so the
+  // packed result has to be permuted back into order.
+  const __m256i lane_order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  auto requantize8 = [&](const int32* source) {
+    const __m256 values = _mm256_cvtepi32_ps(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source)));
+    __m256 scaled = _mm256_add_ps(_mm256_mul_ps(values, scale), offset);
+    scaled = _mm256_min_ps(_mm256_max_ps(scaled, lowest), highest);
+    return _mm256_cvtps_epi32(scaled);
+  };
+  for (; index + 32 <= count; index += 32) {
+    const __m256i a = requantize8(input_data + index);
+    const __m256i b = requantize8(input_data + index + 8);
+    const __m256i c = requantize8(input_data + index + 16);
+    const __m256i d = requantize8(input_data + index + 24);
+    const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(a, b),
+                                               _mm256_packs_epi32(c, d));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output_data + index),
+                        _mm256_permutevar8x32_epi32(packed, lane_order));
+  }
+#endif
+  for (; index < count; ++index) {
+    float scaled = input_data[index] * params.scale + params.offset;
+    scaled = std::min(std::max(scaled, kLowestScaledValue), kHighestScaledValue);
+    const int32 rounded = static_cast<int32>(std::nearbyint(scaled));
+    output_data[index] = static_cast<uint8>(std::min(std::max(rounded, 0), 255));
+  }
+}
+
 void GetOutputMinAndMaxForQuantizedAdd(float input_min, float input_max,
                                        float smaller_input_min,
                                        float smaller_input_max,
@@ -26,8 +26,10 @@ limitations under the License.
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "public/gemmlowp.h"
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -248,6 +250,24 @@ inline void RequantizeManyInNewRange<qint32, quint8>(
   }
 }
 
+// Precomputed constants for requantizing qint32 values in the range
+// [min_input, max_input] into quint8 values in [min_output, max_output]. Each
+// value is converted with a single float multiply-add followed by a rounding,
+// saturating conversion, which maps directly onto SIMD instructions.
+struct Int32ToUint8RequantizeParams {
+  Int32ToUint8RequantizeParams(float min_input, float max_input,
+                               float min_output, float max_output);
+
+  float scale;
+  float offset;
+};
+
+// Requantizes "count" values from "input" into "output". Uses AVX2 when it is
+// available at compile time. The results match
+// RequantizeManyInNewRange<qint32, quint8>() to within one quantized level.
+void RequantizeInt32ToUint8(const Int32ToUint8RequantizeParams& params,
+                            const qint32* input, int64 count, quint8* output);
+
 template <int shift>
 struct int64_right_shift_op {
   EIGEN_EMPTY_STRUCT_CTOR(int64_right_shift_op)
@@ -550,6 +570,55 @@ class TensorflowGemmContext : public gemmlowp::MultiThreadGemmContextBase {
   TF_DISALLOW_COPY_AND_ASSIGN(TensorflowGemmContext);
 };
 
+// Multiplies the m x k matrix "a" by the k x n matrix "b", both stored with the
+// given gemmlowp orders, and writes the result requantized to eight bits into
+// the row major m x n matrix "output". Rather than materializing the full
+// 32-bit result, blocks of output rows are sharded across the worker threads
+// and each block is accumulated into a scratch buffer that stays in cache
+// before being requantized.
+template <gemmlowp::MapOrder LhsOrder, gemmlowp::MapOrder RhsOrder>
+void GemmlowpMultiplyAndRequantize(
+    const DeviceBase::CpuWorkerThreads& worker_threads, const quint8* a_data,
+    const quint8* b_data, int m, int n, int k, int offset_a, int offset_b,
+    int lda, int ldb, const Int32ToUint8RequantizeParams& params,
+    quint8* output_data) {
+  // Aim for about 256KB of 32-bit accumulators per block.
+  const int rows_per_block = std::max(1, (64 * 1024) / std::max(1, n));
+  const int block_count = (m + rows_per_block - 1) / rows_per_block;
+  const uint8* a_data_as_uint8 = &(a_data->value);
+  const uint8* b_data_as_uint8 = &(b_data->value);
+  auto compute_blocks = [&](int64 start_block, int64 end_block) {
+    std::vector<std::int32_t> accumulators(rows_per_block * n);
+    // Parallelism comes from sharding the blocks, so each gemmlowp call runs
+    // on the calling thread.
+    TensorflowGemmContext context(1, worker_threads.workers);
+    const std::tuple<> empty_pipeline = {};
+    for (int64 block = start_block; block < end_block; ++block) {
+      const int row_start = block * rows_per_block;
+      const int rows = std::min(rows_per_block, m - row_start);
+      const uint8* a_block =
+          a_data_as_uint8 +
+          (LhsOrder == gemmlowp::MapOrder::RowMajor ? row_start * lda
+                                                    : row_start);
+      gemmlowp::MatrixMap<const std::uint8_t, LhsOrder> lhs(a_block, rows, k,
+                                                            lda);
+      gemmlowp::MatrixMap<const std::uint8_t, RhsOrder> rhs(b_data_as_uint8, k,
+                                                            n, ldb);
+      gemmlowp::MatrixMap<std::int32_t, gemmlowp::MapOrder::RowMajor> result(
+          accumulators.data(), rows, n, n);
+      gemmlowp::GemmWithOutputPipeline<std::uint8_t, std::int32_t,
+                                       gemmlowp::DefaultL8R8BitDepthParams>(
+          &context, lhs, rhs, &result, -offset_a, -offset_b, empty_pipeline);
+      RequantizeInt32ToUint8(
+          params, reinterpret_cast<const qint32*>(accumulators.data()),
+          rows * n, output_data + static_cast<int64>(row_start) * n);
+    }
+  };
+  const int64 cost_per_block = static_cast<int64>(rows_per_block) * n * k;
+  Shard(worker_threads.num_threads, worker_threads.workers, block_count,
+        cost_per_block, compute_blocks);
+}
+
 }  // namespace tensorflow
 
 #endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_QUANTIZATION_KERNELS_QUANTIZATION_UTILS_H_
@@ -466,6 +466,45 @@ TEST_F(QuantizationUtilsTest,
   TestRequantizeManyInNewRangeEigenVsNonEigen<qint32, qint8>();
 }
 
+TEST_F(QuantizationUtilsTest, RequantizeInt32ToUint8) {
+  // Use enough values to exercise both the vectorized loop and the tail.
+  const int values_count = 1000;
+  random::PhiloxRandom philox(testing::RandomSeed(), 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<qint32> values(values_count);
+  for (int i = 0; i < values_count; ++i) {
+    values[i] = static_cast<int32>(rnd.Rand32());
+  }
+  values[0] = std::numeric_limits<int32>::lowest();
+  values[1] = std::numeric_limits<int32>::max();
+  values[2] = 0;
+
+  const std::vector<std::pair<float, float>> ranges = {
+      {-1.0f, 1.0f}, {-255.0f, 255.0f}, {0.0f, 1.0f}, {-0.5f, 3.0f}};
+  for (const auto& input_range : ranges) {
+    for (const auto& output_range : ranges) {
+      const float input_min = input_range.first * 1000.0f;
+      const float input_max = input_range.second * 1000.0f;
+      const Int32ToUint8RequantizeParams params(
+          input_min, input_max, output_range.first, output_range.second);
+      std::vector<quint8> output(values_count);
+      RequantizeInt32ToUint8(params, values.data(), values_count,
+                             output.data());
+      for (int i = 0; i < values_count; ++i) {
+        const int expected = FloatToQuantized<quint8>(
+            QuantizedToFloat(values[i], input_min, input_max),
+            output_range.first, output_range.second);
+        const int actual = output[i];
+        ASSERT_LE(std::abs(expected - actual), 1)
+            << "value=" << values[i] << ", input_min=" << input_min
+            << ", input_max=" << input_max
+            << ", output_min=" << output_range.first
+            << ", output_max=" << output_range.second;
+      }
+    }
+  }
+}
+
 TEST_F(QuantizationUtilsTest, FloatTensorToQuantized) {
   const int input_width = 3;
   const int input_height = 3;
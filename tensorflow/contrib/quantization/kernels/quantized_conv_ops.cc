@@ -178,6 +178,109 @@ class ReferenceConvFunctor {
   }
 };
 
+// Packs the patches of the input image into the rows of "im2col_buffer", which
+// must have room for (input_batches * output_height * output_width) patches of
+// (filter_height * filter_width * input_depth) values. Samples from outside
+// the image are set to "input_offset", the quantized value of zero.
+template <class T1>
+void Im2Col(const T1* input_data, int input_batches, int input_height,
+            int input_width, int input_depth, int input_offset,
+            int filter_height, int filter_width, int stride, Padding padding,
+            int output_height, int output_width, T1* im2col_buffer) {
+  CHECK_GT(output_width, 0);
+  CHECK_GT(output_height, 0);
+  int filter_left_offset;
+  int filter_top_offset;
+  if (padding == VALID) {
+    filter_left_offset =
+        ((output_width - 1) * stride + filter_width - input_width) / 2;
+    filter_top_offset =
+        ((output_height - 1) * stride + filter_height - input_height) / 2;
+  } else {
+    filter_left_offset =
+        ((output_width - 1) * stride + filter_width - input_width) / 2;
+    filter_top_offset =
+        ((output_height - 1) * stride + filter_height - input_height) / 2;
+  }
+
+  const int filter_value_count = filter_width * filter_height * input_depth;
+  for (int batch = 0; batch < input_batches; ++batch) {
+    const T1* input_batch_start =
+        input_data + (batch * input_height * input_width * input_depth);
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y_origin = (out_y * stride) - filter_top_offset;
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin = (out_x * stride) - filter_left_offset;
+        const int patch_index = (batch * output_width * output_height) +
+                                (out_y * output_width) + out_x;
+        T1* im2col_patch_start =
+            im2col_buffer + (patch_index * filter_value_count);
+        for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+          const int in_y = in_y_origin + filter_y;
+          T1* im2col_row_start =
+              im2col_patch_start + (filter_y * filter_width * input_depth);
+          // If we're off the top or the bottom of the input, fill the whole
+          // row with zeroes.
+          if ((in_y < 0) || (in_y >= input_height)) {
+            T1* im2col_row_end = im2col_row_start + (filter_width * input_depth);
+            // We'll be subtracting this offset during the calculations
+            // so to get an actual zero after that bias we need to set
+            // it to input_offset here.
+            std::fill(im2col_row_start, im2col_row_end, input_offset);
+          } else {
+            // What we're doing here is trying to copy and fill the im2col
+            // buffer as efficiently as possible, using functions to set or
+            // duplicate values en masse. We know we don't have to worry about
+            // vertical edges because we dealt with that case above, so we
+            // just need to handle filters that overlap the left or right
+            // edges. Here's what that looks like:
+            //
+            // < left_zero_count > < center_copy_count > < right_zero_count >
+            // +------------------+---------------------+--------------------+
+            // |     (filter)     |       (image)       |      (filter)      |
+            // +------------------+---------------------+--------------------+
+            // in_x_origin        0                 input_width       in_x_end
+            //
+            // In reality it's unlikely that a filter patch will be wider
+            // than an input, but this shows all the edge cases.
+            // We use std::fill() to set the left and right sections to zeroes
+            // and std::copy() to copy over the input data for the center.
+            const int in_x_end = in_x_origin + filter_width;
+            const int left_zero_count = std::max(0, 0 - in_x_origin);
+            const int right_zero_count = std::max(0, in_x_end - input_width);
+            const int center_copy_count =
+                filter_width - (left_zero_count + right_zero_count);
+            if (left_zero_count > 0) {
+              T1* im2col_left_start = im2col_row_start;
+              T1* im2col_left_end =
+                  im2col_left_start + (left_zero_count * input_depth);
+              std::fill(im2col_left_start, im2col_left_end, input_offset);
+            }
+            if (center_copy_count > 0) {
+              const T1* input_row_start =
+                  input_batch_start + (in_y * input_width * input_depth) +
+                  (std::max(0, in_x_origin) * input_depth);
+              const T1* input_row_end =
+                  input_row_start + (center_copy_count * input_depth);
+              T1* im2col_center_start =
+                  im2col_row_start + (left_zero_count * input_depth);
+              std::copy(input_row_start, input_row_end, im2col_center_start);
+            }
+            if (right_zero_count > 0) {
+              T1* im2col_right_start =
+                  im2col_row_start +
+                  ((left_zero_count + center_copy_count) * input_depth);
+              T1* im2col_right_end =
+                  im2col_right_start + (right_zero_count * input_depth);
+              std::fill(im2col_right_start, im2col_right_end, input_offset);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
 // Implements convolution as a two stage process, first packing the patches of
 // the input image into columns (im2col) and then running GEMM to produce the
 // final result.
@@ -214,22 +317,6 @@ class Im2ColConvFunctor {
       return;
     }
 
-    CHECK_GT(output_width, 0);
-    CHECK_GT(output_height, 0);
-    int filter_left_offset;
-    int filter_top_offset;
-    if (padding == VALID) {
-      filter_left_offset =
-          ((output_width - 1) * stride + filter_width - input_width) / 2;
-      filter_top_offset =
-          ((output_height - 1) * stride + filter_height - input_height) / 2;
-    } else {
-      filter_left_offset =
-          ((output_width - 1) * stride + filter_width - input_width) / 2;
-      filter_top_offset =
-          ((output_height - 1) * stride + filter_height - input_height) / 2;
-    }
-
     // The im2col buffer has # of patches rows, and # of filters cols.
     // It's laid out like this, in row major order in memory:
     //        < filter value count >
@@ -248,82 +335,9 @@ class Im2ColConvFunctor {
     // optimize this by keeping the scratch buffer around?
     std::unique_ptr<T1[]> im2col_buffer(new T1[im2col_size]);
 
-    for (int batch = 0; batch < input_batches; ++batch) {
-      const T1* input_batch_start =
-          input_data + (batch * input_height * input_width * input_depth);
-      for (int out_y = 0; out_y < output_height; ++out_y) {
-        const int in_y_origin = (out_y * stride) - filter_top_offset;
-        for (int out_x = 0; out_x < output_width; ++out_x) {
-          const int in_x_origin = (out_x * stride) - filter_left_offset;
-          const int patch_index = (batch * output_width * output_height) +
-                                  (out_y * output_width) + out_x;
-          T1* im2col_patch_start =
-              im2col_buffer.get() + (patch_index * filter_value_count);
-          for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
-            const int in_y = in_y_origin + filter_y;
-            T1* im2col_row_start =
-                im2col_patch_start + (filter_y * filter_width * input_depth);
-            // If we're off the top or the bottom of the input, fill the whole
-            // row with zeroes.
-            if ((in_y < 0) || (in_y >= input_height)) {
-              T1* im2col_row_end =
-                  im2col_row_start + (filter_width * input_depth);
-              // We'll be subtracting this offset during the calculations
-              // so to get an actual zero after that bias we need to set
-              // it to input_offset here.
-              std::fill(im2col_row_start, im2col_row_end, input_offset);
-            } else {
-              // What we're doing here is trying to copy and fill the im2col
-              // buffer as efficiently as possible, using functions to set or
-              // duplicate values en masse. We know we don't have to worry about
-              // vertical edges because we dealt with that case above, so we
-              // just need to handle filters that overlap the left or right
-              // edges. Here's what that looks like:
-              //
-              // < left_zero_count > < center_copy_count > < right_zero_count >
-              // +------------------+---------------------+--------------------+
-              // |     (filter)     |       (image)       |      (filter)      |
-              // +------------------+---------------------+--------------------+
-              // in_x_origin        0                 input_width       in_x_end
-              //
-              // In reality it's unlikely that a filter patch will be wider
-              // than an input, but this shows all the edge cases.
-              // We use std::fill() to set the left and right sections to zeroes
-              // and std::copy() to copy over the input data for the center.
-              const int in_x_end = in_x_origin + filter_width;
-              const int left_zero_count = std::max(0, 0 - in_x_origin);
-              const int right_zero_count = std::max(0, in_x_end - input_width);
-              const int center_copy_count =
-                  filter_width - (left_zero_count + right_zero_count);
-              if (left_zero_count > 0) {
-                T1* im2col_left_start = im2col_row_start;
-                T1* im2col_left_end =
-                    im2col_left_start + (left_zero_count * input_depth);
-                std::fill(im2col_left_start, im2col_left_end, input_offset);
-              }
-              if (center_copy_count > 0) {
-                const T1* input_row_start =
-                    input_batch_start + (in_y * input_width * input_depth) +
-                    (std::max(0, in_x_origin) * input_depth);
-                const T1* input_row_end =
-                    input_row_start + (center_copy_count * input_depth);
-                T1* im2col_center_start =
-                    im2col_row_start + (left_zero_count * input_depth);
-                std::copy(input_row_start, input_row_end, im2col_center_start);
-              }
-              if (right_zero_count > 0) {
-                T1* im2col_right_start =
-                    im2col_row_start +
-                    ((left_zero_count + center_copy_count) * input_depth);
-                T1* im2col_right_end =
-                    im2col_right_start + (right_zero_count * input_depth);
-                std::fill(im2col_right_start, im2col_right_end, input_offset);
-              }
-            }
-          }
-        }
-      }
-    }
+    Im2Col(input_data, input_batches, input_height, input_width, input_depth,
+           input_offset, filter_height, filter_width, stride, padding,
+           output_height, output_width, im2col_buffer.get());
 
     CHECK_GT(patch_count, 0);
     CHECK_GT(filter_count, 0);
@@ -406,6 +420,9 @@ class QuantizedConv2DOp : public OpKernel {
         errors::InvalidArgument("Current implementation does not yet support "
                                 "strides in the batch and depth dimensions."));
     OP_REQUIRES_OK(context, context->GetAttr("padding", &padding_));
+    // QuantizedConv2DAndRequantize shares this kernel and has two extra inputs
+    // giving the range of its eight bit output.
+    requantize_ = (context->num_inputs() == 8);
   }
 
   void Compute(OpKernelContext* context) override {
@@ -484,21 +501,70 @@ class QuantizedConv2DOp : public OpKernel {
     Tensor* output = nullptr;
     OP_REQUIRES_OK(context, context->allocate_output(0, out_shape, &output));
 
-    // This will call different implementations (e.g. reference or optimized)
-    // depending on the template parameter.
-    ConvFunctor<T1, T2, T3> conv_functor;
-    conv_functor(context, input.flat<T1>().data(), batch, input_rows,
-                 input_cols, in_depth, offset_input, filter.flat<T2>().data(),
-                 filter_rows, filter_cols, out_depth, offset_filter, stride,
-                 padding_, output->flat<T3>().data(), out_rows, out_cols,
-                 shift_output, offset_output, mult_output);
-
     float min_output_value;
     float max_output_value;
     QuantizationRangeForMultiplication<T1, T2, T3>(
         min_input, max_input, min_filter, max_filter, &min_output_value,
         &max_output_value);
 
+    if (requantize_) {
+      const float requested_output_min = context->input(6).flat<float>()(0);
+      const float requested_output_max = context->input(7).flat<float>()(0);
+      OP_REQUIRES(context, (requested_output_max > requested_output_min),
+                  errors::InvalidArgument("requested_output_max must be larger "
+                                          "than requested_output_min."));
+      const Int32ToUint8RequantizeParams params(
+          min_output_value, max_output_value, requested_output_min,
+          requested_output_max);
+      if (offset_input >= 0) {
+        // Pack the patches and requantize the GEMM output a block of rows at
+        // a time, so the 32-bit result is never written out in full.
+        const int filter_value_count = filter_rows * filter_cols * in_depth;
+        const int patch_count = batch * out_rows * out_cols;
+        std::unique_ptr<T1[]> im2col_buffer(
+            new T1[patch_count * filter_value_count]);
+        Im2Col(input.flat<T1>().data(), batch, input_rows, input_cols,
+               in_depth, offset_input, filter_rows, filter_cols, stride,
+               padding_, out_rows, out_cols, im2col_buffer.get());
+        GemmlowpMultiplyAndRequantize<gemmlowp::MapOrder::RowMajor,
+                                      gemmlowp::MapOrder::RowMajor>(
+            *(context->device()->tensorflow_cpu_worker_threads()),
+            im2col_buffer.get(), filter.flat<T2>().data(), patch_count,
+            out_depth, filter_value_count, offset_input, offset_filter,
+            filter_value_count, out_depth, params,
+            output->flat<quint8>().data());
+      } else {
+        // The im2col path can't pad the borders when zero isn't representable
+        // in the input range, so convolve into a temporary and requantize it.
+        Tensor accumulators;
+        OP_REQUIRES_OK(context,
+                       context->allocate_temp(DataTypeToEnum<T3>::v(),
+                                              out_shape, &accumulators));
+        ConvFunctor<T1, T2, T3> conv_functor;
+        conv_functor(context, input.flat<T1>().data(), batch, input_rows,
+                     input_cols, in_depth, offset_input,
+                     filter.flat<T2>().data(), filter_rows, filter_cols,
+                     out_depth, offset_filter, stride, padding_,
+                     accumulators.flat<T3>().data(), out_rows, out_cols,
+                     shift_output, offset_output, mult_output);
+        RequantizeInt32ToUint8(params, accumulators.flat<qint32>().data(),
+                               accumulators.NumElements(),
+                               output->flat<quint8>().data());
+      }
+      min_output_value = requested_output_min;
+      max_output_value = requested_output_max;
+    } else {
+      // This will call different implementations (e.g. reference or
+      // optimized) depending on the template parameter.
+      ConvFunctor<T1, T2, T3> conv_functor;
+      conv_functor(context, input.flat<T1>().data(), batch, input_rows,
+                   input_cols, in_depth, offset_input,
+                   filter.flat<T2>().data(), filter_rows, filter_cols,
+                   out_depth, offset_filter, stride, padding_,
+                   output->flat<T3>().data(), out_rows, out_cols, shift_output,
+                   offset_output, mult_output);
+    }
+
     Tensor* output_min = nullptr;
     OP_REQUIRES_OK(context, context->allocate_output(1, {}, &output_min));
     output_min->flat<float>()(0) = min_output_value;
@@ -511,6 +577,7 @@ class QuantizedConv2DOp : public OpKernel {
  private:
   std::vector<int32> strides_;
   Padding padding_;
+  bool requantize_;
 };
 
 // Right now we only support taking two eight bit inputs, and returning the
@@ -523,4 +590,13 @@ REGISTER_KERNEL_BUILDER(
         .TypeConstraint<qint32>("out_type"),
     QuantizedConv2DOp<quint8, quint8, qint32, Im2ColConvFunctor>);
 
+// The fused version accumulates in 32 bits but only ever outputs eight bits.
+REGISTER_KERNEL_BUILDER(
+    Name("QuantizedConv2DAndRequantize")
+        .Device(DEVICE_CPU)
+        .TypeConstraint<quint8>("Tinput")
+        .TypeConstraint<quint8>("Tfilter")
+        .TypeConstraint<quint8>("out_type"),
+    QuantizedConv2DOp<quint8, quint8, qint32, Im2ColConvFunctor>);
+
 }  // namespace tensorflow
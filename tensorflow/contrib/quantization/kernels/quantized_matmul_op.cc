@@ -63,6 +63,9 @@ class QuantizedMatMulOp : public OpKernel {
       : OpKernel(context) {
     OP_REQUIRES_OK(context, context->GetAttr("transpose_a", &transpose_a_));
     OP_REQUIRES_OK(context, context->GetAttr("transpose_b", &transpose_b_));
+    // QuantizedMatMulAndRequantize shares this kernel and has two extra inputs
+    // giving the range of its eight bit output.
+    requantize_ = (context->num_inputs() == 8);
   }
 
   void Compute(OpKernelContext* context) override {
@@ -115,7 +118,6 @@ class QuantizedMatMulOp : public OpKernel {
 
     const T1* a_data = a.flat<T1>().data();
     const T2* b_data = b.flat<T2>().data();
-    Toutput* c_data = c->flat<Toutput>().data();
 
     const bool transpose_c = false;
     const size_t m = a.dim_size(a_dim_remaining);
@@ -125,43 +127,62 @@ class QuantizedMatMulOp : public OpKernel {
     const size_t ldb = b.dim_size(1);
     const size_t ldc = n;
 
-    // The gemmlowp optimized library only works for a particular set of data
-    // types, so check if we meet those requirements and
-    // fall back to a slower reference implementation if not.
-    if (std::is_same<T1, quint8>() && std::is_same<T2, quint8>() &&
-        std::is_same<Toutput, qint32>() && (offset_c == 0) && (mult_c == 1) &&
-        (shift_c == 0) && (transpose_c == false)) {
-      if (transpose_a_) {
-        if (transpose_b_) {
-          GemmlowpMultiply<true, true, false>(context, a_data, b_data, c_data,
-                                              m, n, k, offset_a, offset_b, lda,
-                                              ldb, ldc);
+    float min_c_value;
+    float max_c_value;
+    QuantizationRangeForMultiplication<T1, T2, Toutput>(
+        min_a, max_a, min_b, max_b, &min_c_value, &max_c_value);
+
+    if (requantize_) {
+      const float requested_output_min = context->input(6).flat<float>()(0);
+      const float requested_output_max = context->input(7).flat<float>()(0);
+      OP_REQUIRES(context, (requested_output_max > requested_output_min),
+                  errors::InvalidArgument("requested_output_max must be larger "
+                                          "than requested_output_min."));
+      const Int32ToUint8RequantizeParams params(
+          min_c_value, max_c_value, requested_output_min,
+          requested_output_max);
+      RequantizedMultiply(context, a_data, b_data, m, n, k, offset_a, offset_b,
+                          lda, ldb, params, c->flat<quint8>().data());
+      min_c_value = requested_output_min;
+      max_c_value = requested_output_max;
+    } else {
+      Toutput* c_data = c->flat<Toutput>().data();
+
+      // The gemmlowp optimized library only works for a particular set of
+      // data types, so check if we meet those requirements and
+      // fall back to a slower reference implementation if not.
+      if (std::is_same<T1, quint8>() && std::is_same<T2, quint8>() &&
+          std::is_same<Toutput, qint32>() && (offset_c == 0) &&
+          (mult_c == 1) && (shift_c == 0) && (transpose_c == false)) {
+        if (transpose_a_) {
+          if (transpose_b_) {
+            GemmlowpMultiply<true, true, false>(context, a_data, b_data,
+                                                c_data, m, n, k, offset_a,
+                                                offset_b, lda, ldb, ldc);
+          } else {
+            GemmlowpMultiply<true, false, false>(context, a_data, b_data,
+                                                 c_data, m, n, k, offset_a,
+                                                 offset_b, lda, ldb, ldc);
+          }
         } else {
-          GemmlowpMultiply<true, false, false>(context, a_data, b_data, c_data,
-                                               m, n, k, offset_a, offset_b, lda,
-                                               ldb, ldc);
+          if (transpose_b_) {
+            GemmlowpMultiply<false, true, false>(context, a_data, b_data,
+                                                 c_data, m, n, k, offset_a,
+                                                 offset_b, lda, ldb, ldc);
+          } else {
+            GemmlowpMultiply<false, false, false>(context, a_data, b_data,
+                                                  c_data, m, n, k, offset_a,
+                                                  offset_b, lda, ldb, ldc);
+          }
         }
       } else {
-        if (transpose_b_) {
-          GemmlowpMultiply<false, true, false>(context, a_data, b_data, c_data,
-                                               m, n, k, offset_a, offset_b, lda,
-                                               ldb, ldc);
-        } else {
-          GemmlowpMultiply<false, false, false>(context, a_data, b_data, c_data,
-                                                m, n, k, offset_a, offset_b,
-                                                lda, ldb, ldc);
-        }
+        ReferenceGemm<T1, T2, Toutput>(transpose_a_, transpose_b_, transpose_c,
+                                       m, n, k, a_data, offset_a, lda, b_data,
+                                       offset_b, ldb, c_data, shift_c,
+                                       offset_c, mult_c, ldc);
       }
-    } else {
-      ReferenceGemm<T1, T2, Toutput>(
-          transpose_a_, transpose_b_, transpose_c, m, n, k, a_data, offset_a,
-          lda, b_data, offset_b, ldb, c_data, shift_c, offset_c, mult_c, ldc);
     }
 
-    float min_c_value;
-    float max_c_value;
-    QuantizationRangeForMultiplication<T1, T2, Toutput>(
-        min_a, max_a, min_b, max_b, &min_c_value, &max_c_value);
     Tensor* c_min = nullptr;
     OP_REQUIRES_OK(context, context->allocate_output(1, {}, &c_min));
     c_min->flat<float>()(0) = min_c_value;
@@ -172,8 +193,43 @@ class QuantizedMatMulOp : public OpKernel {
   }
 
  private:
+  // Multiplies "a" by "b" and requantizes the product into eight bit "c_data"
+  // using "params", without storing the 32-bit intermediate result.
+  void RequantizedMultiply(OpKernelContext* context, const T1* a_data,
+                           const T2* b_data, int m, int n, int k, int offset_a,
+                           int offset_b, int lda, int ldb,
+                           const Int32ToUint8RequantizeParams& params,
+                           quint8* c_data) {
+    static const gemmlowp::MapOrder RowMajor = gemmlowp::MapOrder::RowMajor;
+    static const gemmlowp::MapOrder ColMajor = gemmlowp::MapOrder::ColMajor;
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *(context->device()->tensorflow_cpu_worker_threads());
+    if (transpose_a_) {
+      if (transpose_b_) {
+        GemmlowpMultiplyAndRequantize<ColMajor, ColMajor>(
+            worker_threads, a_data, b_data, m, n, k, offset_a, offset_b, lda,
+            ldb, params, c_data);
+      } else {
+        GemmlowpMultiplyAndRequantize<ColMajor, RowMajor>(
+            worker_threads, a_data, b_data, m, n, k, offset_a, offset_b, lda,
+            ldb, params, c_data);
+      }
+    } else {
+      if (transpose_b_) {
+        GemmlowpMultiplyAndRequantize<RowMajor, ColMajor>(
+            worker_threads, a_data, b_data, m, n, k, offset_a, offset_b, lda,
+            ldb, params, c_data);
+      } else {
+        GemmlowpMultiplyAndRequantize<RowMajor, RowMajor>(
+            worker_threads, a_data, b_data, m, n, k, offset_a, offset_b, lda,
+            ldb, params, c_data);
+      }
+    }
+  }
+
   bool transpose_a_;
   bool transpose_b_;
+  bool requantize_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("QuantizedMatMul")
@@ -183,4 +239,12 @@ REGISTER_KERNEL_BUILDER(Name("QuantizedMatMul")
                             .TypeConstraint<qint32>("Toutput"),
                         QuantizedMatMulOp<quint8, quint8, qint32>);
 
+// The fused version accumulates in 32 bits but only ever outputs eight bits.
+REGISTER_KERNEL_BUILDER(Name("QuantizedMatMulAndRequantize")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<quint8>("T1")
+                            .TypeConstraint<quint8>("T2")
+                            .TypeConstraint<quint8>("Toutput"),
+                        QuantizedMatMulOp<quint8, quint8, qint32>);
+
 }  // namespace tensorflow
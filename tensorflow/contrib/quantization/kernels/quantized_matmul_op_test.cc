@@ -244,6 +244,58 @@ TEST_F(QuantizedMatMulTest, Small_WithParams) {
   test::ExpectTensorEqual<qint32>(expected, *GetOutput(0));
 }
 
+// Runs the same multiplication as Small_WithParams through the fused op, which
+// should produce eight bit results in the requested range.
+TEST_F(QuantizedMatMulTest, Small_Requantize) {
+  const bool transpose_a = true;
+  const int a_rows = 3;
+  const int a_cols = 4;
+  const int b_rows = 3;
+  const int b_cols = 2;
+  const bool transpose_b = false;
+  TF_ASSERT_OK(NodeDefBuilder("quantized_mat_mul_op",
+                              "QuantizedMatMulAndRequantize")
+                   .Input(FakeInput(DT_QUINT8))
+                   .Input(FakeInput(DT_QUINT8))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("Toutput", DataTypeToEnum<quint8>::v())
+                   .Attr("transpose_a", transpose_a)
+                   .Attr("transpose_b", transpose_b)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<quint8>(TensorShape({a_rows, a_cols}),
+                            {
+                                11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                            });
+  AddInputFromArray<quint8>(TensorShape({b_rows, b_cols}), {
+                                                               1, 4, 2, 5, 3, 6,
+                                                           });
+  AddInputFromArray<float>(TensorShape({1}), {-12.0f});
+  AddInputFromArray<float>(TensorShape({1}), {243.0f});
+  AddInputFromArray<float>(TensorShape({1}), {0});
+  AddInputFromArray<float>(TensorShape({1}), {255.0f});
+  AddInputFromArray<float>(TensorShape({1}), {-128.0f});
+  AddInputFromArray<float>(TensorShape({1}), {0.0f});
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected_float(DT_FLOAT, {a_cols, b_cols});
+  test::FillValues<float>(&expected_float,
+                          {-38, -83, -44, -98, -50, -113, -56, -128});
+  const Tensor& output_quantized = *GetOutput(0);
+  EXPECT_EQ(DT_QUINT8, output_quantized.dtype());
+  const float output_min = GetOutput(1)->flat<float>()(0);
+  const float output_max = GetOutput(2)->flat<float>()(0);
+  EXPECT_EQ(-128.0f, output_min);
+  EXPECT_EQ(0.0f, output_max);
+  Tensor output_float =
+      QuantizedTensorToFloat<quint8>(output_quantized, output_min, output_max);
+  test::ExpectTensorNear<float>(expected_float, output_float, 1.0);
+}
+
 // This test multiplies a couple of medium-sized 8-bit matrices, and tests the
 // results against what we saw from running a float MatMul with equivalent
 // inputs.
@@ -71,6 +71,63 @@ max_out: The float value that the highest quantized output value represents.
 
 )doc");
 
+REGISTER_OP("QuantizedMatMulAndRequantize")
+    .Input("a: T1")
+    .Input("b: T2")
+    .Input("min_a: float")
+    .Input("max_a: float")
+    .Input("min_b: float")
+    .Input("max_b: float")
+    .Input("requested_output_min: float")
+    .Input("requested_output_max: float")
+    .Output("out: Toutput")
+    .Output("min_out: float")
+    .Output("max_out: float")
+    .Attr("T1: quantizedtype")
+    .Attr("T2: quantizedtype")
+    .Attr("Toutput: quantizedtype = DT_QUINT8")
+    .Attr("transpose_a: bool = false")
+    .Attr("transpose_b: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      TF_RETURN_IF_ERROR(shape_inference::MatMulShape(c));
+      ShapeHandle unused;
+      for (int i = 2; i < 8; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+      c->set_output(1, c->Scalar());
+      c->set_output(2, c->Scalar());
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Perform a quantized matrix multiplication of `a` by the matrix `b`, and
+requantize the result into the range given by `requested_output_min` and
+`requested_output_max`.
+
+This produces the same values as QuantizedMatMul followed by a conversion of
+its 32-bit output into the requested range, but the intermediate result is
+converted a block at a time while it is still in cache, so it never makes a
+round trip through memory.
+Results outside the requested range are saturated.
+
+a: Must be a two-dimensional tensor.
+b: Must be a two-dimensional tensor.
+transpose_a: If true, `a` is transposed before multiplication.
+transpose_b: If true, `b` is transposed before multiplication.
+min_a: The float value that the lowest quantized `a` value represents.
+max_a: The float value that the highest quantized `a` value represents.
+min_b: The float value that the lowest quantized `b` value represents.
+max_b: The float value that the highest quantized `b` value represents.
+requested_output_min: The float value that the lowest quantized output value
+  should represent.
+requested_output_max: The float value that the highest quantized output value
+  should represent.
+min_out: The float value that the lowest quantized output value represents.
+  Always equal to `requested_output_min`.
+max_out: The float value that the highest quantized output value represents.
+  Always equal to `requested_output_max`.
+
+)doc");
+
 REGISTER_OP("QuantizeDownAndShrinkRange")
     .Input("input: Tinput")
     .Input("input_min: float")
@@ -26,3 +26,5 @@ from tensorflow.python.framework import ops
 
 
 ops.RegisterShape("QuantizedMatMul")(common_shapes.call_cpp_shape_fn)
+ops.RegisterShape("QuantizedMatMulAndRequantize")(
+    common_shapes.call_cpp_shape_fn)
@@ -28,6 +28,8 @@ from tensorflow.python.framework import ops
 ops.RegisterShape("QuantizedAvgPool")(common_shapes.call_cpp_shape_fn)
 ops.RegisterShape("QuantizedBiasAdd")(common_shapes.call_cpp_shape_fn)
 ops.RegisterShape("QuantizedConv2D")(common_shapes.call_cpp_shape_fn)
+ops.RegisterShape("QuantizedConv2DAndRequantize")(
+    common_shapes.call_cpp_shape_fn)
 ops.RegisterShape("QuantizedMaxPool")(common_shapes.call_cpp_shape_fn)
 ops.RegisterShape("QuantizedRelu")(common_shapes.call_cpp_shape_fn)
 ops.RegisterShape("QuantizedRelu6")(common_shapes.call_cpp_shape_fn)
@@ -34,6 +34,11 @@ void TFNode::AddStepStat(const string& device, const NodeExecStats* step_stat) {
   }
   all_spent_micros_ = step_stat_->all_end_rel_micros();
 
+  if (step_stat_->has_hardware_counters()) {
+    has_hardware_counters_ = true;
+    hardware_counters_ = step_stat_->hardware_counters();
+  }
+
   for (const auto& output : step_stat_->output()) {
     if (output.has_tensor_description() &&
         output.tensor_description().has_allocation_description()) {
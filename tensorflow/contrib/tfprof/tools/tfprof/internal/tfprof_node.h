@@ -42,7 +42,9 @@ class TFNode {
         op_exec_micros_(0),
         all_spent_micros_(0),
         requested_bytes_(0),
-        float_ops_(0) {
+        peak_bytes_(0),
+        float_ops_(0),
+        has_hardware_counters_(false) {
     if (!node) return;
 
     for (const auto& attr : node->attr()) {
@@ -72,13 +74,19 @@ class TFNode {
 
   void AddFloatOps(int64 float_ops) { float_ops_ = float_ops; }
 
+  // Adds an allocation of the op that was live at the memory peak.
+  void AddPeakBytes(int64 bytes) { peak_bytes_ += bytes; }
+
   const NodeDef* node_def() { return node_; }
   const std::map<string, TFNode*>& inputs() { return inputs_; }
   int64 op_start_micros() { return op_start_micros_; }
   int64 op_exec_micros() { return op_exec_micros_; }
   int64 all_spent_micros() { return all_spent_micros_; }
   int64 requested_byptes() { return requested_bytes_; }
+  int64 peak_bytes() { return peak_bytes_; }
   int64 float_ops() { return float_ops_; }
+  bool has_hardware_counters() { return has_hardware_counters_; }
+  const HardwareCounters& hardware_counters() { return hardware_counters_; }
   string device() { return device_; }
   const std::set<string>& op_types() { return op_types_; }
 
@@ -97,7 +105,10 @@ class TFNode {
   int64 op_exec_micros_;
   int64 all_spent_micros_;
   int64 requested_bytes_;
+  int64 peak_bytes_;
   int64 float_ops_;
+  bool has_hardware_counters_;
+  HardwareCounters hardware_counters_;
 };
 
 }  // namespace tfprof
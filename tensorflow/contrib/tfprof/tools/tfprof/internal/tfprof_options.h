@@ -47,13 +47,15 @@ static const char* const kOptions[] = {
 };
 
 static const char* const kOrderBy[] = {
-    "name", "bytes", "micros", "params", "float_ops",
+    "name", "bytes", "micros", "params", "float_ops", "peak_bytes",
+    "cycles",
 };
 
 // Append Only.
 static const char* const kShown[] = {
     "bytes",          "micros",       "params", "float_ops",
     "num_hidden_ops", "tensor_value", "device", "op_types",
+    "peak_bytes",     "hardware_counters",
 };
 
 static const char* const kCmds[] = {
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/contrib/tfprof/tools/tfprof/internal/tfprof_show.h"
 
+#include <algorithm>
 #include <memory>
 #include <set>
 
@@ -25,6 +26,16 @@ limitations under the License.
 
 namespace tensorflow {
 namespace tfprof {
+namespace {
+void AddHardwareCounters(const TFProfHardwareCounters& counters,
+                         TFProfHardwareCounters* total) {
+  total->set_cycles(total->cycles() + counters.cycles());
+  total->set_instructions(total->instructions() + counters.instructions());
+  total->set_llc_misses(total->llc_misses() + counters.llc_misses());
+  total->set_branch_misses(total->branch_misses() + counters.branch_misses());
+}
+}  // namespace
+
 ShowNode::ShowNode(TFNode* node) : node(node), account(true) {
   mutable_proto()->set_name(name());
   if (!node->device().empty()) {
@@ -32,7 +43,20 @@ ShowNode::ShowNode(TFNode* node) : node(node), account(true) {
   }
   mutable_proto()->set_exec_micros(node->op_exec_micros());
   mutable_proto()->set_requested_bytes(node->requested_byptes());
+  if (node->peak_bytes() > 0) {
+    mutable_proto()->set_peak_bytes(node->peak_bytes());
+  }
   mutable_proto()->set_float_ops(node->float_ops());
+  if (node->has_hardware_counters()) {
+    // Unavailable counters are -1 in the step stats.
+    const HardwareCounters& hc = node->hardware_counters();
+    TFProfHardwareCounters* counters =
+        mutable_proto()->mutable_hardware_counters();
+    counters->set_cycles(std::max<int64>(0, hc.cycles()));
+    counters->set_instructions(std::max<int64>(0, hc.instructions()));
+    counters->set_llc_misses(std::max<int64>(0, hc.llc_misses()));
+    counters->set_branch_misses(std::max<int64>(0, hc.branch_misses()));
+  }
 
   if (!node->shape().empty()) {
     int64 params = 1;
@@ -94,6 +118,33 @@ string ShowNode::FormatMeta(const Options& opts) {
     }
     info.push_back(memory);
   }
+  if (opts.select.find(kShown[8]) != opts.select.end()) {
+    string peak = FormatMemory(proto().total_peak_bytes()) + " at peak";
+    if (account) {
+      peak = FormatMemory(proto().peak_bytes()) + "/" + peak;
+    } else {
+      peak = "--/" + peak;
+    }
+    info.push_back(peak);
+  }
+  if (opts.select.find(kShown[9]) != opts.select.end()) {
+    const TFProfHardwareCounters& total = proto().total_hardware_counters();
+    string counters = FormatNumber(total.cycles()) + " cycles";
+    if (account) {
+      counters =
+          FormatNumber(proto().hardware_counters().cycles()) + "/" + counters;
+    } else {
+      counters = "--/" + counters;
+    }
+    if (total.cycles() > 0) {
+      counters += strings::Printf(
+          ", %.2f IPC",
+          static_cast<double>(total.instructions()) / total.cycles());
+    }
+    counters += ", " + FormatNumber(total.llc_misses()) + " LLC misses, " +
+                FormatNumber(total.branch_misses()) + " branch misses";
+    info.push_back(counters);
+  }
   if (opts.select.find(kShown[1]) != opts.select.end()) {
     string time = FormatTime(proto().total_exec_micros());
     if (account) {
@@ -133,6 +184,16 @@ void ShowNode::AggregateTotalStats(ShowNode* node) {
                                         node_pb->total_parameters());
   mutable_proto()->set_total_float_ops(proto().total_float_ops() +
                                        node_pb->total_float_ops());
+  // Peak bytes are only set when available, to keep the output of steps
+  // run without memory profiling unchanged.
+  if (node_pb->total_peak_bytes() > 0) {
+    mutable_proto()->set_total_peak_bytes(proto().total_peak_bytes() +
+                                          node_pb->total_peak_bytes());
+  }
+  if (node_pb->has_total_hardware_counters()) {
+    AddHardwareCounters(node_pb->total_hardware_counters(),
+                        mutable_proto()->mutable_total_hardware_counters());
+  }
 }
 
 void ShowNode::AddSelfToTotalStats() {
@@ -144,6 +205,14 @@ void ShowNode::AddSelfToTotalStats() {
                                         proto().parameters());
   mutable_proto()->set_total_float_ops(proto().total_float_ops() +
                                        proto().float_ops());
+  if (proto().peak_bytes() > 0) {
+    mutable_proto()->set_total_peak_bytes(proto().total_peak_bytes() +
+                                          proto().peak_bytes());
+  }
+  if (proto().has_hardware_counters()) {
+    AddHardwareCounters(proto().hardware_counters(),
+                        mutable_proto()->mutable_total_hardware_counters());
+  }
 }
 
 void ShowNode::ResetTotalStats() {
@@ -151,6 +220,8 @@ void ShowNode::ResetTotalStats() {
   mutable_proto()->set_total_requested_bytes(0);
   mutable_proto()->set_total_parameters(0);
   mutable_proto()->set_total_float_ops(0);
+  mutable_proto()->clear_total_peak_bytes();
+  mutable_proto()->clear_total_hardware_counters();
 }
 
 const TFProfNode& TFShow::Show(const Options& opts) {
@@ -112,6 +112,12 @@ class TFShow {
         return n1->proto().total_parameters() > n2->proto().total_parameters();
       } else if (opts.order_by == kOrderBy[4]) {
         return n1->proto().total_float_ops() > n2->proto().total_float_ops();
+      } else if (opts.order_by == kOrderBy[5]) {
+        return n1->proto().total_peak_bytes() >
+               n2->proto().total_peak_bytes();
+      } else if (opts.order_by == kOrderBy[6]) {
+        return n1->proto().total_hardware_counters().cycles() >
+               n2->proto().total_hardware_counters().cycles();
       }
       return name_cmp;
     });
@@ -125,6 +125,15 @@ void TFStats::ParseRunMeta() {
       node->second.AddStepStat(dev_stat.device(), &node_stat);
     }
   }
+  for (const auto& peak : run_meta_->step_stats().memory_peak()) {
+    for (const auto& live : peak.live()) {
+      auto node = nodes_map_.find(live.node_name());
+      if (node == nodes_map_.end()) {
+        continue;
+      }
+      node->second.AddPeakBytes(live.num_bytes());
+    }
+  }
 }
 }  // namespace tfprof
 }  // namespace tensorflow
@@ -190,5 +190,57 @@ TEST_F(TFProfStatsTest, TestShowTensorValue) {
   EXPECT_EQ(expected.DebugString(), root.DebugString());
 }
 
+TEST(TFProfStatsMemoryTest, TestPeakBytes) {
+  std::unique_ptr<GraphDef> graph_pb(new GraphDef());
+  CHECK(protobuf::TextFormat::ParseFromString(
+      "node { name: \"a\" op: \"Const\" }\n"
+      "node { name: \"c\" op: \"Neg\" input: \"a\" }\n",
+      graph_pb.get()));
+  std::unique_ptr<RunMetadata> run_meta_pb(new RunMetadata());
+  CHECK(protobuf::TextFormat::ParseFromString(
+      "step_stats { memory_peak { allocator_name: \"cpu\" peak_bytes: 700\n"
+      "  live { node_name: \"c\" num_bytes: 300 }\n"
+      "  live { node_name: \"c\" num_bytes: 300 }\n"
+      "  live { node_name: \"a\" num_bytes: 100 } } }\n",
+      run_meta_pb.get()));
+  TFStats tf_stats(std::move(graph_pb), std::move(run_meta_pb), nullptr,
+                   nullptr);
+
+  Options opts(10, 0, 0, 0, 0, {".*"}, "peak_bytes", {".*"}, {".*"}, {""},
+               {".*"}, {""}, false, {"peak_bytes"}, false);
+  const TFProfNode& root = tf_stats.PrintGraph("scope", opts);
+  EXPECT_FALSE(root.has_peak_bytes());
+  EXPECT_EQ(700, root.total_peak_bytes());
+}
+
+TEST(TFProfStatsHardwareCountersTest, TestAggregation) {
+  std::unique_ptr<GraphDef> graph_pb(new GraphDef());
+  CHECK(protobuf::TextFormat::ParseFromString(
+      "node { name: \"a\" op: \"Const\" }\n"
+      "node { name: \"c\" op: \"Neg\" input: \"a\" }\n",
+      graph_pb.get()));
+  std::unique_ptr<RunMetadata> run_meta_pb(new RunMetadata());
+  CHECK(protobuf::TextFormat::ParseFromString(
+      "step_stats { dev_stats { device: \"/cpu:0\"\n"
+      "  node_stats { node_name: \"a\" hardware_counters {\n"
+      "    cycles: 1000 instructions: 500 llc_misses: -1 branch_misses: 2 } }\n"
+      "  node_stats { node_name: \"c\" hardware_counters {\n"
+      "    cycles: 3000 instructions: 7500 llc_misses: -1 branch_misses: 8 } }"
+      " } }\n",
+      run_meta_pb.get()));
+  TFStats tf_stats(std::move(graph_pb), std::move(run_meta_pb), nullptr,
+                   nullptr);
+
+  Options opts(10, 0, 0, 0, 0, {".*"}, "cycles", {".*"}, {".*"}, {""},
+               {".*"}, {""}, false, {"hardware_counters"}, false);
+  const TFProfNode& root = tf_stats.PrintGraph("scope", opts);
+  EXPECT_FALSE(root.has_hardware_counters());
+  EXPECT_EQ(4000, root.total_hardware_counters().cycles());
+  EXPECT_EQ(8000, root.total_hardware_counters().instructions());
+  // Unavailable counters count as 0.
+  EXPECT_EQ(0, root.total_hardware_counters().llc_misses());
+  EXPECT_EQ(10, root.total_hardware_counters().branch_misses());
+}
+
 }  // namespace tfprof
 }  // namespace tensorflow
@@ -298,7 +298,7 @@ void PrintHelp() {
       "  -device_regexes: Show ops that a placed on the specified devices. "
       "regexes are comma-separated.\n\n"
       "  -order_by: Order the results by [name|depth|bytes|micros|params|"
-      "float_ops]\n\n"
+      "float_ops|peak_bytes|cycles]\n\n"
       "  -account_type_regexes: Account and display the ops whose types match "
       "one of the type regexes specified. tfprof "
       "allow user to define extra op types for ops "
@@ -329,8 +329,12 @@ void PrintHelp() {
       "ops eventually displayed. If False, account all "
       "op statistics matching -account_type_regexes recursively.\n\n"
       "  -select: Comma-separated list of metrics to show: [bytes|micros|"
-      "params|float_ops|num_hidden_ops|tensor_value|device|op_types]."
-      "\n\n"
+      "params|float_ops|num_hidden_ops|tensor_value|device|op_types|"
+      "peak_bytes|hardware_counters]. peak_bytes are the bytes allocated by "
+      "the ops that were live at the memory peak of a step run with "
+      "RunOptions.profile_memory. hardware_counters are the cycles, "
+      "instructions per cycle, and LLC and branch misses of the ops of a "
+      "step run with RunOptions.collect_hardware_counters.\n\n"
       "  -dump_to_file: Dump the output to a file, instead of terminal.\n\n"
       ""
       "Examples\n"
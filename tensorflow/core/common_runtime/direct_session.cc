@@ -27,7 +27,9 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/graph_optimizer.h"
 #include "tensorflow/core/common_runtime/memory_types.h"
 #include "tensorflow/core/common_runtime/simple_placer.h"
+#include "tensorflow/core/common_runtime/step_memory_profiler.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/trace_recorder.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/graph.pb_text.h"
@@ -52,6 +54,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
@@ -110,6 +113,25 @@ string GetRendezvousKey(const string& tensor_name,
                          frame_iter.frame_id, ":", frame_iter.iter_id);
 }
 
+// The _Send and _Recv nodes that a cached partition shares with the client
+// device name the incarnation of the client device in the session that
+// created the entry.  Replaces it with the incarnation of 'client', which
+// the rendezvous keys of the feeds and fetches use.
+void SetClientDeviceIncarnation(const DeviceAttributes& client,
+                                GraphDef* graph_def) {
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    auto send_device = node.attr().find("send_device");
+    if (send_device == node.attr().end() ||
+        send_device->second.s() != client.name()) {
+      continue;
+    }
+    auto incarnation = node.mutable_attr()->find("send_device_incarnation");
+    if (incarnation != node.mutable_attr()->end()) {
+      incarnation->second.set_i(static_cast<int64>(client.incarnation()));
+    }
+  }
+}
+
 }  // namespace
 
 class DirectSessionFactory : public SessionFactory {
@@ -263,6 +285,11 @@ DirectSession::DirectSession(const SessionOptions& options,
     }
     ++devices_added;
   }
+  const string& cache_dir =
+      options_.config.graph_options().partitioned_graph_cache_dir();
+  if (!cache_dir.empty()) {
+    graph_cache_.reset(new PartitionedGraphCache(options_.env, cache_dir));
+  }
 }
 
 DirectSession::~DirectSession() {
@@ -273,6 +300,7 @@ DirectSession::~DirectSession() {
   for (auto& it : executors_) {
     it.second.reset(nullptr);
   }
+  stateless_kernels_.clear();
   for (auto d : device_mgr_->ListDevices()) {
     d->op_segment()->RemoveHold(session_handle_);
   }
@@ -296,8 +324,12 @@ void DirectSession::MaybeInitializeExecutionState(const GraphDef& graph) {
   SimpleGraphExecutionStateOptions options;
   options.device_set = &device_set_;
   options.session_options = &options_;
+  options.thread_pool = thread_pools_[0];
   execution_state_.reset(
       new SimpleGraphExecutionState(graph.library(), options));
+  // Keeps the stateful nodes where the partitions loaded from the cache, if
+  // any, expect them.
+  execution_state_->SetStatefulPlacements(stateful_placements_);
 }
 
 Status DirectSession::Create(const GraphDef& graph) {
@@ -320,6 +352,11 @@ Status DirectSession::ExtendLocked(const GraphDef& graph) {
   std::unique_ptr<SimpleGraphExecutionState> state;
   TF_RETURN_IF_ERROR(execution_state_->Extend(graph, &state));
   execution_state_.swap(state);
+  if (graph_cache_ != nullptr) {
+    // Identifies the graph in the keys of the cache entries.
+    strings::StrAppend(&graph_fingerprint_,
+                       PartitionedGraphCache::FingerprintGraphDef(graph), ";");
+  }
 
   graph_created_ = true;  // In case this is first call
   return Status::OK();
@@ -414,11 +451,19 @@ Status DirectSession::Run(const RunOptions& run_options,
   const bool do_trace = (run_options.trace_level() > RunOptions::NO_TRACE);
   const int64 build_cost_model =
       options_.config.graph_options().build_cost_model();
-  if (do_trace || build_cost_model > 0) {
+  if (do_trace || build_cost_model > 0 ||
+      run_options.collect_hardware_counters()) {
     run_state.collector.reset(
         new StepStatsCollector(run_metadata->mutable_step_stats()));
     args.stats_collector = run_state.collector.get();
   }
+  args.collect_hardware_counters = run_options.collect_hardware_counters();
+
+  StepMemoryProfiler* memory_profiler =
+      run_options.profile_memory() ? new StepMemoryProfiler(Env::Default())
+                                   : nullptr;
+  core::ScopedUnref memory_profiler_unref(memory_profiler);
+  args.allocation_recorder = memory_profiler;
 
   std::unique_ptr<GPUTracer> tracer;
   if (run_options.trace_level() >= RunOptions::HARDWARE_TRACE) {
@@ -427,6 +472,10 @@ Status DirectSession::Run(const RunOptions& run_options,
     if (tracer) tracer->Start();
   }
 
+  TraceRecorder* trace_recorder = TraceRecorder::Global();
+  const bool sampled = trace_recorder->ShouldTrace(args.step_id);
+  const uint64 step_start_micros = sampled ? Env::Default()->NowMicros() : 0;
+
   for (const auto& item : executors_and_keys->items) {
     item.executor->RunAsync(args, barrier->Get());
   }
@@ -435,11 +484,23 @@ Status DirectSession::Run(const RunOptions& run_options,
                                       ? run_options.timeout_in_ms()
                                       : operation_timeout_in_ms_);
 
+  if (sampled) {
+    trace_recorder->StepDone(args.step_id, step_start_micros,
+                             Env::Default()->NowMicros());
+  }
+
   if (tracer) {
     tracer->Stop();
     tracer->Collect(args.stats_collector);
   }
 
+  // Summarize the memory profile even if the step failed, since it is
+  // most useful when the step ran out of memory.
+  if (memory_profiler != nullptr) {
+    memory_profiler->Stop();
+    memory_profiler->Summarize(run_metadata->mutable_step_stats());
+  }
+
   {
     mutex_lock l(run_state.mu_);
     TF_RETURN_IF_ERROR(run_state.status);
@@ -790,6 +851,55 @@ Status DirectSession::CheckFetch(const NamedTensorList& feeds,
   return Status::OK();
 }
 
+/* static */
+bool DirectSession::IsSharedKernel(FunctionLibraryRuntime* lib,
+                                   const string& op) {
+  // The kernel of a function call instantiates the function in 'lib', so it
+  // is only shared if the function is stateful.
+  return lib->IsStateful(op) ||
+         lib->GetFunctionLibraryDefinition()->Find(op) == nullptr;
+}
+
+Status DirectSession::CreateKernel(FunctionLibraryRuntime* lib,
+                                   int graph_def_version, const NodeDef& ndef,
+                                   OpKernel** kernel) {
+  if (!IsSharedKernel(lib, ndef.op())) {
+    return lib->CreateKernel(ndef, kernel);
+  }
+  if (lib->IsStateful(ndef.op())) {
+    auto create_fn = [lib, &ndef](OpKernel** kernel) {
+      return lib->CreateKernel(ndef, kernel);
+    };
+    // Kernels created for subgraph nodes need to be cached.  On
+    // cache miss, create_fn() is invoked to create a kernel based
+    // on the function library here + global op registry.
+    return lib->device()->op_segment()->FindOrCreate(
+        session_handle_, ndef.name(), kernel, create_fn);
+  }
+
+  const string key = strings::StrCat(
+      lib->device()->name(), ";", graph_def_version, ";",
+      PartitionedGraphCache::FingerprintNodeDef(ndef));
+  {
+    mutex_lock l(kernels_lock_);
+    auto it = stateless_kernels_.find(key);
+    if (it != stateless_kernels_.end()) {
+      *kernel = it->second.get();
+      return Status::OK();
+    }
+  }
+  // Kernels may be created in parallel, so another executor may have
+  // created the same kernel in the meantime; the first one is kept.
+  OpKernel* created = nullptr;
+  TF_RETURN_IF_ERROR(lib->CreateKernel(ndef, &created));
+  std::unique_ptr<OpKernel> owned(created);
+  mutex_lock l(kernels_lock_);
+  std::unique_ptr<OpKernel>& cached = stateless_kernels_[key];
+  if (cached == nullptr) cached = std::move(owned);
+  *kernel = cached.get();
+  return Status::OK();
+}
+
 Status DirectSession::GetOrCreateExecutors(
     thread::ThreadPool* pool, gtl::ArraySlice<string> inputs,
     gtl::ArraySlice<string> outputs, gtl::ArraySlice<string> target_nodes,
@@ -836,8 +946,23 @@ Status DirectSession::GetOrCreateExecutors(
   // The executor_lock_ is intentionally released while executor is
   // being created.
   std::unordered_map<string, std::unique_ptr<Graph>> graphs;
-  TF_RETURN_IF_ERROR(
-      CreateGraphs(options, &graphs, &ek->flib_def, run_state_args));
+  // Partial runs need the full graph, and debug nodes are not cached.
+  string cache_key;
+  bool cached = false;
+  if (graph_cache_ != nullptr && !run_state_args->is_partial_run &&
+      run_state_args->debug_tensor_watches.empty()) {
+    TF_RETURN_IF_ERROR(CreateGraphsFromCache(key, &cache_key, &graphs,
+                                             &ek->flib_def, &cached));
+  }
+  if (!cached) {
+    TF_RETURN_IF_ERROR(
+        CreateGraphs(options, &graphs, &ek->flib_def, run_state_args));
+  }
+  // Set if the partitions are to be added to the cache.
+  std::unique_ptr<PartitionedGraphCacheEntry> cache_entry;
+  if (!cache_key.empty() && !cached) {
+    cache_entry.reset(new PartitionedGraphCacheEntry);
+  }
 
   if (run_state_args->is_partial_run) {
     ek->graph = std::move(run_state_args->graph);
@@ -878,32 +1003,28 @@ Status DirectSession::GetOrCreateExecutors(
     params.device = device;
     params.function_library = item->flib.get();
     auto lib = item->flib.get();
-    auto opseg = device->op_segment();
-    params.create_kernel = [this, lib, opseg](const NodeDef& ndef,
-                                              OpKernel** kernel) {
-      // Caches the kernel only if the node is stateful.
-      if (!lib->IsStateful(ndef.op())) {
-        return lib->CreateKernel(ndef, kernel);
-      }
-      auto create_fn = [lib, &ndef](OpKernel** kernel) {
-        return lib->CreateKernel(ndef, kernel);
-      };
-      // Kernels created for subgraph nodes need to be cached.  On
-      // cache miss, create_fn() is invoked to create a kernel based
-      // on the function library here + global op registry.
-      return opseg->FindOrCreate(session_handle_, ndef.name(), kernel,
-                                 create_fn);
+    params.create_kernel = [this, lib, graph_def_version](
+        const NodeDef& ndef, OpKernel** kernel) {
+      return CreateKernel(lib, graph_def_version, ndef, kernel);
     };
     params.delete_kernel = [lib](OpKernel* kernel) {
-      // If the node is stateful, opseg owns it. Otherwise, delete it.
-      if (kernel && !lib->IsStateful(kernel->type_string())) {
+      // Shared kernels are owned by opseg or stateless_kernels_.
+      if (kernel && !IsSharedKernel(lib, kernel->type_string())) {
         delete kernel;
       }
     };
+    params.thread_pool = thread_pools_[0];
     params.node_outputs_cb = node_outputs_callback_;
 
     partition_graph = iter->second.release();
-    optimizer.Optimize(lib, options_.env, device, &partition_graph);
+    // Cached partitions are already optimized.
+    if (!cached) {
+      optimizer.Optimize(lib, options_.env, device, &partition_graph);
+    }
+    if (cache_entry != nullptr) {
+      partition_graph->ToGraphDef(
+          &(*cache_entry->mutable_partitions())[partition_name]);
+    }
 
     // EXPERIMENTAL: tfdb inserts debug nodes (i.e., probes) to the graph
     if (!run_state_args->debug_tensor_watches.empty()) {
@@ -924,6 +1045,20 @@ Status DirectSession::GetOrCreateExecutors(
     item->executor.reset(executor);
   }
 
+  if (cache_entry != nullptr) {
+    *cache_entry->mutable_library() = ek->flib_def->ToProto();
+    {
+      mutex_lock l(graph_def_lock_);
+      cache_entry->mutable_stateful_placements()->insert(
+          stateful_placements_.begin(), stateful_placements_.end());
+    }
+    Status s = graph_cache_->Insert(cache_key, *cache_entry);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to add the graphs of " << key
+                   << " to the partitioned graph cache: " << s;
+    }
+  }
+
   // Compute the rendezvous keys to avoid recomputing them every time.
   //
   // We always use the first device as the device name portion of the
@@ -965,6 +1100,7 @@ Status DirectSession::CreateGraphs(
     SimpleGraphExecutionStateOptions prune_options;
     prune_options.device_set = &device_set_;
     prune_options.session_options = &options_;
+    prune_options.thread_pool = thread_pools_[0];
     temp_exec_state_holder.reset(new SimpleGraphExecutionState(
         execution_state_->original_graph_def().library(), prune_options));
     temp_exec_state_holder->SetStatefulPlacements(stateful_placements_);
@@ -1068,6 +1204,7 @@ Status DirectSession::CreateGraphs(
     // allow.
     device_opts.allow_internal_ops = true;
     device_opts.expect_device_spec = true;
+    device_opts.thread_pool = thread_pools_[0];
     TF_RETURN_IF_ERROR(
         ConvertGraphDefToGraph(device_opts, *graph_def, device_graph.get()));
     outputs->emplace(partition_name, std::move(device_graph));
@@ -1076,6 +1213,70 @@ Status DirectSession::CreateGraphs(
   return s;
 }
 
+Status DirectSession::CreateGraphsFromCache(
+    const string& signature, string* cache_key,
+    std::unordered_map<string, std::unique_ptr<Graph>>* outputs,
+    std::unique_ptr<FunctionLibraryDefinition>* flib_def, bool* found) {
+  *found = false;
+  mutex_lock l(graph_def_lock_);
+  *cache_key = PartitionedGraphCache::Key(graph_fingerprint_, options_.config,
+                                          devices_, signature);
+  PartitionedGraphCacheEntry entry;
+  if (!graph_cache_->Lookup(*cache_key, &entry)) {
+    return Status::OK();
+  }
+  // The partitions expect the stateful nodes on the devices they were on
+  // when the entry was created.
+  for (const auto& placement : entry.stateful_placements()) {
+    auto iter = stateful_placements_.find(placement.first);
+    if (iter != stateful_placements_.end() &&
+        iter->second != placement.second) {
+      VLOG(1) << "Not using the cached graphs of " << signature << ": "
+              << placement.first << " is on " << iter->second
+              << " instead of " << placement.second;
+      return Status::OK();
+    }
+  }
+
+  std::unique_ptr<FunctionLibraryDefinition> library(
+      new FunctionLibraryDefinition(OpRegistry::Global(), entry.library()));
+  const DeviceAttributes& client = device_set_.client_device()->attributes();
+  std::unordered_map<string, std::unique_ptr<Graph>> graphs;
+  for (auto& partition : *entry.mutable_partitions()) {
+    Device* d;
+    Status s = device_mgr_->LookupDevice(partition.first, &d);
+    if (s.ok()) {
+      SetClientDeviceIncarnation(client, &partition.second);
+      std::unique_ptr<Graph> device_graph(new Graph(library.get()));
+      GraphConstructorOptions device_opts;
+      device_opts.allow_internal_ops = true;
+      device_opts.expect_device_spec = true;
+      device_opts.thread_pool = thread_pools_[0];
+      s = ConvertGraphDefToGraph(device_opts, partition.second,
+                                 device_graph.get());
+      graphs.emplace(partition.first, std::move(device_graph));
+    }
+    if (!s.ok()) {
+      // E.g. an op was removed from the binary since the entry was created.
+      LOG(WARNING) << "Not using the cached graphs of " << signature << ": "
+                   << s;
+      return Status::OK();
+    }
+  }
+
+  for (const auto& placement : entry.stateful_placements()) {
+    stateful_placements_.insert(placement);
+  }
+  if (execution_state_ != nullptr) {
+    // Keeps the stateful nodes there if the graph is placed later.
+    execution_state_->SetStatefulPlacements(stateful_placements_);
+  }
+  *outputs = std::move(graphs);
+  *flib_def = std::move(library);
+  *found = true;
+  return Status::OK();
+}
+
 ::tensorflow::Status DirectSession::Reset(
     const std::vector<string>& containers) {
   device_mgr_->ClearContainers(containers);
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/device_set.h"
 #include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/partitioned_graph_cache.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/common_runtime/session_factory.h"
 #include "tensorflow/core/common_runtime/simple_graph_execution_state.h"
@@ -183,9 +184,31 @@ class DirectSession : public Session {
       std::unique_ptr<FunctionLibraryDefinition>* flib_def,
       RunStateArgs* run_state_args);
 
+  // Creates the graphs for the run signature 'signature' from the entry of
+  // graph_cache_, if it has one.  Sets '*found' to false, without error,
+  // if it has none or if the entry cannot be used.  Fills in '*cache_key'
+  // in either case.
+  ::tensorflow::Status CreateGraphsFromCache(
+      const string& signature, string* cache_key,
+      std::unordered_map<string, std::unique_ptr<Graph>>* outputs,
+      std::unique_ptr<FunctionLibraryDefinition>* flib_def, bool* found);
+
   ::tensorflow::Status ExtendLocked(const GraphDef& graph)
       EXCLUSIVE_LOCKS_REQUIRED(graph_def_lock_);
 
+  // Returns true if the kernels of 'op' are shared between executors and
+  // so must not be deleted by them: stateful kernels, owned by the device's
+  // op segment, and the kernels in stateless_kernels_.
+  static bool IsSharedKernel(FunctionLibraryRuntime* lib, const string& op);
+
+  // Sets '*kernel' to the kernel of 'ndef' for an executor using 'lib',
+  // whose graph has the producer version 'graph_def_version', reusing the
+  // kernel created for an identical node of another executor when it is
+  // shared.
+  ::tensorflow::Status CreateKernel(FunctionLibraryRuntime* lib,
+                                    int graph_def_version, const NodeDef& ndef,
+                                    OpKernel** kernel);
+
   // Feeds more inputs to the executors, triggering further execution.
   ::tensorflow::Status SendInputs(
       const std::vector<std::pair<string, Tensor>>& inputs,
@@ -230,6 +253,10 @@ class DirectSession : public Session {
   GraphDef graph_def_ GUARDED_BY(graph_def_lock_);
 
   // The thread-pools to use for running ops.
+  //
+  // Building the executors of a new signature converts GraphDefs and creates
+  // kernels on thread_pools_[0] and waits for it, so Run() and PRunSetup()
+  // must not be called from one of its threads, e.g. by a kernel.
   std::vector<thread::ThreadPool*> thread_pools_;
   bool owns_thread_pools_ = false;
 
@@ -243,6 +270,16 @@ class DirectSession : public Session {
   std::unordered_map<string, std::unique_ptr<ExecutorsAndKeys>> executors_
       GUARDED_BY(executor_lock_);
 
+  // The stateless kernels of the executors, other than function calls,
+  // keyed by device, graph version and a fingerprint of their NodeDef.  The
+  // executors of a signature first run after Extend() thus create only the
+  // kernels of nodes that no earlier executor has, instead of creating
+  // again e.g. every large constant of their partitions.  Deleted after
+  // executors_.
+  mutex kernels_lock_;
+  std::unordered_map<string, std::unique_ptr<OpKernel>> stateless_kernels_
+      GUARDED_BY(kernels_lock_);
+
   // Holds mappings from handle to partial run state.
   std::unordered_map<string, std::unique_ptr<RunState>> partial_runs_
       GUARDED_BY(executor_lock_);
@@ -264,6 +301,13 @@ class DirectSession : public Session {
   std::unique_ptr<SimpleGraphExecutionState> execution_state_
       GUARDED_BY(graph_def_lock_);
 
+  // Set if the partitioned_graph_cache_dir option is not empty.
+  std::unique_ptr<PartitionedGraphCache> graph_cache_;
+
+  // With graph_cache_, the fingerprints of the graphs passed to Create() and
+  // Extend(), in order.
+  string graph_fingerprint_ GUARDED_BY(graph_def_lock_);
+
   // The function library, before any rewrites or optimizations have been
   // performed. In particular, CreateGraphs() may need to modify the function
   // library; it copies and modifies the function library.
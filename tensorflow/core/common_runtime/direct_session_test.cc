@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/direct_session.h"
 
+#include <atomic>
 #include <map>
 #include <string>
 #include <unordered_map>
@@ -22,6 +23,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -35,7 +37,11 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/profile_utils/perf_counters.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/partitioned_graph_cache.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/util/device_name_utils.h"
@@ -295,6 +301,162 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetworkWithOpts) {
   EXPECT_EQ(run_metadata.step_stats().dev_stats_size(), 2);
 }
 
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetworkWithMemoryProfile) {
+  Initialize({3, 2, -1, 0});
+  std::unique_ptr<Session> session(CreateSession());
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_names = {y_ + ":0"};
+  std::vector<string> target_nodes = {y_neg_};
+  std::vector<Tensor> outputs;
+
+  RunOptions run_options;
+  run_options.set_profile_memory(true);
+  RunMetadata run_metadata;
+  TF_ASSERT_OK(session->Run(run_options, inputs, output_names, target_nodes,
+                            &outputs, &run_metadata));
+
+  // The fetched output of y is live until the end of the step, so it is
+  // part of the peak.
+  EXPECT_EQ(run_metadata.step_stats().dev_stats_size(), 0);
+  ASSERT_GT(run_metadata.step_stats().memory_peak_size(), 0);
+  bool found_y = false;
+  for (const auto& peak : run_metadata.step_stats().memory_peak()) {
+    EXPECT_GT(peak.peak_bytes(), 0);
+    for (const auto& live : peak.live()) {
+      if (live.node_name() == y_) {
+        found_y = true;
+        EXPECT_EQ(8, live.num_bytes());  // 2x1 floats.
+      }
+    }
+  }
+  EXPECT_TRUE(found_y);
+}
+
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetworkWithHardwareCounters) {
+  Initialize({3, 2, -1, 0});
+  std::unique_ptr<Session> session(CreateSession());
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_names = {y_ + ":0"};
+  std::vector<string> target_nodes = {y_neg_};
+  std::vector<Tensor> outputs;
+
+  RunOptions run_options;
+  run_options.set_collect_hardware_counters(true);
+  RunMetadata run_metadata;
+  TF_ASSERT_OK(session->Run(run_options, inputs, output_names, target_nodes,
+                            &outputs, &run_metadata));
+
+  // Collecting counters implies collecting step stats.  The counters
+  // themselves depend on the machine.
+  EXPECT_EQ(run_metadata.step_stats().dev_stats_size(), 2);
+  if (profile_utils::PerfCounters::ForCurrentThread() != nullptr) {
+    bool found_y = false;
+    for (const auto& dev_stats : run_metadata.step_stats().dev_stats()) {
+      for (const auto& node_stats : dev_stats.node_stats()) {
+        if (node_stats.node_name() == y_) {
+          found_y = true;
+          EXPECT_TRUE(node_stats.has_hardware_counters());
+        }
+      }
+    }
+    EXPECT_TRUE(found_y);
+  }
+}
+
+TEST_F(DirectSessionMinusAXTest, RunWithPartitionedGraphCache) {
+  Initialize({3, 2, -1, 0});
+  const string cache_dir =
+      io::JoinPath(testing::TmpDir(), "direct_session_graph_cache");
+  int64 undeleted_files, undeleted_dirs;
+  Env::Default()->DeleteRecursively(cache_dir, &undeleted_files,
+                                    &undeleted_dirs);
+  SessionOptions options;
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  options.config.mutable_graph_options()->set_partitioned_graph_cache_dir(
+      cache_dir);
+  // Feeds x, on cpu:1, and fetches y, on cpu:0, so that the cached graphs
+  // exchange tensors with the client device of each new session.
+  Tensor x(DT_FLOAT, TensorShape({2, 1}));
+  test::FillValues<float>(&x, {2, 1});
+  std::vector<std::pair<string, Tensor>> inputs = {{x_, x}};
+  std::vector<string> output_names = {y_ + ":0"};
+  std::vector<string> target_nodes = {y_neg_};
+
+  auto run = [this, &options, &inputs, &output_names,
+              &target_nodes](float* y0) {
+    std::unique_ptr<Session> session(NewSession(options));
+    ASSERT_TRUE(session != nullptr);
+    TF_ASSERT_OK(session->Create(def_));
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run(inputs, output_names, target_nodes, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    *y0 = outputs[0].matrix<float>()(0, 0);
+  };
+
+  // The first session creates the entry and the second one uses it.
+  float y0 = 0;
+  run(&y0);
+  EXPECT_FLOAT_EQ(8.0, y0);
+  std::vector<string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(cache_dir, &children));
+  ASSERT_EQ(1, children.size());
+  run(&y0);
+  EXPECT_FLOAT_EQ(8.0, y0);
+
+  // Changes A in the cached partitions, to check that they are used.
+  const string entry_file = io::JoinPath(cache_dir, children[0]);
+  PartitionedGraphCacheEntry entry;
+  TF_ASSERT_OK(ReadBinaryProto(Env::Default(), entry_file, &entry));
+  Tensor identity(DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&identity, {1, 0, 0, 1});
+  int num_changed = 0;
+  for (auto& partition : *entry.mutable_partitions()) {
+    for (NodeDef& node : *partition.second.mutable_node()) {
+      if (node.op() != "Const") continue;
+      Tensor value;
+      ASSERT_TRUE(value.FromProto(node.attr().at("value").tensor()));
+      if (value.shape() == identity.shape()) {
+        identity.AsProtoTensorContent(
+            (*node.mutable_attr())["value"].mutable_tensor());
+        ++num_changed;
+      }
+    }
+  }
+  ASSERT_EQ(1, num_changed);
+  TF_ASSERT_OK(WriteBinaryProto(Env::Default(), entry_file, entry));
+  run(&y0);
+  EXPECT_FLOAT_EQ(2.0, y0);
+
+  // A different fetch is a different entry.
+  output_names = {y_neg_ + ":0"};
+  target_nodes.clear();
+  run(&y0);
+  EXPECT_FLOAT_EQ(-8.0, y0);
+  TF_ASSERT_OK(Env::Default()->GetChildren(cache_dir, &children));
+  EXPECT_EQ(2, children.size());
+
+  // Invalid graphs are still rejected by Create() and Extend().
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  GraphDef unknown_op = def_;
+  unknown_op.mutable_node(0)->set_op("NoSuchOp");
+  EXPECT_FALSE(session->Create(unknown_op).ok());
+  TF_ASSERT_OK(session->Create(def_));
+  Status s = session->Extend(def_);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+  // The rejected graph is not part of the key, so the entry is still used.
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run(inputs, output_names, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_FLOAT_EQ(-8.0, outputs[0].matrix<float>()(0, 0));
+  TF_ASSERT_OK(Env::Default()->GetChildren(cache_dir, &children));
+  EXPECT_EQ(2, children.size());
+}
+
 TEST(DirectSessionTest, KeepsStateAcrossRunsOfSession) {
   GraphDef def;
   Graph g(OpRegistry::Global());
@@ -407,6 +569,63 @@ TEST(DirectSessionTest, MultipleFeedTest) {
   EXPECT_TRUE(StringPiece(s.error_message()).contains("fed more than once"));
 }
 
+REGISTER_OP("ConstructionCounter").Input("x: float").Output("y: float").Doc("");
+
+// The number of ConstructionCounterOp kernels constructed so far.
+std::atomic<int> num_construction_counters(0);
+
+class ConstructionCounterOp : public OpKernel {
+ public:
+  explicit ConstructionCounterOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    ++num_construction_counters;
+  }
+  void Compute(OpKernelContext* ctx) override {
+    ctx->set_output(0, ctx->input(0));
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("ConstructionCounter").Device(DEVICE_CPU),
+                        ConstructionCounterOp);
+
+TEST(DirectSessionTest, StatelessKernelsAreSharedBetweenSignatures) {
+  Graph g(OpRegistry::Global());
+  Tensor vx(DT_FLOAT, TensorShape({}));
+  vx.scalar<float>()() = 3.0;
+  Node* x = test::graph::Constant(&g, vx);
+  Node* y = test::graph::Unary(&g, "ConstructionCounter", x);
+  Node* a = test::graph::Identity(&g, y);
+  Node* b = test::graph::Identity(&g, y);
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  SessionOptions options;
+  // Turn off constant folding, which would create kernels of its own.
+  options.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_opt_level(OptimizerOptions_Level_L0);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  const int num_constructed = num_construction_counters;
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({}, {a->name() + ":0"}, {}, &outputs));
+  EXPECT_EQ(num_constructed + 1, num_construction_counters);
+  TF_ASSERT_OK(session->Run({}, {b->name() + ":0"}, {}, &outputs));
+  EXPECT_EQ(3.0, outputs[0].scalar<float>()());
+
+  // A signature first run after Extend() reuses the kernel too.
+  GraphDef extension;
+  NodeDef* c = extension.add_node();
+  c->set_name("c");
+  c->set_op("Identity");
+  c->add_input(y->name());
+  SetAttrValue(DT_FLOAT, &(*c->mutable_attr())["T"]);
+  TF_ASSERT_OK(session->Extend(extension));
+  TF_ASSERT_OK(session->Run({}, {"c:0"}, {}, &outputs));
+  EXPECT_EQ(3.0, outputs[0].scalar<float>()());
+  EXPECT_EQ(num_constructed + 1, num_construction_counters);
+}
+
 REGISTER_OP("Darth")
     .Input("x: float")
     .Output("y: float")
@@ -23,8 +23,10 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
+#include "tensorflow/core/common_runtime/op_latency_stats.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/trace_recorder.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
@@ -44,19 +46,23 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/gtl/manual_constructor.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/profile_utils/perf_counters.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #include "tensorflow/core/platform/default/tracing_context.h"
 #include "tensorflow/core/kernels/sendrecv_ops.h"
@@ -169,6 +175,28 @@ void SetMemory(NodeExecStats* nt, OpKernelContext* ctx) {
   }
 }
 
+void SetHardwareCounters(NodeExecStats* nt, const int64* start,
+                         const int64* end) {
+  using profile_utils::PerfCounters;
+  auto delta = [start, end](PerfCounters::Counter c) {
+    return start[c] == PerfCounters::UNAVAILABLE ? PerfCounters::UNAVAILABLE
+                                                 : end[c] - start[c];
+  };
+  HardwareCounters* counters = nt->mutable_hardware_counters();
+  counters->set_cycles(delta(PerfCounters::CYCLES));
+  counters->set_instructions(delta(PerfCounters::INSTRUCTIONS));
+  counters->set_llc_misses(delta(PerfCounters::LLC_MISSES));
+  counters->set_branch_misses(delta(PerfCounters::BRANCH_MISSES));
+}
+
+// Drops the executor's references to the tracking allocators of 'ctx'
+// without collecting their statistics.
+void ReleaseMemory(OpKernelContext* ctx) {
+  for (const auto& allocator_pair : ctx->wrapped_allocators()) {
+    allocator_pair.second->GetSizesAndUnRef();
+  }
+}
+
 void SetReferencedTensors(NodeExecStats* nt,
                           const TensorReferenceVector& tensors) {
   // be careful not to increment the reference count on any tensor
@@ -231,6 +259,14 @@ class ExecutorImpl : public Executor {
   }
 
   ~ExecutorImpl() override {
+    if (!latency_cells_.empty()) {
+      OpLatencyStats* latency_stats = OpLatencyStats::Global();
+      for (const Node* n : graph_->nodes()) {
+        if (!n->IsOp()) continue;
+        latency_stats->ReleaseCell(latency_graph_label_, n->name(),
+                                   n->type_string());
+      }
+    }
     for (int i = 0; i < graph_->num_node_ids(); i++) {
       params_.delete_kernel(nodes_[i].kernel);
     }
@@ -271,6 +307,16 @@ class ExecutorImpl : public Executor {
   // A cached value of params_
   bool device_record_tensor_accesses_ = false;
 
+  // Interned names of the nodes and the device, for TraceRecorder events.
+  // Empty if the global TraceRecorder is disabled.
+  std::vector<int32> trace_name_ids_;
+  int32 trace_device_id_ = -1;
+
+  // The OpLatencyStats cells of the nodes, indexed by node id.  Empty if the
+  // global OpLatencyStats is disabled.
+  std::vector<OpLatencyStats::Cell*> latency_cells_;
+  string latency_graph_label_;
+
   // Root nodes (with no in edges) that should form the initial ready queue
   std::vector<const Node*> root_nodes_;
 
@@ -301,9 +347,64 @@ Status ExecutorImpl::Initialize() {
   device_record_tensor_accesses_ =
       params_.device->RequiresRecordingAccessedTensors();
 
-  // Preprocess every node in the graph to create an instance of op
-  // kernel for each node;
+  TraceRecorder* trace_recorder = TraceRecorder::Global();
+  if (trace_recorder->enabled()) {
+    trace_device_id_ = trace_recorder->InternName(params_.device->name());
+    trace_name_ids_.assign(num_nodes, -1);
+    for (const Node* n : graph_->nodes()) {
+      trace_name_ids_[n->id()] = trace_recorder->InternName(n->name());
+    }
+  }
+
+  OpLatencyStats* latency_stats = OpLatencyStats::Global();
+  if (latency_stats->enabled()) {
+    // Graphs have no names, so label them with a fingerprint of their nodes,
+    // which is stable across runs of the same program.
+    uint64 fingerprint = Hash64(params_.device->name());
+    for (const Node* n : graph_->nodes()) {
+      fingerprint = Hash64Combine(fingerprint, Hash64(n->name()));
+      fingerprint = Hash64Combine(fingerprint, Hash64(n->type_string()));
+    }
+    latency_graph_label_ =
+        strings::StrCat(params_.device->name(), "/",
+                        strings::Hex(fingerprint, strings::ZERO_PAD_16));
+    latency_cells_.assign(num_nodes, nullptr);
+    for (const Node* n : graph_->nodes()) {
+      if (!n->IsOp()) continue;
+      latency_cells_[n->id()] = latency_stats->GetCell(
+          latency_graph_label_, n->name(), n->type_string());
+    }
+  }
+
+  // Creating a kernel can be expensive (e.g. ConstantOp parses its tensor),
+  // so the kernels are created first, in parallel if there is a pool.
+  std::vector<const Node*> nodes;
+  nodes.reserve(graph_->num_nodes());
   for (const Node* n : graph_->nodes()) {
+    nodes.push_back(n);
+  }
+  std::vector<Status> kernel_status(nodes.size());
+  auto create_kernels = [this, &nodes, &kernel_status](int64 begin,
+                                                       int64 end) {
+    for (int64 i = begin; i < end; ++i) {
+      const Node* n = nodes[i];
+      kernel_status[i] =
+          params_.create_kernel(n->def(), &nodes_[n->id()].kernel);
+    }
+  };
+  if (params_.thread_pool != nullptr) {
+    // Most kernels take a few microseconds to create, but constants may
+    // take much longer.
+    const int64 kCostPerKernel = 10000;
+    Shard(params_.thread_pool->NumThreads(), params_.thread_pool,
+          nodes.size(), kCostPerKernel, create_kernels);
+  } else {
+    create_kernels(0, nodes.size());
+  }
+
+  // Preprocess every node in the graph.
+  for (size_t node_index = 0; node_index < nodes.size(); ++node_index) {
+    const Node* n = nodes[node_index];
     const int id = n->id();
 
     // See if this node is a root node, and if so, add to root_nodes_
@@ -330,7 +431,7 @@ Status ExecutorImpl::Initialize() {
     item->output_attr_start = total_output_tensors_;
     total_output_tensors_ += n->num_outputs();
 
-    s = params_.create_kernel(n->def(), &item->kernel);
+    s = kernel_status[node_index];
     if (!s.ok()) {
       item->kernel = nullptr;
       s = AttachDef(s, n->def());
@@ -748,6 +849,12 @@ class ExecutorState {
   // Step-local resource manager.
   ResourceMgr* step_resource_manager_;
   StepStatsCollector* stats_collector_;
+  AllocationRecorder* allocation_recorder_;
+  const bool collect_hardware_counters_;
+  // Non-null if this step is sampled for tracing.
+  TraceRecorder* trace_recorder_;
+  // True if the nodes' latencies go to OpLatencyStats.
+  const bool record_latency_;
   // QUESTION: Make it a checkpoint::TensorSliceReaderCacheWrapper
   // instead of a pointer?  (avoids having to delete).
   checkpoint::TensorSliceReaderCacheWrapper* slice_reader_cache_;
@@ -846,6 +953,16 @@ class ExecutorState {
   Status ProcessOutputs(const NodeItem& item, OpKernelContext* ctx,
                         EntryVector* outputs, NodeExecStats* stats);
 
+  // Records in trace_recorder_ that 'item' ran from 'start_usec' to now and
+  // produced 'outputs'.
+  void RecordTraceEvent(const NodeItem& item, bool is_async, uint64 start_usec,
+                        const EntryVector& outputs);
+
+  // Records in OpLatencyStats that 'item', ready since 'scheduled_usec', ran
+  // from 'start_usec' to now.
+  void RecordLatency(const NodeItem& item, int64 scheduled_usec,
+                     uint64 start_usec);
+
   // After processing the outputs, propagates the outputs to their dsts.
   void PropagateOutputs(const TaggedNode& tagged_node,
                         const EntryVector& outputs, TaggedNodeSeq* ready);
@@ -896,6 +1013,13 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
       tensor_store_(args.tensor_store),
       step_resource_manager_(args.step_resource_manager),
       stats_collector_(args.stats_collector),
+      allocation_recorder_(args.allocation_recorder),
+      collect_hardware_counters_(args.collect_hardware_counters),
+      trace_recorder_(!impl->trace_name_ids_.empty() &&
+                              TraceRecorder::Global()->ShouldTrace(step_id_)
+                          ? TraceRecorder::Global()
+                          : nullptr),
+      record_latency_(!impl->latency_cells_.empty()),
       slice_reader_cache_(new checkpoint::TensorSliceReaderCacheWrapper),
       call_frame_(args.call_frame),
       impl_(impl),
@@ -998,7 +1122,8 @@ void ExecutorState::RunAsync(Executor::DoneCallback done) {
 // sync kernels because these vectors are kept on the stack.
 struct ExecutorState::AsyncState {
   AsyncState(const OpKernelContext::Params& p, const TaggedNode& _tagged_node,
-             const NodeItem& _item, Entry* _first_input, NodeExecStats* _stats)
+             const NodeItem& _item, Entry* _first_input, NodeExecStats* _stats,
+             int64 _scheduled_usec)
       : saved_inputs(*p.inputs),
         saved_input_device_contexts(*p.input_device_contexts),
         saved_input_alloc_attrs(*p.input_alloc_attrs),
@@ -1009,7 +1134,9 @@ struct ExecutorState::AsyncState {
         // ParamsButClearingEigenGPUDevice does equivalent of
         //   params.eigen_gpu_device = nullptr;
         ctx(ParamsButClearingEigenGPUDevice(&params), item.num_outputs),
-        stats(_stats) {
+        stats(_stats),
+        scheduled_usec(_scheduled_usec),
+        start_usec(0) {
     params.inputs = &saved_inputs;
     params.input_device_contexts = &saved_input_device_contexts;
     params.input_alloc_attrs = &saved_input_alloc_attrs;
@@ -1024,6 +1151,8 @@ struct ExecutorState::AsyncState {
   Entry* first_input;
   OpKernelContext ctx;
   NodeExecStats* stats;
+  int64 scheduled_usec;
+  uint64 start_usec;
 
  private:
   OpKernelContext::Params* ParamsButClearingEigenGPUDevice(
@@ -1049,8 +1178,11 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
   params.step_id = step_id_;
   Device* device = impl_->params_.device;
   params.device = device;
-  // track allocations if and only if we are collecting statistics
-  params.track_allocations = (stats_collector_ != nullptr);
+  // track allocations if and only if we are collecting statistics or
+  // profiling memory
+  params.track_allocations =
+      (stats_collector_ != nullptr || allocation_recorder_ != nullptr);
+  params.allocation_recorder = allocation_recorder_;
   params.log_memory = log_memory_;
   params.record_tensor_accesses = impl_->device_record_tensor_accesses_;
   params.rendezvous = rendezvous_;
@@ -1081,12 +1213,20 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
     const int id = node->id();
     const NodeItem& item = nodes[id];
 
+    // Building the arguments of the TracingContext calls copies strings for
+    // every input of every node, so skip it unless TF_TRACE_PATH is set.
+    const bool legacy_trace =
+        ::tensorflow::internal::_tracing_context.enabled();
     std::vector<::tensorflow::internal::TracingNode> in_node_id_list;
-    for(Node* n : node->in_nodes()) {
-      in_node_id_list.push_back(::tensorflow::internal::TracingNode(n->id(), n->name(), n->assigned_device_name()));
+    if (legacy_trace) {
+      for (Node* n : node->in_nodes()) {
+        in_node_id_list.push_back(::tensorflow::internal::TracingNode(n->id(), n->name(), n->assigned_device_name()));
+      }
     }
 
-    if (node->IsSend()) {
+    if (!legacy_trace) {
+      // Nothing to record.
+    } else if (node->IsSend()) {
       SendOp* op = dynamic_cast<SendOp*>(item.kernel);
       assert(op != NULL);
       string full_key;
@@ -1179,7 +1319,8 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         DCHECK(async != nullptr);
         launched_asynchronously = true;
         AsyncState* state =
-            new AsyncState(params, tagged_node, item, first_input, stats);
+            new AsyncState(params, tagged_node, item, first_input, stats,
+                           scheduled_usec);
 
         auto done = [this, state]() {
 
@@ -1194,7 +1335,18 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
           if (stats_collector_) nodestats::SetOpEnd(stats);
           EntryVector outputs;
           Status s = ProcessOutputs(state->item, &state->ctx, &outputs, stats);
-          if (stats_collector_) nodestats::SetMemory(stats, &state->ctx);
+          if (stats_collector_) {
+            nodestats::SetMemory(stats, &state->ctx);
+          } else if (allocation_recorder_) {
+            nodestats::ReleaseMemory(&state->ctx);
+          }
+          if (trace_recorder_) {
+            RecordTraceEvent(state->item, true, state->start_usec, outputs);
+          }
+          if (record_latency_) {
+            RecordLatency(state->item, state->scheduled_usec,
+                          state->start_usec);
+          }
           // Clears inputs.
           const int num_inputs = state->item.num_inputs;
           for (int i = 0; i < num_inputs; ++i) {
@@ -1224,7 +1376,9 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
                                                  accessed);
           }
 
-          if (state->tagged_node.node->IsSend()) {
+          if (!::tensorflow::internal::_tracing_context.enabled()) {
+            // Nothing to record.
+          } else if (state->tagged_node.node->IsSend()) {
             ::tensorflow::internal::_tracing_context.RecordSendRecvEnd(state->tagged_node.node->id(), state->params.step_id, state->tagged_node.node->assigned_device_name());
           } else if (state->tagged_node.node->IsRecv()) {
             ::tensorflow::internal::_tracing_context.RecordSendRecvEnd(state->tagged_node.node->id(), state->params.step_id, state->tagged_node.node->assigned_device_name());
@@ -1237,11 +1391,26 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
           if (completed) Finish();
         };
         if (stats_collector_) nodestats::SetOpStart(stats);
+        if (trace_recorder_ || record_latency_) {
+          state->start_usec = nodestats::NowInUsec();
+        }
         device->ComputeAsync(async, &state->ctx, done);
       } else {
         // Synchronous computes.
         OpKernelContext ctx(&params, item.num_outputs);
         if (stats_collector_) nodestats::SetOpStart(stats);
+        const uint64 start_usec =
+            trace_recorder_ || record_latency_ ? nodestats::NowInUsec() : 0;
+        // The counters only see this thread, so asynchronous kernels,
+        // which finish on another one, are not counted.
+        profile_utils::PerfCounters* perf_counters = nullptr;
+        int64 counters_start[profile_utils::PerfCounters::NUM_COUNTERS];
+        if (stats_collector_ && collect_hardware_counters_) {
+          perf_counters = profile_utils::PerfCounters::ForCurrentThread();
+          if (perf_counters && !perf_counters->Read(counters_start)) {
+            perf_counters = nullptr;
+          }
+        }
         device->Compute(CHECK_NOTNULL(op_kernel), &ctx);
         // The final node in the step is always a Sink node. Block
         // this Op from completing until the device has finished all
@@ -1252,15 +1421,30 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         if (node->IsSink() && ctx.status().ok()) {
           ctx.SetStatus(device->Sync());
         }
+        if (perf_counters) {
+          int64 counters_end[profile_utils::PerfCounters::NUM_COUNTERS];
+          if (perf_counters->Read(counters_end)) {
+            nodestats::SetHardwareCounters(stats, counters_start,
+                                           counters_end);
+          }
+        }
         if (stats_collector_) nodestats::SetOpEnd(stats);
 
         s = ProcessOutputs(item, &ctx, &outputs, stats);
+        if (trace_recorder_) {
+          RecordTraceEvent(item, false, start_usec, outputs);
+        }
+        if (record_latency_) RecordLatency(item, scheduled_usec, start_usec);
         if (s.ok() && impl_->device_record_tensor_accesses_) {
           // Get the list of all tensors accessed during the execution
           ctx.retrieve_accessed_tensors(&accessed_tensors);
           device_context = ctx.op_device_context();
         }
-        if (stats_collector_) nodestats::SetMemory(stats, &ctx);
+        if (stats_collector_) {
+          nodestats::SetMemory(stats, &ctx);
+        } else if (allocation_recorder_) {
+          nodestats::ReleaseMemory(&ctx);
+        }
       }
     }
 
@@ -1288,11 +1472,13 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         // device_context is set above in synchronous computes
         device->ConsumeListOfAccessedTensors(device_context, accessed_tensors);
       }
-      if (stats_collector_) {
+      if (stats_collector_ || record_latency_) {
         scheduled_usec = nodestats::NowInUsec();
       }
 
-      if (node->IsSend()) {
+      if (!legacy_trace) {
+        // Nothing to record.
+      } else if (node->IsSend()) {
         ::tensorflow::internal::_tracing_context.RecordSendRecvEnd(id, params.step_id, node->assigned_device_name());
       } else if (node->IsRecv()) {
         ::tensorflow::internal::_tracing_context.RecordSendRecvEnd(id, params.step_id, node->assigned_device_name());
@@ -1385,6 +1571,41 @@ Status ExecutorState::PrepareInputs(const NodeItem& item, Entry* first_input,
   return Status::OK();
 }
 
+void ExecutorState::RecordTraceEvent(const NodeItem& item, bool is_async,
+                                     uint64 start_usec,
+                                     const EntryVector& outputs) {
+  TraceRecorder::Event event;
+  event.step_id = step_id_;
+  event.start_micros = start_usec;
+  event.end_micros = nodestats::NowInUsec();
+  event.output_bytes = 0;
+  for (const Entry& out : outputs) {
+    // Reference outputs are owned by their producer; count values only.
+    if (out.val_field_is_set) {
+      event.output_bytes +=
+          out.val->shape().num_elements() * DataTypeSize(out.val->dtype());
+    }
+  }
+  event.name_id = impl_->trace_name_ids_[item.node->id()];
+  event.device_id = impl_->trace_device_id_;
+  if (item.node->IsRecv()) {
+    event.type = TraceRecorder::kRecv;
+  } else if (is_async) {
+    event.type = TraceRecorder::kAsyncCompute;
+  } else {
+    event.type = TraceRecorder::kCompute;
+  }
+  trace_recorder_->Record(event);
+}
+
+void ExecutorState::RecordLatency(const NodeItem& item, int64 scheduled_usec,
+                                  uint64 start_usec) {
+  OpLatencyStats::Cell* cell = impl_->latency_cells_[item.node->id()];
+  if (cell == nullptr) return;
+  const int64 start = static_cast<int64>(start_usec);
+  cell->Record(start - scheduled_usec, nodestats::NowInUsec() - start);
+}
+
 Status ExecutorState::ProcessOutputs(const NodeItem& item, OpKernelContext* ctx,
                                      EntryVector* outputs,
                                      NodeExecStats* stats) {
@@ -1701,7 +1922,7 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
   if (ready.empty()) return;
 
   int64 scheduled_usec = 0;
-  if (stats_collector_) {
+  if (stats_collector_ || record_latency_) {
     scheduled_usec = nodestats::NowInUsec();
   }
   if (inline_ready == nullptr) {
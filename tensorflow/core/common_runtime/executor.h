@@ -29,6 +29,9 @@ limitations under the License.
 namespace tensorflow {
 
 class StepStatsCollector;
+namespace thread {
+class ThreadPool;
+}  // namespace thread
 
 // Executor runs a graph computation.
 // Example:
@@ -84,6 +87,12 @@ class Executor {
     int64 step_id = 0;
     Rendezvous* rendezvous = nullptr;
     StepStatsCollector* stats_collector = nullptr;
+    // If not null, receives every allocation the kernels of this step
+    // make, attributed to their nodes.
+    AllocationRecorder* allocation_recorder = nullptr;
+    // If true, and stats_collector is not null, hardware performance
+    // counters are recorded for each synchronous kernel.
+    bool collect_hardware_counters = false;
     FunctionCallFrame* call_frame = nullptr;
     CancellationManager* cancellation_manager = nullptr;
     SessionState* session_state = nullptr;
@@ -137,6 +146,11 @@ struct LocalExecutorParams {
   std::function<Status(const NodeDef&, OpKernel**)> create_kernel;
   std::function<void(OpKernel*)> delete_kernel;
 
+  // If not null, the kernels are created in parallel on this pool, so
+  // create_kernel must be thread-safe.  NewLocalExecutor() waits for them,
+  // so it must not be called from this pool.
+  thread::ThreadPool* thread_pool = nullptr;
+
   Executor::Args::NodeOutputsCallback node_outputs_cb;
 };
 ::tensorflow::Status NewLocalExecutor(const LocalExecutorParams& params,
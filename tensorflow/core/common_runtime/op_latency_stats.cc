@@ -0,0 +1,225 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/op_latency_stats.h"
+
+#include <float.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/summary.pb.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+int64 Int64FromEnv(const char* name, int64 default_value) {
+  const char* value = getenv(name);
+  int64 result;
+  if (value == nullptr || !strings::safe_strto64(value, &result)) {
+    return default_value;
+  }
+  return result;
+}
+
+// Buckets growing by 25% from 1us to about 30 minutes: about 100 buckets,
+// against the ~1500 of the default limits, which also cover negative and
+// sub-microsecond values that latencies never take.
+const std::vector<double>& LatencyBucketLimits() {
+  static const std::vector<double>* limits = [] {
+    std::vector<double>* v = new std::vector<double>;
+    for (double limit = 1.0; limit < 2.0e9; limit *= 1.25) {
+      v->push_back(limit);
+    }
+    v->push_back(DBL_MAX);
+    return v;
+  }();
+  return *limits;
+}
+
+// Appends 's' to 'out' as a Prometheus label value.
+void AppendLabelValue(const string& s, string* out) {
+  out->push_back('"');
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out->push_back('\\');
+      out->push_back(c);
+    } else if (c == '\n') {
+      out->append("\\n");
+    } else {
+      out->push_back(c);
+    }
+  }
+  out->push_back('"');
+}
+
+// Appends the samples of the summary 'metric' for 'histo' to 'out'.
+void AppendSummary(const string& metric, const string& labels,
+                   const histogram::Histogram& histo,
+                   const HistogramProto& proto, string* out) {
+  static const double kQuantiles[] = {0.5, 0.9, 0.99};
+  for (double q : kQuantiles) {
+    strings::StrAppend(out, metric, "{", labels, ",quantile=\"", q, "\"} ",
+                       histo.Percentile(q * 100.0), "\n");
+  }
+  strings::StrAppend(out, metric, "_sum{", labels, "} ", proto.sum(), "\n");
+  strings::StrAppend(out, metric, "_count{", labels, "} ", proto.num(), "\n");
+}
+
+}  // namespace
+
+OpLatencyStats::Cell::Cell()
+    : queue_micros_(LatencyBucketLimits()),
+      compute_micros_(LatencyBucketLimits()) {}
+
+void OpLatencyStats::Cell::Record(int64 queue_micros, int64 compute_micros) {
+  mutex_lock l(mu_);
+  queue_micros_.Add(std::max<int64>(0, queue_micros));
+  compute_micros_.Add(std::max<int64>(0, compute_micros));
+}
+
+/* static */
+OpLatencyStats* OpLatencyStats::Global() {
+  static OpLatencyStats* stats = [] {
+    OpLatencyStats* s =
+        new OpLatencyStats(Int64FromEnv("TF_OP_LATENCY_STATS", 0) != 0);
+    const char* filename = getenv("TF_OP_LATENCY_STATS_FILE");
+    if (s->enabled() && filename != nullptr) {
+      s->StartTextDump(filename,
+                       Int64FromEnv("TF_OP_LATENCY_STATS_INTERVAL_SECS", 60));
+    }
+    return s;
+  }();
+  return stats;
+}
+
+OpLatencyStats::OpLatencyStats(bool enabled) : enabled_(enabled) {}
+
+OpLatencyStats::~OpLatencyStats() {
+  {
+    mutex_lock l(dump_mu_);
+    stop_dump_ = true;
+    dump_cv_.notify_all();
+  }
+  // Joins the thread.
+  dump_thread_.reset();
+}
+
+OpLatencyStats::Cell* OpLatencyStats::GetCell(const string& graph,
+                                              const string& node,
+                                              const string& op) {
+  mutex_lock l(mu_);
+  Entry& entry = cells_[Key(graph, node, op)];
+  if (entry.cell == nullptr) entry.cell.reset(new Cell);
+  ++entry.num_users;
+  return entry.cell.get();
+}
+
+void OpLatencyStats::ReleaseCell(const string& graph, const string& node,
+                                 const string& op) {
+  mutex_lock l(mu_);
+  auto it = cells_.find(Key(graph, node, op));
+  CHECK(it != cells_.end()) << "Releasing an unknown cell for " << node;
+  if (--it->second.num_users == 0) cells_.erase(it);
+}
+
+string OpLatencyStats::ExportText() const {
+  string queue_text;
+  string compute_text;
+  mutex_lock l(mu_);
+  for (const auto& it : cells_) {
+    string labels = "graph=";
+    AppendLabelValue(std::get<0>(it.first), &labels);
+    labels.append(",node=");
+    AppendLabelValue(std::get<1>(it.first), &labels);
+    labels.append(",op=");
+    AppendLabelValue(std::get<2>(it.first), &labels);
+
+    const Cell& cell = *it.second.cell;
+    mutex_lock cell_lock(cell.mu_);
+    HistogramProto proto;
+    cell.queue_micros_.EncodeToProto(&proto, false);
+    AppendSummary("tensorflow_op_queue_micros", labels, cell.queue_micros_,
+                  proto, &queue_text);
+    proto.Clear();
+    cell.compute_micros_.EncodeToProto(&proto, false);
+    AppendSummary("tensorflow_op_compute_micros", labels, cell.compute_micros_,
+                  proto, &compute_text);
+  }
+  return strings::StrCat(
+      "# HELP tensorflow_op_queue_micros Time from when a node became ready "
+      "until its kernel started.\n"
+      "# TYPE tensorflow_op_queue_micros summary\n",
+      queue_text,
+      "# HELP tensorflow_op_compute_micros Time a node's kernel ran, until "
+      "its done callback for asynchronous kernels.\n"
+      "# TYPE tensorflow_op_compute_micros summary\n",
+      compute_text);
+}
+
+void OpLatencyStats::EncodeSummary(Summary* summary) const {
+  mutex_lock l(mu_);
+  for (const auto& it : cells_) {
+    const string prefix = strings::StrCat(
+        "op_latency/", std::get<0>(it.first), "/", std::get<1>(it.first), "/");
+    const Cell& cell = *it.second.cell;
+    mutex_lock cell_lock(cell.mu_);
+    Summary::Value* value = summary->add_value();
+    value->set_tag(strings::StrCat(prefix, "queue_micros"));
+    cell.queue_micros_.EncodeToProto(value->mutable_histo(), false);
+    value = summary->add_value();
+    value->set_tag(strings::StrCat(prefix, "compute_micros"));
+    cell.compute_micros_.EncodeToProto(value->mutable_histo(), false);
+  }
+}
+
+void OpLatencyStats::StartTextDump(const string& filename,
+                                   int64 interval_secs) {
+  mutex_lock l(dump_mu_);
+  if (dump_thread_ != nullptr) return;
+  dump_thread_.reset(Env::Default()->StartThread(
+      ThreadOptions(), "op_latency_stats_dump",
+      [this, filename, interval_secs]() {
+        DumpLoop(filename, std::max<int64>(1, interval_secs));
+      }));
+}
+
+void OpLatencyStats::DumpLoop(const string& filename, int64 interval_secs) {
+  Env* env = Env::Default();
+  // Writes to a temporary file first, so that readers never see a partial
+  // dump.
+  const string tmp_filename = strings::StrCat(filename, ".tmp");
+  while (true) {
+    {
+      mutex_lock l(dump_mu_);
+      if (!stop_dump_) {
+        WaitForMilliseconds(&l, &dump_cv_, interval_secs * 1000);
+      }
+      if (stop_dump_) return;
+    }
+    Status s = WriteStringToFile(env, tmp_filename, ExportText());
+    if (s.ok()) s = env->RenameFile(tmp_filename, filename);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to write op latency stats to " << filename
+                   << ": " << s;
+    }
+  }
+}
+
+}  // namespace tensorflow
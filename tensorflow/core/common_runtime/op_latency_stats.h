@@ -0,0 +1,128 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_OP_LATENCY_STATS_H_
+#define TENSORFLOW_COMMON_RUNTIME_OP_LATENCY_STATS_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+
+#include "tensorflow/core/framework/summary.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/histogram/histogram.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// OpLatencyStats keeps, for every (graph, node, op type) executed since the
+// process started, histograms of how long the node waited in the executor's
+// ready queue and how long its kernel ran.  Unlike the cost model, which
+// keeps averages, or StatSummarizer, which looks at individual steps, it is
+// meant to stay enabled in long-running processes so that tail latencies
+// (e.g. the p99 of every op) can be monitored.
+//
+// The executors record into the global instance, which is configured from
+// the environment:
+//   TF_OP_LATENCY_STATS=1                   record the latencies (default 0).
+//   TF_OP_LATENCY_STATS_FILE=path           periodically rewrite 'path' with
+//                                           the output of ExportText().
+//   TF_OP_LATENCY_STATS_INTERVAL_SECS=N     how often to do so (default 60).
+class OpLatencyStats {
+ public:
+  // The histograms of one node.  Owned by OpLatencyStats, and only deleted
+  // once every GetCell() for the node is matched by a ReleaseCell(), so
+  // executors can keep pointers to the cells of their nodes.
+  class Cell {
+   public:
+    // Adds one execution of the node.
+    void Record(int64 queue_micros, int64 compute_micros);
+
+   private:
+    friend class OpLatencyStats;
+    Cell();
+
+    mutable mutex mu_;
+    histogram::Histogram queue_micros_ GUARDED_BY(mu_);
+    histogram::Histogram compute_micros_ GUARDED_BY(mu_);
+
+    TF_DISALLOW_COPY_AND_ASSIGN(Cell);
+  };
+
+  // Returns the instance configured from the environment.
+  static OpLatencyStats* Global();
+
+  explicit OpLatencyStats(bool enabled);
+  ~OpLatencyStats();
+
+  // Returns true if the executors should record latencies.
+  bool enabled() const { return enabled_; }
+
+  // Returns the cell of the given node, creating it if needed.  Takes a
+  // lock, so callers should look up cells ahead of time.
+  Cell* GetCell(const string& graph, const string& node, const string& op);
+
+  // Releases the cell returned by a call to GetCell() with the same
+  // arguments.  When no caller holds it any more, the cell is deleted and
+  // its node no longer exported, so the cells of graphs that are gone do
+  // not accumulate.
+  void ReleaseCell(const string& graph, const string& node, const string& op);
+
+  // Returns the histograms in the Prometheus text exposition format, as
+  // summaries named tensorflow_op_queue_micros and
+  // tensorflow_op_compute_micros with graph, node and op labels.
+  string ExportText() const;
+
+  // Appends to 'summary' one histogram value per node and metric, tagged
+  // "op_latency/<graph>/<node>/{queue,compute}_micros", for writing to an
+  // events file with EventsWriter.
+  void EncodeSummary(Summary* summary) const;
+
+  // Starts a thread that rewrites 'filename' with ExportText() every
+  // 'interval_secs' seconds, until this object is destroyed.  Only the
+  // first call has an effect.
+  void StartTextDump(const string& filename, int64 interval_secs);
+
+ private:
+  typedef std::tuple<string, string, string> Key;  // graph, node, op
+
+  struct Entry {
+    std::unique_ptr<Cell> cell;
+    int64 num_users = 0;  // Calls to GetCell() not yet released.
+  };
+
+  void DumpLoop(const string& filename, int64 interval_secs);
+
+  const bool enabled_;
+
+  mutable mutex mu_;
+  std::map<Key, Entry> cells_ GUARDED_BY(mu_);
+
+  mutex dump_mu_;
+  condition_variable dump_cv_;
+  bool stop_dump_ GUARDED_BY(dump_mu_) = false;
+  std::unique_ptr<Thread> dump_thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(OpLatencyStats);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_OP_LATENCY_STATS_H_
@@ -0,0 +1,108 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/op_latency_stats.h"
+
+#include "tensorflow/core/framework/summary.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(OpLatencyStatsTest, GetCell) {
+  OpLatencyStats stats(true);
+  EXPECT_TRUE(stats.enabled());
+  EXPECT_FALSE(OpLatencyStats(false).enabled());
+
+  OpLatencyStats::Cell* a = stats.GetCell("g", "a", "MatMul");
+  EXPECT_EQ(a, stats.GetCell("g", "a", "MatMul"));
+  EXPECT_NE(a, stats.GetCell("g", "b", "MatMul"));
+  EXPECT_NE(a, stats.GetCell("h", "a", "MatMul"));
+}
+
+TEST(OpLatencyStatsTest, ReleaseCell) {
+  OpLatencyStats stats(true);
+  stats.GetCell("g", "a", "MatMul")->Record(1, 2);
+  stats.GetCell("g", "a", "MatMul");
+  stats.ReleaseCell("g", "a", "MatMul");
+  EXPECT_NE(string::npos, stats.ExportText().find("node=\"a\""));
+  stats.ReleaseCell("g", "a", "MatMul");
+  EXPECT_EQ(string::npos, stats.ExportText().find("node=\"a\""));
+}
+
+TEST(OpLatencyStatsTest, ExportText) {
+  OpLatencyStats stats(true);
+  OpLatencyStats::Cell* cell = stats.GetCell("g", "my\"node", "MatMul");
+  for (int i = 0; i < 100; ++i) {
+    cell->Record(10, 1000);
+  }
+
+  const string text = stats.ExportText();
+  EXPECT_NE(string::npos,
+            text.find("# TYPE tensorflow_op_compute_micros summary\n"));
+  const string labels = "{graph=\"g\",node=\"my\\\"node\",op=\"MatMul\"";
+  EXPECT_NE(string::npos, text.find("tensorflow_op_compute_micros" + labels +
+                                    ",quantile=\"0.99\"} "));
+  EXPECT_NE(string::npos,
+            text.find("tensorflow_op_compute_micros_sum" + labels +
+                      "} 100000\n"));
+  EXPECT_NE(string::npos,
+            text.find("tensorflow_op_queue_micros_count" + labels + "} 100\n"));
+  EXPECT_NE(string::npos,
+            text.find("tensorflow_op_queue_micros_sum" + labels + "} 1000\n"));
+}
+
+TEST(OpLatencyStatsTest, Percentiles) {
+  OpLatencyStats stats(true);
+  OpLatencyStats::Cell* cell = stats.GetCell("g", "n", "Op");
+  for (int i = 1; i <= 1000; ++i) {
+    cell->Record(0, i);
+  }
+  Summary summary;
+  stats.EncodeSummary(&summary);
+  ASSERT_EQ(2, summary.value_size());
+  EXPECT_EQ("op_latency/g/n/queue_micros", summary.value(0).tag());
+  EXPECT_EQ("op_latency/g/n/compute_micros", summary.value(1).tag());
+
+  EXPECT_EQ(1000, summary.value(1).histo().num());
+  histogram::Histogram compute;
+  ASSERT_TRUE(compute.DecodeFromProto(summary.value(1).histo()));
+  // The buckets are 25% wide.
+  EXPECT_NEAR(990, compute.Percentile(99), 250);
+  EXPECT_NEAR(500, compute.Percentile(50), 125);
+}
+
+TEST(OpLatencyStatsTest, TextDump) {
+  const string filename =
+      io::JoinPath(testing::TmpDir(), "op_latency_stats_test.txt");
+  {
+    OpLatencyStats stats(true);
+    stats.GetCell("g", "n", "Op")->Record(1, 2);
+    stats.StartTextDump(filename, 1);
+    while (!Env::Default()->FileExists(filename)) {
+      Env::Default()->SleepForMicroseconds(10000);
+    }
+  }
+  string text;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), filename, &text));
+  EXPECT_NE(string::npos, text.find("tensorflow_op_compute_micros_count{"
+                                    "graph=\"g\",node=\"n\",op=\"Op\"} 1\n"));
+}
+
+}  // namespace
+}  // namespace tensorflow
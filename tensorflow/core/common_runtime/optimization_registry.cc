@@ -44,4 +44,9 @@ Status OptimizationPassRegistry::RunGrouping(
   return Status::OK();
 }
 
+bool OptimizationPassRegistry::HasPasses(Grouping grouping) const {
+  auto group = groups_.find(grouping);
+  return group != groups_.end() && !group->second.empty();
+}
+
 }  // namespace tensorflow
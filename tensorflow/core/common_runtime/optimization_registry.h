@@ -75,6 +75,9 @@ class OptimizationPassRegistry {
   Status RunGrouping(Grouping grouping,
                      const GraphOptimizationPassOptions& options);
 
+  // Returns true if any pass is registered in grouping.
+  bool HasPasses(Grouping grouping) const;
+
   // Returns the global registry of optimization passes.
   static OptimizationPassRegistry* Global();
 
@@ -0,0 +1,227 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/partitioned_graph_cache.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The functions below append a canonical encoding of a proto to 'out'.
+// Strings are length-prefixed so that the encoding is unambiguous, and maps
+// are encoded in key order.  Messages without maps are simply serialized.
+
+void AppendString(const string& s, string* out) {
+  strings::StrAppend(out, s.size(), ":", s);
+}
+
+void AppendSerialized(const protobuf::MessageLite& message, string* out) {
+  string bytes;
+  message.SerializeToString(&bytes);
+  AppendString(bytes, out);
+}
+
+void AppendAttrs(const protobuf::Map<string, AttrValue>& attrs, string* out);
+
+void AppendAttrValue(const AttrValue& value, string* out) {
+  if (value.value_case() == AttrValue::kFunc) {
+    out->append("f");
+    AppendString(value.func().name(), out);
+    AppendAttrs(value.func().attr(), out);
+  } else {
+    out->append("v");
+    AppendSerialized(value, out);
+  }
+}
+
+void AppendAttrs(const protobuf::Map<string, AttrValue>& attrs, string* out) {
+  std::vector<std::pair<const string*, const AttrValue*>> sorted;
+  sorted.reserve(attrs.size());
+  for (const auto& it : attrs) {
+    sorted.emplace_back(&it.first, &it.second);
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const std::pair<const string*, const AttrValue*>& a,
+               const std::pair<const string*, const AttrValue*>& b) {
+              return *a.first < *b.first;
+            });
+  strings::StrAppend(out, sorted.size(), ":");
+  for (const auto& it : sorted) {
+    AppendString(*it.first, out);
+    AppendAttrValue(*it.second, out);
+  }
+}
+
+void AppendNodeDef(const NodeDef& node, string* out) {
+  AppendString(node.name(), out);
+  AppendString(node.op(), out);
+  AppendString(node.device(), out);
+  strings::StrAppend(out, node.input_size(), ":");
+  for (const string& input : node.input()) {
+    AppendString(input, out);
+  }
+  AppendAttrs(node.attr(), out);
+}
+
+void AppendFunctionDef(const FunctionDef& fdef, string* out) {
+  AppendSerialized(fdef.signature(), out);
+  strings::StrAppend(out, fdef.node_size(), ":");
+  for (const FunctionDef::Node& node : fdef.node()) {
+    FunctionDef::Node copy = node;
+    copy.clear_attr();
+    AppendSerialized(copy, out);
+    AppendAttrs(node.attr(), out);
+  }
+  strings::StrAppend(out, fdef.node_def_size(), ":");
+  for (const NodeDef& node : fdef.node_def()) {
+    AppendNodeDef(node, out);
+  }
+  std::vector<std::pair<string, string>> ret(fdef.ret().begin(),
+                                             fdef.ret().end());
+  std::sort(ret.begin(), ret.end());
+  strings::StrAppend(out, ret.size(), ":");
+  for (const auto& it : ret) {
+    AppendString(it.first, out);
+    AppendString(it.second, out);
+  }
+}
+
+string ToHex(const Fprint128& fp) {
+  return strings::StrCat(strings::Hex(fp.high64, strings::ZERO_PAD_16),
+                         strings::Hex(fp.low64, strings::ZERO_PAD_16));
+}
+
+}  // namespace
+
+PartitionedGraphCache::PartitionedGraphCache(Env* env, const string& dir)
+    : env_(env), dir_(dir) {}
+
+/* static */
+string PartitionedGraphCache::FingerprintGraphDef(const GraphDef& def) {
+  string canonical;
+  AppendSerialized(def.versions(), &canonical);
+  strings::StrAppend(&canonical, def.node_size(), ":");
+  for (const NodeDef& node : def.node()) {
+    AppendNodeDef(node, &canonical);
+  }
+  strings::StrAppend(&canonical, def.library().function_size(), ":");
+  for (const FunctionDef& fdef : def.library().function()) {
+    AppendFunctionDef(fdef, &canonical);
+  }
+  strings::StrAppend(&canonical, def.library().gradient_size(), ":");
+  for (const GradientDef& grad : def.library().gradient()) {
+    AppendSerialized(grad, &canonical);
+  }
+  return ToHex(Fingerprint128(canonical));
+}
+
+/* static */
+string PartitionedGraphCache::FingerprintNodeDef(const NodeDef& def) {
+  string canonical;
+  AppendNodeDef(def, &canonical);
+  return ToHex(Fingerprint128(canonical));
+}
+
+/* static */
+string PartitionedGraphCache::Key(const string& graph_fingerprint,
+                                  const ConfigProto& config,
+                                  const std::vector<Device*>& devices,
+                                  const string& signature) {
+  string canonical;
+  // Kernels and graph rewrites may change between versions.
+  AppendString(TF_VERSION_STRING, &canonical);
+  strings::StrAppend(&canonical, TF_GRAPH_DEF_VERSION, ";");
+  AppendString(graph_fingerprint, &canonical);
+
+  // The options that affect placement and graph optimization.
+  GraphOptions graph_options = config.graph_options();
+  graph_options.clear_partitioned_graph_cache_dir();
+  AppendSerialized(graph_options, &canonical);
+  strings::StrAppend(&canonical, config.allow_soft_placement(), ";",
+                     config.device_filters_size(), ":");
+  for (const string& filter : config.device_filters()) {
+    AppendString(filter, &canonical);
+  }
+
+  strings::StrAppend(&canonical, devices.size(), ":");
+  for (const Device* device : devices) {
+    AppendString(device->name(), &canonical);
+    AppendString(device->device_type(), &canonical);
+  }
+  AppendString(signature, &canonical);
+  return ToHex(Fingerprint128(canonical));
+}
+
+string PartitionedGraphCache::FileName(const string& key) const {
+  return io::JoinPath(dir_, strings::StrCat(key, ".pb"));
+}
+
+bool PartitionedGraphCache::Lookup(const string& key,
+                                   PartitionedGraphCacheEntry* entry) const {
+  const string filename = FileName(key);
+  if (!env_->FileExists(filename)) {
+    return false;
+  }
+  Status s = ReadBinaryProto(env_, filename, entry);
+  if (!s.ok()) {
+    LOG(WARNING) << "Ignoring unreadable partitioned graph cache entry "
+                 << filename << ": " << s;
+    entry->Clear();
+    return false;
+  }
+  return true;
+}
+
+Status PartitionedGraphCache::Insert(
+    const string& key, const PartitionedGraphCacheEntry& entry) const {
+  if (!env_->IsDirectory(dir_).ok()) {
+    Status s = env_->RecursivelyCreateDir(dir_);
+    // Another process may have created it concurrently.
+    if (!s.ok() && !env_->IsDirectory(dir_).ok()) {
+      return s;
+    }
+  }
+  const string filename = FileName(key);
+  // Writes to a temporary file first, so that readers never see a partial
+  // entry.
+  const string tmp_filename = strings::StrCat(
+      filename, ".tmp.", strings::Hex(random::New64(), strings::ZERO_PAD_16));
+  Status s = WriteBinaryProto(env_, tmp_filename, entry);
+  if (s.ok()) {
+    s = env_->RenameFile(tmp_filename, filename);
+  }
+  if (!s.ok()) {
+    env_->DeleteFile(tmp_filename);
+  }
+  return s;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,80 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_PARTITIONED_GRAPH_CACHE_H_
+#define TENSORFLOW_COMMON_RUNTIME_PARTITIONED_GRAPH_CACHE_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/partitioned_graph_cache.pb.h"
+
+namespace tensorflow {
+
+class Device;
+
+// PartitionedGraphCache stores, in a directory, the per-device graphs that a
+// session created for a run signature, so that a later session running the
+// same graph on the same devices (typically in a restarted process) can skip
+// placement, partitioning and graph optimization.
+//
+// Entries are files named after their key and are never evicted.  Concurrent
+// writers of the same entry are safe: each writes a temporary file that is
+// then renamed over the entry.
+class PartitionedGraphCache {
+ public:
+  PartitionedGraphCache(Env* env, const string& dir);
+
+  // Returns a fingerprint of 'def'.  Unlike a fingerprint of its
+  // serialization, it does not depend on the iteration order of the attr
+  // maps, so it is the same in every process.
+  static string FingerprintGraphDef(const GraphDef& def);
+
+  // Returns a fingerprint of 'def', with the same properties.
+  static string FingerprintNodeDef(const NodeDef& def);
+
+  // Returns the key of the entry for running 'signature' on 'devices', in a
+  // session configured with 'config' whose graph has the fingerprint
+  // 'graph_fingerprint'.
+  static string Key(const string& graph_fingerprint, const ConfigProto& config,
+                    const std::vector<Device*>& devices,
+                    const string& signature);
+
+  // Returns true and fills in '*entry' if the cache has an entry for 'key'.
+  // Entries that cannot be read are logged and treated as missing.
+  bool Lookup(const string& key, PartitionedGraphCacheEntry* entry) const;
+
+  // Stores 'entry' under 'key', creating the directory if needed.
+  Status Insert(const string& key,
+                const PartitionedGraphCacheEntry& entry) const;
+
+ private:
+  string FileName(const string& key) const;
+
+  Env* const env_;
+  const string dir_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PartitionedGraphCache);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_PARTITIONED_GRAPH_CACHE_H_
@@ -0,0 +1,124 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/partitioned_graph_cache.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+GraphDef MakeGraphDef(bool reverse_attrs, float value) {
+  GraphDef def;
+  NodeDef* node = def.add_node();
+  node->set_name("n");
+  node->set_op("Op");
+  node->add_input("in:1");
+  node->set_device("/cpu:0");
+  std::vector<std::pair<string, AttrValue>> attrs(3);
+  attrs[0].first = "a";
+  SetAttrValue(value, &attrs[0].second);
+  attrs[1].first = "b";
+  SetAttrValue(DT_INT32, &attrs[1].second);
+  attrs[2].first = "c";
+  attrs[2].second.mutable_func()->set_name("f");
+  SetAttrValue(1, &(*attrs[2].second.mutable_func()->mutable_attr())["x"]);
+  if (reverse_attrs) std::reverse(attrs.begin(), attrs.end());
+  for (const auto& attr : attrs) {
+    node->mutable_attr()->insert({attr.first, attr.second});
+  }
+  return def;
+}
+
+TEST(PartitionedGraphCacheTest, FingerprintGraphDef) {
+  const string fp = PartitionedGraphCache::FingerprintGraphDef(
+      MakeGraphDef(false, 1.0));
+  EXPECT_EQ(32, fp.size());
+  EXPECT_EQ(fp, PartitionedGraphCache::FingerprintGraphDef(
+                    MakeGraphDef(true, 1.0)));
+  EXPECT_NE(fp, PartitionedGraphCache::FingerprintGraphDef(
+                    MakeGraphDef(false, 2.0)));
+
+  GraphDef renamed = MakeGraphDef(false, 1.0);
+  renamed.mutable_node(0)->set_name("m");
+  EXPECT_NE(fp, PartitionedGraphCache::FingerprintGraphDef(renamed));
+  GraphDef with_library = MakeGraphDef(false, 1.0);
+  with_library.mutable_library()->add_gradient()->set_function_name("f");
+  EXPECT_NE(fp, PartitionedGraphCache::FingerprintGraphDef(with_library));
+}
+
+TEST(PartitionedGraphCacheTest, FingerprintNodeDef) {
+  const GraphDef def = MakeGraphDef(false, 1.0);
+  const NodeDef& node = def.node(0);
+  const string fp = PartitionedGraphCache::FingerprintNodeDef(node);
+  EXPECT_EQ(32, fp.size());
+  EXPECT_EQ(fp, PartitionedGraphCache::FingerprintNodeDef(
+                    MakeGraphDef(true, 1.0).node(0)));
+  EXPECT_NE(fp, PartitionedGraphCache::FingerprintNodeDef(
+                    MakeGraphDef(false, 2.0).node(0)));
+  NodeDef moved = node;
+  moved.set_device("/cpu:1");
+  EXPECT_NE(fp, PartitionedGraphCache::FingerprintNodeDef(moved));
+}
+
+TEST(PartitionedGraphCacheTest, Key) {
+  ConfigProto config;
+  const std::vector<Device*> devices;
+  const string key =
+      PartitionedGraphCache::Key("graph", config, devices, "a->b");
+  EXPECT_EQ(key, PartitionedGraphCache::Key("graph", config, devices, "a->b"));
+  EXPECT_NE(key, PartitionedGraphCache::Key("graph", config, devices, "a->c"));
+  EXPECT_NE(key, PartitionedGraphCache::Key("other", config, devices, "a->b"));
+
+  // The cache directory itself does not matter.
+  config.mutable_graph_options()->set_partitioned_graph_cache_dir("/tmp");
+  EXPECT_EQ(key, PartitionedGraphCache::Key("graph", config, devices, "a->b"));
+  config.mutable_graph_options()->set_place_pruned_graph(true);
+  EXPECT_NE(key, PartitionedGraphCache::Key("graph", config, devices, "a->b"));
+}
+
+TEST(PartitionedGraphCacheTest, InsertAndLookup) {
+  const string dir =
+      io::JoinPath(testing::TmpDir(), "partitioned_graph_cache_test", "dir");
+  PartitionedGraphCache cache(Env::Default(), dir);
+  PartitionedGraphCacheEntry entry;
+  EXPECT_FALSE(cache.Lookup("key", &entry));
+
+  (*entry.mutable_partitions())["/cpu:0"] = MakeGraphDef(false, 1.0);
+  (*entry.mutable_stateful_placements())["var"] = "/cpu:0";
+  TF_ASSERT_OK(cache.Insert("key", entry));
+
+  PartitionedGraphCacheEntry found;
+  ASSERT_TRUE(cache.Lookup("key", &found));
+  EXPECT_EQ(entry.SerializeAsString(), found.SerializeAsString());
+  EXPECT_FALSE(cache.Lookup("other", &found));
+
+  // Unreadable entries are ignored.
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), io::JoinPath(dir, "bad.pb"),
+                                 "not a proto"));
+  EXPECT_FALSE(cache.Lookup("bad", &found));
+}
+
+}  // namespace
+}  // namespace tensorflow
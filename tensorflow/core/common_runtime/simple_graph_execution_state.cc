@@ -44,6 +44,7 @@ SimpleGraphExecutionState::SimpleGraphExecutionState(
     const SimpleGraphExecutionStateOptions& options)
     : device_set_(options.device_set),
       session_options_(options.session_options),
+      thread_pool_(options.thread_pool),
       costs_(true /*is_global*/),
       flib_def_(
           new FunctionLibraryDefinition(OpRegistry::Global(), func_def_lib)),
@@ -140,11 +141,37 @@ Status SimpleGraphExecutionState::Extend(
   SimpleGraphExecutionStateOptions combined_options;
   combined_options.device_set = device_set_;
   combined_options.session_options = session_options_;
+  combined_options.thread_pool = thread_pool_;
 
   std::unique_ptr<SimpleGraphExecutionState> new_execution_state(
       new SimpleGraphExecutionState(flib_def_->ToProto(), combined_options));
+  GraphDef extension_with_defaults;
+  if (CanExtendIncrementally()) {
+    *extension_with_defaults.mutable_versions() = gdef.versions();
+    extension_with_defaults.mutable_node()->Reserve(gdef.node_size() -
+                                                    old_node_size);
+    for (int i = old_node_size; i < gdef.node_size(); ++i) {
+      *extension_with_defaults.add_node() = gdef.node(i);
+    }
+  }
   TF_RETURN_IF_ERROR(new_execution_state->Create(&gdef));
   new_execution_state->SetStatefulPlacements(GetStatefulPlacements());
+
+  // 7. Start from a copy of the placed graph, if there is one.
+  if (CanExtendIncrementally()) {
+    mutex_lock l(mu_);
+    if (graph_ != nullptr) {
+      // The copied nodes share their OpDefs, which may belong to functions
+      // in flib_def_, so the new state must share flib_def_ too.  Extend()
+      // does not add functions, so both libraries hold the same functions.
+      new_execution_state->flib_def_ = flib_def_;
+      std::unique_ptr<Graph> base(new Graph(flib_def_.get()));
+      CopyGraph(*graph_, base.get());
+      mutex_lock new_l(new_execution_state->mu_);
+      new_execution_state->placed_base_graph_ = std::move(base);
+      new_execution_state->extension_def_.Swap(&extension_with_defaults);
+    }
+  }
   *out = std::move(new_execution_state);
 
   // TODO(mrry): This is likely to be used for non-throughput-sensitive
@@ -174,12 +201,35 @@ void SimpleGraphExecutionState::RestoreStatefulNodes(Graph* graph) {
   }
 }
 
+bool SimpleGraphExecutionState::CanExtendIncrementally() const {
+  // Placing pruned graphs creates a new state per signature, and the
+  // optimization passes around placement would see part of the graph
+  // twice.
+  if (session_options_ &&
+      session_options_->config.graph_options().place_pruned_graph()) {
+    return false;
+  }
+  OptimizationPassRegistry* passes = OptimizationPassRegistry::Global();
+  return !passes->HasPasses(OptimizationPassRegistry::PRE_PLACEMENT) &&
+         !passes->HasPasses(OptimizationPassRegistry::POST_PLACEMENT);
+}
+
 Status SimpleGraphExecutionState::InitBaseGraph(
     const BuildGraphOptions& options) {
-  std::unique_ptr<Graph> new_graph(new Graph(flib_def_.get()));
+  std::unique_ptr<Graph> new_graph;
+  int num_placed_node_ids = 0;
   GraphConstructorOptions opts;
-  TF_RETURN_IF_ERROR(
-      ConvertGraphDefToGraph(opts, original_graph_def_, new_graph.get()));
+  opts.thread_pool = thread_pool_;
+  if (placed_base_graph_ != nullptr) {
+    new_graph = std::move(placed_base_graph_);
+    num_placed_node_ids = new_graph->num_node_ids();
+    TF_RETURN_IF_ERROR(ExtendGraph(opts, extension_def_, new_graph.get()));
+    extension_def_.Clear();
+  } else {
+    new_graph.reset(new Graph(flib_def_.get()));
+    TF_RETURN_IF_ERROR(
+        ConvertGraphDefToGraph(opts, original_graph_def_, new_graph.get()));
+  }
   for (const Node* n : new_graph->nodes()) {
     VLOG(2) << "Mapping " << n->name() << " to " << n->cost_id();
     node_name_to_cost_id_map_[n->name()] = n->cost_id();
@@ -209,6 +259,7 @@ Status SimpleGraphExecutionState::InitBaseGraph(
       OptimizationPassRegistry::PRE_PLACEMENT, optimization_options));
 
   SimplePlacer placer(new_graph.get(), device_set_, session_options_);
+  placer.set_num_placed_node_ids(num_placed_node_ids);
   // TODO(mrry): Consider making the SimplePlacer cancelable.
   TF_RETURN_IF_ERROR(placer.Run());
 
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
@@ -42,6 +43,10 @@ class Timeline;
 struct SimpleGraphExecutionStateOptions {
   const DeviceSet* device_set = nullptr;
   const SessionOptions* session_options = nullptr;
+  // If not null, used to convert large GraphDefs to Graphs in parallel.
+  // BuildGraph() waits for that work, so it must not be called from this
+  // pool.
+  thread::ThreadPool* thread_pool = nullptr;
 };
 
 // A SimpleClientGraph is simply a sub-graph of the full graph as induced by
@@ -101,8 +106,12 @@ class SimpleGraphExecutionState {
   // Otherwise returns an error and does not modify "*out".
   //
   // NOTE(mrry): This method respects the placement of stateful nodes in
-  // in *this, but currently does not transfer any other placement
-  // or cost model information to the new graph.
+  // in *this, but currently does not transfer any cost model information
+  // to the new graph.  If *this has already placed its graph, and no
+  // optimization pass runs around placement, the new state starts from a
+  // copy of the placed graph and only converts the nodes of
+  // "extension_def".  The placer then only places the new nodes, unless
+  // they could change where the others go (see SimplePlacer).
   Status Extend(const GraphDef& extension_def,
                 std::unique_ptr<SimpleGraphExecutionState>* out) const;
 
@@ -166,6 +175,10 @@ class SimpleGraphExecutionState {
   Status InitBaseGraph(const BuildGraphOptions& options)
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Returns true if Extend() may build the new state's graph from this
+  // state's placed graph.
+  bool CanExtendIncrementally() const;
+
   // Map of placed stateful nodes, i.e. nodes for which is_stateful()
   // is true, such as "params" and "queue" nodes.  Once placed these
   // nodes can not be moved to a different device.  Maps node names to
@@ -177,6 +190,7 @@ class SimpleGraphExecutionState {
   GraphDef original_graph_def_;            // Immutable after ctor.
   const DeviceSet* device_set_;            // Not owned
   const SessionOptions* session_options_;  // Not owned
+  thread::ThreadPool* thread_pool_;        // Not owned
 
   CostModel costs_ GUARDED_BY(mu_);
 
@@ -184,12 +198,20 @@ class SimpleGraphExecutionState {
   NodeNameToCostIdMap node_name_to_cost_id_map_;
 
   // 'flib_def_' is initialized from the initial graph def's library,
-  // and may be updated by a graph optimization pass.
-  std::unique_ptr<FunctionLibraryDefinition> flib_def_;
+  // and may be updated by a graph optimization pass.  Shared with the
+  // states extended incrementally from this one, whose graphs hold
+  // OpDefs of its functions.
+  std::shared_ptr<FunctionLibraryDefinition> flib_def_;
 
   // The dataflow graph owned by this object.
   Graph* graph_ GUARDED_BY(mu_);
 
+  // If not null, a copy of the placed graph of the state this one extends,
+  // from which InitBaseGraph() builds graph_ by adding the nodes of
+  // 'extension_def_'.
+  std::unique_ptr<Graph> placed_base_graph_ GUARDED_BY(mu_);
+  GraphDef extension_def_ GUARDED_BY(mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(SimpleGraphExecutionState);
 };
 
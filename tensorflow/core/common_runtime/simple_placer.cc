@@ -122,10 +122,11 @@ void ColocationGroups(const Node& node,
 class ColocationGraph {
  public:
   ColocationGraph(Graph* graph, const DeviceSet* device_set,
-                  const SessionOptions* options)
+                  const SessionOptions* options, int num_placed_node_ids)
       : device_set_(device_set),
         device_types_(device_set->PrioritizedDeviceTypeList()),
-        options_(options) {
+        options_(options),
+        num_placed_node_ids_(num_placed_node_ids) {
     members_.reserve(graph->num_node_ids());
   }
 
@@ -470,6 +471,20 @@ class ColocationGraph {
       return errors::InvalidArgument("Node id was not positive: ", id);
     }
     member->parent = id;
+    if (id < num_placed_node_ids_) {
+      // A previous placement assigned this node, and the new nodes do not
+      // change where it goes (see PlacedNodesAreUnaffected()), so the
+      // kernels of its device need not be looked up again.
+      const Device* assigned_device =
+          device_set_->FindDeviceByName(node.assigned_device_name());
+      if (assigned_device != nullptr &&
+          DeviceNameUtils::ParseFullName(node.assigned_device_name(),
+                                         &member->device_name)) {
+        member->supported_device_types.push_back(
+            DeviceType(assigned_device->attributes().device_type()));
+        return Status::OK();
+      }
+    }
     TF_RETURN_IF_ERROR(SupportedDeviceTypesForNode(
         device_types_, node.def(), &member->supported_device_types));
 
@@ -577,6 +592,8 @@ class ColocationGraph {
   const DeviceSet* device_set_;  // Not owned.
   const std::vector<DeviceType> device_types_;
   const SessionOptions* options_;  // Not owned;
+  // Nodes with smaller ids keep the devices they were assigned.
+  const int num_placed_node_ids_;
 
   // Maps from a colocation group identifier to the 'root' of that
   // colocation group.
@@ -601,6 +618,66 @@ bool IsGeneratorNode(const Node* node) {
          node->out_edges().size() == 1 && !IsRefType(node->output_type(0));
 }
 
+// Returns true if placing 'graph' from scratch would put the nodes whose id
+// is below 'num_placed_node_ids' on the devices they are assigned to, so
+// that only the other, new nodes need to be placed.
+//
+// A new node can move a placed node by joining its colocation group, by
+// taking a reference from it, or by consuming it if it may be a generator
+// (see Heuristic A below).  None of these matter if the placed node is
+// stateful, or shares a colocation group with a placed stateful node,
+// since stateful nodes keep their devices across placements.
+bool PlacedNodesAreUnaffected(const Graph& graph, int num_placed_node_ids) {
+  // Maps the colocation groups of the placed nodes to whether one of their
+  // placed members is stateful.
+  std::unordered_map<string, bool> placed_groups;
+  std::vector<string> groups;
+  for (Node* node : graph.nodes()) {
+    if (!node->IsOp() || node->id() >= num_placed_node_ids) continue;
+    groups.clear();
+    ColocationGroups(*node, &groups);
+    for (const string& group : groups) {
+      placed_groups[group] |= node->op_def().is_stateful();
+    }
+  }
+  auto is_pinned = [&placed_groups](const Node& node) {
+    if (node.op_def().is_stateful()) return true;
+    std::vector<string> node_groups;
+    ColocationGroups(node, &node_groups);
+    for (const string& group : node_groups) {
+      auto it = placed_groups.find(group);
+      if (it != placed_groups.end() && it->second) return true;
+    }
+    return false;
+  };
+
+  for (Node* node : graph.nodes()) {
+    if (!node->IsOp() || node->id() < num_placed_node_ids) continue;
+    groups.clear();
+    ColocationGroups(*node, &groups);
+    for (const string& group : groups) {
+      auto it = placed_groups.find(group);
+      if (it != placed_groups.end() && !it->second) return false;
+    }
+    for (const Edge* edge : node->in_edges()) {
+      const Node* src = edge->src();
+      if (!src->IsOp() || src->id() >= num_placed_node_ids ||
+          is_pinned(*src)) {
+        continue;
+      }
+      if (!edge->IsControlEdge() &&
+          IsRefType(node->input_type(edge->dst_input()))) {
+        return false;
+      }
+      if (src->num_inputs() == 0 && src->num_outputs() == 1 &&
+          !IsRefType(src->output_type(0))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 }  // namespace
 
 SimplePlacer::SimplePlacer(Graph* graph, const DeviceSet* devices,
@@ -619,7 +696,23 @@ Status SimplePlacer::Run() {
     return errors::FailedPrecondition("No devices are registered");
   }
 
-  ColocationGraph colocation_graph(graph_, devices_, options_);
+  int num_placed_node_ids = num_placed_node_ids_;
+  if (num_placed_node_ids > 0 &&
+      !PlacedNodesAreUnaffected(*graph_, num_placed_node_ids)) {
+    // Places the whole graph again, as if it had been created at once.  The
+    // caller has kept the stateful nodes where they were.
+    VLOG(1) << "New nodes affect placed nodes, placing the whole graph";
+    for (Node* node : graph_->nodes()) {
+      if (node->IsOp() && node->id() < num_placed_node_ids &&
+          !node->op_def().is_stateful()) {
+        node->set_assigned_device_name("");
+      }
+    }
+    num_placed_node_ids = 0;
+  }
+
+  ColocationGraph colocation_graph(graph_, devices_, options_,
+                                   num_placed_node_ids);
   Status status;
 
   // 1. First add all of the nodes. Note that steps (1) and (2)
@@ -78,6 +78,21 @@ class SimplePlacer {
   // Run() may be invoked at most once.
   Status Run();
 
+  // Trusts the devices assigned to the nodes whose id is below
+  // 'num_node_ids', which a previous placement of the same graph on the
+  // same devices chose, instead of checking that they have kernels for
+  // them.  This makes placing a graph that was extended with a few nodes
+  // cost little more than placing the new nodes.
+  //
+  // If the new nodes could change where a full placement puts the old
+  // ones, e.g. by joining the colocation group of an old node, the old
+  // nodes are placed again, except for stateful nodes, which the caller
+  // must have assigned to their previous devices.  Either way, the result
+  // is the same as placing the whole graph at once.
+  void set_num_placed_node_ids(int num_node_ids) {
+    num_placed_node_ids_ = num_node_ids;
+  }
+
  private:
   // Returns true if the device type of 'candidate_device_name' is
   // found in 'devices'.
@@ -91,6 +106,7 @@ class SimplePlacer {
   Graph* const graph_;                           // Not owned.
   const DeviceSet* const devices_;               // Not owned.
   const SessionOptions* options_;                // Not owned.
+  int num_placed_node_ids_ = 0;
 
   TF_DISALLOW_COPY_AND_ASSIGN(SimplePlacer);
 };
@@ -413,6 +413,54 @@ TEST_F(SimplePlacerTest, TestAssignedGpuDeviceToCpuDevice) {
                     "does not have registered OpKernel support for TestInput"));
 }
 
+// Test that the devices of nodes placed before are not checked again, and
+// that the other nodes are placed as usual.
+TEST_F(SimplePlacerTest, TestPlacedNodesAreTrusted) {
+  Graph g(OpRegistry::Global());
+  {  // Scope for temporary variables used to construct g.
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    Node* in = ops::SourceOp("TestInput", b.opts().WithName("in"));
+    // The control input gives "new_in" a larger id than "in".
+    ops::SourceOp("TestInput",
+                  b.opts().WithName("new_in").WithControlInput(in));
+    TF_EXPECT_OK(BuildGraph(b, &g));
+  }
+
+  // TestInput has no GPU kernel, so this would fail a full placement.
+  GetNodeByName(g, "in")
+      ->set_assigned_device_name("/job:a/replica:0/task:0/gpu:0");
+
+  SimplePlacer placer(&g, &devices_);
+  placer.set_num_placed_node_ids(GetNodeByName(g, "new_in")->id());
+  TF_EXPECT_OK(placer.Run());
+  EXPECT_EQ("/job:a/replica:0/task:0/gpu:0",
+            GetNodeByName(g, "in")->assigned_device_name());
+  EXPECT_DEVICE_TYPE(g, "new_in", DEVICE_CPU);
+}
+
+// Test that nodes placed before are placed again if a new node joins their
+// colocation group.
+TEST_F(SimplePlacerTest, TestPlacedNodesArePlacedAgainWhenColocated) {
+  Graph g(OpRegistry::Global());
+  {  // Scope for temporary variables used to construct g.
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    Node* in = ops::SourceOp("TestInput", b.opts().WithName("in"));
+    ops::UnaryOp("TestRelu", in, b.opts().WithName("colocated").WithAttr(
+                                     "_class", {"loc:@in"}));
+    TF_EXPECT_OK(BuildGraph(b, &g));
+  }
+
+  // As above, TestInput has no GPU kernel, so a full placement moves "in".
+  GetNodeByName(g, "in")
+      ->set_assigned_device_name("/job:a/replica:0/task:0/gpu:0");
+
+  SimplePlacer placer(&g, &devices_);
+  placer.set_num_placed_node_ids(GetNodeByName(g, "colocated")->id());
+  TF_EXPECT_OK(placer.Run());
+  EXPECT_DEVICE_TYPE(g, "in", DEVICE_CPU);
+  EXPECT_COLOCATED(g, "in", "colocated");
+}
+
 // Test that graphs with reference connections are correctly placed.
 
 // Build a graph containing a Variable op of "variable_op_type" and an
@@ -0,0 +1,134 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_memory_profiler.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+
+namespace tensorflow {
+
+StepMemoryProfiler::StepMemoryProfiler(Env* env) : env_(env) {}
+
+int32 StepMemoryProfiler::Intern(const string& name,
+                                 std::unordered_map<string, int32>* ids,
+                                 std::vector<string>* names) {
+  auto it = ids->emplace(name, names->size());
+  if (it.second) {
+    names->push_back(name);
+  }
+  return it.first->second;
+}
+
+void StepMemoryProfiler::RecordAllocation(const void* ptr, size_t num_bytes,
+                                          const string& allocator_name,
+                                          const string& node_name) {
+  const uint64 micros = env_->NowMicros();
+  mutex_lock l(mu_);
+  if (stopped_) return;
+  Event event;
+  event.micros = micros;
+  event.num_bytes = num_bytes;
+  event.other = -1;
+  event.allocator_id = Intern(allocator_name, &allocator_ids_,
+                              &allocator_names_);
+  event.node_id = Intern(node_name, &node_ids_, &node_names_);
+  event.is_allocation = true;
+  live_[ptr] = events_.size();
+  events_.push_back(event);
+}
+
+void StepMemoryProfiler::RecordDeallocation(const void* ptr) {
+  const uint64 micros = env_->NowMicros();
+  mutex_lock l(mu_);
+  if (stopped_) return;
+  auto it = live_.find(ptr);
+  if (it == live_.end()) return;
+  Event& allocation = events_[it->second];
+  allocation.other = events_.size();
+  Event event;
+  event.micros = micros;
+  event.num_bytes = allocation.num_bytes;
+  event.other = it->second;
+  event.allocator_id = allocation.allocator_id;
+  event.node_id = allocation.node_id;
+  event.is_allocation = false;
+  events_.push_back(event);
+  live_.erase(it);
+}
+
+void StepMemoryProfiler::Stop() {
+  mutex_lock l(mu_);
+  stopped_ = true;
+}
+
+void StepMemoryProfiler::Summarize(StepStats* step_stats) const {
+  mutex_lock l(mu_);
+  const int num_allocators = allocator_names_.size();
+
+  // Replay the events to find the first event at which each allocator
+  // reached its peak.
+  std::vector<int64> in_use(num_allocators, 0);
+  std::vector<int64> peak_bytes(num_allocators, 0);
+  std::vector<int64> peak_index(num_allocators, -1);
+  for (size_t i = 0; i < events_.size(); ++i) {
+    const Event& event = events_[i];
+    const int32 a = event.allocator_id;
+    if (event.is_allocation) {
+      in_use[a] += event.num_bytes;
+      if (in_use[a] > peak_bytes[a]) {
+        peak_bytes[a] = in_use[a];
+        peak_index[a] = i;
+      }
+    } else {
+      in_use[a] -= event.num_bytes;
+    }
+  }
+
+  // The allocations live at the peak are those made at or before it and
+  // freed after it, if at all.
+  std::vector<AllocatorPeakMemory*> peaks(num_allocators);
+  for (int a = 0; a < num_allocators; ++a) {
+    AllocatorPeakMemory* peak = step_stats->add_memory_peak();
+    peak->set_allocator_name(allocator_names_[a]);
+    peak->set_peak_bytes(peak_bytes[a]);
+    if (peak_index[a] >= 0) {
+      peak->set_peak_micros(events_[peak_index[a]].micros);
+    }
+    peaks[a] = peak;
+  }
+  for (size_t i = 0; i < events_.size(); ++i) {
+    const Event& event = events_[i];
+    const int32 a = event.allocator_id;
+    if (!event.is_allocation || static_cast<int64>(i) > peak_index[a] ||
+        (event.other >= 0 && event.other <= peak_index[a])) {
+      continue;
+    }
+    LiveAllocation* live = peaks[a]->add_live();
+    live->set_node_name(node_names_[event.node_id]);
+    live->set_num_bytes(event.num_bytes);
+    live->set_alloc_micros(event.micros);
+  }
+  for (AllocatorPeakMemory* peak : peaks) {
+    std::stable_sort(peak->mutable_live()->begin(),
+                     peak->mutable_live()->end(),
+                     [](const LiveAllocation& a, const LiveAllocation& b) {
+                       return a.num_bytes() > b.num_bytes();
+                     });
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,99 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_STEP_MEMORY_PROFILER_H_
+#define TENSORFLOW_COMMON_RUNTIME_STEP_MEMORY_PROFILER_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/tracking_allocator.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class StepStats;
+
+// StepMemoryProfiler records the allocations and deallocations of one
+// step, with the node that made each allocation and when, and works out
+// which allocations were live when each allocator reached its peak.  It
+// is meant for finding the tensors that dominate the memory of steps that
+// run out of it, so it favours completeness over speed: every event takes
+// a lock and is kept until the profiler is destroyed.
+//
+// Typical use:
+//   StepMemoryProfiler* profiler = new StepMemoryProfiler(Env::Default());
+//   args.allocation_recorder = profiler;
+//   ... run the step ...
+//   profiler->Stop();
+//   profiler->Summarize(run_metadata->mutable_step_stats());
+//   profiler->Unref();
+class StepMemoryProfiler : public AllocationRecorder {
+ public:
+  explicit StepMemoryProfiler(Env* env);
+
+  void RecordAllocation(const void* ptr, size_t num_bytes,
+                        const string& allocator_name,
+                        const string& node_name) override;
+  void RecordDeallocation(const void* ptr) override;
+
+  // Ignores the events that arrive from now on, e.g. the deallocation of
+  // the step's outputs by the client.
+  void Stop();
+
+  // Adds to 'step_stats' the peak of each allocator that was used during
+  // the step, with the allocations live at that peak.
+  void Summarize(StepStats* step_stats) const;
+
+ private:
+  ~StepMemoryProfiler() override {}
+
+  int32 Intern(const string& name,
+               std::unordered_map<string, int32>* ids,
+               std::vector<string>* names) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  struct Event {
+    uint64 micros;
+    int64 num_bytes;
+    // For an allocation, the index of the event that freed it, or -1 if
+    // it was still live when the profiler stopped.  For a deallocation,
+    // the index of the allocation.
+    int64 other;
+    int32 allocator_id;
+    int32 node_id;
+    bool is_allocation;
+  };
+
+  Env* const env_;
+
+  mutable mutex mu_;
+  bool stopped_ GUARDED_BY(mu_) = false;
+  std::vector<Event> events_ GUARDED_BY(mu_);
+  // Maps the live allocations to the index of their event.
+  std::unordered_map<const void*, int64> live_ GUARDED_BY(mu_);
+  std::unordered_map<string, int32> allocator_ids_ GUARDED_BY(mu_);
+  std::vector<string> allocator_names_ GUARDED_BY(mu_);
+  std::unordered_map<string, int32> node_ids_ GUARDED_BY(mu_);
+  std::vector<string> node_names_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepMemoryProfiler);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_STEP_MEMORY_PROFILER_H_
@@ -0,0 +1,105 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_memory_profiler.h"
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(StepMemoryProfilerTest, LiveSetAtPeak) {
+  StepMemoryProfiler* profiler = new StepMemoryProfiler(Env::Default());
+  core::ScopedUnref unref(profiler);
+  char buffers[5];
+
+  // cpu: a(100) b(300) -a c(50) -b d(500) -c e(10) => peak 560 at 'e',
+  // with d, c and e live.  'b' alone would have been 400.
+  profiler->RecordAllocation(&buffers[0], 100, "cpu", "a");
+  profiler->RecordAllocation(&buffers[1], 300, "cpu", "b");
+  profiler->RecordDeallocation(&buffers[0]);
+  profiler->RecordAllocation(&buffers[2], 50, "cpu", "c");
+  profiler->RecordDeallocation(&buffers[1]);
+  profiler->RecordAllocation(&buffers[3], 500, "cpu", "d");
+  // Another allocator reaches its peak independently.
+  profiler->RecordAllocation(&buffers[4], 7, "gpu", "g");
+  profiler->RecordAllocation(&buffers[0], 10, "cpu", "e");
+  profiler->RecordDeallocation(&buffers[2]);
+  profiler->RecordDeallocation(&buffers[4]);
+  profiler->Stop();
+  // Ignored once stopped.
+  profiler->RecordDeallocation(&buffers[3]);
+  profiler->RecordAllocation(&buffers[1], 1000, "cpu", "late");
+
+  StepStats step_stats;
+  profiler->Summarize(&step_stats);
+  ASSERT_EQ(2, step_stats.memory_peak_size());
+
+  const AllocatorPeakMemory& cpu = step_stats.memory_peak(0);
+  EXPECT_EQ("cpu", cpu.allocator_name());
+  EXPECT_EQ(560, cpu.peak_bytes());
+  ASSERT_EQ(3, cpu.live_size());
+  EXPECT_EQ("d", cpu.live(0).node_name());
+  EXPECT_EQ(500, cpu.live(0).num_bytes());
+  EXPECT_EQ("c", cpu.live(1).node_name());
+  EXPECT_EQ("e", cpu.live(2).node_name());
+  EXPECT_EQ(cpu.peak_micros(), cpu.live(2).alloc_micros());
+
+  const AllocatorPeakMemory& gpu = step_stats.memory_peak(1);
+  EXPECT_EQ("gpu", gpu.allocator_name());
+  EXPECT_EQ(7, gpu.peak_bytes());
+  ASSERT_EQ(1, gpu.live_size());
+  EXPECT_EQ("g", gpu.live(0).node_name());
+}
+
+TEST(StepMemoryProfilerTest, Empty) {
+  StepMemoryProfiler* profiler = new StepMemoryProfiler(Env::Default());
+  core::ScopedUnref unref(profiler);
+  StepStats step_stats;
+  profiler->Summarize(&step_stats);
+  EXPECT_EQ(0, step_stats.memory_peak_size());
+}
+
+TEST(StepMemoryProfilerTest, ThroughTrackingAllocator) {
+  StepMemoryProfiler* profiler = new StepMemoryProfiler(Env::Default());
+  core::ScopedUnref unref(profiler);
+  Allocator* a = cpu_allocator();
+  TrackingAllocator* ta = new TrackingAllocator(a, false, profiler, "node");
+
+  void* p1 = ta->AllocateRaw(4, 64);
+  void* p2 = ta->AllocateRaw(4, 32);
+  ta->DeallocateRaw(p1);
+  ta->GetSizesAndUnRef();
+  // The allocator outlives the executor's reference, and so must the
+  // profiler.
+  ta->DeallocateRaw(p2);
+
+  StepStats step_stats;
+  profiler->Summarize(&step_stats);
+  ASSERT_EQ(1, step_stats.memory_peak_size());
+  const AllocatorPeakMemory& peak = step_stats.memory_peak(0);
+  EXPECT_EQ(a->Name(), peak.allocator_name());
+  EXPECT_EQ(96, peak.peak_bytes());
+  ASSERT_EQ(2, peak.live_size());
+  EXPECT_EQ("node", peak.live(0).node_name());
+  EXPECT_EQ(64, peak.live(0).num_bytes());
+  EXPECT_EQ(32, peak.live(1).num_bytes());
+}
+
+}  // namespace
+}  // namespace tensorflow
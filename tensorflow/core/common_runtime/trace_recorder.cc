@@ -0,0 +1,237 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/trace_recorder.h"
+
+#include <stdlib.h>
+#include <algorithm>
+
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+int64 Int64FromEnv(const char* name, int64 default_value) {
+  const char* value = getenv(name);
+  int64 result;
+  if (value == nullptr || !strings::safe_strto64(value, &result)) {
+    return default_value;
+  }
+  return result;
+}
+
+// Appends 's' to 'out' as a JSON string literal.
+void AppendJsonString(StringPiece s, string* out) {
+  out->push_back('"');
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out->push_back('\\');
+      out->push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      strings::Appendf(out, "\\u%04x", c);
+    } else {
+      out->push_back(c);
+    }
+  }
+  out->push_back('"');
+}
+
+const char* EventTypeName(TraceRecorder::EventType type) {
+  switch (type) {
+    case TraceRecorder::kCompute:
+      return "Compute";
+    case TraceRecorder::kAsyncCompute:
+      return "AsyncCompute";
+    case TraceRecorder::kRecv:
+      return "Recv";
+  }
+  return "Unknown";
+}
+
+std::atomic<uint64> next_recorder_id{1};
+
+}  // namespace
+
+/* static */
+TraceRecorder* TraceRecorder::Global() {
+  static TraceRecorder* recorder = [] {
+    TraceRecorder* r =
+        new TraceRecorder(Int64FromEnv("TF_TRACE_SAMPLE_STEPS", 0),
+                          Int64FromEnv("TF_TRACE_BUFFER_EVENTS", 16384));
+    const char* dir = getenv("TF_TRACE_DUMP_DIR");
+    if (dir != nullptr) {
+      r->SetDumpDir(dir, Int64FromEnv("TF_TRACE_SLOW_STEP_MICROS", 0));
+    }
+    return r;
+  }();
+  return recorder;
+}
+
+TraceRecorder::TraceRecorder(int64 sample_every_n_steps,
+                             int events_per_thread)
+    : sample_every_n_steps_(std::max<int64>(0, sample_every_n_steps)),
+      events_per_thread_(std::max(1, events_per_thread)),
+      id_(next_recorder_id.fetch_add(1)) {}
+
+TraceRecorder::~TraceRecorder() {}
+
+int32 TraceRecorder::InternName(StringPiece name) {
+  mutex_lock l(mu_);
+  auto it = name_ids_.emplace(name.ToString(), names_.size());
+  if (it.second) {
+    names_.push_back(name.ToString());
+  }
+  return it.first->second;
+}
+
+TraceRecorder::Ring* TraceRecorder::GetRing() {
+  // Most threads only ever record into the global recorder, so a one-entry
+  // cache avoids the lock on all but the first event of each thread.
+  struct Cache {
+    uint64 recorder_id = 0;
+    Ring* ring = nullptr;
+  };
+  static thread_local Cache cache;
+  if (cache.recorder_id == id_) return cache.ring;
+
+  mutex_lock l(mu_);
+  Ring*& ring = thread_rings_[std::this_thread::get_id()];
+  if (ring == nullptr) {
+    rings_.emplace_back(new Ring(events_per_thread_, rings_.size()));
+    ring = rings_.back().get();
+  }
+  cache.recorder_id = id_;
+  cache.ring = ring;
+  return ring;
+}
+
+void TraceRecorder::Record(const Event& event) {
+  Ring* ring = GetRing();
+  const uint64 i = ring->next.load(std::memory_order_relaxed);
+  Slot* slot = &ring->slots[i % ring->slots.size()];
+  slot->seq.store(2 * i + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot->event = event;
+  slot->seq.store(2 * i + 2, std::memory_order_release);
+  ring->next.store(i + 1, std::memory_order_release);
+}
+
+void TraceRecorder::ExportChromeTrace(int64 step_id, string* json) const {
+  json->clear();
+  json->append("{\"traceEvents\":[");
+  std::vector<bool> device_seen;
+  bool first = true;
+  auto separator = [json, &first]() {
+    if (!first) json->push_back(',');
+    first = false;
+  };
+
+  mutex_lock l(mu_);
+  for (const auto& ring : rings_) {
+    const uint64 size = ring->slots.size();
+    const uint64 end = ring->next.load(std::memory_order_acquire);
+    const uint64 begin = end > size ? end - size : 0;
+    for (uint64 i = begin; i < end; ++i) {
+      const Slot& slot = ring->slots[i % size];
+      const uint64 seq = slot.seq.load(std::memory_order_acquire);
+      const Event event = slot.event;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      // Skip the slot if the writer has reused it since 'end' was read.
+      if (seq != 2 * i + 2 ||
+          slot.seq.load(std::memory_order_relaxed) != seq) {
+        continue;
+      }
+      if (step_id != -1 && event.step_id != step_id) continue;
+      if (event.name_id < 0 || event.device_id < 0 ||
+          static_cast<size_t>(std::max(event.name_id, event.device_id)) >=
+              names_.size()) {
+        continue;
+      }
+
+      if (static_cast<size_t>(event.device_id) >= device_seen.size()) {
+        device_seen.resize(event.device_id + 1);
+      }
+      if (!device_seen[event.device_id]) {
+        device_seen[event.device_id] = true;
+        separator();
+        strings::Appendf(json,
+                         "{\"name\":\"process_name\",\"ph\":\"M\","
+                         "\"pid\":%d,\"args\":{\"name\":",
+                         event.device_id);
+        AppendJsonString(names_[event.device_id], json);
+        json->append("}}");
+      }
+
+      separator();
+      json->append("{\"name\":");
+      AppendJsonString(names_[event.name_id], json);
+      const uint64 duration = event.end_micros > event.start_micros
+                                  ? event.end_micros - event.start_micros
+                                  : 0;
+      strings::Appendf(json,
+                       ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu,"
+                       "\"dur\":%llu,\"pid\":%d,\"tid\":%d,\"args\":{"
+                       "\"step_id\":%lld,\"output_bytes\":%lld}}",
+                       EventTypeName(event.type),
+                       static_cast<unsigned long long>(event.start_micros),
+                       static_cast<unsigned long long>(duration),
+                       event.device_id, ring->tid,
+                       static_cast<long long>(event.step_id),
+                       static_cast<long long>(event.output_bytes));
+    }
+  }
+  json->append("]}");
+}
+
+Status TraceRecorder::WriteChromeTrace(int64 step_id,
+                                       const string& filename) const {
+  string json;
+  ExportChromeTrace(step_id, &json);
+  return WriteStringToFile(Env::Default(), filename, json);
+}
+
+void TraceRecorder::StepDone(int64 step_id, uint64 start_micros,
+                             uint64 end_micros) {
+  string filename;
+  {
+    mutex_lock l(mu_);
+    if (dump_dir_.empty() || end_micros - start_micros < slow_step_micros_) {
+      return;
+    }
+    filename = io::JoinPath(dump_dir_, strings::StrCat("trace_step_", step_id,
+                                                       ".json"));
+  }
+  Status s = WriteChromeTrace(step_id, filename);
+  if (s.ok()) {
+    VLOG(1) << "Wrote trace of step " << step_id << " ("
+            << end_micros - start_micros << "us) to " << filename;
+  } else {
+    LOG(WARNING) << "Failed to write trace of step " << step_id << ": " << s;
+  }
+}
+
+void TraceRecorder::SetDumpDir(const string& dir, uint64 slow_step_micros) {
+  mutex_lock l(mu_);
+  dump_dir_ = dir;
+  slow_step_micros_ = slow_step_micros;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,146 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_TRACE_RECORDER_H_
+#define TENSORFLOW_COMMON_RUNTIME_TRACE_RECORDER_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// TraceRecorder is a cheap, always available recorder of what the executors
+// do in sampled steps, for diagnosing latency outliers in production where
+// running every step with RunOptions::FULL_TRACE would cost too much.
+//
+// Every thread appends fixed-size events to a ring buffer of its own, without
+// taking locks or allocating, so the rings hold the most recent events of
+// each thread.  Their contents can be exported as a Chrome trace (viewable in
+// chrome://tracing), either on demand or, for sampled steps slower than a
+// threshold, automatically.
+//
+// The global recorder is configured from the environment:
+//   TF_TRACE_SAMPLE_STEPS=N       trace steps whose id is a multiple of N
+//                                 (default 0: never).
+//   TF_TRACE_BUFFER_EVENTS=K      events kept per thread (default 16384).
+//   TF_TRACE_DUMP_DIR=dir         write the trace of each sampled step that
+//                                 takes at least TF_TRACE_SLOW_STEP_MICROS
+//                                 (default 0) to dir/trace_step_<id>.json.
+class TraceRecorder {
+ public:
+  enum EventType : uint8 {
+    kCompute = 0,       // A synchronous kernel.
+    kAsyncCompute = 1,  // An asynchronous kernel, until its done callback.
+    kRecv = 2,          // A _Recv kernel, including the rendezvous wait.
+  };
+
+  struct Event {
+    int64 step_id;
+    uint64 start_micros;
+    uint64 end_micros;
+    int64 output_bytes;  // Bytes of the outputs the node produced.
+    int32 name_id;       // Interned node name.
+    int32 device_id;     // Interned device name.
+    EventType type;
+  };
+
+  // Returns the recorder configured from the environment.
+  static TraceRecorder* Global();
+
+  // Traces the steps whose id is a multiple of 'sample_every_n_steps' (none
+  // if it is 0), keeping the last 'events_per_thread' events of each thread.
+  TraceRecorder(int64 sample_every_n_steps, int events_per_thread);
+  ~TraceRecorder();
+
+  // Returns true if any step may be traced.
+  bool enabled() const { return sample_every_n_steps_ > 0; }
+
+  // Returns true if the executors should record the events of 'step_id'.
+  // All the executors of a step, in all processes, make the same choice.
+  bool ShouldTrace(int64 step_id) const {
+    return sample_every_n_steps_ > 0 &&
+           static_cast<uint64>(step_id) % sample_every_n_steps_ == 0;
+  }
+
+  // Returns a small integer identifying 'name' in events.  Takes a lock, so
+  // callers should intern names ahead of time, not while recording.
+  int32 InternName(StringPiece name);
+
+  // Appends 'event' to the calling thread's ring buffer.  Lock-free.
+  void Record(const Event& event);
+
+  // Sets *json to a Chrome trace of the events still in the ring buffers:
+  // those of step 'step_id', or all of them if 'step_id' is -1.
+  void ExportChromeTrace(int64 step_id, string* json) const;
+
+  // Writes the output of ExportChromeTrace() to 'filename'.
+  Status WriteChromeTrace(int64 step_id, const string& filename) const;
+
+  // Called at the end of a traced step that ran from 'start_micros' to
+  // 'end_micros', to write its trace out if it was slow and a dump
+  // directory is set.
+  void StepDone(int64 step_id, uint64 start_micros, uint64 end_micros);
+
+  // Sets the directory StepDone() writes to, and the step duration from
+  // which it does.  An empty 'dir' disables writing.
+  void SetDumpDir(const string& dir, uint64 slow_step_micros);
+
+ private:
+  // A ring buffer written by a single thread.  Each slot carries a sequence
+  // number, odd while the slot is being written, which lets readers detect
+  // and skip events overwritten while they copy them.
+  struct Slot {
+    std::atomic<uint64> seq{0};
+    Event event;
+  };
+  struct Ring {
+    Ring(int size, int tid) : slots(size), tid(tid) {}
+    std::vector<Slot> slots;
+    std::atomic<uint64> next{0};  // Number of events ever written.
+    const int tid;
+  };
+
+  Ring* GetRing();
+
+  const int64 sample_every_n_steps_;
+  const int events_per_thread_;
+  // Distinguishes recorders in the per-thread cache of GetRing().
+  const uint64 id_;
+
+  mutable mutex mu_;
+  std::vector<std::unique_ptr<Ring>> rings_ GUARDED_BY(mu_);
+  std::unordered_map<std::thread::id, Ring*> thread_rings_ GUARDED_BY(mu_);
+  std::unordered_map<string, int32> name_ids_ GUARDED_BY(mu_);
+  std::vector<string> names_ GUARDED_BY(mu_);
+  string dump_dir_ GUARDED_BY(mu_);
+  uint64 slow_step_micros_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(TraceRecorder);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_TRACE_RECORDER_H_
@@ -0,0 +1,155 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/trace_recorder.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TraceRecorder::Event MakeEvent(int64 step_id, int32 name_id, int32 device_id,
+                               uint64 start) {
+  TraceRecorder::Event event;
+  event.step_id = step_id;
+  event.start_micros = start;
+  event.end_micros = start + 10;
+  event.output_bytes = 4;
+  event.name_id = name_id;
+  event.device_id = device_id;
+  event.type = TraceRecorder::kCompute;
+  return event;
+}
+
+int CountOccurrences(const string& json, const string& pattern) {
+  int count = 0;
+  for (size_t pos = json.find(pattern); pos != string::npos;
+       pos = json.find(pattern, pos + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+int CountEvents(const string& json) {
+  return CountOccurrences(json, "\"ph\":\"X\"");
+}
+
+TEST(TraceRecorderTest, Sampling) {
+  TraceRecorder disabled(0, 16);
+  EXPECT_FALSE(disabled.enabled());
+  EXPECT_FALSE(disabled.ShouldTrace(0));
+
+  TraceRecorder recorder(10, 16);
+  EXPECT_TRUE(recorder.enabled());
+  EXPECT_TRUE(recorder.ShouldTrace(0));
+  EXPECT_FALSE(recorder.ShouldTrace(1));
+  EXPECT_TRUE(recorder.ShouldTrace(20));
+}
+
+TEST(TraceRecorderTest, InternName) {
+  TraceRecorder recorder(1, 16);
+  const int32 a = recorder.InternName("a");
+  const int32 b = recorder.InternName("b");
+  EXPECT_NE(a, b);
+  EXPECT_EQ(a, recorder.InternName("a"));
+}
+
+TEST(TraceRecorderTest, ExportChromeTrace) {
+  TraceRecorder recorder(1, 16);
+  const int32 device = recorder.InternName("/job:a/cpu:0");
+  const int32 node = recorder.InternName("my\"node");
+  recorder.Record(MakeEvent(1, node, device, 100));
+  recorder.Record(MakeEvent(2, node, device, 200));
+
+  string json;
+  recorder.ExportChromeTrace(-1, &json);
+  EXPECT_EQ(2, CountEvents(json));
+  EXPECT_NE(string::npos, json.find("\"name\":\"my\\\"node\""));
+  EXPECT_NE(string::npos, json.find("\"ts\":200,\"dur\":10"));
+  EXPECT_NE(string::npos, json.find("\"name\":\"/job:a/cpu:0\""));
+
+  recorder.ExportChromeTrace(2, &json);
+  EXPECT_EQ(1, CountEvents(json));
+  EXPECT_NE(string::npos, json.find("\"step_id\":2"));
+}
+
+TEST(TraceRecorderTest, RingKeepsLatestEvents) {
+  TraceRecorder recorder(1, 4);
+  const int32 device = recorder.InternName("dev");
+  const int32 node = recorder.InternName("node");
+  for (int i = 0; i < 10; ++i) {
+    recorder.Record(MakeEvent(i, node, device, i));
+  }
+  string json;
+  recorder.ExportChromeTrace(-1, &json);
+  EXPECT_EQ(4, CountEvents(json));
+  EXPECT_EQ(string::npos, json.find("\"step_id\":5,"));
+  EXPECT_NE(string::npos, json.find("\"step_id\":6,"));
+  EXPECT_NE(string::npos, json.find("\"step_id\":9,"));
+}
+
+TEST(TraceRecorderTest, ConcurrentWriters) {
+  // A single pool thread may run every writer, so each ring is sized to hold
+  // all the events without wrapping.
+  TraceRecorder recorder(1, 2000);
+  const int32 device = recorder.InternName("dev");
+  const int32 node = recorder.InternName("node");
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 4);
+    for (int t = 0; t < 4; ++t) {
+      pool.Schedule([&recorder, node, device]() {
+        for (int i = 0; i < 500; ++i) {
+          recorder.Record(MakeEvent(7, node, device, i));
+        }
+      });
+    }
+    // Exporting while the writers run must not return torn events.
+    string json;
+    recorder.ExportChromeTrace(7, &json);
+    const int num_events = CountEvents(json);
+    EXPECT_LE(num_events, 2000);
+    EXPECT_EQ(num_events, CountOccurrences(json, "\"step_id\":7,"));
+    EXPECT_EQ(num_events, CountOccurrences(json, ",\"dur\":10,"));
+  }
+  string json;
+  recorder.ExportChromeTrace(7, &json);
+  EXPECT_EQ(2000, CountEvents(json));
+}
+
+TEST(TraceRecorderTest, StepDoneWritesSlowSteps) {
+  TraceRecorder recorder(1, 16);
+  const int32 device = recorder.InternName("dev");
+  const int32 node = recorder.InternName("node");
+  recorder.Record(MakeEvent(3, node, device, 0));
+  recorder.Record(MakeEvent(4, node, device, 0));
+
+  const string dir = testing::TmpDir();
+  recorder.SetDumpDir(dir, 1000);
+  recorder.StepDone(3, 0, 10);
+  recorder.StepDone(4, 0, 5000);
+  Env* env = Env::Default();
+  EXPECT_FALSE(env->FileExists(io::JoinPath(dir, "trace_step_3.json")));
+  string json;
+  TF_ASSERT_OK(ReadFileToString(
+      env, io::JoinPath(dir, "trace_step_4.json"), &json));
+  EXPECT_EQ(1, CountEvents(json));
+}
+
+}  // namespace
+}  // namespace tensorflow
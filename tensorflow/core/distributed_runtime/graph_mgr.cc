@@ -109,6 +109,8 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
   GraphConstructorOptions opts;
   opts.allow_internal_ops = true;
   opts.expect_device_spec = true;
+  // opts.thread_pool is left unset: RegisterGraph itself runs on
+  // compute_pool, which a parallel conversion would wait for.
   TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(opts, gdef, &graph));
 
   // Splits "graph" into multiple subgraphs by device names.
@@ -196,6 +198,7 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
         delete kernel;
       }
     };
+    // params.thread_pool is left unset, as for the graph conversion above.
 
     optimizer.Optimize(lib, worker_env_->env, params.device, &subgraph);
     s = EnsureMemoryTypes(DeviceType(unit->device->device_type()),
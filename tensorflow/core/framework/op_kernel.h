@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_FRAMEWORK_OP_KERNEL_H_
 
 #include <functional>
+#include <memory>
 
 #include <vector>
 #include "tensorflow/core/framework/allocator.h"
@@ -71,6 +72,14 @@ class OpKernel {
   // OpKernel won't be instantiated by the scheduler, so you may perform
   // expensive initialization in the descendant's constructor.
   explicit OpKernel(OpKernelConstruction* context);
+
+  // Specialized constructor that allows a kernel implementation to keep a
+  // smaller NodeDef than the one it was constructed from, e.g. without the
+  // attrs it parsed into its own data structures.  'node_def' must keep the
+  // name, op and the attrs that the op's input and output types refer to.
+  OpKernel(OpKernelConstruction* context,
+           std::unique_ptr<const NodeDef> node_def);
+
   virtual ~OpKernel();
 
   // An OpKernel's computation can be either synchronous or
@@ -106,9 +115,9 @@ class OpKernel {
   virtual bool IsExpensive() { return expensive_; }
 
   // Accessors.
-  const NodeDef& def() const { return def_; }
-  const string& name() const { return def_.name(); }
-  const string& type_string() const { return def_.op(); }
+  const NodeDef& def() const { return *def_; }
+  const string& name() const { return def_->name(); }
+  const string& type_string() const { return def_->op(); }
   bool is_internal() const { return is_internal_; }
 
   int num_inputs() const { return input_types_.size(); }
@@ -150,7 +159,7 @@ class OpKernel {
   }
 
  private:
-  const NodeDef def_;
+  const std::unique_ptr<const NodeDef> def_;
   const DataTypeVector input_types_;
   const MemoryTypeVector input_memory_types_;
   const DataTypeVector output_types_;
@@ -504,6 +513,10 @@ class OpKernelContext {
     bool log_memory = false;
     bool record_tensor_accesses = false;
 
+    // If set, together with track_allocations, receives the allocations
+    // made by this op kernel invocation.  Not owned.
+    AllocationRecorder* allocation_recorder = nullptr;
+
     // Array indexed by output number for this node
     const AllocatorAttributes* output_attr_array = nullptr;
 
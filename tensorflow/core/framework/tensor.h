@@ -435,6 +435,8 @@ class Tensor {
   friend class VariableOp;            // For access to set_shape
   friend class AutoReloadVariableOp;  // For access to set_shape
   friend class TensorTestHelper;      // For access to set_shape
+  friend class StringBytesBuffer;     // For the constructor from a buffer
+  friend class PackedStringBuffer;    // For the constructor from a buffer
 
   // Creates a tensor with the input datatype, shape and buf.
   //
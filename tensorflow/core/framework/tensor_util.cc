@@ -15,11 +15,148 @@ limitations under the License.
 
 #include "tensorflow/core/framework/tensor_util.h"
 
+#include <atomic>
 #include <vector>
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
+
+// A buffer made of bytes that belong to a string of a DT_STRING tensor. It
+// holds a reference to that tensor, which keeps the bytes alive.
+class StringBytesBuffer : public TensorBuffer {
+ public:
+  // Returns a tensor of the given type and shape whose buffer is 'bytes'.
+  static Tensor MakeTensor(const Tensor& owner, StringPiece bytes,
+                           DataType type, const TensorShape& shape) {
+    StringBytesBuffer* buf = new StringBytesBuffer(owner, bytes);
+    Tensor ret(type, shape, buf);
+    buf->Unref();
+    return ret;
+  }
+
+  void* data() const override { return const_cast<char*>(bytes_.data()); }
+  size_t size() const override { return bytes_.size(); }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size());
+    proto->set_allocator_name("string_bytes");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+
+ private:
+  StringBytesBuffer(const Tensor& owner, StringPiece bytes)
+      : owner_(owner), bytes_(bytes) {}
+  ~StringBytesBuffer() override {}
+
+  const Tensor owner_;
+  const StringPiece bytes_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StringBytesBuffer);
+};
+
+// The buffer of a DT_STRING tensor whose elements are stored back to back in
+// one string, with an array of offsets into it.  The array of strings that
+// data() must return is built on the first call, after which the packed
+// form is released; views handed out before then keep it alive.
+class PackedStringBuffer : public TensorBuffer {
+ public:
+  static Tensor MakeTensor(const TensorShape& shape,
+                           std::vector<int64>* offsets, string* bytes) {
+    PackedStringBuffer* buf =
+        new PackedStringBuffer(shape.num_elements(), offsets, bytes);
+    Tensor ret(DT_STRING, shape, buf);
+    buf->Unref();
+    return ret;
+  }
+
+  // Sets *packed to a view of the elements of 't' and returns true if its
+  // buffer is a PackedStringBuffer that has not been converted.
+  static bool Get(const Tensor& t, tensor::PackedStrings* packed) {
+    const PackedStringBuffer* buf =
+        dynamic_cast<const PackedStringBuffer*>(t.buf_);
+    if (buf == nullptr) return false;
+    mutex_lock l(buf->mu_);
+    if (buf->packed_ == nullptr) return false;
+    *packed = tensor::PackedStrings(buf->packed_, buf->packed_->offsets.data(),
+                                    buf->packed_->bytes.data());
+    return true;
+  }
+
+  void* data() const override {
+    if (!converted_.load(std::memory_order_acquire)) Convert();
+    return strings_;
+  }
+  size_t size() const override { return sizeof(string) * num_elements_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    mutex_lock l(mu_);
+    if (packed_ != nullptr) {
+      proto->set_requested_bytes(packed_->bytes.size() +
+                                 sizeof(int64) * packed_->offsets.size());
+    } else {
+      proto->set_requested_bytes(size());
+    }
+    proto->set_allocator_name("packed_string");
+  }
+
+ private:
+  // The packed form, shared with the views handed out by Get().
+  struct Packed : public core::RefCounted {
+    std::vector<int64> offsets;
+    string bytes;
+  };
+
+  PackedStringBuffer(int64 num_elements, std::vector<int64>* offsets,
+                     string* bytes)
+      : num_elements_(num_elements), packed_(new Packed) {
+    CHECK_EQ(num_elements + 1, static_cast<int64>(offsets->size()));
+    CHECK_EQ(0, offsets->front());
+    CHECK_EQ(static_cast<int64>(bytes->size()), offsets->back());
+    packed_->offsets.swap(*offsets);
+    packed_->bytes.swap(*bytes);
+  }
+
+  ~PackedStringBuffer() override {
+    if (packed_ != nullptr) packed_->Unref();
+    if (strings_ != nullptr) {
+      cpu_allocator()->Deallocate<string>(strings_, num_elements_);
+    }
+  }
+
+  // Builds strings_ from the packed form and releases the latter.  Runs once.
+  void Convert() const {
+    mutex_lock l(mu_);
+    if (converted_.load(std::memory_order_relaxed)) return;
+    strings_ = cpu_allocator()->Allocate<string>(num_elements_);
+    CHECK(strings_ != nullptr || num_elements_ == 0);
+    const std::vector<int64>& offsets = packed_->offsets;
+    for (int64 i = 0; i < num_elements_; ++i) {
+      strings_[i].assign(packed_->bytes.data() + offsets[i],
+                         offsets[i + 1] - offsets[i]);
+    }
+    packed_->Unref();
+    packed_ = nullptr;
+    converted_.store(true, std::memory_order_release);
+  }
+
+  const int64 num_elements_;
+
+  mutable mutex mu_;
+  // Null once converted.
+  mutable Packed* packed_ GUARDED_BY(mu_);
+  // Set, under mu_, once strings_ is built.  Read without mu_ by data().
+  mutable std::atomic<bool> converted_{false};
+  mutable string* strings_ = nullptr;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PackedStringBuffer);
+};
+
 namespace tensor {
 
 Tensor DeepCopy(const Tensor& other) {
@@ -142,5 +279,31 @@ std::vector<Tensor> Split(const Tensor& tensor,
   return result;
 }
 
+bool AliasStringBytes(const Tensor& owner, StringPiece bytes, DataType type,
+                      const TensorShape& shape, Tensor* out) {
+  CHECK_EQ(DT_STRING, owner.dtype());
+  if (!DataTypeCanUseMemcpy(type)) return false;
+  if (shape.num_elements() * DataTypeSize(type) !=
+      static_cast<int64>(bytes.size())) {
+    return false;
+  }
+#if EIGEN_ALIGN == 1
+  if (reinterpret_cast<intptr_t>(bytes.data()) % EIGEN_MAX_ALIGN_BYTES != 0) {
+    return false;
+  }
+#endif
+  *out = StringBytesBuffer::MakeTensor(owner, bytes, type, shape);
+  return true;
+}
+
+Tensor MakePackedStringTensor(const TensorShape& shape,
+                              std::vector<int64>* offsets, string* bytes) {
+  return PackedStringBuffer::MakeTensor(shape, offsets, bytes);
+}
+
+bool GetPackedStrings(const Tensor& t, PackedStrings* packed) {
+  return PackedStringBuffer::Get(t, packed);
+}
+
 }  // namespace tensor
 }  // namespace tensorflow
@@ -19,7 +19,12 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 
 #include <vector>
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
 namespace tensorflow {
+
+class PackedStringBuffer;
+
 namespace tensor {
 
 // DeepCopy returns a tensor whose contents are a deep copy of the
@@ -53,6 +58,87 @@ Tensor Concat(const gtl::ArraySlice<Tensor>& tensors);
 std::vector<Tensor> Split(const Tensor& tensor,
                           const gtl::ArraySlice<int64>& sizes);
 
+// Sets *out to a tensor of the given type and shape whose contents are
+// 'bytes', without copying them, and returns true. 'bytes' must lie within
+// one of the strings of 'owner', and *out keeps 'owner's buffer alive for
+// as long as it needs the bytes.
+//
+// Returns false, leaving *out unchanged, if 'bytes' cannot be used as the
+// buffer of such a tensor: if 'type' cannot be memcpy'd, if the size of
+// 'bytes' does not match 'shape', or if 'bytes' is not aligned as tensor
+// buffers must be.
+//
+// REQUIRES: 'owner' must be a DT_STRING tensor stored in CPU memory.
+bool AliasStringBytes(const Tensor& owner, StringPiece bytes, DataType type,
+                      const TensorShape& shape, Tensor* out);
+
+// Returns a DT_STRING tensor of the given shape whose elements are stored
+// back to back in one block of bytes instead of as an array of strings:
+// element i is bytes[(*offsets)[i], (*offsets)[i + 1]).  Takes the contents
+// of '*offsets' and '*bytes', leaving them empty.
+//
+// Building such a tensor costs a couple of allocations however many
+// elements it has.  Kernels that read it with flat<string>() and the like
+// work unchanged: the first such access converts the tensor, once, to the
+// usual array of strings and drops the packed form.  Kernels that know
+// about the packed form can read it with GetPackedStrings() instead, which
+// avoids the conversion as long as every consumer does so.
+//
+// REQUIRES: offsets->size() == shape.num_elements() + 1, (*offsets)[0] == 0,
+// the offsets are non-decreasing and offsets->back() == bytes->size().
+Tensor MakePackedStringTensor(const TensorShape& shape,
+                              std::vector<int64>* offsets, string* bytes);
+
+// A read-only view of the elements of a packed string tensor.  The view
+// holds a reference to the packed bytes, so it stays valid after the tensor
+// is converted to an array of strings or destroyed.
+class PackedStrings {
+ public:
+  PackedStrings() {}
+  PackedStrings(const PackedStrings& other) { *this = other; }
+  ~PackedStrings() { Reset(); }
+
+  PackedStrings& operator=(const PackedStrings& other) {
+    if (other.owner_ != nullptr) other.owner_->Ref();
+    Reset();
+    owner_ = other.owner_;
+    offsets_ = other.offsets_;
+    bytes_ = other.bytes_;
+    return *this;
+  }
+
+  // Returns element 'i' of the tensor, in row-major order.
+  StringPiece operator()(int64 i) const {
+    return StringPiece(bytes_ + offsets_[i], offsets_[i + 1] - offsets_[i]);
+  }
+
+ private:
+  friend class ::tensorflow::PackedStringBuffer;
+
+  // Takes a reference to 'owner', which keeps 'offsets' and 'bytes' alive.
+  PackedStrings(const core::RefCounted* owner, const int64* offsets,
+                const char* bytes)
+      : owner_(owner), offsets_(offsets), bytes_(bytes) {
+    owner_->Ref();
+  }
+
+  void Reset() {
+    if (owner_ != nullptr) owner_->Unref();
+    owner_ = nullptr;
+  }
+
+  const core::RefCounted* owner_ = nullptr;
+  const int64* offsets_ = nullptr;
+  const char* bytes_ = nullptr;
+};
+
+// If 't' was made by MakePackedStringTensor() and has not been converted to
+// an array of strings, sets *packed to a view of its elements and returns
+// true.  Otherwise returns false and the elements should be read with
+// t.flat<string>().  Once a tensor has been converted, no more views of it
+// are handed out.
+bool GetPackedStrings(const Tensor& t, PackedStrings* packed);
+
 }  // namespace tensor
 }  // namespace tensorflow
 
@@ -17,6 +17,8 @@ limitations under the License.
 
 #include <vector>
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -212,5 +214,120 @@ TEST(TensorUtil, ConcatSplitStrings) {
   }
 }
 
+TEST(TensorUtil, AliasStringBytes) {
+  const int kNumFloats = 16;
+  const int kAlign = EIGEN_MAX_ALIGN_BYTES;
+  Tensor y;
+  const char* aliased_bytes;
+  {
+    Tensor x(DT_STRING, TensorShape({}));
+    string& str = x.scalar<string>()();
+    str.resize(kNumFloats * sizeof(float) + 2 * kAlign);
+    // Find an aligned position within the string to put the floats at.
+    const int offset =
+        (kAlign - reinterpret_cast<intptr_t>(str.data()) % kAlign) % kAlign;
+    for (int i = 0; i < kNumFloats; ++i) {
+      const float value = i * 0.5f;
+      memcpy(&str[offset + i * sizeof(float)], &value, sizeof(float));
+    }
+    aliased_bytes = str.data() + offset;
+    const StringPiece bytes(aliased_bytes, kNumFloats * sizeof(float));
+
+    // The size must match the shape, and the type must be memcpy-able.
+    EXPECT_FALSE(tensor::AliasStringBytes(x, bytes, DT_FLOAT,
+                                          TensorShape({kNumFloats + 1}), &y));
+    EXPECT_FALSE(
+        tensor::AliasStringBytes(x, bytes, DT_STRING, TensorShape({1}), &y));
+#if EIGEN_ALIGN == 1
+    // Misaligned bytes cannot be aliased.
+    EXPECT_FALSE(tensor::AliasStringBytes(
+        x, StringPiece(aliased_bytes + 1, bytes.size()), DT_FLOAT,
+        TensorShape({kNumFloats}), &y));
+#endif
+    ASSERT_TRUE(tensor::AliasStringBytes(x, bytes, DT_FLOAT,
+                                         TensorShape({2, kNumFloats / 2}), &y));
+  }
+
+  // y shares the string's bytes and keeps them alive after x is gone.
+  EXPECT_EQ(aliased_bytes, y.tensor_data().data());
+  ASSERT_EQ(TensorShape({2, kNumFloats / 2}), y.shape());
+  for (int i = 0; i < kNumFloats; ++i) {
+    EXPECT_EQ(i * 0.5f, y.flat<float>()(i));
+  }
+}
+
+TEST(TensorUtil, PackedStrings) {
+  std::vector<int64> offsets = {0, 3, 3, 8, 9};
+  string bytes = "abcdefghi";
+  Tensor x = tensor::MakePackedStringTensor(TensorShape({2, 2}), &offsets,
+                                            &bytes);
+  EXPECT_TRUE(offsets.empty());
+  EXPECT_TRUE(bytes.empty());
+  EXPECT_EQ(DT_STRING, x.dtype());
+  EXPECT_EQ(TensorShape({2, 2}), x.shape());
+
+  tensor::PackedStrings packed;
+  ASSERT_TRUE(tensor::GetPackedStrings(x, &packed));
+  EXPECT_EQ("abc", packed(0));
+  EXPECT_EQ("", packed(1));
+  EXPECT_EQ("defgh", packed(2));
+  EXPECT_EQ("i", packed(3));
+
+  // Copies share the packed buffer.
+  Tensor y = x;
+  tensor::PackedStrings packed_y;
+  ASSERT_TRUE(tensor::GetPackedStrings(y, &packed_y));
+  EXPECT_EQ("defgh", packed_y(2));
+
+  // Reading the elements as strings converts the buffer, after which it is
+  // no longer offered as packed, so that writes to the strings are seen.
+  auto x_flat = x.flat<string>();
+  EXPECT_EQ("abc", x_flat(0));
+  EXPECT_EQ("", x_flat(1));
+  EXPECT_EQ("defgh", x_flat(2));
+  EXPECT_EQ("i", x_flat(3));
+  EXPECT_FALSE(tensor::GetPackedStrings(y, &packed_y));
+  y.flat<string>()(1) = "z";
+  EXPECT_EQ("z", x.matrix<string>()(0, 1));
+
+  // Views taken before the conversion still see the original elements, even
+  // once the tensors are gone.
+  x = Tensor();
+  y = Tensor();
+  tensor::PackedStrings copy = packed;
+  packed = tensor::PackedStrings();
+  EXPECT_EQ("", copy(1));
+  EXPECT_EQ("i", copy(3));
+
+  // A tensor that was not packed is not offered as packed.
+  Tensor w(DT_STRING, TensorShape({1}));
+  EXPECT_FALSE(tensor::GetPackedStrings(w, &packed));
+}
+
+TEST(TensorUtil, PackedStringsAsString) {
+  std::vector<int64> offsets = {0, 2, 5};
+  string bytes = "abcde";
+  Tensor x =
+      tensor::MakePackedStringTensor(TensorShape({2}), &offsets, &bytes);
+
+  // Other views of the tensor work as for any string tensor.
+  Tensor row = x.Slice(1, 2);
+  EXPECT_EQ("cde", row.vec<string>()(0));
+  TensorProto proto;
+  x.AsProtoTensorContent(&proto);
+  Tensor z;
+  ASSERT_TRUE(z.FromProto(proto));
+  test::ExpectTensorEqual<string>(x, z);
+}
+
+TEST(TensorUtil, PackedStringsEmpty) {
+  std::vector<int64> offsets = {0};
+  string bytes;
+  Tensor x = tensor::MakePackedStringTensor(TensorShape({0, 3}), &offsets,
+                                            &bytes);
+  EXPECT_EQ(0, x.NumElements());
+  EXPECT_EQ(0, x.flat<string>().size());
+}
+
 }  // namespace
 }  // namespace tensorflow
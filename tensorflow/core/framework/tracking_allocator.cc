@@ -20,13 +20,26 @@ limitations under the License.
 namespace tensorflow {
 
 TrackingAllocator::TrackingAllocator(Allocator* allocator, bool track_sizes)
+    : TrackingAllocator(allocator, track_sizes, nullptr, "") {}
+
+TrackingAllocator::TrackingAllocator(Allocator* allocator, bool track_sizes,
+                                     AllocationRecorder* recorder,
+                                     const string& node_name)
     : allocator_(allocator),
+      recorder_(recorder),
+      node_name_(node_name),
       ref_(1),
       allocated_(0),
       high_watermark_(0),
       total_bytes_(0),
       track_sizes_locally_(track_sizes && !allocator_->TracksAllocationSizes()),
-      next_allocation_id_(0) {}
+      next_allocation_id_(0) {
+  if (recorder_ != nullptr) recorder_->Ref();
+}
+
+TrackingAllocator::~TrackingAllocator() {
+  if (recorder_ != nullptr) recorder_->Unref();
+}
 
 void* TrackingAllocator::AllocateRaw(
     size_t alignment, size_t num_bytes,
@@ -37,6 +50,10 @@ void* TrackingAllocator::AllocateRaw(
   if (nullptr == ptr) {
     return ptr;
   }
+  if (recorder_ != nullptr) {
+    recorder_->RecordAllocation(ptr, num_bytes, allocator_->Name(),
+                                node_name_);
+  }
   if (allocator_->TracksAllocationSizes()) {
     size_t allocated_bytes = allocator_->AllocatedSize(ptr);
     {
@@ -89,6 +106,9 @@ void TrackingAllocator::DeallocateRaw(void* ptr) {
       in_use_.erase(itr);
     }
   }
+  if (recorder_ != nullptr) {
+    recorder_->RecordDeallocation(ptr);
+  }
   Allocator* allocator = allocator_;
   {
     mutex_lock lock(mu_);
@@ -25,6 +25,23 @@ limitations under the License.
 
 namespace tensorflow {
 
+// AllocationRecorder receives every allocation and deallocation made
+// through the TrackingAllocators that share it, attributed to the node
+// that made the allocation.  It is reference counted since deallocations
+// can arrive long after the step, e.g. when an output tensor is freed.
+class AllocationRecorder : public core::RefCounted {
+ public:
+  // Called after 'ptr' has been allocated by 'allocator_name' on
+  // behalf of node 'node_name'.
+  virtual void RecordAllocation(const void* ptr, size_t num_bytes,
+                                const string& allocator_name,
+                                const string& node_name) = 0;
+
+  // Called before 'ptr', previously passed to RecordAllocation, is
+  // returned to the underlying allocator.
+  virtual void RecordDeallocation(const void* ptr) = 0;
+};
+
 // TrackingAllocator is a wrapper for an Allocator. It keeps a running
 // count of the number of bytes allocated through the wrapper. It is
 // used by the Executor to "charge" allocations to particular Op
@@ -45,6 +62,11 @@ namespace tensorflow {
 class TrackingAllocator : public Allocator {
  public:
   explicit TrackingAllocator(Allocator* allocator, bool track_ids);
+  // As above, and additionally reports the allocations made through the
+  // wrapper to 'recorder', on behalf of node 'node_name'.  Takes a
+  // reference on 'recorder', which may be null.
+  TrackingAllocator(Allocator* allocator, bool track_ids,
+                    AllocationRecorder* recorder, const string& node_name);
   string Name() override { return allocator_->Name(); }
   void* AllocateRaw(size_t alignment, size_t num_bytes) override {
     return AllocateRaw(alignment, num_bytes, AllocationAttributes());
@@ -74,10 +96,12 @@ class TrackingAllocator : public Allocator {
   std::pair<size_t, size_t> GetSizesAndUnRef();
 
  private:
-  ~TrackingAllocator() override {}
+  ~TrackingAllocator() override;
   bool UnRef() EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   Allocator* allocator_;  // not owned.
+  AllocationRecorder* const recorder_;  // may be null.
+  const string node_name_;
   mutex mu_;
   // the number of calls to AllocateRaw that have not yet been matched
   // by a corresponding call to DeAllocateRaw, plus 1 if the Executor
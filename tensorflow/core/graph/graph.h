@@ -155,6 +155,9 @@ class Node {
    public:
     Properties(const OpDef* op_def, const NodeDef& node_def,
                const DataTypeSlice inputs, const DataTypeSlice outputs);
+    // Takes the contents of *node_def instead of copying them.
+    Properties(const OpDef* op_def, NodeDef* node_def,
+               const DataTypeSlice inputs, const DataTypeSlice outputs);
 
     const OpDef* op_def_;  // not owned
     NodeDef node_def_;
@@ -274,6 +277,13 @@ class Graph {
   // Returns nullptr and sets *status on error.
   Node* AddNode(const NodeDef& node_def, Status* status);
 
+  // Like AddNode() above, for callers that already looked up the OpDef of
+  // *node_def and computed its input and output types with
+  // InOutTypesForNode(), e.g. for many nodes in parallel.  Takes the
+  // contents of *node_def instead of copying them.
+  Node* AddNode(const OpDef* op_def, NodeDef* node_def,
+                const DataTypeSlice inputs, const DataTypeSlice outputs);
+
   // Copies *node, which may belong to another graph, to a new node,
   // which is returned.  Does not copy any edges.  *this owns the
   // returned instance.
@@ -24,16 +24,19 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/shape_refiner.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op_def_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/versions.h"
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/scanner.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -58,17 +61,22 @@ class GraphConstructor {
     Options(const GraphConstructorOptions& in)
         : allow_internal_ops(in.allow_internal_ops),
           expect_device_spec(in.expect_device_spec),
-          importing(false) {}
+          thread_pool(in.thread_pool),
+          importing(false),
+          extending(false) {}
     Options(const ImportGraphDefOptions& in)
         : allow_internal_ops(false),
           expect_device_spec(false),
           prefix(in.prefix.empty() || StringPiece(in.prefix).ends_with("/")
                      ? in.prefix
                      : in.prefix + "/"),
-          importing(true) {}
+          thread_pool(in.thread_pool),
+          importing(true),
+          extending(false) {}
 
     bool allow_internal_ops;
     bool expect_device_spec;
+    thread::ThreadPool* thread_pool;
 
     string prefix;
     // TODO(ashankar): This bool exists to separate out functionality required
@@ -80,6 +88,9 @@ class GraphConstructor {
     // applicable to ConvertGraphDefToGraph as well, so make an attempt to
     // remove this.
     bool importing;
+
+    // True if the nodes already in the graph may be inputs of the new ones.
+    bool extending;
   };
 
   static Status Construct(const Options& opts, const GraphDef* gdef, Graph* g,
@@ -106,6 +117,7 @@ class GraphConstructor {
     TF_RETURN_IF_ERROR(EnsureNoNameCollisions());
     TF_RETURN_IF_ERROR(BuildNodeIndex());
     TF_RETURN_IF_ERROR(InitFromEdges());
+    PrepareNodes();
     TF_RETURN_IF_ERROR(Convert());
     TF_RETURN_IF_ERROR(AddBackEdges());
     TF_RETURN_IF_ERROR(UpdateVersionDef());
@@ -116,6 +128,7 @@ class GraphConstructor {
   Status EnsureNoNameCollisions();
   Status BuildNodeIndex();
   Status InitFromEdges();
+  void PrepareNodes();
   Status Convert();
   Status AddBackEdges();
   Status UpdateVersionDef();
@@ -123,11 +136,11 @@ class GraphConstructor {
   void Undo();
 
   Status ValidateColocationConstraints(const NodeDef& node_def);
-  Status MakeNode(const NodeDef& node_def, Node** node);
+  void PrepareNode(int gdef_index);
+  Status MakeNode(int gdef_index, Node** node);
   Status MakeEdge(Node* src, int output_index, Node* dst, int input_index);
   Status ValidateShape(Node* node);
-  Status ModifyNodeDefForImport(NodeDef* node_def);
-  void AddPrefixToNodeDef(NodeDef* node_def);
+  void AddPrefixToNodeDef(NodeDef* node_def) const;
 
   // From constructor
   const Options opts_;
@@ -137,7 +150,8 @@ class GraphConstructor {
 
   ShapeRefiner* refiner_;
 
-  // Mapping from node name to the index within gdef_
+  // Mapping from node name to the index within gdef_, or -1 for the nodes
+  // that were in g_ before, when extending it.
   struct NodeInfo {
     explicit NodeInfo(int i) : gdef_index(i), node(nullptr) {}
     // std::unordered_map<> requires that we have a default constructor.
@@ -160,6 +174,26 @@ class GraphConstructor {
   // all nodes it outputs to.
   std::vector<gtl::InlinedVector<int, 4>> outputs_;
 
+  // The OpDef of each op type in gdef_, looked up once per type rather than
+  // once per node, or the error looking it up.
+  struct OpInfo {
+    const OpDef* op_def = nullptr;
+    Status status;
+  };
+  std::unordered_map<StringPiece, OpInfo, StringPiece::Hasher> op_index_;
+
+  // Everything about the NodeDef at the same index within gdef_ that does
+  // not depend on other nodes, computed by PrepareNodes() before the nodes
+  // are added to g_ in topological order.
+  struct PreparedNode {
+    Status status;
+    const OpDef* op_def = nullptr;
+    NodeDef node_def;  // Moved into the node by MakeNode().
+    DataTypeVector input_types;
+    DataTypeVector output_types;
+  };
+  std::vector<PreparedNode> prepared_;
+
   // Used in the conversion from gdef_ to g_ to represent the ith input
   // of a node.
   struct InputInfo {
@@ -219,6 +253,12 @@ Status GraphConstructor::EnsureNoNameCollisions() {
 }
 
 Status GraphConstructor::BuildNodeIndex() {
+  if (opts_.extending) {
+    for (Node* n : g_->nodes()) {
+      if (!n->IsOp()) continue;
+      name_index_[n->name()].node = n;
+    }
+  }
   // Validate the node names and add them to name_index_.
   for (int n = 0; n < gdef_->node_size(); ++n) {
     const NodeDef& node_def(gdef_->node(n));
@@ -281,6 +321,13 @@ Status GraphConstructor::InitFromEdges() {
                                        "': Unknown input node '",
                                        node_def.input(i), "'");
       }
+      if (iter->second.gdef_index < 0) {
+        // The input is already in the graph, as if it had been converted.
+        if (--pending_count_[n] == 0) {
+          ready_.push_back(n);
+        }
+        continue;
+      }
       outputs_[iter->second.gdef_index].push_back(n);
     }
   }
@@ -304,13 +351,68 @@ Status GraphConstructor::ValidateColocationConstraints(
   return Status::OK();
 }
 
-Status GraphConstructor::MakeNode(const NodeDef& node_def, Node** node) {
+void GraphConstructor::PrepareNodes() {
+  const int num_nodes = gdef_->node_size();
+  for (int n = 0; n < num_nodes; ++n) {
+    const string& op = gdef_->node(n).op();
+    if (op_index_.count(op) > 0) continue;
+    OpInfo& info = op_index_[op];
+    info.status = g_->op_registry()->LookUpOpDef(op, &info.op_def);
+    if (info.status.ok() && opts_.importing) {
+      info.status = CheckOpDeprecation(*info.op_def, TF_GRAPH_DEF_VERSION);
+    }
+  }
+
+  prepared_.resize(num_nodes);
+  auto prepare = [this](int64 begin, int64 end) {
+    for (int64 n = begin; n < end; ++n) {
+      PrepareNode(n);
+    }
+  };
+  if (opts_.thread_pool != nullptr) {
+    // Copying and validating a typical NodeDef takes about a microsecond.
+    const int64 kCostPerNode = 1000;
+    Shard(opts_.thread_pool->NumThreads(), opts_.thread_pool, num_nodes,
+          kCostPerNode, prepare);
+  } else {
+    prepare(0, num_nodes);
+  }
+}
+
+void GraphConstructor::PrepareNode(int gdef_index) {
+  PreparedNode* p = &prepared_[gdef_index];
+  const NodeDef& node_def = gdef_->node(gdef_index);
+  const OpInfo& info = op_index_.find(node_def.op())->second;
+  if (!info.status.ok()) {
+    p->status = info.status;
+    return;
+  }
+  p->op_def = info.op_def;
+  // TODO(ashankar): This copies the NodeDef, which can be expensive if it
+  // contains large tensors.  Might make sense to change the API to take a
+  // mutable GraphDef* and avoid the copying.
+  p->node_def = node_def;
+  if (opts_.importing) {
+    AddPrefixToNodeDef(&p->node_def);
+    AddDefaultsToNodeDef(*p->op_def, &p->node_def);
+    p->status = ValidateNodeDef(p->node_def, *p->op_def);
+    if (!p->status.ok()) return;
+  }
+  p->status = InOutTypesForNode(p->node_def, *p->op_def, &p->input_types,
+                                &p->output_types);
+  if (!p->status.ok()) {
+    p->status = AttachDef(p->status, p->node_def);
+  }
+}
+
+Status GraphConstructor::MakeNode(int gdef_index, Node** node) {
+  PreparedNode* p = &prepared_[gdef_index];
+  TF_RETURN_IF_ERROR(p->status);
   // Add the node to the graph.
-  Status status;
-  *node = g_->AddNode(node_def, &status);
-  if (!status.ok()) return status;
+  *node = g_->AddNode(p->op_def, &p->node_def, p->input_types,
+                      p->output_types);
   if (opts_.expect_device_spec) {
-    (*node)->set_assigned_device_name(node_def.device());
+    (*node)->set_assigned_device_name((*node)->def().device());
   }
   return Status::OK();
 }
@@ -395,16 +497,7 @@ Status GraphConstructor::ValidateShape(Node* node) {
   return Status::OK();
 }
 
-Status GraphConstructor::ModifyNodeDefForImport(NodeDef* node_def) {
-  const OpDef* op_def;
-  TF_RETURN_IF_ERROR(g_->op_registry()->LookUpOpDef(node_def->op(), &op_def));
-  AddDefaultsToNodeDef(*op_def, node_def);
-  TF_RETURN_IF_ERROR(ValidateNodeDef(*node_def, *op_def));
-  TF_RETURN_IF_ERROR(CheckOpDeprecation(*op_def, TF_GRAPH_DEF_VERSION));
-  return Status::OK();
-}
-
-void GraphConstructor::AddPrefixToNodeDef(NodeDef* node_def) {
+void GraphConstructor::AddPrefixToNodeDef(NodeDef* node_def) const {
   const string& prefix = opts_.prefix;
   if (prefix.empty()) return;
   node_def->set_name(strings::StrCat(prefix, node_def->name()));
@@ -483,18 +576,7 @@ Status GraphConstructor::Convert() {
     }
 
     Node* node;
-    if (opts_.importing) {
-      // TODO(ashankar): The line below means an additional copy of the NodeDef,
-      // which can be expensive if the NodeDef contains large tensors in it.
-      // Might make sense to change the API for ImportGraphDef to take a mutable
-      // GraphDef* and avoid the copying.
-      NodeDef imported_node_def = node_def;
-      AddPrefixToNodeDef(&imported_node_def);
-      TF_RETURN_IF_ERROR(ModifyNodeDefForImport(&imported_node_def));
-      TF_RETURN_IF_ERROR(MakeNode(imported_node_def, &node));
-    } else {
-      TF_RETURN_IF_ERROR(MakeNode(node_def, &node));
-    }
+    TF_RETURN_IF_ERROR(MakeNode(o, &node));
     name_index_[node_def.name()].node = node;
 
     // Add edges from inputs to *node to the graph.
@@ -572,7 +654,7 @@ Status GraphConstructor::UpdateVersionDef() {
 
 void GraphConstructor::Undo() {
   for (const auto& iter : name_index_) {
-    if (iter.second.node != nullptr) {
+    if (iter.second.gdef_index >= 0 && iter.second.node != nullptr) {
       g_->RemoveNode(iter.second.node);
     }
   }
@@ -601,6 +683,14 @@ Status ConvertGraphDefToGraph(const GraphConstructorOptions& opts,
   return GraphConstructor::Construct(opts, &gdef, g, &refiner);
 }
 
+Status ExtendGraph(const GraphConstructorOptions& opts, const GraphDef& gdef,
+                   Graph* g) {
+  ShapeRefiner refiner(g->op_registry());
+  GraphConstructor::Options extend_opts(opts);
+  extend_opts.extending = true;
+  return GraphConstructor::Construct(extend_opts, &gdef, g, &refiner);
+}
+
 Status ImportGraphDef(const ImportGraphDefOptions& opts, const GraphDef& gdef,
                       Graph* g, ShapeRefiner* refiner) {
   ShapeRefiner default_refiner(g->op_registry());
@@ -22,6 +22,9 @@ limitations under the License.
 
 namespace tensorflow {
 class ShapeRefiner;
+namespace thread {
+class ThreadPool;
+}  // namespace thread
 
 // Options specific to constant folding optimizations.
 //
@@ -50,10 +53,25 @@ struct GraphConstructorOptions {
   //
   // TODO(zhifengc): if possible, consider removing this option.
   bool expect_device_spec = false;
+
+  // If not null, the NodeDefs are validated and converted to nodes in
+  // parallel on this pool.  Only the edges are added sequentially.  The
+  // conversion waits for that work, so it must not run on this pool.
+  thread::ThreadPool* thread_pool = nullptr;
 };
 extern Status ConvertGraphDefToGraph(const GraphConstructorOptions& opts,
                                      const GraphDef& gdef, Graph* g);
 
+// Adds the nodes of gdef to *g, which may already contain nodes, as
+// ConvertGraphDefToGraph would have converted a GraphDef holding the nodes
+// of *g as well as those of gdef: the nodes of gdef may have nodes of *g as
+// inputs.  The nodes already in *g are not modified, which lets callers
+// extend a graph without converting it again.
+//
+// On error, returns non-OK and leaves *g unmodified.
+extern Status ExtendGraph(const GraphConstructorOptions& opts,
+                          const GraphDef& gdef, Graph* g);
+
 // Add the graph in GraphDef gdef into an existing Graph *g.
 //
 // On error, returns non-OK and leaves *g unmodified.
@@ -73,6 +91,11 @@ struct ImportGraphDefOptions {
   // named "animals/bunny" in *g.
   string prefix;
 
+  // If not null, the NodeDefs are validated and converted to nodes in
+  // parallel on this pool.  Shapes are still inferred sequentially.  The
+  // import waits for that work, so it must not run on this pool.
+  thread::ThreadPool* thread_pool = nullptr;
+
   // TODO(ashankar): Enable node rebinding (in Python's import_graph_def
   // this is achieved by providing an input_map).
   //
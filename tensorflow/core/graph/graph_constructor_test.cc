@@ -15,19 +15,25 @@ limitations under the License.
 
 #include "tensorflow/core/graph/graph_constructor.h"
 
+#include <memory>
 #include <vector>
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/shape_inference.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/version.h"
 
 // TODO(josh11b): Test InitCostModel().
@@ -1030,6 +1036,106 @@ TEST_F(GraphConstructorTest, ImportGraphDef_ErrorsDoNoChangeTheGraph) {
 #undef EXPECT_IMPORT_FAILURE
 }
 
+TEST_F(GraphConstructorTest, ExtendGraph) {
+  ExpectOK(
+      "node { name: 'W1' op: 'TestParams' }"
+      "node { name: 'input' op: 'TestInput' }"
+      "node { name: 't1' op: 'TestMul' input: [ 'W1', 'input:1' ] }");
+  const int num_nodes = graph_.num_nodes();
+  Node* t1 = FindNode("t1");
+
+  GraphDef extension;
+  CHECK(protobuf::TextFormat::ParseFromString(
+      "node { name: 't2' op: 'TestMul' input: [ 't1', 'input:0' ] }"
+      "node { name: 't3' op: 'TestMul' input: [ 't2', 't1' ] "
+      "       input: '^W1' }",
+      &extension));
+  TF_EXPECT_OK(ExtendGraph(GraphConstructorOptions(), extension, &graph_));
+  EXPECT_EQ(num_nodes + 2, graph_.num_nodes());
+  EXPECT_EQ(t1, FindNode("t1"));
+  EXPECT_TRUE(HasEdge("t1", 0, "t2", 0));
+  EXPECT_TRUE(HasEdge("input", 0, "t2", 1));
+  EXPECT_TRUE(HasEdge("t2", 0, "t3", 0));
+  EXPECT_TRUE(HasEdge("t1", 0, "t3", 1));
+  EXPECT_TRUE(HasControlEdge("W1", "t3"));
+
+  // Errors leave the graph unchanged.
+  const string before = GraphDebugString();
+  CHECK(protobuf::TextFormat::ParseFromString(
+      "node { name: 't4' op: 'TestMul' input: [ 't3', 'input:1' ] }"
+      "node { name: 't5' op: 'TestInt' input: 't4' }",
+      &extension));
+  Status s = ExtendGraph(GraphConstructorOptions(), extension, &graph_);
+  EXPECT_TRUE(StringPiece(s.error_message()).contains("incompatible")) << s;
+  CHECK(protobuf::TextFormat::ParseFromString(
+      "node { name: 't1' op: 'TestMul' input: [ 't3', 'input:1' ] }",
+      &extension));
+  s = ExtendGraph(GraphConstructorOptions(), extension, &graph_);
+  EXPECT_TRUE(StringPiece(s.error_message()).contains("is not unique")) << s;
+  EXPECT_EQ(before, GraphDebugString());
+}
+
+// Returns a GraphDef of 'num_nodes' nodes, most of which have two inputs.
+GraphDef SyntheticGraphDef(int num_nodes) {
+  GraphDef gdef;
+  NodeDef* params = gdef.add_node();
+  params->set_name("n0");
+  params->set_op("TestParams");
+  for (int i = 1; i < num_nodes; ++i) {
+    NodeDef* node = gdef.add_node();
+    node->set_name(strings::StrCat("n", i));
+    node->add_input(strings::StrCat("n", i - 1));
+    if (i % 2 == 0) {
+      node->set_op("TestMul");
+      node->add_input(strings::StrCat("n", i / 2));
+    } else {
+      node->set_op("TestOneInputOneOutput");
+      AddNodeAttr("T", DT_FLOAT, node);
+    }
+  }
+  return gdef;
+}
+
+TEST_F(GraphConstructorTest, ParallelConversion) {
+  const GraphDef gdef = SyntheticGraphDef(1000);
+  GraphConstructorOptions opts;
+  TF_EXPECT_OK(ConvertGraphDefToGraph(opts, gdef, &graph_));
+  const string expected = GraphDebugString();
+
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  Graph parallel_graph(OpRegistry::Global());
+  opts.thread_pool = &pool;
+  TF_EXPECT_OK(ConvertGraphDefToGraph(opts, gdef, &parallel_graph));
+  GraphDef parallel_def;
+  parallel_graph.ToGraphDef(&parallel_def);
+  EXPECT_EQ(expected, parallel_def.DebugString());
+}
+
+TEST_F(GraphConstructorTest, ParallelConversionErrors) {
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  GraphConstructorOptions opts;
+  opts.thread_pool = &pool;
+
+  GraphDef gdef = SyntheticGraphDef(1000);
+  gdef.mutable_node(500)->set_op("NotARegisteredOp");
+  Status s = ConvertGraphDefToGraph(opts, gdef, &graph_);
+  EXPECT_TRUE(StringPiece(s.error_message()).contains("NotARegisteredOp"))
+      << s;
+
+  gdef = SyntheticGraphDef(1000);
+  gdef.mutable_node(501)->clear_attr();
+  s = ConvertGraphDefToGraph(opts, gdef, &graph_);
+  EXPECT_TRUE(StringPiece(s.error_message()).contains("n501")) << s;
+
+  ImportGraphDefOptions import_opts;
+  import_opts.prefix = "import";
+  import_opts.thread_pool = &pool;
+  TF_EXPECT_OK(ImportGraphDef(import_opts, SyntheticGraphDef(1000), &graph_,
+                              nullptr));
+  EXPECT_TRUE(HasEdge("import/n499", 0, "import/n500", 0));
+  EXPECT_TRUE(HasEdge("import/n250", 0, "import/n500", 1));
+}
+
 TEST_F(GraphConstructorTest, CopyGraph) {
   const int v = TF_GRAPH_DEF_VERSION;
   const int bad = v + 17;
@@ -1049,5 +1155,33 @@ TEST_F(GraphConstructorTest, CopyGraph) {
   EXPECT_EQ(dst.versions().bad_consumers(0), bad);
 }
 
+static void BM_ConvertGraphDefToGraph(int iters, int num_nodes,
+                                      int num_threads) {
+  testing::StopTiming();
+  const GraphDef gdef = SyntheticGraphDef(num_nodes);
+  std::unique_ptr<thread::ThreadPool> pool;
+  GraphConstructorOptions opts;
+  if (num_threads > 0) {
+    pool.reset(new thread::ThreadPool(Env::Default(), "bench", num_threads));
+    opts.thread_pool = pool.get();
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_nodes);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    Graph graph(OpRegistry::Global());
+    TF_CHECK_OK(ConvertGraphDefToGraph(opts, gdef, &graph));
+  }
+}
+
+static void BM_ConvertGraphDefToGraph_Sequential(int iters, int num_nodes) {
+  BM_ConvertGraphDefToGraph(iters, num_nodes, 0);
+}
+BENCHMARK(BM_ConvertGraphDefToGraph_Sequential)->Arg(1 << 10)->Arg(1 << 20);
+
+static void BM_ConvertGraphDefToGraph_Parallel(int iters, int num_nodes) {
+  BM_ConvertGraphDefToGraph(iters, num_nodes, 8);
+}
+BENCHMARK(BM_ConvertGraphDefToGraph_Parallel)->Arg(1 << 10)->Arg(1 << 20);
+
 }  // namespace
 }  // namespace tensorflow
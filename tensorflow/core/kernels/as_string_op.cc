@@ -16,10 +16,12 @@ limitations under the License.
 // See docs in ../ops/string_ops.cc.
 
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/framework/kernel_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
@@ -109,18 +111,21 @@ class AsStringOp : public OpKernel {
     OP_REQUIRES_OK(context, context->input("input", &input_tensor));
     const DataType& dtype = input_tensor->dtype();
 
-    Tensor* output_tensor = nullptr;
-    OP_REQUIRES_OK(context,
-                   context->allocate_output("output", input_tensor->shape(),
-                                            &output_tensor));
-    auto output_flat = output_tensor->flat<string>();
-
-#define ENCODE_TYPE(type, T, enc_str)                                     \
-  case (type): {                                                          \
-    const auto& input_flat = input_tensor->flat<T>();                     \
-    for (int i = 0; i < input_flat.size(); ++i) {                         \
-      output_flat(i) = strings::Printf((enc_str.c_str()), input_flat(i)); \
-    }                                                                     \
+    // The output is formatted straight into one packed block of bytes
+    // instead of one string allocation per element.
+    const int64 num_elements = input_tensor->NumElements();
+    std::vector<int64> offsets;
+    offsets.reserve(num_elements + 1);
+    offsets.push_back(0);
+    string bytes;
+
+#define ENCODE_TYPE(type, T, enc_str)                             \
+  case (type): {                                                  \
+    const auto& input_flat = input_tensor->flat<T>();             \
+    for (int i = 0; i < input_flat.size(); ++i) {                 \
+      strings::Appendf(&bytes, (enc_str.c_str()), input_flat(i)); \
+      offsets.push_back(bytes.size());                            \
+    }                                                             \
   } break
 
     switch (dtype) {
@@ -132,14 +137,16 @@ class AsStringOp : public OpKernel {
       case (DT_BOOL): {
         const auto& input_flat = input_tensor->flat<bool>();
         for (int i = 0; i < input_flat.size(); ++i) {
-          output_flat(i) = (input_flat(i)) ? "true" : "false";
+          bytes.append((input_flat(i)) ? "true" : "false");
+          offsets.push_back(bytes.size());
         }
       } break;
       case (DT_COMPLEX64): {
         const auto& input_flat = input_tensor->flat<complex64>();
         for (int i = 0; i < input_flat.size(); ++i) {
-          output_flat(i) = strings::Printf(
-              format_.c_str(), input_flat(i).real(), input_flat(i).imag());
+          strings::Appendf(&bytes, format_.c_str(), input_flat(i).real(),
+                           input_flat(i).imag());
+          offsets.push_back(bytes.size());
         }
       } break;
       default:
@@ -150,6 +157,9 @@ class AsStringOp : public OpKernel {
     }
 
 #undef ENCODE_TYPE
+
+    context->set_output(0, tensor::MakePackedStringTensor(
+                               input_tensor->shape(), &offsets, &bytes));
   }
 
  private:
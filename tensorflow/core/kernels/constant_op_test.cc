@@ -14,17 +14,42 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 
+class ConstantOpTest : public OpsTestBase {};
+
+TEST_F(ConstantOpTest, KernelDoesNotKeepValue) {
+  Tensor value(DT_FLOAT, TensorShape({2, 3}));
+  test::FillValues<float>(&value, {1, 2, 3, 4, 5, 6});
+  TF_ASSERT_OK(NodeDefBuilder("const", "Const")
+                   .Attr("dtype", DT_FLOAT)
+                   .Attr("value", value)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  EXPECT_EQ("const", kernel_->name());
+  EXPECT_EQ("Const", kernel_->type_string());
+  EXPECT_EQ(0, kernel_->def().attr().count("value"));
+  ASSERT_EQ(1, kernel_->num_outputs());
+  EXPECT_EQ(DT_FLOAT, kernel_->output_type(0));
+
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<float>(value, *GetOutput(0));
+}
+
 // Returns graph containing "num" const nodes.  If 'sequential' is
 // true, make sure all constants are executed sequentially in the
 // graph by adding control dependencies.
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 
 // See docs in ../ops/parsing_ops.cc.
+#include <string.h>
+#include <deque>
 #include <vector>
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -21,6 +23,8 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -53,6 +57,13 @@ class DecodeCSVOp : public OpKernel {
                       "There should only be 1 default per field but field ", i,
                       " has ", record_defaults[i].NumElements()));
     }
+    for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
+      const DataType dtype = out_type_[f];
+      OP_REQUIRES(ctx, dtype == DT_INT32 || dtype == DT_INT64 ||
+                           dtype == DT_FLOAT || dtype == DT_STRING,
+                  errors::InvalidArgument("csv: data type ", dtype,
+                                          " not supported in field ", f));
+    }
 
     auto records_t = records->flat<string>();
     int64 records_size = records_t.size();
@@ -62,176 +73,224 @@ class DecodeCSVOp : public OpKernel {
 
     for (int i = 0; i < static_cast<int>(out_type_.size()); ++i) {
       Tensor* out = nullptr;
-      output.allocate(i, records->shape(), &out);
+      OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &out));
     }
 
+    // Records are parsed in parallel.  If several are malformed, the error
+    // for the first of them is reported, as a sequential parse would do.
+    mutex mu;
+    int64 first_error_record = records_size;
+    Status first_error;
+    int64 record_bytes = 0;
     for (int64 i = 0; i < records_size; ++i) {
-      const StringPiece record(records_t(i));
-      std::vector<string> fields;
-      ExtractFields(ctx, record, &fields);
-      OP_REQUIRES(ctx, fields.size() == out_type_.size(),
-                  errors::InvalidArgument("Expect ", out_type_.size(),
-                                          " fields but have ", fields.size(),
-                                          " in record ", i));
-
-      // Check each field in the record
-      for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
-        const DataType& dtype = out_type_[f];
-        switch (dtype) {
-          case DT_INT32: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-
-              output[f]->flat<int32>()(i) = record_defaults[f].flat<int32>()(0);
-            } else {
-              int32 value;
-              OP_REQUIRES(ctx, strings::safe_strto32(fields[f], &value),
-                          errors::InvalidArgument("Field ", f, " in record ", i,
-                                                  " is not a valid int32: ",
-                                                  fields[f]));
-              output[f]->flat<int32>()(i) = value;
+      record_bytes += records_t(i).size();
+    }
+    const int64 cost_per_record =
+        20 * (1 + record_bytes / std::max<int64>(records_size, 1));
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, records_size,
+          cost_per_record, [&](int64 start, int64 limit) {
+            ParseState state;
+            for (int64 i = start; i < limit; ++i) {
+              const Status s = ParseRecord(records_t(i), i, record_defaults,
+                                           &output, &state);
+              if (!s.ok()) {
+                mutex_lock l(mu);
+                if (i < first_error_record) {
+                  first_error_record = i;
+                  first_error = s;
+                }
+                return;
+              }
             }
-            break;
-          }
-          case DT_INT64: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-
-              output[f]->flat<int64>()(i) = record_defaults[f].flat<int64>()(0);
-            } else {
-              int64 value;
-              OP_REQUIRES(ctx, strings::safe_strto64(fields[f], &value),
-                          errors::InvalidArgument("Field ", f, " in record ", i,
-                                                  " is not a valid int64: ",
-                                                  fields[f]));
-              output[f]->flat<int64>()(i) = value;
+          });
+    OP_REQUIRES_OK(ctx, first_error);
+  }
+
+ private:
+  std::vector<DataType> out_type_;
+  char delim_;
+
+  // Scratch space reused across the records parsed by one shard, so that
+  // steady-state parsing does not allocate.
+  struct ParseState {
+    std::vector<StringPiece> fields;
+    // Backing storage for quoted fields with escaped quotes, the only fields
+    // that are not views into the record.  A deque keeps the pieces pointing
+    // into it valid as it grows.
+    std::deque<string> unescaped;
+    // NUL-terminated copy of a field for safe_strtof.
+    string float_buffer;
+  };
+
+  Status ParseRecord(const string& record_str, int64 i,
+                     const OpInputList& record_defaults, OpOutputList* output,
+                     ParseState* state) const {
+    const StringPiece record(record_str);
+    std::vector<StringPiece>& fields = state->fields;
+    fields.clear();
+    state->unescaped.clear();
+    TF_RETURN_IF_ERROR(ExtractFields(record, &fields, &state->unescaped));
+    if (fields.size() != out_type_.size()) {
+      return errors::InvalidArgument("Expect ", out_type_.size(),
+                                     " fields but have ", fields.size(),
+                                     " in record ", i);
+    }
+
+    // Check each field in the record
+    for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
+      // If this field is empty, check if default is given:
+      // If yes, use default value; Otherwise report error.
+      if (fields[f].empty() && record_defaults[f].NumElements() != 1) {
+        return errors::InvalidArgument(
+            "Field ", f, " is required but missing in record ", i, "!");
+      }
+      switch (out_type_[f]) {
+        case DT_INT32: {
+          if (fields[f].empty()) {
+            (*output)[f]->flat<int32>()(i) =
+                record_defaults[f].flat<int32>()(0);
+          } else {
+            int32 value;
+            if (!strings::safe_strto32(fields[f], &value)) {
+              return errors::InvalidArgument("Field ", f, " in record ", i,
+                                             " is not a valid int32: ",
+                                             fields[f]);
             }
-            break;
+            (*output)[f]->flat<int32>()(i) = value;
           }
-          case DT_FLOAT: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<float>()(i) = record_defaults[f].flat<float>()(0);
-            } else {
-              float value;
-              OP_REQUIRES(ctx, strings::safe_strtof(fields[f].c_str(), &value),
-                          errors::InvalidArgument("Field ", f, " in record ", i,
-                                                  " is not a valid float: ",
-                                                  fields[f]));
-              output[f]->flat<float>()(i) = value;
+          break;
+        }
+        case DT_INT64: {
+          if (fields[f].empty()) {
+            (*output)[f]->flat<int64>()(i) =
+                record_defaults[f].flat<int64>()(0);
+          } else {
+            int64 value;
+            if (!strings::safe_strto64(fields[f], &value)) {
+              return errors::InvalidArgument("Field ", f, " in record ", i,
+                                             " is not a valid int64: ",
+                                             fields[f]);
             }
-            break;
+            (*output)[f]->flat<int64>()(i) = value;
           }
-          case DT_STRING: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<string>()(i) =
-                  record_defaults[f].flat<string>()(0);
-            } else {
-              output[f]->flat<string>()(i) = fields[f];
+          break;
+        }
+        case DT_FLOAT: {
+          if (fields[f].empty()) {
+            (*output)[f]->flat<float>()(i) =
+                record_defaults[f].flat<float>()(0);
+          } else {
+            state->float_buffer.assign(fields[f].data(), fields[f].size());
+            float value;
+            if (!strings::safe_strtof(state->float_buffer.c_str(), &value)) {
+              return errors::InvalidArgument("Field ", f, " in record ", i,
+                                             " is not a valid float: ",
+                                             fields[f]);
             }
-            break;
+            (*output)[f]->flat<float>()(i) = value;
           }
-          default:
-            OP_REQUIRES(ctx, false,
-                        errors::InvalidArgument("csv: data type ", dtype,
-                                                " not supported in field ", f));
+          break;
         }
+        case DT_STRING: {
+          if (fields[f].empty()) {
+            (*output)[f]->flat<string>()(i) =
+                record_defaults[f].flat<string>()(0);
+          } else {
+            (*output)[f]->flat<string>()(i).assign(fields[f].data(),
+                                                   fields[f].size());
+          }
+          break;
+        }
+        default:
+          // Checked in Compute().
+          break;
       }
     }
+    return Status::OK();
   }
 
- private:
-  std::vector<DataType> out_type_;
-  char delim_;
-
-  void ExtractFields(OpKernelContext* ctx, StringPiece input,
-                     std::vector<string>* result) {
-    int64 current_idx = 0;
+  // Splits `input` into fields.  Fields are returned as views into `input`,
+  // except quoted fields containing escaped quotes, whose unescaped contents
+  // are stored in `unescaped`.  Delimiters and quotes are found with memchr,
+  // which the C library vectorizes, rather than a byte at a time.
+  Status ExtractFields(StringPiece input, std::vector<StringPiece>* result,
+                       std::deque<string>* unescaped) const {
+    const size_t size = input.size();
+    const char* const data = input.data();
+    size_t current_idx = 0;
     if (!input.empty()) {
-      while (static_cast<size_t>(current_idx) < input.size()) {
-        if (input[current_idx] == '\n' || input[current_idx] == '\r') {
+      while (current_idx < size) {
+        if (data[current_idx] == '\n' || data[current_idx] == '\r') {
           current_idx++;
           continue;
         }
 
-        bool quoted = false;
-        if (input[current_idx] == '"') {
-          quoted = true;
-          current_idx++;
-        }
-
-        // This is the body of the field;
-        string field;
-        if (!quoted) {
-          while (static_cast<size_t>(current_idx) < input.size() &&
-                 input[current_idx] != delim_) {
-            OP_REQUIRES(ctx, input[current_idx] != '"' &&
-                                 input[current_idx] != '\n' &&
-                                 input[current_idx] != '\r',
-                        errors::InvalidArgument(
-                            "Unquoted fields cannot have quotes/CRLFs inside"));
-            field += input[current_idx];
-            current_idx++;
+        if (data[current_idx] != '"') {
+          const char* delim = static_cast<const char*>(
+              memchr(data + current_idx, delim_, size - current_idx));
+          const size_t end = delim ? delim - data : size;
+          // No early exit, so that the compiler can vectorize the loop.
+          bool invalid = false;
+          for (size_t j = current_idx; j < end; ++j) {
+            const char c = data[j];
+            invalid |= (c == '"') | (c == '\n') | (c == '\r');
           }
+          if (invalid) {
+            return errors::InvalidArgument(
+                "Unquoted fields cannot have quotes/CRLFs inside");
+          }
+          result->emplace_back(data + current_idx, end - current_idx);
 
           // Go to next field or the end
-          current_idx++;
+          current_idx = end + 1;
         } else {
-          // Quoted field needs to be ended with '"' and delim or end
-          while (
-              (static_cast<size_t>(current_idx) < input.size() - 1) &&
-              (input[current_idx] != '"' || input[current_idx + 1] != delim_)) {
-            if (input[current_idx] != '"') {
-              field += input[current_idx];
-              current_idx++;
+          // Quoted field needs to be ended with '"' and delim or end.  Runs
+          // of characters between quotes are copied in one go, and only a
+          // field with escaped quotes inside needs its own storage.
+          current_idx++;
+          const size_t field_start = current_idx;
+          string* field = nullptr;
+          while (true) {
+            const char* quote = static_cast<const char*>(
+                memchr(data + current_idx, '"', size - current_idx));
+            if (quote == nullptr) {
+              return errors::InvalidArgument(
+                  "Quoted field has to end with quote followed by delim or "
+                  "end");
+            }
+            const size_t q = quote - data;
+            if (q == size - 1 || data[q + 1] == delim_) {
+              if (field == nullptr) {
+                result->emplace_back(data + field_start, q - field_start);
+              } else {
+                field->append(data + current_idx, q - current_idx);
+                result->emplace_back(*field);
+              }
+              current_idx = q + 2;
+              break;
+            }
+            if (data[q + 1] != '"') {
+              return errors::InvalidArgument(
+                  "Quote inside a string has to be escaped by another quote");
+            }
+            if (field == nullptr) {
+              unescaped->emplace_back();
+              field = &unescaped->back();
+              field->assign(data + field_start, q - field_start);
             } else {
-              OP_REQUIRES(
-                  ctx, input[current_idx + 1] == '"',
-                  errors::InvalidArgument("Quote inside a string has to be "
-                                          "escaped by another quote"));
-              field += '"';
-              current_idx += 2;
+              field->append(data + current_idx, q - current_idx);
             }
+            field->push_back('"');
+            current_idx = q + 2;
           }
-
-          OP_REQUIRES(
-              ctx, (static_cast<size_t>(current_idx) < input.size() &&
-                    input[current_idx] == '"' &&
-                    (static_cast<size_t>(current_idx) == input.size() - 1 ||
-                     input[current_idx + 1] == delim_)),
-              errors::InvalidArgument("Quoted field has to end with quote "
-                                      "followed by delim or end"));
-
-          current_idx += 2;
         }
-
-        result->push_back(field);
       }
 
       // Check if the last field is missing
-      if (input[input.size() - 1] == delim_) result->push_back(string());
+      if (data[size - 1] == delim_) result->emplace_back();
     }
+    return Status::OK();
   }
 };
 
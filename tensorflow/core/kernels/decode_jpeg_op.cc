@@ -15,15 +15,21 @@ limitations under the License.
 
 // See docs in ../ops/image_ops.cc
 
+#include <math.h>
+#include <algorithm>
 #include <memory>
+#include <vector>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/image_resizer_state.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/jpeg/jpeg_mem.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -84,4 +90,176 @@ class DecodeJpegOp : public OpKernel {
 };
 REGISTER_KERNEL_BUILDER(Name("DecodeJpeg").Device(DEVICE_CPU), DecodeJpegOp);
 
+// Decode a batch of JPEG files, crop each one and resize the crops to a
+// common size, all in one pass over each file.
+class DecodeJpegCropAndResizeOp : public OpKernel {
+ public:
+  explicit DecodeJpegCropAndResizeOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("channels", &flags_.components));
+    OP_REQUIRES(context, flags_.components == 1 || flags_.components == 3,
+                errors::InvalidArgument("channels must be 1 or 3, got ",
+                                        flags_.components));
+    OP_REQUIRES_OK(
+        context, context->GetAttr("fancy_upscaling", &flags_.fancy_upscaling));
+    OP_REQUIRES_OK(context, context->GetAttr("align_corners", &align_corners_));
+    flags_.crop = true;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& contents = context->input(0);
+    const Tensor& crop_windows = context->input(1);
+    const Tensor& size = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(contents.shape()),
+                errors::InvalidArgument("contents must be 1-D, got shape ",
+                                        contents.shape().DebugString()));
+    const int64 batch = contents.NumElements();
+    OP_REQUIRES(context, crop_windows.dims() == 2 &&
+                             crop_windows.dim_size(0) == batch &&
+                             crop_windows.dim_size(1) == 4,
+                errors::InvalidArgument("crop_windows must have shape [",
+                                        batch, ", 4], got shape ",
+                                        crop_windows.shape().DebugString()));
+    OP_REQUIRES(context, size.dims() == 1 && size.NumElements() == 2,
+                errors::InvalidArgument("size must be 1-D with 2 elements, "
+                                        "got shape ",
+                                        size.shape().DebugString()));
+    const int out_height = size.vec<int32>()(0);
+    const int out_width = size.vec<int32>()(1);
+    OP_REQUIRES(context, out_height > 0 && out_width > 0,
+                errors::InvalidArgument("output dimensions must be positive, "
+                                        "got ",
+                                        out_height, " x ", out_width));
+
+    const auto contents_vec = contents.vec<string>();
+    const auto windows = crop_windows.matrix<int32>();
+    int64 max_window_pixels = 0;
+    for (int64 b = 0; b < batch; ++b) {
+      OP_REQUIRES(
+          context, contents_vec(b).size() <= std::numeric_limits<int>::max(),
+          errors::InvalidArgument("JPEG contents are too large for int: ",
+                                  contents_vec(b).size()));
+      OP_REQUIRES(context, windows(b, 0) >= 0 && windows(b, 1) >= 0 &&
+                               windows(b, 2) > 0 && windows(b, 3) > 0,
+                  errors::InvalidArgument(
+                      "crop window ", b, " must have a non-negative offset "
+                                         "and a positive size"));
+      max_window_pixels = std::max(
+          max_window_pixels, static_cast<int64>(windows(b, 2)) * windows(b, 3));
+    }
+
+    const int channels = flags_.components;
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({batch, out_height, out_width,
+                                                channels}),
+                                &output));
+    if (batch == 0) return;
+
+    // Each image is decoded, cropped and resized by a single thread; images
+    // are spread over the intra-op pool.
+    std::vector<Status> statuses(batch);
+    float* const output_data = output->flat<float>().data();
+    const int64 output_image_size =
+        static_cast<int64>(out_height) * out_width * channels;
+    auto work = [&](int64 start, int64 limit) {
+      for (int64 b = start; b < limit; ++b) {
+        const StringPiece input = contents_vec(b);
+        jpeg::UncompressFlags flags = flags_;
+        flags.crop_y = windows(b, 0);
+        flags.crop_x = windows(b, 1);
+        flags.crop_height = windows(b, 2);
+        flags.crop_width = windows(b, 3);
+        flags.ratio = ChooseRatio(flags.crop_height, flags.crop_width,
+                                  out_height, out_width);
+        int width, height, components;
+        std::unique_ptr<uint8[]> image(
+            jpeg::Uncompress(input.data(), input.size(), flags, &width,
+                             &height, &components, nullptr /* nwarn */));
+        if (image == nullptr) {
+          statuses[b] = errors::InvalidArgument(
+              "Invalid JPEG data or crop window for image ", b, ", size ",
+              input.size());
+          continue;
+        }
+        ResizeBilinear(image.get(), height, width, channels, out_height,
+                       out_width, output_data + b * output_image_size);
+      }
+    };
+    // Decoding costs on the order of a hundred cycles per pixel.
+    const int64 cost_per_image = max_window_pixels * channels * 100;
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, batch,
+          cost_per_image, work);
+    for (const Status& s : statuses) {
+      OP_REQUIRES_OK(context, s);
+    }
+  }
+
+ private:
+  // Returns the largest of the downscaling ratios libjpeg applies in the DCT
+  // domain for which the crop window still has at least as many pixels as
+  // the output in both dimensions, so that the resize never has to upscale
+  // what the decoder has scaled down.
+  static int ChooseRatio(int crop_height, int crop_width, int out_height,
+                         int out_width) {
+    for (int ratio = 8; ratio > 1; ratio /= 2) {
+      if (crop_height / ratio >= out_height &&
+          crop_width / ratio >= out_width) {
+        return ratio;
+      }
+    }
+    return 1;
+  }
+
+  // Resizes the in_height x in_width image at "in" into the out_height x
+  // out_width image at "out", with the same interpolation as ResizeBilinear.
+  void ResizeBilinear(const uint8* in, int in_height, int in_width,
+                      int channels, int out_height, int out_width,
+                      float* out) const {
+    const float height_scale =
+        CalculateResizeScale(in_height, out_height, align_corners_);
+    const float width_scale =
+        CalculateResizeScale(in_width, out_width, align_corners_);
+    // The horizontal interpolation is the same for every row.
+    std::vector<int64> left(out_width), right(out_width);
+    std::vector<float> x_lerp(out_width);
+    for (int x = 0; x < out_width; ++x) {
+      const float in_x = x * width_scale;
+      const int64 left_x = static_cast<int64>(floorf(in_x));
+      left[x] = left_x * channels;
+      right[x] =
+          std::min(static_cast<int64>(ceilf(in_x)), in_width - 1LL) * channels;
+      x_lerp[x] = in_x - left_x;
+    }
+    const int64 in_row_size = static_cast<int64>(in_width) * channels;
+    for (int y = 0; y < out_height; ++y) {
+      const float in_y = y * height_scale;
+      const int64 top_y = static_cast<int64>(floorf(in_y));
+      const int64 bottom_y =
+          std::min(static_cast<int64>(ceilf(in_y)), in_height - 1LL);
+      const float y_lerp = in_y - top_y;
+      const uint8* top_row = in + top_y * in_row_size;
+      const uint8* bottom_row = in + bottom_y * in_row_size;
+      for (int x = 0; x < out_width; ++x) {
+        for (int c = 0; c < channels; ++c) {
+          const float top_left(top_row[left[x] + c]);
+          const float top_right(top_row[right[x] + c]);
+          const float bottom_left(bottom_row[left[x] + c]);
+          const float bottom_right(bottom_row[right[x] + c]);
+          const float top = top_left + (top_right - top_left) * x_lerp[x];
+          const float bottom =
+              bottom_left + (bottom_right - bottom_left) * x_lerp[x];
+          *out++ = top + (bottom - top) * y_lerp;
+        }
+      }
+    }
+  }
+
+  jpeg::UncompressFlags flags_;
+  bool align_corners_;
+};
+REGISTER_KERNEL_BUILDER(Name("DecodeJpegCropAndResize").Device(DEVICE_CPU),
+                        DecodeJpegCropAndResizeOp);
+
 }  // namespace tensorflow
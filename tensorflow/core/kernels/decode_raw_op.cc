@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/cpu_info.h"
@@ -64,17 +65,27 @@ class DecodeRawOp : public OpKernel {
                                 ", the size of ", DataTypeString(out_type_)));
     const int64 added_dim = str_size / sizeof(T);
     out_shape.AddDim(added_dim);
-    Tensor* output_tensor = nullptr;
-    OP_REQUIRES_OK(
-        context, context->allocate_output("output", out_shape, &output_tensor));
-    auto out = output_tensor->flat_inner_dims<T>();
-    DCHECK_EQ(flat_in.size(), out.dimensions()[0]);
     OP_REQUIRES(
         context,
         little_endian_ == ::tensorflow::port::kLittleEndian || sizeof(T) == 1,
         errors::Unimplemented("Unimplemented support for little_endian=",
                               little_endian_ ? "true" : "false"));
-    // Endianness matches, so just copy each string byte-for-byte.
+    // Endianness matches, so the output is the input bytes as they are. A
+    // single string can be used as the output's buffer directly if it is
+    // aligned well enough, which saves copying what is often a large blob.
+    Tensor aliased;
+    if (flat_in.size() == 1 &&
+        tensor::AliasStringBytes(input, flat_in(0), out_type_, out_shape,
+                                 &aliased)) {
+      context->set_output(0, aliased);
+      return;
+    }
+    Tensor* output_tensor = nullptr;
+    OP_REQUIRES_OK(
+        context, context->allocate_output("output", out_shape, &output_tensor));
+    auto out = output_tensor->flat_inner_dims<T>();
+    DCHECK_EQ(flat_in.size(), out.dimensions()[0]);
+    // Otherwise, copy each string byte-for-byte.
     T* out_data = out.data();
     for (int64 i = 0; i < flat_in.size(); ++i) {
       const T* in_data = reinterpret_cast<const T*>(flat_in(i).data());
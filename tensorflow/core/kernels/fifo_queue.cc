@@ -16,9 +16,12 @@ limitations under the License.
 // See docs in ../ops/data_flow_ops.cc.
 
 #include <algorithm>
+#include <atomic>
 #include <deque>
+#include <thread>
 #include <vector>
 
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
@@ -31,22 +34,207 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// Sets *element to the index^th slice of batch, sharing its buffer when the
+// slice is suitably aligned and copying it otherwise.
+Status GetBatchElement(OpKernelContext* ctx, const Tensor& batch, int64 index,
+                       Tensor* element) {
+  TensorShape element_shape(batch.shape());
+  element_shape.RemoveDim(0);
+  Tensor slice = batch.Slice(index, index + 1);
+  if (slice.IsAligned()) {
+    CHECK(element->CopyFrom(slice, element_shape));
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(batch.dtype(), element_shape, element));
+  return QueueBase::CopySliceToElement(batch, element, index);
+}
+
+}  // namespace
+
+void FIFOQueueComponent::push_back(const PersistentTensor& element) {
+  chunks_.push_back({element, false, 0, 1});
+  ++size_;
+}
+
+void FIFOQueueComponent::push_front(const PersistentTensor& element) {
+  chunks_.push_front({element, false, 0, 1});
+  ++size_;
+}
+
+void FIFOQueueComponent::PushBackBatch(const PersistentTensor& batch,
+                                       int64 begin, int64 end) {
+  DCHECK_LT(begin, end);
+  chunks_.push_back({batch, true, begin, end});
+  size_ += end - begin;
+}
+
+void FIFOQueueComponent::PushFrontBatch(const PersistentTensor& batch,
+                                        int64 begin, int64 end) {
+  DCHECK_LT(begin, end);
+  chunks_.push_front({batch, true, begin, end});
+  size_ += end - begin;
+}
+
+int64 FIFOQueueComponent::FrontChunkSize() const {
+  DCHECK(!chunks_.empty());
+  const Chunk& chunk = chunks_.front();
+  return chunk.end - chunk.begin;
+}
+
+Status FIFOQueueComponent::FrontElement(OpKernelContext* ctx,
+                                        Tensor* element) {
+  DCHECK(!chunks_.empty());
+  Chunk& chunk = chunks_.front();
+  const Tensor& t = *chunk.tensor.AccessTensor(ctx);
+  if (!chunk.is_batch) {
+    *element = t;
+    return Status::OK();
+  }
+  return GetBatchElement(ctx, t, chunk.begin, element);
+}
+
+bool FIFOQueueComponent::FrontBatchView(OpKernelContext* ctx, int64 n,
+                                        Tensor* batch) {
+  DCHECK_GT(n, 0);
+  DCHECK_LE(n, FrontChunkSize());
+  Chunk& chunk = chunks_.front();
+  const Tensor& t = *chunk.tensor.AccessTensor(ctx);
+  if (!chunk.is_batch) {
+    TensorShape batch_shape(t.shape());
+    batch_shape.InsertDim(0, 1);
+    return batch->CopyFrom(t, batch_shape);
+  }
+  if (chunk.begin == 0 && n == t.dim_size(0)) {
+    *batch = t;
+    return true;
+  }
+  Tensor slice = t.Slice(chunk.begin, chunk.begin + n);
+  if (!slice.IsAligned()) return false;
+  *batch = slice;
+  return true;
+}
+
+Status FIFOQueueComponent::CopyFrontBatch(OpKernelContext* ctx, int64 n,
+                                          Tensor* batch, int64 index) {
+  DCHECK_GT(n, 0);
+  DCHECK_LE(n, FrontChunkSize());
+  Chunk& chunk = chunks_.front();
+  const Tensor& t = *chunk.tensor.AccessTensor(ctx);
+  if (!chunk.is_batch) {
+    return QueueBase::CopyElementToSlice(t, batch, index);
+  }
+  return QueueBase::CopySlicesToSlices(t, chunk.begin, batch, index, n);
+}
+
+void FIFOQueueComponent::PopFront(int64 n) {
+  DCHECK_GT(n, 0);
+  DCHECK_LE(n, FrontChunkSize());
+  Chunk& chunk = chunks_.front();
+  chunk.begin += n;
+  size_ -= n;
+  if (chunk.begin == chunk.end) chunks_.pop_front();
+}
+
 FIFOQueue::FIFOQueue(int capacity, const DataTypeVector& component_dtypes,
                      const std::vector<TensorShape>& component_shapes,
-                     const string& name)
-    : TypedQueue(capacity, component_dtypes, component_shapes, name) {}
+                     const string& name, bool lock_free)
+    : TypedQueue(capacity, component_dtypes, component_shapes, name),
+      lock_free_(lock_free),
+      use_ring_(false),
+      closing_(false),
+      num_lock_free_ops_(0) {}
+
+Status FIFOQueue::Initialize() {
+  TF_RETURN_IF_ERROR(TypedQueue::Initialize());
+  if (lock_free_) {
+    if (capacity_ <= 0 || capacity_ == kUnbounded) {
+      return errors::InvalidArgument("FIFOQueue '", name_,
+                                     "' must have a bounded, positive ",
+                                     "capacity to be lock-free, but has ",
+                                     "capacity ", capacity_);
+    }
+    mutex_lock lock(mu_);
+    ring_.reset(new MPMCRingBuffer<Tuple>(capacity_));
+    use_ring_ = true;
+  }
+  return Status::OK();
+}
+
+void FIFOQueue::NoteAttemptAddedLocked(Action action) {
+  if (ring_ == nullptr) return;
+  if (action == kEnqueue) {
+    ++num_enqueue_attempts_;
+  } else {
+    ++num_dequeue_attempts_;
+  }
+  // Pairs with the fences in Try{En,De}queueLockFree: either the attempt
+  // sees the effect of a lock-free operation when it runs, or that operation
+  // sees the attempt and flushes it.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+bool FIFOQueue::TryEnqueueLockFree(const Tuple& tuple) {
+  if (ring_ == nullptr) return false;
+  bool enqueued = false;
+  ++num_lock_free_ops_;
+  // Waiting enqueue attempts must not be overtaken, or the order of
+  // enqueues would no longer be the order in which they were issued.
+  if (!closing_ && num_enqueue_attempts_ == 0) {
+    enqueued = ring_->TryPush(tuple);
+  }
+  --num_lock_free_ops_;
+  if (enqueued) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_dequeue_attempts_ > 0) FlushUnlocked();
+  }
+  return enqueued;
+}
+
+bool FIFOQueue::TryDequeueLockFree(Tuple* tuple) {
+  if (ring_ == nullptr) return false;
+  bool dequeued = false;
+  ++num_lock_free_ops_;
+  // Likewise for waiting dequeue attempts, e.g. a DequeueMany that has
+  // taken part of its batch.
+  if (!closing_ && num_dequeue_attempts_ == 0) {
+    dequeued = ring_->TryPop(tuple);
+  }
+  --num_lock_free_ops_;
+  if (dequeued) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_enqueue_attempts_ > 0) FlushUnlocked();
+  }
+  return dequeued;
+}
 
 void FIFOQueue::DequeueLocked(OpKernelContext* ctx, Tuple* tuple) {
   DCHECK_GT(queues_[0].size(), size_t{0});
   (*tuple).reserve(num_components());
   for (int i = 0; i < num_components(); ++i) {
-    (*tuple).push_back(*queues_[i][0].AccessTensor(ctx));
-    queues_[i].pop_front();
+    Tensor element;
+    Status s = queues_[i].FrontElement(ctx, &element);
+    if (!s.ok()) {
+      ctx->SetStatus(s);
+      // Leave the queue unchanged so that no partial tuple is lost.
+      tuple->clear();
+      return;
+    }
+    (*tuple).push_back(element);
+  }
+  for (int i = 0; i < num_components(); ++i) {
+    queues_[i].PopFront(1);
   }
 }
 
 void FIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
                            DoneCallback callback) {
+  if (TryEnqueueLockFree(tuple)) {
+    callback();
+    return;
+  }
+
   CancellationManager* cm = ctx->cancellation_manager();
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
@@ -63,6 +251,9 @@ void FIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
                   errors::Cancelled("FIFOQueue '", name_, "' is closed."));
               return kComplete;
             }
+            if (use_ring_) {
+              return ring_->TryPush(tuple) ? kComplete : kNoProgress;
+            }
             if (queues_[0].size() < static_cast<size_t>(capacity_)) {
               for (int i = 0; i < num_components(); ++i) {
                 queues_[i].push_back(PersistentTensor(tuple[i]));
@@ -72,6 +263,7 @@ void FIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
               return kNoProgress;
             }
           });
+      NoteAttemptAddedLocked(kEnqueue);
     }
   }
   if (!already_cancelled) {
@@ -82,21 +274,6 @@ void FIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
   }
 }
 
-/* static */
-Status FIFOQueue::GetElementComponentFromBatch(const FIFOQueue::Tuple& tuple,
-                                               int64 index, int component,
-                                               OpKernelContext* ctx,
-                                               PersistentTensor* out_tensor) {
-  TensorShape element_shape(tuple[component].shape());
-  element_shape.RemoveDim(0);
-  Tensor* element_access = nullptr;
-  TF_RETURN_IF_ERROR(ctx->allocate_persistent(
-      tuple[component].dtype(), element_shape, out_tensor, &element_access));
-  TF_RETURN_IF_ERROR(
-      CopySliceToElement(tuple[component], element_access, index));
-  return Status::OK();
-}
-
 void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
                                DoneCallback callback) {
   const int64 batch_size = tuple[0].dim_size(0);
@@ -121,25 +298,59 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
                   errors::Cancelled("FIFOQueue '", name_, "' is closed."));
               return kComplete;
             }
-            RunResult result = kNoProgress;
-            while (queues_[0].size() < static_cast<size_t>(capacity_)) {
-              result = kProgress;
-              const int64 index =
-                  tuple[0].dim_size(0) - attempt->elements_requested;
-              for (int i = 0; i < num_components(); ++i) {
-                PersistentTensor element;
-                attempt->context->SetStatus(GetElementComponentFromBatch(
-                    tuple, index, i, attempt->context, &element));
-                if (!attempt->context->status().ok()) return kComplete;
-                queues_[i].push_back(element);
-              }
-              --attempt->elements_requested;
-              if (attempt->elements_requested == 0) {
-                return kComplete;
+            const int64 batch_size = tuple[0].dim_size(0);
+            if (use_ring_) {
+              RunResult result = kNoProgress;
+              while (attempt->elements_requested > 0) {
+                const int64 index = batch_size - attempt->elements_requested;
+                Tuple element;
+                element.reserve(num_components());
+                for (int i = 0; i < num_components(); ++i) {
+                  TensorShape element_shape(tuple[i].shape());
+                  element_shape.RemoveDim(0);
+                  Tensor component;
+                  attempt->context->SetStatus(attempt->context->allocate_temp(
+                      tuple[i].dtype(), element_shape, &component));
+                  if (!attempt->context->status().ok()) return kComplete;
+                  attempt->context->SetStatus(
+                      CopySliceToElement(tuple[i], &component, index));
+                  if (!attempt->context->status().ok()) return kComplete;
+                  element.push_back(component);
+                }
+                if (!ring_->TryPushMove(&element)) return result;
+                result = kProgress;
+                --attempt->elements_requested;
               }
+              return kComplete;
+            }
+            const int64 queue_size = queues_[0].size();
+            if (queue_size >= capacity_) return kNoProgress;
+            // Enqueue as many elements as fit as one chunk, copied out of
+            // the batch with a single copy per component rather than one
+            // per element. The batch itself is not kept, since the caller
+            // may reuse its buffer once the enqueue completes.
+            const int64 begin = batch_size - attempt->elements_requested;
+            const int64 n = std::min<int64>(attempt->elements_requested,
+                                            capacity_ - queue_size);
+            std::vector<PersistentTensor> chunks(num_components());
+            for (int i = 0; i < num_components(); ++i) {
+              TensorShape chunk_shape(tuple[i].shape());
+              chunk_shape.set_dim(0, n);
+              Tensor* chunk = nullptr;
+              attempt->context->SetStatus(attempt->context->allocate_persistent(
+                  tuple[i].dtype(), chunk_shape, &chunks[i], &chunk));
+              if (!attempt->context->status().ok()) return kComplete;
+              attempt->context->SetStatus(
+                  CopySlicesToSlices(tuple[i], begin, chunk, 0, n));
+              if (!attempt->context->status().ok()) return kComplete;
             }
-            return result;
+            for (int i = 0; i < num_components(); ++i) {
+              queues_[i].PushBackBatch(chunks[i], 0, n);
+            }
+            attempt->elements_requested -= n;
+            return attempt->elements_requested == 0 ? kComplete : kProgress;
           });
+      NoteAttemptAddedLocked(kEnqueue);
     }
   }
   if (!already_cancelled) {
@@ -151,6 +362,14 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
 }
 
 void FIFOQueue::TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) {
+  {
+    Tuple tuple;
+    if (TryDequeueLockFree(&tuple)) {
+      callback(tuple);
+      return;
+    }
+  }
+
   CancellationManager* cm = ctx->cancellation_manager();
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
@@ -163,7 +382,7 @@ void FIFOQueue::TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) {
       dequeue_attempts_.emplace_back(
           1, [callback]() { callback(Tuple()); }, ctx, cm, token,
           [callback, this](Attempt* attempt) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-            const int64 queue_size = queues_[0].size();
+            const int64 queue_size = SizeLocked();
             if (closed_ && queue_size == 0) {
               attempt->context->SetStatus(errors::OutOfRange(
                   "FIFOQueue '", name_, "' is closed and has ",
@@ -171,6 +390,12 @@ void FIFOQueue::TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) {
                   queue_size, ")"));
               return kComplete;
             }
+            if (use_ring_) {
+              Tuple tuple;
+              if (!ring_->TryPop(&tuple)) return kNoProgress;
+              attempt->done_callback = [callback, tuple]() { callback(tuple); };
+              return kComplete;
+            }
             if (queue_size > 0) {
               Tuple tuple;
               DequeueLocked(attempt->context, &tuple);
@@ -180,6 +405,7 @@ void FIFOQueue::TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) {
               return kNoProgress;
             }
           });
+      NoteAttemptAddedLocked(kDequeue);
     }
   }
   if (!already_cancelled) {
@@ -249,29 +475,20 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
           num_elements, [callback]() { callback(Tuple()); }, ctx, cm, token,
           [callback, allow_small_batch, this](Attempt* attempt)
               EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-                int64 queue_size = queues_[0].size();
+                int64 queue_size = SizeLocked();
 
                 if (closed_ && queue_size < attempt->elements_requested) {
                   // If we don't have enough for a full dequeue, we have
                   // to reset the attempt tuple.
                   if (!attempt->tuple.empty()) {
                     // Restore already-dequeued elements to the front of the
-                    // queue.
-                    for (int64 i = attempt->tuple[0].dim_size(0) -
-                                   attempt->elements_requested - 1;
-                         i >= 0; --i) {
+                    // queue, as a single chunk of the partial batch.
+                    const int64 dequeued = attempt->tuple[0].dim_size(0) -
+                                           attempt->elements_requested;
+                    if (dequeued > 0) {
                       for (int j = 0; j < num_components(); ++j) {
-                        PersistentTensor element;
-                        Status s = GetElementComponentFromBatch(
-                            attempt->tuple, i, j, attempt->context, &element);
-                        if (!s.ok()) {
-                          attempt->context->SetStatus(
-                              errors::DataLoss("Failed to restore element from "
-                                               "partially-dequeued batch "
-                                               "to FIFOQueue: ",
-                                               s.error_message()));
-                        }
-                        queues_[j].push_front(element);
+                        queues_[j].PushFrontBatch(
+                            PersistentTensor(attempt->tuple[j]), 0, dequeued);
                       }
                     }
                   }
@@ -298,44 +515,102 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
                   }
                 }
 
-                RunResult result = kNoProgress;
-                for (; queue_size > 0; --queue_size) {
-                  if (attempt->tuple.empty()) {
-                    // Only allocate tuple when we have something to dequeue
-                    // so we don't use excessive memory when there are many
-                    // blocked dequeue attempts waiting.
-                    attempt->tuple.reserve(num_components());
+                if (queue_size == 0) return kNoProgress;
+
+                if (!use_ring_ && attempt->tuple.empty() &&
+                    queues_[0].FrontChunkSize() >=
+                        attempt->elements_requested) {
+                  // The whole request lies within one enqueued chunk; if
+                  // its elements are suitably aligned, return them without
+                  // copying.
+                  const int64 n = attempt->elements_requested;
+                  Tuple tuple;
+                  tuple.reserve(num_components());
+                  for (int i = 0; i < num_components(); ++i) {
+                    Tensor batch;
+                    if (!queues_[i].FrontBatchView(attempt->context, n,
+                                                   &batch)) {
+                      break;
+                    }
+                    tuple.push_back(batch);
+                  }
+                  if (tuple.size() == static_cast<size_t>(num_components())) {
                     for (int i = 0; i < num_components(); ++i) {
-                      const TensorShape shape =
-                          ManyOutShape(i, attempt->elements_requested);
-                      Tensor element;
-                      attempt->context->allocate_temp(component_dtypes_[i],
-                                                      shape, &element);
-                      attempt->tuple.emplace_back(element);
+                      queues_[i].PopFront(n);
                     }
+                    attempt->elements_requested = 0;
+                    attempt->done_callback = [callback, tuple]() {
+                      callback(tuple);
+                    };
+                    return kComplete;
                   }
-                  result = kProgress;
+                }
+
+                if (attempt->tuple.empty()) {
+                  // Only allocate tuple when we have something to dequeue
+                  // so we don't use excessive memory when there are many
+                  // blocked dequeue attempts waiting.
+                  attempt->tuple.reserve(num_components());
+                  for (int i = 0; i < num_components(); ++i) {
+                    const TensorShape shape =
+                        ManyOutShape(i, attempt->elements_requested);
+                    Tensor element;
+                    attempt->context->allocate_temp(component_dtypes_[i],
+                                                    shape, &element);
+                    attempt->tuple.emplace_back(element);
+                  }
+                }
+                if (use_ring_) {
+                  RunResult result = kNoProgress;
                   Tuple tuple;
-                  DequeueLocked(attempt->context, &tuple);
+                  while (ring_->TryPop(&tuple)) {
+                    result = kProgress;
+                    const int64 index = attempt->tuple[0].dim_size(0) -
+                                        attempt->elements_requested;
+                    for (int i = 0; i < num_components(); ++i) {
+                      attempt->context->SetStatus(CopyElementToSlice(
+                          tuple[i], &attempt->tuple[i], index));
+                      if (!attempt->context->status().ok()) return kComplete;
+                    }
+                    --attempt->elements_requested;
+                    if (attempt->elements_requested == 0) {
+                      tuple = attempt->tuple;
+                      attempt->done_callback = [callback, tuple]() {
+                        callback(tuple);
+                      };
+                      return kComplete;
+                    }
+                  }
+                  return result;
+                }
+                // Copy whole runs of elements out of each chunk, rather than
+                // one element at a time.
+                while (queues_[0].size() > 0) {
+                  const int64 n = std::min<int64>(
+                      queues_[0].FrontChunkSize(),
+                      attempt->elements_requested);
                   const int64 index = attempt->tuple[0].dim_size(0) -
                                       attempt->elements_requested;
                   for (int i = 0; i < num_components(); ++i) {
-                    attempt->context->SetStatus(CopyElementToSlice(
-                        tuple[i], &attempt->tuple[i], index));
+                    attempt->context->SetStatus(queues_[i].CopyFrontBatch(
+                        attempt->context, n, &attempt->tuple[i], index));
                     if (!attempt->context->status().ok()) return kComplete;
                   }
-                  tuple.clear();
-                  --attempt->elements_requested;
+                  for (int i = 0; i < num_components(); ++i) {
+                    queues_[i].PopFront(n);
+                  }
+                  attempt->elements_requested -= n;
                   if (attempt->elements_requested == 0) {
-                    tuple = attempt->tuple;
+                    Tuple tuple = attempt->tuple;
                     attempt->done_callback = [callback, tuple]() {
                       callback(tuple);
                     };
                     return kComplete;
                   }
                 }
-                return result;
+                return kProgress;
               });
+      NoteAttemptAddedLocked(kDequeue);
     }
   }
   if (!already_cancelled) {
@@ -346,11 +621,44 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
   }
 }
 
+void FIFOQueue::Close(OpKernelContext* ctx, bool cancel_pending_enqueues,
+                      DoneCallback callback) {
+  if (ring_ != nullptr) {
+    closing_ = true;
+    // Lock-free operations that started before closing_ was set never
+    // block, so this wait is short.
+    while (num_lock_free_ops_ > 0) {
+      std::this_thread::yield();
+    }
+    // From now on every operation goes through the attempt lists, so the
+    // close and anything after it can use queues_ as usual.
+    mutex_lock lock(mu_);
+    if (use_ring_) {
+      Tuple tuple;
+      while (ring_->TryPop(&tuple)) {
+        for (int i = 0; i < num_components(); ++i) {
+          queues_[i].push_back(PersistentTensor(tuple[i]));
+        }
+      }
+      use_ring_ = false;
+    }
+  }
+  QueueBase::Close(ctx, cancel_pending_enqueues, callback);
+}
+
 Status FIFOQueue::MatchesNodeDef(const NodeDef& node_def) {
   TF_RETURN_IF_ERROR(MatchesNodeDefOp(node_def, "FIFOQueue"));
   TF_RETURN_IF_ERROR(MatchesNodeDefCapacity(node_def, capacity_));
   TF_RETURN_IF_ERROR(MatchesNodeDefTypes(node_def));
   TF_RETURN_IF_ERROR(MatchesNodeDefShapes(node_def));
+  bool requested_lock_free = false;
+  TF_RETURN_IF_ERROR(
+      GetNodeAttr(node_def, "lock_free", &requested_lock_free));
+  if (requested_lock_free != lock_free_) {
+    return errors::InvalidArgument("Shared queue '", name_, "' has lock_free ",
+                                   lock_free_, " but requested lock_free was ",
+                                   requested_lock_free);
+  }
   return Status::OK();
 }
 
@@ -16,13 +16,16 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_FIFO_QUEUE_H_
 #define TENSORFLOW_KERNELS_FIFO_QUEUE_H_
 
+#include <atomic>
 #include <deque>
+#include <memory>
 #include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/mpmc_ring_buffer.h"
 #include "tensorflow/core/kernels/typed_queue.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -30,11 +33,77 @@ limitations under the License.
 
 namespace tensorflow {
 
-class FIFOQueue : public TypedQueue<std::deque<PersistentTensor> > {
+// The queued values of one component of a FIFOQueue. The elements of a batch
+// from EnqueueMany are copied into a single chunk tensor, kept with the range
+// of its elements that are still queued, rather than into one tensor per
+// element. Every component of a FIFOQueue is pushed and popped
+// the same way, so all components have the same chunk boundaries.
+class FIFOQueueComponent {
+ public:
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Adds a single element at the back or front of the queue.
+  void push_back(const PersistentTensor& element);
+  void push_front(const PersistentTensor& element);
+
+  // Adds the elements [begin, end) of batch, which holds one element per
+  // index of its first dimension, at the back or front of the queue.
+  void PushBackBatch(const PersistentTensor& batch, int64 begin, int64 end);
+  void PushFrontBatch(const PersistentTensor& batch, int64 begin, int64 end);
+
+  // Returns the number of elements in the chunk at the front of the queue.
+  // REQUIRES: !empty()
+  int64 FrontChunkSize() const;
+
+  // Sets *element to the front element, sharing the chunk's buffer when it
+  // is suitably aligned and copying it otherwise.
+  // REQUIRES: !empty()
+  Status FrontElement(OpKernelContext* ctx, Tensor* element);
+
+  // If the first n elements can be returned as a batch without copying, sets
+  // *batch to them and returns true.
+  // REQUIRES: 0 < n <= FrontChunkSize()
+  bool FrontBatchView(OpKernelContext* ctx, int64 n, Tensor* batch);
+
+  // Copies the first n elements into batch, starting at index in its first
+  // dimension.
+  // REQUIRES: 0 < n <= FrontChunkSize()
+  Status CopyFrontBatch(OpKernelContext* ctx, int64 n, Tensor* batch,
+                        int64 index);
+
+  // Removes the first n elements.
+  // REQUIRES: 0 < n <= FrontChunkSize()
+  void PopFront(int64 n);
+
+ private:
+  struct Chunk {
+    PersistentTensor tensor;
+    // True if tensor is a batch and [begin, end) are the queued indices of
+    // its first dimension. Otherwise tensor is a single element.
+    bool is_batch;
+    int64 begin;
+    int64 end;
+  };
+
+  std::deque<Chunk> chunks_;
+  size_t size_ = 0;
+};
+
+// If lock_free is true, a FIFOQueue keeps its elements in an MPMCRingBuffer
+// instead of in queues_, and single-element enqueues and dequeues that need
+// not wait (the queue is neither full nor empty, and no earlier attempt is
+// waiting) complete without acquiring mu_. Everything else, including
+// EnqueueMany and DequeueMany, takes the usual path through the attempt
+// lists. Closing the queue moves the remaining elements into queues_.
+// A lock-free queue must have a bounded capacity.
+class FIFOQueue : public TypedQueue<FIFOQueueComponent> {
  public:
   FIFOQueue(int32 capacity, const DataTypeVector& component_dtypes,
             const std::vector<TensorShape>& component_shapes,
-            const string& name);
+            const string& name, bool lock_free);
+
+  Status Initialize() override;
 
   // Implementations of QueueInterface methods --------------------------------
 
@@ -46,11 +115,13 @@ class FIFOQueue : public TypedQueue<std::deque<PersistentTensor> > {
   void TryDequeueMany(int num_elements, OpKernelContext* ctx,
                       bool allow_small_batch,
                       CallbackWithTuple callback) override;
+  void Close(OpKernelContext* ctx, bool cancel_pending_enqueues,
+             DoneCallback callback) override;
   Status MatchesNodeDef(const NodeDef& node_def) override;
 
   int32 size() override {
     mutex_lock lock(mu_);
-    return queues_[0].size();
+    return SizeLocked();
   }
 
  protected:
@@ -60,12 +131,30 @@ class FIFOQueue : public TypedQueue<std::deque<PersistentTensor> > {
   void DequeueLocked(OpKernelContext* ctx, Tuple* tuple)
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
-  static Status GetElementComponentFromBatch(const Tuple& tuple, int64 index,
-                                             int component,
-                                             OpKernelContext* ctx,
-                                             PersistentTensor* out_element);
-
  private:
+  int64 SizeLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return use_ring_ ? ring_->size() : queues_[0].size();
+  }
+
+  // Try to enqueue or dequeue a single element without acquiring mu_.
+  // Return false if the caller must fall back to an attempt.
+  bool TryEnqueueLockFree(const Tuple& tuple);
+  bool TryDequeueLockFree(Tuple* tuple);
+
+  // Counts an attempt just added to enqueue_attempts_ (or dequeue_attempts_),
+  // so that lock-free operations stop overtaking it and flush it when they
+  // may have let it make progress.
+  void NoteAttemptAddedLocked(Action action) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const bool lock_free_;
+  std::unique_ptr<MPMCRingBuffer<Tuple>> ring_;
+  // True while the elements are kept in ring_ rather than queues_.
+  bool use_ring_ GUARDED_BY(mu_);
+  // Set when the queue starts closing; disables the lock-free path.
+  std::atomic<bool> closing_;
+  // The number of lock-free enqueues and dequeues in progress.
+  std::atomic<int64> num_lock_free_ops_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(FIFOQueue);
 };
 
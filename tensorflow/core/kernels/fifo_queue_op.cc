@@ -43,13 +43,15 @@ class FIFOQueueOp : public QueueOp {
  public:
   explicit FIFOQueueOp(OpKernelConstruction* context) : QueueOp(context) {
     OP_REQUIRES_OK(context, context->GetAttr("shapes", &component_shapes_));
+    OP_REQUIRES_OK(context, context->GetAttr("lock_free", &lock_free_));
   }
 
  protected:
   CreatorCallback GetCreator() const override {
     return [this](QueueInterface** ret) {
-      FIFOQueue* queue = new FIFOQueue(capacity_, component_types_,
-                                       component_shapes_, cinfo_.name());
+      FIFOQueue* queue =
+          new FIFOQueue(capacity_, component_types_, component_shapes_,
+                        cinfo_.name(), lock_free_);
       Status s = queue->Initialize();
       if (s.ok()) {
         *ret = queue;
@@ -62,6 +64,7 @@ class FIFOQueueOp : public QueueOp {
 
  private:
   std::vector<TensorShape> component_shapes_;
+  bool lock_free_;
   TF_DISALLOW_COPY_AND_ASSIGN(FIFOQueueOp);
 };
 
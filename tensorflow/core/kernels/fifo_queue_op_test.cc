@@ -0,0 +1,73 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// A graph in which num_pairs enqueues and as many dequeues run concurrently
+// against a single FIFOQueue, so that each run of the graph measures how well
+// the queue copes with contending producers and consumers.
+static Graph* QueueContention(int num_pairs, bool lock_free) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* queue;
+  TF_CHECK_OK(NodeBuilder(g->NewName("queue"), "FIFOQueue")
+                  .Attr("component_types", {DT_FLOAT})
+                  .Attr("shapes", {TensorShape({})})
+                  .Attr("capacity", 1024)
+                  .Attr("lock_free", lock_free)
+                  .Finalize(g, &queue));
+  Tensor value(DT_FLOAT, TensorShape({}));
+  value.scalar<float>()() = 1.0f;
+  Node* component = test::graph::Constant(g, value);
+  for (int i = 0; i < num_pairs; ++i) {
+    Node* node;
+    TF_CHECK_OK(NodeBuilder(g->NewName("enqueue"), "QueueEnqueue")
+                    .Input(queue)
+                    .Input({NodeBuilder::NodeOut(component)})
+                    .Finalize(g, &node));
+    TF_CHECK_OK(NodeBuilder(g->NewName("dequeue"), "QueueDequeue")
+                    .Input(queue)
+                    .Attr("component_types", {DT_FLOAT})
+                    .Finalize(g, &node));
+  }
+  return g;
+}
+
+static void BM_QueueContention(int iters, int num_pairs, bool lock_free) {
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_pairs);
+  testing::UseRealTime();
+  test::Benchmark("cpu", QueueContention(num_pairs, lock_free)).Run(iters);
+}
+
+static void BM_FIFOQueueContention(int iters, int num_pairs) {
+  BM_QueueContention(iters, num_pairs, false);
+}
+BENCHMARK(BM_FIFOQueueContention)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+static void BM_LockFreeFIFOQueueContention(int iters, int num_pairs) {
+  BM_QueueContention(iters, num_pairs, true);
+}
+BENCHMARK(BM_LockFreeFIFOQueueContention)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+}  // namespace
+}  // namespace tensorflow
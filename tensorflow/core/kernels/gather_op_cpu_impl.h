@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -29,15 +30,20 @@ typedef Eigen::ThreadPoolDevice CPUDevice;
 
 namespace functor {
 
-// Helper method to copy using memcpy.
+// Number of indices ahead of the current one whose rows are prefetched, and
+// the number of leading bytes of each of those rows that are prefetched.
+constexpr int kGatherPrefetchDistance = 8;
+constexpr size_t kGatherPrefetchBytes = 256;
+
+// Helper method to copy using memcpy. Copies the slices for indices in
+// [first, last), coalescing runs of consecutive indices into a single copy.
+// Returns the position of the first invalid index in the range, or -1.
 template <typename T, typename Index, typename SliceIndex,
           SliceIndex static_slice_elems>
 SliceIndex HandleCopies(typename TTypes<T>::ConstMatrix params,
                         typename TTypes<Index>::ConstFlat indices,
-                        SliceIndex slice_elems,
-                        typename TTypes<T>::Matrix out) {
-  const SliceIndex first_dim_size =
-      static_cast<SliceIndex>(indices.dimension(0));
+                        SliceIndex slice_elems, SliceIndex first,
+                        SliceIndex last, typename TTypes<T>::Matrix out) {
   const Index limit = static_cast<Index>(params.dimension(0));
   T* out_base = &out(0, 0);
   const T* params_base = &params(0, 0);
@@ -48,25 +54,41 @@ SliceIndex HandleCopies(typename TTypes<T>::ConstMatrix params,
   }
   // Compute slice_bytes here so that static knowledge is available
   const size_t slice_bytes = slice_elems * sizeof(T);
-  for (SliceIndex i = 0; i < first_dim_size; i++) {
-    const SliceIndex j = i + 1;
-    if (j < first_dim_size) {
-      port::prefetch<port::PREFETCH_HINT_T0>(&params(indices(j), 0));
-      port::prefetch<port::PREFETCH_HINT_T0>(&out(j, 0));
+  const size_t prefetch_bytes = std::min(slice_bytes, kGatherPrefetchBytes);
+  for (SliceIndex i = first; i < last;) {
+    const SliceIndex j = i + kGatherPrefetchDistance;
+    if (j < last) {
+      const Index prefetch_index = internal::SubtleMustCopy(indices(j));
+      if (FastBoundsCheck(prefetch_index, limit)) {
+        const char* row = reinterpret_cast<const char*>(
+            params_base + prefetch_index * slice_elems);
+        for (size_t b = 0; b < prefetch_bytes; b += 64) {
+          port::prefetch<port::PREFETCH_HINT_T0>(row + b);
+        }
+      }
     }
     // Grab the index and check its validity.  An earlier version of the
     // code checked it and then grabbed it from memory a second time, which
     // was a security risk since it could have changed in between.
     const Index index = internal::SubtleMustCopy(indices(i));
     if (!FastBoundsCheck(index, limit)) return i;
-    // Copy using memcpy if possible, otherwise an Eigen loop
     // TODO(cwhipkey): avoid linking to framework to get Allocator (to improve
     // ahead-of-time compilation binary size).
     if (Allocator::is_simple<T>::value) {
+      // Extend the copy over following indices that address the next rows
+      // of params, which is common for sorted or range-like lookups.
+      SliceIndex run = 1;
+      while (i + run < last) {
+        const Index next = internal::SubtleMustCopy(indices(i + run));
+        if (next != index + run || !FastBoundsCheck(next, limit)) break;
+        ++run;
+      }
       memcpy(out_base + i * slice_elems, params_base + index * slice_elems,
-             slice_bytes);
+             run * slice_bytes);
+      i += run;
     } else {
       out.template chip<0>(i) = params.template chip<0>(index);
+      ++i;
     }
   }
   return -1;
@@ -74,36 +96,54 @@ SliceIndex HandleCopies(typename TTypes<T>::ConstMatrix params,
 
 template <typename T, typename Index>
 struct GatherCpu {
-  int64 operator()(typename TTypes<T>::ConstMatrix params,
+  int64 operator()(const CPUDevice& d,
+                   typename TTypes<T>::ConstMatrix params,
                    typename TTypes<Index>::ConstFlat indices,
                    typename TTypes<T>::Matrix out) {
     const int64 N = indices.size();
     const int64 slice_size = out.size() / N;
-    int64 bad_i;
 
     bool use_large = (slice_size > std::numeric_limits<int32>::max() ||
                       params.size() > std::numeric_limits<int32>::max() ||
                       N > std::numeric_limits<int32>::max());
-#define CALL(elems)                                                   \
-  do {                                                                \
-    if (use_large) {                                                  \
-      bad_i = HandleCopies<T, Index, int64, elems>(params, indices,   \
-                                                   slice_size, out);  \
-    } else {                                                          \
-      const int32 small_slice = static_cast<int32>(slice_size);       \
-      bad_i = HandleCopies<T, Index, int32, elems>(params, indices,   \
-                                                   small_slice, out); \
-    }                                                                 \
+
+    // Shards of the indices are copied in parallel. Each shard reports the
+    // first invalid index it finds, and the smallest one is returned so that
+    // the error doesn't depend on the sharding.
+    mutex mu;
+    int64 bad_i = -1;
+    auto work = [&](Eigen::Index first, Eigen::Index last) {
+      int64 shard_bad_i;
+#define CALL(elems)                                                        \
+  do {                                                                     \
+    if (use_large) {                                                       \
+      shard_bad_i = HandleCopies<T, Index, int64, elems>(                  \
+          params, indices, slice_size, first, last, out);                  \
+    } else {                                                               \
+      const int32 small_slice = static_cast<int32>(slice_size);            \
+      shard_bad_i = HandleCopies<T, Index, int32, elems>(                  \
+          params, indices, small_slice, static_cast<int32>(first),         \
+          static_cast<int32>(last), out);                                  \
+    }                                                                      \
   } while (0)
 
-    if (slice_size == 10)
-      CALL(10);
-    else if (slice_size == 20)
-      CALL(20);
-    else
-      CALL(-1);
+      if (slice_size == 10)
+        CALL(10);
+      else if (slice_size == 20)
+        CALL(20);
+      else
+        CALL(-1);
 #undef CALL
 
+      if (shard_bad_i >= 0) {
+        mutex_lock l(mu);
+        if (bad_i < 0 || shard_bad_i < bad_i) bad_i = shard_bad_i;
+      }
+    };
+    const double slice_bytes = slice_size * sizeof(T);
+    d.parallelFor(N, Eigen::TensorOpCost(slice_bytes + sizeof(Index),
+                                         slice_bytes, 0),
+                  work);
     return bad_i;
   }
 };
@@ -120,6 +120,43 @@ TEST_F(GatherOpTest, HighRank) {
   test::ExpectTensorEqual<float>(expected, *GetOutput(0));
 }
 
+TEST_F(GatherOpTest, Adjacent_TwoD32) {
+  MakeOp(DT_INT32);
+
+  // Feed and run; runs of consecutive indices are copied together.
+  AddInputFromArray<float>(TensorShape({5, 2}),
+                           {0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+  AddInputFromArray<int32>(TensorShape({7}), {1, 2, 3, 3, 4, 0, 1});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Check the output.
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({7, 2}));
+  test::FillValues<float>(&expected,
+                          {2, 3, 4, 5, 6, 7, 6, 7, 8, 9, 0, 1, 2, 3});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(GatherOpTest, Large_TwoD32) {
+  MakeOp(DT_INT32);
+
+  // Feed and run with enough indices to be split across threads.
+  const int kRows = 1000;
+  const int kDim = 64;
+  const int kLookups = 20000;
+  AddInput<float>(TensorShape({kRows, kDim}), [](int i) -> float { return i; });
+  AddInput<int32>(TensorShape({kLookups}),
+                  [](int i) -> int32 { return (i * 7 + i / 3) % kRows; });
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Check the output.
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({kLookups, kDim}));
+  test::FillFn<float>(&expected, [](int i) -> float {
+    const int row = ((i / kDim) * 7 + (i / kDim) / 3) % kRows;
+    return row * kDim + i % kDim;
+  });
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
 TEST_F(GatherOpTest, Error_IndexOutOfRange) {
   MakeOp(DT_INT32);
 
@@ -133,10 +170,25 @@ TEST_F(GatherOpTest, Error_IndexOutOfRange) {
       << s;
 }
 
+TEST_F(GatherOpTest, Error_FirstIndexOutOfRangeIsReported) {
+  MakeOp(DT_INT32);
+
+  // Feed and run with several invalid indices spread across threads.
+  const int kLookups = 20000;
+  AddInput<float>(TensorShape({100, 32}), [](int i) -> float { return i; });
+  AddInput<int32>(TensorShape({kLookups}), [](int i) -> int32 {
+    return (i >= 1234 && i % 1000 == 234) ? 100 + i : i % 100;
+  });
+  Status s = RunOpKernel();
+  EXPECT_TRUE(StringPiece(s.ToString())
+                  .contains("indices[1234] = 1334 is not in [0, 100)"))
+      << s;
+}
+
 constexpr int kLookups = 2000;
 
 template <typename Index>
-static Graph* Gather(int dim) {
+static Graph* Gather(int dim, int lookups = kLookups) {
   Graph* g = new Graph(OpRegistry::Global());
   // Always use a 512MB buffer.
   const int kRows = ((512 << 20) / sizeof(float)) / dim;
@@ -146,10 +198,10 @@ static Graph* Gather(int dim) {
   random::PhiloxRandom philox(301, 17);
   random::SimplePhilox rnd(&philox);
   std::vector<Index> indices_vec;
-  for (int i = 0; i < kLookups; i++) {
+  for (int i = 0; i < lookups; i++) {
     indices_vec.push_back(rnd.Uniform(kRows));
   }
-  Tensor indices(DataTypeToEnum<Index>::value, TensorShape({kLookups}));
+  Tensor indices(DataTypeToEnum<Index>::value, TensorShape({lookups}));
   for (int i = 0; i < indices_vec.size(); i++) {
     indices.flat<Index>()(i) = indices_vec[i];
   }
@@ -181,5 +233,17 @@ BM_GATHER(gpu, int32);
 BM_GATHER(cpu, int64);
 BM_GATHER(gpu, int64);
 
+// Embedding-style lookups: many indices into a large table.
+constexpr int kManyLookups = 100000;
+
+static void BM_cpu_gather_many(int iters, int dim) {
+  const int64 tot = static_cast<int64>(iters) * kManyLookups * dim;
+  testing::ItemsProcessed(tot);
+  testing::BytesProcessed(tot * sizeof(float));
+  testing::UseRealTime();
+  test::Benchmark("cpu", Gather<int32>(dim, kManyLookups)).Run(iters);
+}
+BENCHMARK(BM_cpu_gather_many)->Arg(16)->Arg(64)->Arg(256);
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,333 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks of the most heavily used CPU kernels, over a fixed set of
+// representative shapes.  Unlike the benchmarks next to each kernel's tests,
+// which explore one kernel's parameters, these are meant to be run together
+// before and after a change and compared against a baseline:
+//
+//   bazel run -c opt //tensorflow/tools/test:kernel_benchmarks -- \
+//       --test_log_output=/tmp/kernel_benchmarks.pbtxt
+//   bazel run //tensorflow/tools/test:compare_benchmarks -- \
+//       --results=/tmp/kernel_benchmarks.pbtxt --baseline=<baseline.pbtxt>
+//
+// where the baseline was recorded on the same machine, before the change,
+// by passing --update_baseline to compare_benchmarks.
+//
+// Benchmark names encode the shapes, so keep them stable: renaming a
+// benchmark drops it from the comparison.
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+
+static Node* RandomFloat(Graph* g, const TensorShape& shape) {
+  Tensor t(DT_FLOAT, shape);
+  t.flat<float>().setRandom();
+  return test::graph::Constant(g, t);
+}
+
+// Returns int32 values in [0, limit), sorted if 'sorted' is true.
+static Node* RandomIndices(Graph* g, int64 n, int32 limit, bool sorted) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  Tensor t(DT_INT32, TensorShape({n}));
+  auto flat = t.flat<int32>();
+  for (int64 i = 0; i < n; ++i) {
+    flat(i) = sorted ? static_cast<int32>(i * limit / n) : rnd.Uniform(limit);
+  }
+  return test::graph::Constant(g, t);
+}
+
+static Node* Int32Vector(Graph* g, const std::vector<int32>& values) {
+  Tensor t(DT_INT32, TensorShape({static_cast<int64>(values.size())}));
+  std::copy(values.begin(), values.end(), t.flat<int32>().data());
+  return test::graph::Constant(g, t);
+}
+
+// MatMul of [M, K] by [K, N].
+static Graph* MatMul(int m, int k, int n) {
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Matmul(g, RandomFloat(g, TensorShape({m, k})),
+                      RandomFloat(g, TensorShape({k, n})), false, false);
+  return g;
+}
+
+#define BM_KERNEL_MATMUL(M, K, N)                                         \
+  static void BM_Kernel_MatMul_##M##_##K##_##N(int iters) {               \
+    testing::ItemsProcessed(static_cast<int64>(iters) * M * K * N * 2);   \
+    test::Benchmark("cpu", MatMul(M, K, N)).Run(iters);                   \
+  }                                                                       \
+  BENCHMARK(BM_Kernel_MatMul_##M##_##K##_##N);
+
+BM_KERNEL_MATMUL(1, 1024, 1024);
+BM_KERNEL_MATMUL(32, 1024, 1024);
+BM_KERNEL_MATMUL(256, 256, 256);
+BM_KERNEL_MATMUL(512, 512, 512);
+
+// SAME, stride 1 Conv2D of an [N, H, W, C] input with [F, F, C, O] filters.
+static Graph* Conv2D(int n, int h, int w, int c, int f, int o) {
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Conv2D(g, RandomFloat(g, TensorShape({n, h, w, c})),
+                      RandomFloat(g, TensorShape({f, f, c, o})));
+  return g;
+}
+
+#define BM_KERNEL_CONV2D(N, H, W, C, F, O)                                   \
+  static void BM_Kernel_Conv2D_##N##_##H##_##W##_##C##_##F##_##O(int iters) { \
+    testing::ItemsProcessed(static_cast<int64>(iters) * N * H * W * C * F *  \
+                            F * O * 2);                                      \
+    test::Benchmark("cpu", Conv2D(N, H, W, C, F, O)).Run(iters);             \
+  }                                                                          \
+  BENCHMARK(BM_Kernel_Conv2D_##N##_##H##_##W##_##C##_##F##_##O);
+
+BM_KERNEL_CONV2D(1, 56, 56, 64, 3, 64);
+BM_KERNEL_CONV2D(8, 28, 28, 128, 1, 128);
+BM_KERNEL_CONV2D(8, 14, 14, 256, 3, 256);
+
+// Gather of N random rows from a [R, D] float table.
+static Graph* Gather(int rows, int dim, int n) {
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Gather(g, RandomFloat(g, TensorShape({rows, dim})),
+                      RandomIndices(g, n, rows, false));
+  return g;
+}
+
+#define BM_KERNEL_GATHER(R, D, N)                                           \
+  static void BM_Kernel_Gather_##R##_##D##_##N(int iters) {                 \
+    testing::BytesProcessed(static_cast<int64>(iters) * N * D *             \
+                            sizeof(float));                                 \
+    test::Benchmark("cpu", Gather(R, D, N)).Run(iters);                     \
+  }                                                                         \
+  BENCHMARK(BM_Kernel_Gather_##R##_##D##_##N);
+
+BM_KERNEL_GATHER(100000, 64, 1024);
+BM_KERNEL_GATHER(1000, 512, 4096);
+
+// Sums the [R, D] rows of a float matrix into S segments.  SegmentSum gets
+// sorted segment ids, UnsortedSegmentSum random ones.
+static Graph* SegmentSum(const string& op, int rows, int dim, int segments) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const bool sorted = op == "SegmentSum";
+  NodeBuilder builder(g->NewName("n"), op);
+  builder.Input(RandomFloat(g, TensorShape({rows, dim})))
+      .Input(RandomIndices(g, rows, segments, sorted));
+  if (!sorted) {
+    Tensor num_segments(DT_INT32, TensorShape({}));
+    num_segments.scalar<int32>()() = segments;
+    builder.Input(test::graph::Constant(g, num_segments));
+  }
+  TF_CHECK_OK(builder.Finalize(g, nullptr));
+  return g;
+}
+
+#define BM_KERNEL_SEGMENT(OP, R, D, S)                                      \
+  static void BM_Kernel_##OP##_##R##_##D##_##S(int iters) {                 \
+    testing::BytesProcessed(static_cast<int64>(iters) * R * D *             \
+                            sizeof(float));                                 \
+    test::Benchmark("cpu", SegmentSum(#OP, R, D, S)).Run(iters);            \
+  }                                                                         \
+  BENCHMARK(BM_Kernel_##OP##_##R##_##D##_##S);
+
+BM_KERNEL_SEGMENT(SegmentSum, 16384, 64, 128);
+BM_KERNEL_SEGMENT(SegmentSum, 16384, 64, 8192);
+BM_KERNEL_SEGMENT(UnsortedSegmentSum, 16384, 64, 128);
+BM_KERNEL_SEGMENT(UnsortedSegmentSum, 16384, 64, 8192);
+
+// Elementwise ops on [R, C] floats.  Binary ops broadcast a [C] row into the
+// second operand if 'broadcast' is true.
+static Graph* Cwise(const string& op, int rows, int cols, bool broadcast) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* x = RandomFloat(g, TensorShape({rows, cols}));
+  if (op == "Tanh" || op == "Sigmoid") {
+    test::graph::Unary(g, op, x);
+  } else {
+    Node* y = RandomFloat(
+        g, broadcast ? TensorShape({cols}) : TensorShape({rows, cols}));
+    test::graph::Binary(g, op, x, y);
+  }
+  return g;
+}
+
+#define BM_KERNEL_CWISE(OP, R, C, B)                                        \
+  static void BM_Kernel_Cwise_##OP##_##R##_##C##_##B(int iters) {           \
+    testing::ItemsProcessed(static_cast<int64>(iters) * R * C);             \
+    test::Benchmark("cpu", Cwise(#OP, R, C, B)).Run(iters);                 \
+  }                                                                         \
+  BENCHMARK(BM_Kernel_Cwise_##OP##_##R##_##C##_##B);
+
+BM_KERNEL_CWISE(Add, 1024, 1024, false);
+BM_KERNEL_CWISE(Add, 1024, 1024, true);
+BM_KERNEL_CWISE(Mul, 1024, 1024, false);
+BM_KERNEL_CWISE(Tanh, 1024, 1024, false);
+BM_KERNEL_CWISE(Sigmoid, 1024, 1024, false);
+
+// Sum of a [R, C] float matrix over its rows (axis 0), columns (axis 1), or
+// both (axis 2).
+static Graph* Sum(int rows, int cols, int axis) {
+  Graph* g = new Graph(OpRegistry::Global());
+  std::vector<int32> axes;
+  if (axis == 2) {
+    axes = {0, 1};
+  } else {
+    axes = {axis};
+  }
+  test::graph::Reduce(g, "Sum", RandomFloat(g, TensorShape({rows, cols})),
+                      Int32Vector(g, axes));
+  return g;
+}
+
+#define BM_KERNEL_SUM(R, C, A)                                              \
+  static void BM_Kernel_Sum_##R##_##C##_##A(int iters) {                    \
+    testing::ItemsProcessed(static_cast<int64>(iters) * R * C);             \
+    test::Benchmark("cpu", Sum(R, C, A)).Run(iters);                        \
+  }                                                                         \
+  BENCHMARK(BM_Kernel_Sum_##R##_##C##_##A);
+
+BM_KERNEL_SUM(1024, 1024, 0);
+BM_KERNEL_SUM(1024, 1024, 1);
+BM_KERNEL_SUM(1024, 1024, 2);
+BM_KERNEL_SUM(32, 65536, 1);
+
+// Transposes of a 2-D [R, C] matrix and of an NHWC batch into NCHW.
+static Graph* Transpose(const TensorShape& shape,
+                        const std::vector<int32>& perm) {
+  Graph* g = new Graph(OpRegistry::Global());
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Transpose")
+                  .Input(RandomFloat(g, shape))
+                  .Input(Int32Vector(g, perm))
+                  .Finalize(g, nullptr));
+  return g;
+}
+
+static void BM_Kernel_Transpose_1024_1024(int iters) {
+  testing::BytesProcessed(static_cast<int64>(iters) * 1024 * 1024 *
+                          sizeof(float));
+  test::Benchmark("cpu", Transpose(TensorShape({1024, 1024}), {1, 0}))
+      .Run(iters);
+}
+BENCHMARK(BM_Kernel_Transpose_1024_1024);
+
+static void BM_Kernel_Transpose_NHWC_NCHW_32_28_28_64(int iters) {
+  testing::BytesProcessed(static_cast<int64>(iters) * 32 * 28 * 28 * 64 *
+                          sizeof(float));
+  test::Benchmark("cpu",
+                  Transpose(TensorShape({32, 28, 28, 64}), {0, 3, 1, 2}))
+      .Run(iters);
+}
+BENCHMARK(BM_Kernel_Transpose_NHWC_NCHW_32_28_28_64);
+
+// Concatenation of N [R, C] float matrices along dimension D.
+static Graph* Concat(int n, int rows, int cols, int dim) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor concat_dim(DT_INT32, TensorShape({}));
+  concat_dim.scalar<int32>()() = dim;
+  std::vector<Node*> inputs;
+  for (int i = 0; i < n; ++i) {
+    inputs.push_back(RandomFloat(g, TensorShape({rows, cols})));
+  }
+  test::graph::Concat(g, test::graph::Constant(g, concat_dim), inputs);
+  return g;
+}
+
+#define BM_KERNEL_CONCAT(N, R, C, D)                                        \
+  static void BM_Kernel_Concat_##N##_##R##_##C##_##D(int iters) {           \
+    testing::BytesProcessed(static_cast<int64>(iters) * N * R * C *         \
+                            sizeof(float));                                 \
+    test::Benchmark("cpu", Concat(N, R, C, D)).Run(iters);                  \
+  }                                                                         \
+  BENCHMARK(BM_Kernel_Concat_##N##_##R##_##C##_##D);
+
+BM_KERNEL_CONCAT(4, 1024, 256, 0);
+BM_KERNEL_CONCAT(4, 1024, 256, 1);
+BM_KERNEL_CONCAT(64, 256, 16, 1);
+
+// ParseExample of B serialized Examples, each with K scalar float features
+// parsed as dense and K int64 features of 4 values parsed as sparse.
+static Graph* ParseExample(int batch_size, int num_keys) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor serialized(DT_STRING, TensorShape({batch_size}));
+  Example example;
+  auto* features = example.mutable_features()->mutable_feature();
+  for (int k = 0; k < num_keys; ++k) {
+    (*features)[strings::Printf("dense_%d", k)]
+        .mutable_float_list()
+        ->add_value(1.5f * k);
+    auto* int64_list =
+        (*features)[strings::Printf("sparse_%d", k)].mutable_int64_list();
+    for (int i = 0; i < 4; ++i) int64_list->add_value(k * 4 + i);
+  }
+  for (int b = 0; b < batch_size; ++b) {
+    CHECK(example.SerializeToString(&serialized.vec<string>()(b)));
+  }
+
+  std::vector<NodeBuilder::NodeOut> sparse_keys;
+  std::vector<NodeBuilder::NodeOut> dense_keys;
+  std::vector<NodeBuilder::NodeOut> dense_defaults;
+  std::vector<DataType> sparse_types;
+  std::vector<TensorShape> dense_shapes;
+  for (int k = 0; k < num_keys; ++k) {
+    Tensor dense_key(DT_STRING, TensorShape({}));
+    dense_key.scalar<string>()() = strings::Printf("dense_%d", k);
+    dense_keys.emplace_back(test::graph::Constant(g, dense_key));
+    Tensor dense_default(DT_FLOAT, TensorShape({}));
+    dense_default.scalar<float>()() = 0.0f;
+    dense_defaults.emplace_back(test::graph::Constant(g, dense_default));
+    dense_shapes.push_back(TensorShape());
+
+    Tensor sparse_key(DT_STRING, TensorShape({}));
+    sparse_key.scalar<string>()() = strings::Printf("sparse_%d", k);
+    sparse_keys.emplace_back(test::graph::Constant(g, sparse_key));
+    sparse_types.push_back(DT_INT64);
+  }
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "ParseExample")
+                  .Input(test::graph::Constant(g, serialized))
+                  .Input(test::graph::Constant(
+                      g, Tensor(DT_STRING, TensorShape({0}))))
+                  .Input(sparse_keys)
+                  .Input(dense_keys)
+                  .Input(dense_defaults)
+                  .Attr("sparse_types", sparse_types)
+                  .Attr("dense_shapes", dense_shapes)
+                  .Finalize(g, nullptr));
+  return g;
+}
+
+#define BM_KERNEL_PARSE_EXAMPLE(B, K)                                       \
+  static void BM_Kernel_ParseExample_##B##_##K(int iters) {                 \
+    testing::ItemsProcessed(static_cast<int64>(iters) * B);                 \
+    test::Benchmark("cpu", ParseExample(B, K)).Run(iters);                  \
+  }                                                                         \
+  BENCHMARK(BM_Kernel_ParseExample_##B##_##K);
+
+BM_KERNEL_PARSE_EXAMPLE(128, 10);
+BM_KERNEL_PARSE_EXAMPLE(512, 100);
+
+}  // end namespace tensorflow
@@ -0,0 +1,146 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_MPMC_RING_BUFFER_H_
+#define TENSORFLOW_KERNELS_MPMC_RING_BUFFER_H_
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A bounded first-in first-out buffer that any number of threads may push to
+// and pop from concurrently without taking a lock.
+//
+// Each slot carries a sequence number that says whether it is ready to be
+// written or read at a given position, so a push or pop only contends with
+// other operations on the same end of the buffer, through a single
+// compare-and-swap. TryPush and TryPop never block: they fail when the
+// buffer is full or empty, respectively (including when the slot they need
+// is still being written or read by another thread), and the caller decides
+// whether and how to wait.
+//
+// T must be default-constructible and movable.
+template <typename T>
+class MPMCRingBuffer {
+ public:
+  explicit MPMCRingBuffer(int64 capacity)
+      : capacity_(capacity), slots_(new Slot[capacity]) {
+    CHECK_GT(capacity, 0);
+    for (int64 i = 0; i < capacity_; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    push_pos_.store(0, std::memory_order_relaxed);
+    pop_pos_.store(0, std::memory_order_relaxed);
+  }
+
+  int64 capacity() const { return capacity_; }
+
+  // Appends a copy of value and returns true, or returns false if the buffer
+  // is full.
+  bool TryPush(const T& value) {
+    T copy(value);
+    return TryPushMove(&copy);
+  }
+
+  // Moves *value to the back of the buffer and returns true, or returns false
+  // and leaves *value unchanged if the buffer is full.
+  bool TryPushMove(T* value) {
+    Slot* slot;
+    uint64 pos = push_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      slot = &slots_[pos % capacity_];
+      const uint64 seq = slot->sequence.load(std::memory_order_acquire);
+      const int64 diff = static_cast<int64>(seq - pos);
+      if (diff == 0) {
+        if (push_pos_.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = push_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    slot->value = std::move(*value);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Moves the front element into *value and returns true, or returns false
+  // if the buffer is empty.
+  bool TryPop(T* value) {
+    Slot* slot;
+    uint64 pos = pop_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      slot = &slots_[pos % capacity_];
+      const uint64 seq = slot->sequence.load(std::memory_order_acquire);
+      const int64 diff = static_cast<int64>(seq - (pos + 1));
+      if (diff == 0) {
+        if (pop_pos_.compare_exchange_weak(pos, pos + 1,
+                                           std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = pop_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    *value = std::move(slot->value);
+    // Release whatever the moved-from value still holds before the slot is
+    // handed back to producers.
+    slot->value = T();
+    slot->sequence.store(pos + capacity_, std::memory_order_release);
+    return true;
+  }
+
+  // Returns the number of elements in the buffer. The result is exact only
+  // when no push or pop is in progress.
+  int64 size() const {
+    const uint64 pop_pos = pop_pos_.load(std::memory_order_acquire);
+    const uint64 push_pos = push_pos_.load(std::memory_order_acquire);
+    const int64 size = static_cast<int64>(push_pos - pop_pos);
+    if (size < 0) return 0;
+    return size > capacity_ ? capacity_ : size;
+  }
+
+ private:
+  // The two positions are kept on separate cache lines so that producers and
+  // consumers do not invalidate each other's line on every operation.
+  static constexpr int kCacheLineSize = 64;
+
+  struct Slot {
+    std::atomic<uint64> sequence;
+    T value;
+  };
+
+  const int64 capacity_;
+  std::unique_ptr<Slot[]> slots_;
+  alignas(kCacheLineSize) std::atomic<uint64> push_pos_;
+  alignas(kCacheLineSize) std::atomic<uint64> pop_pos_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MPMCRingBuffer);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_MPMC_RING_BUFFER_H_
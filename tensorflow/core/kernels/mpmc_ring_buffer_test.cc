@@ -0,0 +1,184 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/mpmc_ring_buffer.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(MPMCRingBufferTest, FirstInFirstOut) {
+  MPMCRingBuffer<int> buffer(4);
+  int value;
+  EXPECT_FALSE(buffer.TryPop(&value));
+  // Wrap around the buffer several times.
+  for (int round = 0; round < 5; ++round) {
+    for (int i = 0; i < 3; ++i) EXPECT_TRUE(buffer.TryPush(round * 10 + i));
+    EXPECT_EQ(3, buffer.size());
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_TRUE(buffer.TryPop(&value));
+      EXPECT_EQ(round * 10 + i, value);
+    }
+    EXPECT_EQ(0, buffer.size());
+  }
+}
+
+TEST(MPMCRingBufferTest, FullAndEmpty) {
+  MPMCRingBuffer<string> buffer(3);
+  EXPECT_EQ(3, buffer.capacity());
+  EXPECT_TRUE(buffer.TryPush("a"));
+  EXPECT_TRUE(buffer.TryPush("b"));
+  EXPECT_TRUE(buffer.TryPush("c"));
+  EXPECT_FALSE(buffer.TryPush("d"));
+  string moved = "e";
+  EXPECT_FALSE(buffer.TryPushMove(&moved));
+  EXPECT_EQ("e", moved);
+  EXPECT_EQ(3, buffer.size());
+
+  string value;
+  EXPECT_TRUE(buffer.TryPop(&value));
+  EXPECT_EQ("a", value);
+  EXPECT_TRUE(buffer.TryPushMove(&moved));
+  for (const char* expected : {"b", "c", "e"}) {
+    EXPECT_TRUE(buffer.TryPop(&value));
+    EXPECT_EQ(expected, value);
+  }
+  EXPECT_FALSE(buffer.TryPop(&value));
+}
+
+TEST(MPMCRingBufferTest, ConcurrentProducersAndConsumers) {
+  const int kNumProducers = 4;
+  const int kNumConsumers = 4;
+  const int kPerProducer = 10000;
+  MPMCRingBuffer<int> buffer(16);
+
+  // Each consumer records what it popped; since every producer pushes its
+  // values in increasing order, each consumer must see each producer's
+  // values in increasing order too.
+  std::vector<std::vector<int>> popped(kNumConsumers);
+  std::atomic<int> remaining(kNumProducers * kPerProducer);
+  {
+    thread::ThreadPool pool(Env::Default(), "test",
+                            kNumProducers + kNumConsumers);
+    for (int p = 0; p < kNumProducers; ++p) {
+      pool.Schedule([&buffer, p]() {
+        for (int i = 0; i < kPerProducer; ++i) {
+          while (!buffer.TryPush(p * kPerProducer + i)) {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+    for (int c = 0; c < kNumConsumers; ++c) {
+      pool.Schedule([&buffer, &popped, &remaining, c]() {
+        int value;
+        while (remaining > 0) {
+          if (buffer.TryPop(&value)) {
+            popped[c].push_back(value);
+            --remaining;
+          } else {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+  }
+
+  std::vector<bool> seen(kNumProducers * kPerProducer, false);
+  for (const std::vector<int>& values : popped) {
+    std::vector<int> last(kNumProducers, -1);
+    for (int value : values) {
+      EXPECT_FALSE(seen[value]) << value;
+      seen[value] = true;
+      const int producer = value / kPerProducer;
+      EXPECT_LT(last[producer], value);
+      last[producer] = value;
+    }
+  }
+  for (bool s : seen) EXPECT_TRUE(s);
+}
+
+// Contention benchmarks: "threads" threads each alternately push and pop,
+// through the lock-free buffer or through a mutex-protected deque.
+
+template <typename Pusher, typename Popper>
+static void RunContention(int iters, int threads, Pusher push, Popper pop) {
+  testing::StopTiming();
+  thread::ThreadPool pool(Env::Default(), "bench", threads);
+  BlockingCounter counter(threads);
+  testing::ItemsProcessed(static_cast<int64>(iters) * threads);
+  testing::UseRealTime();
+  testing::StartTiming();
+  for (int t = 0; t < threads; ++t) {
+    pool.Schedule([iters, &counter, &push, &pop]() {
+      int value;
+      for (int i = 0; i < iters; ++i) {
+        while (!push(i)) {
+          std::this_thread::yield();
+        }
+        while (!pop(&value)) {
+          std::this_thread::yield();
+        }
+      }
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  testing::StopTiming();
+}
+
+static void BM_MPMCRingBufferContention(int iters, int threads) {
+  MPMCRingBuffer<int> buffer(1024);
+  RunContention(iters, threads,
+                [&buffer](int value) { return buffer.TryPush(value); },
+                [&buffer](int* value) { return buffer.TryPop(value); });
+}
+BENCHMARK(BM_MPMCRingBufferContention)->Arg(1)->Arg(4)->Arg(16);
+
+static void BM_MutexDequeContention(int iters, int threads) {
+  mutex mu;
+  std::deque<int> queue;
+  RunContention(iters, threads,
+                [&mu, &queue](int value) {
+                  mutex_lock l(mu);
+                  if (queue.size() >= 1024) return false;
+                  queue.push_back(value);
+                  return true;
+                },
+                [&mu, &queue](int* value) {
+                  mutex_lock l(mu);
+                  if (queue.empty()) return false;
+                  *value = queue.front();
+                  queue.pop_front();
+                  return true;
+                });
+}
+BENCHMARK(BM_MutexDequeContention)->Arg(1)->Arg(4)->Arg(16);
+
+}  // namespace
+}  // namespace tensorflow
@@ -63,6 +63,16 @@ Status GetBroadcastSize(const int index, const int in_size, const int ksize,
   return Status::OK();
 }
 
+gtl::InlinedVector<int64, 4> RowMajorStrides(const TensorShape& s) {
+  gtl::InlinedVector<int64, 4> strides(s.dims());
+  int64 stride = 1;
+  for (int d = s.dims() - 1; d >= 0; --d) {
+    strides[d] = stride;
+    stride *= s.dim_size(d);
+  }
+  return strides;
+}
+
 string SanitizeThreadSuffix(string suffix) {
   string clean;
   for (int i = 0; i < suffix.size(); ++i) {
@@ -283,5 +283,15 @@ TEST_F(OpsUtilTest, SanitizeThreadSuffix) {
   EXPECT_EQ("_aBc123_-___", SanitizeThreadSuffix("/aBc123_-  /"));
 }
 
+TEST_F(OpsUtilTest, RowMajorStrides) {
+  EXPECT_TRUE(RowMajorStrides(TensorShape({})).empty());
+  EXPECT_EQ((gtl::InlinedVector<int64, 4>{1}),
+            RowMajorStrides(TensorShape({7})));
+  EXPECT_EQ((gtl::InlinedVector<int64, 4>{60, 20, 5, 1}),
+            RowMajorStrides(TensorShape({2, 3, 4, 5})));
+  EXPECT_EQ((gtl::InlinedVector<int64, 4>{0, 3, 1}),
+            RowMajorStrides(TensorShape({2, 0, 3})));
+}
+
 }  // namespace
 }  // namespace tensorflow
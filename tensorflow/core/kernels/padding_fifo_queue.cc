@@ -35,7 +35,8 @@ PaddingFIFOQueue::PaddingFIFOQueue(
     int capacity, const DataTypeVector& component_dtypes,
     const std::vector<PartialTensorShape>& partial_shapes, const string& name)
     : FIFOQueue(capacity, component_dtypes,
-                ConvertShapesPartialDimensionsToZero(partial_shapes), name),
+                ConvertShapesPartialDimensionsToZero(partial_shapes), name,
+                false /* lock_free */),
       partial_shapes_(partial_shapes) {}
 
 Status PaddingFIFOQueue::Initialize() {
@@ -146,6 +147,7 @@ void PaddingFIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
               result = kProgress;
               Tuple tuple;
               DequeueLocked(attempt->context, &tuple);
+              if (!attempt->context->status().ok()) return kComplete;
               attempt->tuples.push_back(tuple);
               tuple.clear();
               --attempt->elements_requested;
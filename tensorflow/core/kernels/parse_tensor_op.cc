@@ -15,15 +15,82 @@ limitations under the License.
 
 // See docs in ../ops/parsing_ops.cc.
 
+#include <limits.h>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/protobuf.h"
 
 namespace tensorflow {
 
+namespace {
+
+// Splits a serialized TensorProto into the bytes of its tensor_content field,
+// returned as a view into `serialized`, and the serialization of all its other
+// fields, returned in `header`.  Returns false if the input uses wire types
+// this does not handle (or is malformed); the caller should then parse the
+// proto the usual way.
+bool SplitTensorContent(StringPiece serialized, string* header,
+                        StringPiece* content) {
+  protobuf::io::CodedInputStream stream(
+      reinterpret_cast<const uint8*>(serialized.data()), serialized.size());
+  stream.SetTotalBytesLimit(INT_MAX, INT_MAX);
+  header->clear();
+  *content = StringPiece();
+  int field_start = 0;
+  while (true) {
+    const uint32 tag = stream.ReadTag();
+    if (tag == 0) return stream.ConsumedEntireMessage();
+    const uint32 wire_type = tag & 7;
+    if ((tag >> 3) == TensorProto::kTensorContentFieldNumber &&
+        wire_type == 2) {
+      uint32 length;
+      if (!stream.ReadVarint32(&length)) return false;
+      const int begin = stream.CurrentPosition();
+      if (!stream.Skip(length)) return false;
+      // As for any non-repeated field, the last occurrence wins.
+      *content = StringPiece(serialized.data() + begin, length);
+    } else {
+      switch (wire_type) {
+        case 0: {
+          protobuf_uint64 value;
+          if (!stream.ReadVarint64(&value)) return false;
+          break;
+        }
+        case 1: {
+          protobuf_uint64 value;
+          if (!stream.ReadLittleEndian64(&value)) return false;
+          break;
+        }
+        case 2: {
+          uint32 length;
+          if (!stream.ReadVarint32(&length) || !stream.Skip(length)) {
+            return false;
+          }
+          break;
+        }
+        case 5: {
+          uint32 value;
+          if (!stream.ReadLittleEndian32(&value)) return false;
+          break;
+        }
+        default:
+          return false;
+      }
+      header->append(serialized.data() + field_start,
+                     stream.CurrentPosition() - field_start);
+    }
+    field_start = stream.CurrentPosition();
+  }
+}
+
+}  // namespace
+
 class ParseTensorOp : public OpKernel {
  public:
   explicit ParseTensorOp(OpKernelConstruction* context) : OpKernel(context) {
@@ -40,6 +107,25 @@ class ParseTensorOp : public OpKernel {
 
     auto serialized_t = serialized.scalar<string>();
 
+    // A tensor serialized with its values in tensor_content can be returned
+    // as a view of those bytes, without copying them out of `serialized`.
+    string header;
+    StringPiece content;
+    if (SplitTensorContent(serialized_t(), &header, &content) &&
+        !content.empty()) {
+      TensorProto header_proto;
+      Tensor aliased;
+      if (ParseProtoUnlimited(&header_proto, header) &&
+          header_proto.dtype() == out_type_ &&
+          TensorShape::IsValid(header_proto.tensor_shape()) &&
+          tensor::AliasStringBytes(serialized, content, out_type_,
+                                   TensorShape(header_proto.tensor_shape()),
+                                   &aliased)) {
+        ctx->set_output(0, aliased);
+        return;
+      }
+    }
+
     TensorProto proto;
     OP_REQUIRES(ctx, ParseProtoUnlimited(&proto, serialized_t()),
                 errors::InvalidArgument(
@@ -64,6 +64,29 @@ Status HandleElementToSlice(const Tensor& element, Tensor* parent, int index) {
   return Status::OK();
 }
 
+template <DataType DT>
+Status HandleSlicesToSlices(const Tensor& src, int64 src_index, Tensor* dst,
+                            int64 dst_index, int64 num_slices) {
+  typedef typename EnumToDataType<DT>::Type T;
+  DCHECK_GE(src_index, 0);
+  DCHECK_GE(dst_index, 0);
+  auto src_as_matrix = src.flat_outer_dims<T>();
+  auto dst_as_matrix = dst->flat_outer_dims<T>();
+  if (src_as_matrix.dimension(1) != dst_as_matrix.dimension(1)) {
+    return errors::Internal(
+        "HandleSlicesToSlices Cannot copy slices: number of elements does not "
+        "match.  Shapes are: [src]: ",
+        src.shape().DebugString(), ", [dst]: ", dst->shape().DebugString());
+  }
+  const Eigen::DSizes<Eigen::DenseIndex, 2> extents(num_slices,
+                                                    src_as_matrix.dimension(1));
+  dst_as_matrix.slice(Eigen::DSizes<Eigen::DenseIndex, 2>(dst_index, 0),
+                      extents) =
+      src_as_matrix.slice(Eigen::DSizes<Eigen::DenseIndex, 2>(src_index, 0),
+                          extents);
+  return Status::OK();
+}
+
 }  // namespace
 
 QueueBase::QueueBase(int32 capacity, const DataTypeVector& component_dtypes,
@@ -73,7 +96,9 @@ QueueBase::QueueBase(int32 capacity, const DataTypeVector& component_dtypes,
       component_dtypes_(component_dtypes),
       component_shapes_(component_shapes),
       name_(name),
-      closed_(false) {}
+      closed_(false),
+      num_enqueue_attempts_(0),
+      num_dequeue_attempts_(0) {}
 
 QueueBase::~QueueBase() {}
 
@@ -338,6 +363,8 @@ void QueueBase::FlushUnlocked() {
       changed = TryAttemptLocked(kEnqueue, &clean_up);
       changed = TryAttemptLocked(kDequeue, &clean_up) || changed;
     } while (changed);
+    num_enqueue_attempts_ = enqueue_attempts_.size();
+    num_dequeue_attempts_ = dequeue_attempts_.size();
   }
   Unref();
   for (const auto& to_clean : clean_up) {
@@ -410,4 +437,36 @@ Status QueueBase::CopyElementToSlice(const Tensor& element, Tensor* parent,
                                element.dtype());
 }
 
+// Static method
+Status QueueBase::CopySlicesToSlices(const Tensor& src, int64 src_index,
+                                     Tensor* dst, int64 dst_index,
+                                     int64 num_slices) {
+#define HANDLE_TYPE(DT)                                                    \
+  if (src.dtype() == DT) {                                                 \
+    TF_RETURN_IF_ERROR(HandleSlicesToSlices<DT>(src, src_index, dst,       \
+                                                dst_index, num_slices));   \
+    return Status::OK();                                                   \
+  }
+  HANDLE_TYPE(DT_FLOAT);
+  HANDLE_TYPE(DT_HALF);
+  HANDLE_TYPE(DT_DOUBLE);
+  HANDLE_TYPE(DT_INT32);
+  HANDLE_TYPE(DT_UINT8);
+  HANDLE_TYPE(DT_INT16);
+  HANDLE_TYPE(DT_INT8);
+  HANDLE_TYPE(DT_STRING);
+  HANDLE_TYPE(DT_COMPLEX64);
+  HANDLE_TYPE(DT_COMPLEX128);
+  HANDLE_TYPE(DT_INT64);
+  HANDLE_TYPE(DT_BOOL);
+  HANDLE_TYPE(DT_QINT8);
+  HANDLE_TYPE(DT_QUINT8);
+  HANDLE_TYPE(DT_QINT32);
+  HANDLE_TYPE(DT_QINT16);
+  HANDLE_TYPE(DT_QUINT16);
+#undef HANDLE_TYPE
+  return errors::Unimplemented("CopySlicesToSlices Unhandled data type: ",
+                               src.dtype());
+}
+
 }  // namespace tensorflow
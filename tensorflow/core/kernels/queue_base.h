@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_QUEUE_BASE_H_
 #define TENSORFLOW_CORE_KERNELS_QUEUE_BASE_H_
 
+#include <atomic>
 #include <deque>
 #include <vector>
 
@@ -82,6 +83,12 @@ class QueueBase : public QueueInterface {
   static Status CopyElementToSlice(const Tensor& element, Tensor* parent,
                                    int64 index);
 
+  // Copies the num_slices slices (in the first dimension) of src starting at
+  // src_index into the slices of dst starting at dst_index.
+  static Status CopySlicesToSlices(const Tensor& src, int64 src_index,
+                                   Tensor* dst, int64 dst_index,
+                                   int64 num_slices);
+
  protected:
   enum Action { kEnqueue, kDequeue };
   enum RunResult { kNoProgress, kProgress, kComplete };
@@ -174,6 +181,14 @@ class QueueBase : public QueueInterface {
   std::deque<Attempt> enqueue_attempts_ GUARDED_BY(mu_);
   std::deque<Attempt> dequeue_attempts_ GUARDED_BY(mu_);
 
+  // The sizes of enqueue_attempts_ and dequeue_attempts_, for implementations
+  // that need to know whether any attempt is waiting without acquiring mu_.
+  // They are reset to the exact sizes by FlushUnlocked(); an implementation
+  // that reads them must increment them (while holding mu_) whenever it adds
+  // an attempt, so that they are never lower than the true sizes.
+  std::atomic<int64> num_enqueue_attempts_;
+  std::atomic<int64> num_dequeue_attempts_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(QueueBase);
 };
 
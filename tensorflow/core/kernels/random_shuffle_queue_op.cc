@@ -15,17 +15,23 @@ limitations under the License.
 
 // See docs in ../ops/data_flow_ops.cc.
 
+#include <algorithm>
 #include <deque>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/queue_base.h"
 #include "tensorflow/core/kernels/queue_op.h"
-#include "tensorflow/core/kernels/typed_queue.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
@@ -37,14 +43,76 @@ limitations under the License.
 
 namespace tensorflow {
 
-class RandomShuffleQueue : public TypedQueue<std::vector<PersistentTensor> > {
+namespace {
+
+// Cumulative counts for each RandomShuffleQueue, labelled by queue name. The
+// difference between the enqueued and dequeued counts is the fill level.
+auto* elements_enqueued = monitoring::Counter<1>::New(
+    "/tensorflow/core/random_shuffle_queue/elements_enqueued",
+    "The number of elements added to a RandomShuffleQueue.", "queue");
+auto* elements_dequeued = monitoring::Counter<1>::New(
+    "/tensorflow/core/random_shuffle_queue/elements_dequeued",
+    "The number of elements removed from a RandomShuffleQueue.", "queue");
+auto* bytes_enqueued = monitoring::Counter<1>::New(
+    "/tensorflow/core/random_shuffle_queue/bytes_enqueued",
+    "The bytes of elements added to a RandomShuffleQueue.", "queue");
+auto* bytes_dequeued = monitoring::Counter<1>::New(
+    "/tensorflow/core/random_shuffle_queue/bytes_dequeued",
+    "The bytes of elements removed from a RandomShuffleQueue.", "queue");
+
+// The cells of the queues with one name.
+struct QueueCells {
+  monitoring::CounterCell* elements_enqueued;
+  monitoring::CounterCell* elements_dequeued;
+  monitoring::CounterCell* bytes_enqueued;
+  monitoring::CounterCell* bytes_dequeued;
+};
+
+// The number of live queues with each name. The cells of a name are removed
+// when its last queue is destroyed, so that the cells of short-lived queues
+// do not accumulate.
+struct QueueNames {
+  mutex mu;
+  std::unordered_map<string, int> num_queues GUARDED_BY(mu);
+};
+
+QueueNames* GetQueueNames() {
+  static QueueNames* names = new QueueNames;
+  return names;
+}
+
+QueueCells AcquireQueueCells(const string& name) {
+  QueueNames* names = GetQueueNames();
+  mutex_lock l(names->mu);
+  ++names->num_queues[name];
+  return {elements_enqueued->GetCell(name), elements_dequeued->GetCell(name),
+          bytes_enqueued->GetCell(name), bytes_dequeued->GetCell(name)};
+}
+
+void ReleaseQueueCells(const string& name) {
+  QueueNames* names = GetQueueNames();
+  mutex_lock l(names->mu);
+  auto it = names->num_queues.find(name);
+  DCHECK(it != names->num_queues.end());
+  if (--it->second > 0) return;
+  names->num_queues.erase(it);
+  elements_enqueued->RemoveCell(name);
+  elements_dequeued->RemoveCell(name);
+  bytes_enqueued->RemoveCell(name);
+  bytes_dequeued->RemoveCell(name);
+}
+
+}  // namespace
+
+class RandomShuffleQueue : public QueueBase {
  public:
-  RandomShuffleQueue(int32 capacity, int32 min_after_dequeue, int64 seed,
-                     int64 seed2, const DataTypeVector& component_dtypes,
+  RandomShuffleQueue(int32 capacity, int64 capacity_bytes,
+                     int32 min_after_dequeue, int64 seed, int64 seed2,
+                     const DataTypeVector& component_dtypes,
                      const std::vector<TensorShape>& component_shapes,
                      const string& name);
 
-  Status Initialize() override;  // Must be called before any other method.
+  Status Initialize();  // Must be called before any other method.
 
   // Implementations of QueueInterface methods --------------------------------
   void TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
@@ -59,25 +127,68 @@ class RandomShuffleQueue : public TypedQueue<std::vector<PersistentTensor> > {
 
   int32 size() override {
     mutex_lock lock(mu_);
-    return queues_[0].size();
+    return elements_.size();
   }
 
  private:
-  ~RandomShuffleQueue() override {}
+  // One element of the queue. An element enqueued with Enqueue keeps the
+  // enqueued tensors. An element copied out of an EnqueueMany batch has its
+  // components packed into a single buffer, laid out by packed_offsets_, if
+  // every component has a fixed shape and a type that can be memcpy'd.
+  struct Element {
+    bool is_packed = false;
+    Tuple components;  // Empty if is_packed.
+    Tensor packed;     // Set if is_packed.
+    int64 bytes = 0;
+  };
+
+  ~RandomShuffleQueue() override { ReleaseQueueCells(name_); }
+
+  // Returns true if an element of the given size may be added now. An
+  // element always fits into an empty queue, however large it is.
+  bool HasRoomLocked(int64 bytes) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns the number of elements that may be dequeued now.
+  int64 NumDequeuableLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  void AddElementLocked(Element* element) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Removes a random element and moves it into *element.
+  void RemoveRandomElementLocked(Element* element)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
-  // Helper for dequeuing a single random element from queues_.
-  void DequeueLocked(OpKernelContext* ctx, Tuple* tuple)
+  // Helper for dequeuing a single random element.
+  Status DequeueLocked(OpKernelContext* ctx, Tuple* tuple)
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
-  static Status GetElementComponentFromBatch(const Tuple& tuple, int64 index,
-                                             int component,
-                                             OpKernelContext* ctx,
-                                             PersistentTensor* out_tensor);
+  // Makes an element from the index^th slice of each component of batch.
+  Status MakeElementFromBatch(const Tuple& batch, int64 index,
+                              OpKernelContext* ctx, Element* element) const;
 
+  // Copies element into the index^th slice of each component of batch.
+  Status CopyElementToBatch(const Element& element, int64 index,
+                            Tuple* batch) const;
+
+  const int64 capacity_bytes_;
   const int32 min_after_dequeue_;
   const int64 original_seed_;
   const int64 original_seed2_;
 
+  // The byte offset of each component within a packed element, followed by
+  // the size of a packed element. Empty if elements are not packed.
+  std::vector<int64> packed_offsets_;
+
+  std::vector<Element> elements_ GUARDED_BY(mu_);
+  int64 bytes_ GUARDED_BY(mu_);
+  // Set when an enqueue could not proceed because of capacity_bytes_, so
+  // that a dequeue can make room even though it would leave fewer than
+  // min_after_dequeue_ elements. Otherwise a queue of large elements whose
+  // byte budget is exhausted before min_after_dequeue_ elements are queued
+  // would never let a dequeue run.
+  bool blocked_on_bytes_ GUARDED_BY(mu_);
+
+  const QueueCells cells_;
+
   random::PhiloxRandom parent_generator_ GUARDED_BY(mu_);
   random::SingleSampleAdapter<random::PhiloxRandom> generator_ GUARDED_BY(mu_);
 
@@ -85,13 +196,17 @@ class RandomShuffleQueue : public TypedQueue<std::vector<PersistentTensor> > {
 };
 
 RandomShuffleQueue::RandomShuffleQueue(
-    int32 capacity, int32 min_after_dequeue, int64 seed, int64 seed2,
-    const DataTypeVector& component_dtypes,
+    int32 capacity, int64 capacity_bytes, int32 min_after_dequeue, int64 seed,
+    int64 seed2, const DataTypeVector& component_dtypes,
     const std::vector<TensorShape>& component_shapes, const string& name)
-    : TypedQueue(capacity, component_dtypes, component_shapes, name),
+    : QueueBase(capacity, component_dtypes, component_shapes, name),
+      capacity_bytes_(capacity_bytes),
       min_after_dequeue_(min_after_dequeue),
       original_seed_(seed),
       original_seed2_(seed2),
+      bytes_(0),
+      blocked_on_bytes_(false),
+      cells_(AcquireQueueCells(name)),
       generator_(&parent_generator_) {
   if (seed == 0 && seed2 == 0) {
     // If both seeds are unspecified, use completely random seeds.
@@ -102,24 +217,152 @@ RandomShuffleQueue::RandomShuffleQueue(
 }
 
 Status RandomShuffleQueue::Initialize() {
-  TF_RETURN_IF_ERROR(TypedQueue::Initialize());
+  if (component_dtypes_.empty()) {
+    return errors::InvalidArgument("Empty component types for queue ", name_);
+  }
+  if (!component_shapes_.empty() &&
+      component_dtypes_.size() != component_shapes_.size()) {
+    return errors::InvalidArgument(
+        "Different number of component types.  ", "Types: ",
+        DataTypeSliceString(component_dtypes_), ", Shapes: ",
+        ShapeListString(component_shapes_));
+  }
+
+  bool can_pack = specified_shapes();
+  for (DataType dtype : component_dtypes_) {
+    can_pack = can_pack && DataTypeCanUseMemcpy(dtype);
+  }
+  if (can_pack) {
+    int64 offset = 0;
+    for (int i = 0; i < num_components(); ++i) {
+      packed_offsets_.push_back(offset);
+      const int64 bytes = component_shapes_[i].num_elements() *
+                          DataTypeSize(component_dtypes_[i]);
+      // Keep every component as aligned as a separately allocated tensor.
+      offset += (bytes + Allocator::kAllocatorAlignment - 1) /
+                Allocator::kAllocatorAlignment *
+                Allocator::kAllocatorAlignment;
+    }
+    packed_offsets_.push_back(offset);
+  }
 
   mutex_lock lock(mu_);
+  elements_.reserve(min_after_dequeue_);
+  return Status::OK();
+}
+
+bool RandomShuffleQueue::HasRoomLocked(int64 bytes) {
+  if (elements_.size() >= static_cast<size_t>(capacity_)) return false;
+  if (capacity_bytes_ < 0 || elements_.empty() ||
+      bytes_ + bytes <= capacity_bytes_) {
+    blocked_on_bytes_ = false;
+    return true;
+  }
+  blocked_on_bytes_ = true;
+  return false;
+}
+
+int64 RandomShuffleQueue::NumDequeuableLocked() {
+  const int64 queue_size = elements_.size();
+  if (closed_) return queue_size;
+  if (queue_size > min_after_dequeue_) return queue_size - min_after_dequeue_;
+  return blocked_on_bytes_ && queue_size > 0 ? 1 : 0;
+}
+
+void RandomShuffleQueue::AddElementLocked(Element* element) {
+  bytes_ += element->bytes;
+  cells_.elements_enqueued->IncrementBy(1);
+  cells_.bytes_enqueued->IncrementBy(element->bytes);
+  elements_.push_back(std::move(*element));
+}
+
+void RandomShuffleQueue::RemoveRandomElementLocked(Element* element) {
+  DCHECK(!elements_.empty());
+  const int64 index = generator_() % elements_.size();
+  *element = std::move(elements_[index]);
+  if (index + 1 != static_cast<int64>(elements_.size())) {
+    elements_[index] = std::move(elements_.back());
+  }
+  elements_.pop_back();
+  bytes_ -= element->bytes;
+  cells_.elements_dequeued->IncrementBy(1);
+  cells_.bytes_dequeued->IncrementBy(element->bytes);
+  // Removing an element makes room, so any enqueue must be retried before
+  // it can block dequeues again.
+  blocked_on_bytes_ = false;
+}
+
+Status RandomShuffleQueue::DequeueLocked(OpKernelContext* ctx, Tuple* tuple) {
+  Element element;
+  RemoveRandomElementLocked(&element);
+  if (!element.is_packed) {
+    *tuple = std::move(element.components);
+    return Status::OK();
+  }
+  tuple->reserve(num_components());
+  const char* src = element.packed.tensor_data().data();
+  for (int i = 0; i < num_components(); ++i) {
+    Tensor component;
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(component_dtypes_[i],
+                                          component_shapes_[i], &component));
+    memcpy(const_cast<char*>(component.tensor_data().data()),
+           src + packed_offsets_[i], component.TotalBytes());
+    tuple->push_back(component);
+  }
+  return Status::OK();
+}
+
+Status RandomShuffleQueue::MakeElementFromBatch(const Tuple& batch,
+                                                int64 index,
+                                                OpKernelContext* ctx,
+                                                Element* element) const {
+  if (!packed_offsets_.empty()) {
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DT_INT8, TensorShape({packed_offsets_.back()}), &element->packed));
+    char* dst = const_cast<char*>(element->packed.tensor_data().data());
+    for (int i = 0; i < num_components(); ++i) {
+      const StringPiece src = batch[i].tensor_data();
+      const int64 row_bytes = src.size() / batch[i].dim_size(0);
+      memcpy(dst + packed_offsets_[i], src.data() + index * row_bytes,
+             row_bytes);
+    }
+    element->is_packed = true;
+    element->bytes = packed_offsets_.back();
+    return Status::OK();
+  }
+  element->components.reserve(num_components());
+  element->bytes = 0;
   for (int i = 0; i < num_components(); ++i) {
-    queues_[i].reserve(min_after_dequeue_);
+    TensorShape element_shape(batch[i].shape());
+    element_shape.RemoveDim(0);
+    Tensor component;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(batch[i].dtype(), element_shape, &component));
+    TF_RETURN_IF_ERROR(CopySliceToElement(batch[i], &component, index));
+    element->bytes += component.TotalBytes();
+    element->components.push_back(component);
   }
   return Status::OK();
 }
 
-void RandomShuffleQueue::DequeueLocked(OpKernelContext* ctx, Tuple* tuple) {
-  DCHECK_GT(queues_[0].size(), size_t{0});
-  int64 index = generator_() % queues_[0].size();
-  (*tuple).reserve(num_components());
+Status RandomShuffleQueue::CopyElementToBatch(const Element& element,
+                                              int64 index,
+                                              Tuple* batch) const {
+  if (!element.is_packed) {
+    for (int i = 0; i < num_components(); ++i) {
+      TF_RETURN_IF_ERROR(
+          CopyElementToSlice(element.components[i], &(*batch)[i], index));
+    }
+    return Status::OK();
+  }
+  const char* src = element.packed.tensor_data().data();
   for (int i = 0; i < num_components(); ++i) {
-    (*tuple).push_back(*queues_[i][index].AccessTensor(ctx));
-    queues_[i][index] = queues_[i].back();
-    queues_[i].pop_back();
+    const StringPiece dst = (*batch)[i].tensor_data();
+    const int64 row_bytes = dst.size() / (*batch)[i].dim_size(0);
+    memcpy(const_cast<char*>(dst.data()) + index * row_bytes,
+           src + packed_offsets_[i], row_bytes);
   }
+  return Status::OK();
 }
 
 void RandomShuffleQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
@@ -140,10 +383,13 @@ void RandomShuffleQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
                   "RandomShuffleQueue '", name_, "' is closed."));
               return kComplete;
             }
-            if (queues_[0].size() < static_cast<size_t>(capacity_)) {
-              for (int i = 0; i < num_components(); ++i) {
-                queues_[i].push_back(PersistentTensor(tuple[i]));
-              }
+            Element element;
+            for (const Tensor& component : tuple) {
+              element.bytes += component.TotalBytes();
+            }
+            if (HasRoomLocked(element.bytes)) {
+              element.components = tuple;
+              AddElementLocked(&element);
               return kComplete;
             } else {
               return kNoProgress;
@@ -159,20 +405,6 @@ void RandomShuffleQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
   }
 }
 
-/* static */
-Status RandomShuffleQueue::GetElementComponentFromBatch(
-    const Tuple& tuple, int64 index, int component, OpKernelContext* ctx,
-    PersistentTensor* out_tensor) {
-  TensorShape element_shape(tuple[component].shape());
-  element_shape.RemoveDim(0);
-  Tensor* element_access = nullptr;
-  TF_RETURN_IF_ERROR(ctx->allocate_persistent(
-      tuple[component].dtype(), element_shape, out_tensor, &element_access));
-  TF_RETURN_IF_ERROR(
-      CopySliceToElement(tuple[component], element_access, index));
-  return Status::OK();
-}
-
 void RandomShuffleQueue::TryEnqueueMany(const Tuple& tuple,
                                         OpKernelContext* ctx,
                                         DoneCallback callback) {
@@ -198,18 +430,26 @@ void RandomShuffleQueue::TryEnqueueMany(const Tuple& tuple,
                   "RandomShuffleQueue '", name_, "' is closed."));
               return kComplete;
             }
+            // Check for room before copying each element out of the batch,
+            // assuming the elements share the batch's bytes evenly.
+            int64 element_bytes = 0;
+            if (packed_offsets_.empty()) {
+              for (const Tensor& component : tuple) {
+                element_bytes += component.TotalBytes() / component.dim_size(0);
+              }
+            } else {
+              element_bytes = packed_offsets_.back();
+            }
             RunResult result = kNoProgress;
-            while (queues_[0].size() < static_cast<size_t>(capacity_)) {
-              result = kProgress;
-              const int index =
+            while (HasRoomLocked(element_bytes)) {
+              const int64 index =
                   tuple[0].dim_size(0) - attempt->elements_requested;
-              for (int i = 0; i < num_components(); ++i) {
-                PersistentTensor element;
-                attempt->context->SetStatus(GetElementComponentFromBatch(
-                    tuple, index, i, attempt->context, &element));
-                if (!attempt->context->status().ok()) return kComplete;
-                queues_[i].push_back(element);
-              }
+              result = kProgress;
+              Element element;
+              attempt->context->SetStatus(MakeElementFromBatch(
+                  tuple, index, attempt->context, &element));
+              if (!attempt->context->status().ok()) return kComplete;
+              AddElementLocked(&element);
               --attempt->elements_requested;
               if (attempt->elements_requested == 0) {
                 return kComplete;
@@ -241,7 +481,7 @@ void RandomShuffleQueue::TryDequeue(OpKernelContext* ctx,
       dequeue_attempts_.emplace_back(
           1, [callback]() { callback(Tuple()); }, ctx, cm, token,
           [callback, this](Attempt* attempt) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-            int32 queue_size = queues_[0].size();
+            const int32 queue_size = elements_.size();
             if (closed_ && queue_size == 0) {
               attempt->context->SetStatus(errors::OutOfRange(
                   "RandomShuffleQueue '", name_, "' is closed and has ",
@@ -249,10 +489,11 @@ void RandomShuffleQueue::TryDequeue(OpKernelContext* ctx,
                   queue_size, ")"));
               return kComplete;
             }
-            if (!closed_) queue_size -= min_after_dequeue_;
-            if (queue_size > 0) {
+            if (NumDequeuableLocked() > 0) {
               Tuple tuple;
-              DequeueLocked(attempt->context, &tuple);
+              attempt->context->SetStatus(
+                  DequeueLocked(attempt->context, &tuple));
+              if (!attempt->context->status().ok()) return kComplete;
               attempt->done_callback = [callback, tuple]() { callback(tuple); };
               return kComplete;
             } else {
@@ -328,7 +569,7 @@ void RandomShuffleQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
           num_elements, [callback]() { callback(Tuple()); }, ctx, cm, token,
           [callback, allow_small_batch, this](Attempt* attempt)
               EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-                int32 queue_size = queues_[0].size();
+                int32 queue_size = elements_.size();
                 if (closed_ && queue_size < attempt->elements_requested) {
                   // If we don't have enough for a full dequeue, we have
                   // to reset the attempt tuple.
@@ -337,24 +578,23 @@ void RandomShuffleQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
                     for (int64 i = attempt->tuple[0].dim_size(0) -
                                    attempt->elements_requested - 1;
                          i >= 0; --i) {
-                      for (int j = 0; j < num_components(); ++j) {
-                        PersistentTensor element;
-                        Status s = GetElementComponentFromBatch(
-                            attempt->tuple, i, j, attempt->context, &element);
-                        if (!s.ok()) {
-                          attempt->context->SetStatus(
-                              errors::DataLoss("Failed to restore element from "
-                                               "partially-dequeued batch "
-                                               "to RandomShuffleQueue: ",
-                                               s.error_message()));
-                        }
-                        queues_[j].push_back(element);
+                      Element element;
+                      Status s = MakeElementFromBatch(
+                          attempt->tuple, i, attempt->context, &element);
+                      if (!s.ok()) {
+                        attempt->context->SetStatus(
+                            errors::DataLoss("Failed to restore element from "
+                                             "partially-dequeued batch "
+                                             "to RandomShuffleQueue: ",
+                                             s.error_message()));
+                        continue;
                       }
+                      AddElementLocked(&element);
                     }
                   }
-                  if (allow_small_batch && queues_[0].size() > 0) {
+                  if (allow_small_batch && !elements_.empty()) {
                     // Request all remaining elements in the queue.
-                    queue_size = queues_[0].size();
+                    queue_size = elements_.size();
                     attempt->tuple.clear();
                     attempt->elements_requested = queue_size;
                   } else {
@@ -375,44 +615,43 @@ void RandomShuffleQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
                   }
                 }
 
-                RunResult result = kNoProgress;
-                if (!closed_) queue_size -= min_after_dequeue_;
-                for (; queue_size > 0; --queue_size) {
-                  if (attempt->tuple.empty()) {
-                    // Only allocate tuple when we have something to dequeue
-                    // so we don't use excessive memory when there are many
-                    // blocked dequeue attempts waiting.
-                    attempt->tuple.reserve(num_components());
-                    for (int i = 0; i < num_components(); ++i) {
-                      const TensorShape shape =
-                          ManyOutShape(i, attempt->elements_requested);
-                      Tensor element;
-                      attempt->context->allocate_temp(component_dtypes_[i],
-                                                      shape, &element);
-                      attempt->tuple.emplace_back(element);
-                    }
-                  }
-                  result = kProgress;
-                  Tuple tuple;
-                  DequeueLocked(attempt->context, &tuple);
-                  const int index = attempt->tuple[0].dim_size(0) -
-                                    attempt->elements_requested;
+                const int64 num_dequeuable = std::min<int64>(
+                    NumDequeuableLocked(), attempt->elements_requested);
+                if (num_dequeuable == 0) return kNoProgress;
+                if (attempt->tuple.empty()) {
+                  // Only allocate tuple when we have something to dequeue
+                  // so we don't use excessive memory when there are many
+                  // blocked dequeue attempts waiting.
+                  attempt->tuple.reserve(num_components());
                   for (int i = 0; i < num_components(); ++i) {
-                    attempt->context->SetStatus(CopyElementToSlice(
-                        tuple[i], &attempt->tuple[i], index));
-                    if (!attempt->context->status().ok()) return kComplete;
+                    const TensorShape shape =
+                        ManyOutShape(i, attempt->elements_requested);
+                    Tensor element;
+                    attempt->context->allocate_temp(component_dtypes_[i],
+                                                    shape, &element);
+                    attempt->tuple.emplace_back(element);
                   }
-                  tuple.clear();
+                }
+                // Move each sampled element straight into its row of the
+                // batch.
+                for (int64 n = 0; n < num_dequeuable; ++n) {
+                  Element element;
+                  RemoveRandomElementLocked(&element);
+                  const int64 index = attempt->tuple[0].dim_size(0) -
+                                      attempt->elements_requested;
+                  attempt->context->SetStatus(
+                      CopyElementToBatch(element, index, &attempt->tuple));
+                  if (!attempt->context->status().ok()) return kComplete;
                   --attempt->elements_requested;
-                  if (attempt->elements_requested == 0) {
-                    tuple = attempt->tuple;
-                    attempt->done_callback = [callback, tuple]() {
-                      callback(tuple);
-                    };
-                    return kComplete;
-                  }
                 }
-                return result;
+                if (attempt->elements_requested == 0) {
+                  Tuple tuple = attempt->tuple;
+                  attempt->done_callback = [callback, tuple]() {
+                    callback(tuple);
+                  };
+                  return kComplete;
+                }
+                return kProgress;
               });
     }
   }
@@ -428,6 +667,16 @@ Status RandomShuffleQueue::MatchesNodeDef(const NodeDef& node_def) {
   TF_RETURN_IF_ERROR(MatchesNodeDefOp(node_def, "RandomShuffleQueue"));
   TF_RETURN_IF_ERROR(MatchesNodeDefCapacity(node_def, capacity_));
 
+  int64 capacity_bytes = -1;
+  TF_RETURN_IF_ERROR(GetNodeAttr(node_def, "capacity_bytes", &capacity_bytes));
+  if (capacity_bytes < 0) capacity_bytes = -1;
+  if (capacity_bytes != capacity_bytes_) {
+    return errors::InvalidArgument("Shared queue '", name_,
+                                   "' has capacity_bytes ", capacity_bytes_,
+                                   " but requested capacity_bytes was ",
+                                   capacity_bytes, ".");
+  }
+
   int32 min_after_dequeue = -1;
   TF_RETURN_IF_ERROR(
       GetNodeAttr(node_def, "min_after_dequeue", &min_after_dequeue));
@@ -472,6 +721,11 @@ class RandomShuffleQueueOp : public QueueOp {
         context, min_after_dequeue_ < capacity_,
         errors::InvalidArgument("min_after_dequeue ", min_after_dequeue_,
                                 " must be < capacity ", capacity_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("capacity_bytes", &capacity_bytes_));
+    OP_REQUIRES(context, capacity_bytes_ != 0,
+                errors::InvalidArgument("capacity_bytes must not be 0"));
+    if (capacity_bytes_ < 0) capacity_bytes_ = -1;
     OP_REQUIRES_OK(context, context->GetAttr("seed", &seed_));
     OP_REQUIRES_OK(context, context->GetAttr("seed2", &seed2_));
 
@@ -481,9 +735,9 @@ class RandomShuffleQueueOp : public QueueOp {
  protected:
   CreatorCallback GetCreator() const override {
     return [this](QueueInterface** ret) {
-      auto* q = new RandomShuffleQueue(capacity_, min_after_dequeue_, seed_,
-                                       seed2_, component_types_,
-                                       component_shapes_, cinfo_.name());
+      auto* q = new RandomShuffleQueue(
+          capacity_, capacity_bytes_, min_after_dequeue_, seed_, seed2_,
+          component_types_, component_shapes_, cinfo_.name());
       Status s = q->Initialize();
       if (s.ok()) {
         *ret = q;
@@ -495,6 +749,7 @@ class RandomShuffleQueueOp : public QueueOp {
   }
 
  private:
+  int64 capacity_bytes_;
   int32 min_after_dequeue_;
   int64 seed_;
   int64 seed2_;
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
@@ -128,7 +129,6 @@ class ReduceJoinOp : public OpKernel {
 
   void Compute(OpKernelContext* context) override {
     const Tensor& input = context->input(0);
-    const auto input_flat = input.flat<string>();
     const TensorShape& input_shape = input.shape();
     const int32 input_dims = input_shape.dims();
     OP_REQUIRES(context, TensorShapeUtils::IsVectorOrHigher(input_shape),
@@ -173,6 +173,13 @@ class ReduceJoinOp : public OpKernel {
                                                      &output_tensor));
     auto output_flat = output_tensor->flat<string>();
 
+    // A packed input, e.g. the tokens from StringSplit, is read in place
+    // rather than converted to an array of strings.
+    tensor::PackedStrings packed_input;
+    const bool input_is_packed = tensor::GetPackedStrings(input, &packed_input);
+    const string* input_strings =
+        input_is_packed ? nullptr : input.flat<string>().data();
+
     const int64 reduction_iter_size =
         GetReductionIterSize(reduced_indices, input_shape);
     gtl::InlinedVector<StringPiece, 8> curr_strings(reduction_iter_size);
@@ -184,8 +191,10 @@ class ReduceJoinOp : public OpKernel {
            ++reduction_index) {
         int64 reduction_full_index = LinearSubIndexToFullIndex(
             reduction_index, reduced_indices, input_shape, strides);
+        const int64 input_index = output_full_index + reduction_full_index;
         curr_strings[reduction_index] =
-            input_flat(output_full_index + reduction_full_index);
+            input_is_packed ? packed_input(input_index)
+                            : StringPiece(input_strings[input_index]);
       }
       output_flat(output_index) =
           str_util::Join(curr_strings, separator_.c_str());
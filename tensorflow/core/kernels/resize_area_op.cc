@@ -16,8 +16,12 @@ limitations under the License.
 // See docs in ../ops/image_ops.cc
 #define EIGEN_USE_THREADS
 
+#include <math.h>
 #include <algorithm>
 #include <memory>
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -30,6 +34,35 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+inline int64 Bound(int64 val, int64 limit) {
+  return std::min(limit - 1ll, std::max(0ll, val));
+}
+
+// Computes, for every output column, the weighted sum of the input columns
+// in in_row that contribute to it (see x_begin, x_offsets and x_weights
+// below), writing (x_begin.size() - 1) * channels floats to out. Only the
+// input pixels are converted to float, one at a time.
+template <typename T>
+void SumRow(const T* in_row, const std::vector<int64>& x_begin,
+            const std::vector<int64>& x_offsets,
+            const std::vector<float>& x_weights, int64 channels, float* out) {
+  const int64 out_width = x_begin.size() - 1;
+  for (int64 x = 0; x < out_width; ++x, out += channels) {
+    for (int64 c = 0; c < channels; ++c) out[c] = 0;
+    for (int64 k = x_begin[x]; k < x_begin[x + 1]; ++k) {
+      const T* in = in_row + x_offsets[k];
+      const float weight = x_weights[k];
+      for (int64 c = 0; c < channels; ++c) {
+        out[c] += static_cast<float>(in[c]) * weight;
+      }
+    }
+  }
+}
+
+}  // namespace
+
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
 template <typename Device, typename T>
@@ -46,17 +79,6 @@ class ResizeAreaOp : public OpKernel {
 
     if (!context->status().ok()) return;
 
-    typename TTypes<T, 4>::ConstTensor input_data = input.tensor<T, 4>();
-    typename TTypes<float, 4>::Tensor output_data =
-        st.output->tensor<float, 4>();
-
-    // A temporary tensor for computing the sum.
-    Tensor sum_tensor;
-    OP_REQUIRES_OK(context, context->allocate_temp(DataTypeToEnum<float>::value,
-                                                   TensorShape({st.channels}),
-                                                   &sum_tensor));
-    typename TTypes<float, 1>::Tensor sum_data = sum_tensor.vec<float>();
-
     // When using this algorithm for downsizing, the target pixel value is the
     // weighted average of all the source pixels. The weight is determined by
     // the contribution percentage of the source pixel.
@@ -76,48 +98,81 @@ class ResizeAreaOp : public OpKernel {
     //   out[0] = (in[0] * 1.0 + in[1] * 1/3) * scale
     //   out[1] = (in[1] * 2/3 + in[2] * 2/3 * scale
     //   out[2] = (in[3] * 1/3 + in[3] * 1.0) * scale
-    float scale = 1.0 / (st.height_scale * st.width_scale);
-    for (int64 b = 0; b < st.batch_size; ++b) {
-      for (int64 y = 0; y < st.out_height; ++y) {
+    //
+    // The weights are separable, so each input row is first summed
+    // horizontally with the column weights, which are the same for every
+    // row, and the output row is then the sum of those rows weighted by the
+    // row weights.
+    const float scale = 1.0 / (st.height_scale * st.width_scale);
+    const int64 channels = st.channels;
+    const int64 in_row_size = st.in_width * channels;
+    const int64 out_row_size = st.out_width * channels;
+
+    // The input columns that contribute to output column x are
+    // x_offsets[x_begin[x]] to x_offsets[x_begin[x + 1] - 1] (offsets into a
+    // row), with the corresponding x_weights.
+    std::vector<int64> x_begin(st.out_width + 1);
+    std::vector<int64> x_offsets;
+    std::vector<float> x_weights;
+    for (int64 x = 0; x < st.out_width; ++x) {
+      x_begin[x] = x_offsets.size();
+      const float in_x = x * st.width_scale;
+      const float in_x1 = (x + 1) * st.width_scale;
+      // The start and end width indices of all the cells that could
+      // contribute to the target cell.
+      const int64 x_start = floor(in_x);
+      const int64 x_end = ceil(in_x1);
+      for (int64 j = x_start; j < x_end; ++j) {
+        const float scale_x =
+            j < in_x ? (j + 1 > in_x1 ? st.width_scale : j + 1 - in_x)
+                     : (j + 1 > in_x1 ? in_x1 - j : 1.0);
+        x_offsets.push_back(Bound(j, st.in_width) * channels);
+        x_weights.push_back(scale_x);
+      }
+    }
+    x_begin[st.out_width] = x_offsets.size();
+
+    const T* input_data = input.flat<T>().data();
+    float* output_data = st.output->flat<float>().data();
+    auto resize_rows = [&](int64 start, int64 limit) {
+      std::vector<float> row_sum(out_row_size);
+      Eigen::Map<const Eigen::ArrayXf> row_sum_map(row_sum.data(),
+                                                   out_row_size);
+      for (int64 row = start; row < limit; ++row) {
+        const int64 b = row / st.out_height;
+        const int64 y = row % st.out_height;
         const float in_y = y * st.height_scale;
         const float in_y1 = (y + 1) * st.height_scale;
         // The start and end height indices of all the cells that could
         // contribute to the target cell.
-        int64 y_start = floor(in_y);
-        int64 y_end = ceil(in_y1);
-
-        for (int64 x = 0; x < st.out_width; ++x) {
-          const float in_x = x * st.width_scale;
-          const float in_x1 = (x + 1) * st.width_scale;
-          // The start and end width indices of all the cells that could
-          // contribute to the target cell.
-          int64 x_start = floor(in_x);
-          int64 x_end = ceil(in_x1);
-
-          sum_data.setConstant(0.0);
-          for (int64 i = y_start; i < y_end; ++i) {
-            float scale_y =
-                i < in_y ? (i + 1 > in_y1 ? st.height_scale : i + 1 - in_y)
-                         : (i + 1 > in_y1 ? in_y1 - i : 1.0);
-            for (int64 j = x_start; j < x_end; ++j) {
-              float scale_x =
-                  j < in_x ? (j + 1 > in_x1 ? st.width_scale : j + 1 - in_x)
-                           : (j + 1 > in_x1 ? in_x1 - j : 1.0);
-              for (int64 c = 0; c < st.channels; ++c) {
-#define BOUND(val, limit) std::min(((limit)-1ll), (std::max(0ll, (val))))
-                sum_data(c) += float(input_data(b, BOUND(i, st.in_height),
-                                                BOUND(j, st.in_width), c)) *
-                               scale_y * scale_x * scale;
-#undef BOUND
-              }
-            }
-          }
-          for (int64 c = 0; c < st.channels; ++c) {
-            output_data(b, y, x, c) = sum_data(c);
-          }
+        const int64 y_start = floor(in_y);
+        const int64 y_end = ceil(in_y1);
+        Eigen::Map<Eigen::ArrayXf> output_row(output_data + row * out_row_size,
+                                              out_row_size);
+        output_row.setZero();
+        for (int64 i = y_start; i < y_end; ++i) {
+          const float scale_y =
+              i < in_y ? (i + 1 > in_y1 ? st.height_scale : i + 1 - in_y)
+                       : (i + 1 > in_y1 ? in_y1 - i : 1.0);
+          const T* input_row =
+              input_data + (b * st.in_height + Bound(i, st.in_height)) *
+                               in_row_size;
+          SumRow(input_row, x_begin, x_offsets, x_weights, channels,
+                 row_sum.data());
+          output_row += row_sum_map * (scale_y * scale);
         }
       }
-    }
+    };
+    // Each output row reads about height_scale input rows, each summed at
+    // about width_scale points per output pixel.
+    const int64 reads_per_row =
+        static_cast<int64>(ceil(st.height_scale) + 1) * x_offsets.size() *
+        channels;
+    const Eigen::TensorOpCost cost(reads_per_row * sizeof(T),
+                                   out_row_size * sizeof(float),
+                                   2 * reads_per_row);
+    context->eigen_device<CPUDevice>().parallelFor(
+        st.batch_size * st.out_height, cost, resize_rows);
   }
 
  private:
@@ -0,0 +1,101 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+
+class ResizeAreaOpTest : public OpsTestBase {
+ protected:
+  ResizeAreaOpTest() {
+    TF_EXPECT_OK(NodeDefBuilder("resize_area_op", "ResizeArea")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("align_corners", false)
+                     .Finalize(node_def()));
+    TF_EXPECT_OK(InitOp());
+  }
+};
+
+TEST_F(ResizeAreaOpTest, TestAreaDownscaleByTwo) {
+  // Each output pixel is the average of a 2x2 block of input pixels.
+  AddInputFromArray<float>(TensorShape({1, 4, 4, 2}),
+                           {1,  2,  3,  4,  5,  6,  7,  8,  //
+                            9,  10, 11, 12, 13, 14, 15, 16,  //
+                            17, 18, 19, 20, 21, 22, 23, 24,  //
+                            25, 26, 27, 28, 29, 30, 31, 32});
+  AddInputFromArray<int32>(TensorShape({2}), {2, 2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 2, 2, 2}));
+  test::FillValues<float>(&expected, {6, 7, 10, 11, 22, 23, 26, 27});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+TEST_F(ResizeAreaOpTest, TestAreaPartialPixels) {
+  // Resizing 3 pixels to 2 gives each output pixel one and a half input
+  // pixels.
+  AddInputFromArray<float>(TensorShape({1, 3, 3, 1}),
+                           {1, 2, 3, 4, 5, 6, 7, 8, 9});
+  AddInputFromArray<int32>(TensorShape({2}), {2, 2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 2, 2, 1}));
+  test::FillValues<float>(&expected, {7.0 / 3, 11.0 / 3, 19.0 / 3, 23.0 / 3});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+static Graph* ResizeArea(DataType type, int in_height, int in_width,
+                         int out_height, int out_width) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor input(type, TensorShape({1, in_height, in_width, 3}));
+  if (type == DT_UINT8) {
+    input.flat<uint8>().setRandom();
+  } else {
+    input.flat<float>().setRandom();
+  }
+  Tensor size(DT_INT32, TensorShape({2}));
+  size.flat<int32>()(0) = out_height;
+  size.flat<int32>()(1) = out_width;
+  test::graph::Binary(g, "ResizeArea", test::graph::Constant(g, input),
+                      test::graph::Constant(g, size));
+  return g;
+}
+
+// Downscales of 4K RGB images to 224 x 224, as in input preprocessing.
+#define BM_ResizeAreaDev(TYPE, IN_H, IN_W, OUT_H, OUT_W)                  \
+  static void BM_ResizeArea_##TYPE##_##IN_H##_##IN_W##_##OUT_H##_##OUT_W( \
+      int iters) {                                                        \
+    testing::ItemsProcessed(static_cast<int64>(iters) * OUT_H * OUT_W * 3); \
+    testing::UseRealTime();                                               \
+    test::Benchmark("cpu", ResizeArea(DataTypeToEnum<TYPE>::value, IN_H,  \
+                                      IN_W, OUT_H, OUT_W))                \
+        .Run(iters);                                                      \
+  }                                                                       \
+  BENCHMARK(BM_ResizeArea_##TYPE##_##IN_H##_##IN_W##_##OUT_H##_##OUT_W)
+
+BM_ResizeAreaDev(uint8, 2160, 3840, 224, 224);
+BM_ResizeAreaDev(float, 2160, 3840, 224, 224);
+
+}  // namespace tensorflow
@@ -19,7 +19,9 @@ limitations under the License.
 #include <math.h>
 #include <algorithm>
 #include <array>
+#include <vector>
 
+#include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -80,6 +82,28 @@ inline float Interpolate1D(const std::array<float, 4>& weights,
          values[2] * weights[2] + values[3] * weights[3];
 }
 
+// Interpolates one input row horizontally, writing x_weights.size() *
+// channels floats to out. The indices are offsets into the row, already
+// multiplied by the number of channels. Only the input pixels that are
+// actually used are converted to float.
+template <typename T>
+void InterpolateRow(const T* in_row,
+                    const std::vector<std::array<float, 4>>& x_weights,
+                    const std::vector<std::array<int64, 4>>& x_indices,
+                    int64 channels, float* out) {
+  for (size_t x = 0; x < x_weights.size(); ++x) {
+    const std::array<int64, 4>& indices = x_indices[x];
+    for (int64 c = 0; c < channels; ++c) {
+      const std::array<float, 4> values = {
+          {static_cast<float>(in_row[indices[0] + c]),
+           static_cast<float>(in_row[indices[1] + c]),
+           static_cast<float>(in_row[indices[2] + c]),
+           static_cast<float>(in_row[indices[3] + c])}};
+      *out++ = Interpolate1D(x_weights[x], values);
+    }
+  }
+}
+
 }  // namespace
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
@@ -98,42 +122,85 @@ class ResizeBicubicOp : public OpKernel {
 
     if (!context->status().ok()) return;
 
-    typename TTypes<T, 4>::ConstTensor input_data = input.tensor<T, 4>();
-    typename TTypes<float, 4>::Tensor output_data =
-        st.output->tensor<float, 4>();
+    const int64 channels = st.channels;
+    const int64 in_row_size = st.in_width * channels;
+    const int64 out_row_size = st.out_width * channels;
+
+    // The resize is separable: every output row is a weighted sum of four
+    // input rows that have been interpolated horizontally, and the horizontal
+    // weights and indices are the same for every row, so they are worked out
+    // once.
+    std::vector<std::array<float, 4>> x_weights(st.out_width);
+    std::vector<std::array<int64, 4>> x_indices(st.out_width);
+    for (int64 x = 0; x < st.out_width; ++x) {
+      GetWeightsAndIndices(st.width_scale, x, st.in_width, &x_weights[x],
+                           &x_indices[x]);
+      for (int64& index : x_indices[x]) index *= channels;
+    }
 
-    std::array<float, 4> coeff = {{0.0, 0.0, 0.0, 0.0}};
-    for (int64 b = 0; b < st.batch_size; ++b) {
-      for (int64 y = 0; y < st.out_height; ++y) {
+    const T* input_data = input.flat<T>().data();
+    float* output_data = st.output->flat<float>().data();
+    auto resize_rows = [&](int64 start, int64 limit) {
+      // The last four interpolated input rows are kept: when upscaling,
+      // consecutive output rows read mostly the same ones.
+      std::array<std::vector<float>, 4> rows;
+      std::array<int64, 4> cached;
+      for (int i = 0; i < 4; ++i) {
+        rows[i].resize(out_row_size);
+        cached[i] = -1;
+      }
+      for (int64 row = start; row < limit; ++row) {
+        const int64 b = row / st.out_height;
+        const int64 y = row % st.out_height;
         std::array<float, 4> y_weights;
         std::array<int64, 4> y_indices;
         GetWeightsAndIndices(st.height_scale, y, st.in_height, &y_weights,
                              &y_indices);
-        for (int64 x = 0; x < st.out_width; ++x) {
-          std::array<float, 4> x_weights;
-          std::array<int64, 4> x_indices;
-          GetWeightsAndIndices(st.width_scale, x, st.in_width, &x_weights,
-                               &x_indices);
-          for (int64 c = 0; c < st.channels; ++c) {
-            // Use a 4x4 patch to compute the interpolated output value at
-            // (b, y, x, c).
-            for (int64 i = 0; i < 4; ++i) {
-              const std::array<float, 4> values = {
-                  {static_cast<float>(
-                       input_data(b, y_indices[i], x_indices[0], c)),
-                   static_cast<float>(
-                       input_data(b, y_indices[i], x_indices[1], c)),
-                   static_cast<float>(
-                       input_data(b, y_indices[i], x_indices[2], c)),
-                   static_cast<float>(
-                       input_data(b, y_indices[i], x_indices[3], c))}};
-              coeff[i] = Interpolate1D(x_weights, values);
+        // Use the rows that are already interpolated, then interpolate the
+        // missing ones into the slots that this output row does not need.
+        std::array<const float*, 4> values;
+        std::array<bool, 4> in_use = {{false, false, false, false}};
+        for (int i = 0; i < 4; ++i) {
+          const int64 key = b * st.in_height + y_indices[i];
+          values[i] = nullptr;
+          for (int j = 0; j < 4; ++j) {
+            if (cached[j] == key) {
+              values[i] = rows[j].data();
+              in_use[j] = true;
+              break;
             }
-            output_data(b, y, x, c) = Interpolate1D(y_weights, coeff);
           }
         }
+        for (int i = 0; i < 4; ++i) {
+          if (values[i] != nullptr) continue;
+          const int64 key = b * st.in_height + y_indices[i];
+          int slot = 0;
+          while (in_use[slot] && cached[slot] != key) ++slot;
+          if (cached[slot] != key) {
+            InterpolateRow(input_data + key * in_row_size, x_weights,
+                           x_indices, channels, rows[slot].data());
+            cached[slot] = key;
+            in_use[slot] = true;
+          }
+          values[i] = rows[slot].data();
+        }
+        Eigen::Map<const Eigen::ArrayXf> v0(values[0], out_row_size);
+        Eigen::Map<const Eigen::ArrayXf> v1(values[1], out_row_size);
+        Eigen::Map<const Eigen::ArrayXf> v2(values[2], out_row_size);
+        Eigen::Map<const Eigen::ArrayXf> v3(values[3], out_row_size);
+        Eigen::Map<Eigen::ArrayXf>(output_data + row * out_row_size,
+                                   out_row_size) =
+            v0 * y_weights[0] + v1 * y_weights[1] + v2 * y_weights[2] +
+            v3 * y_weights[3];
       }
-    }
+    };
+    // Each output row reads (at most) four input rows at four points per
+    // output pixel and writes one row.
+    const Eigen::TensorOpCost cost(16 * out_row_size * sizeof(T),
+                                   out_row_size * sizeof(float),
+                                   32 * out_row_size);
+    context->eigen_device<CPUDevice>().parallelFor(
+        st.batch_size * st.out_height, cost, resize_rows);
   }
 
  private:
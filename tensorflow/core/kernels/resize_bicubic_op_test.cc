@@ -54,4 +54,26 @@ BM_ResizeBicubicDev(32, 128, 3);
 BM_ResizeBicubicDev(32, 512, 3);
 BM_ResizeBicubicDev(32, 1024, 3);
 
+// Downscales of 4K RGB uint8 images to 224 x 224, as in input preprocessing.
+static Graph* ResizeBicubicUint8(int in_height, int in_width, int out_height,
+                                 int out_width) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor input(DT_UINT8, TensorShape({1, in_height, in_width, 3}));
+  input.flat<uint8>().setRandom();
+  Tensor shape(DT_INT32, TensorShape({2}));
+  auto shape_t = shape.flat<int32>();
+  shape_t(0) = out_height;
+  shape_t(1) = out_width;
+  test::graph::Binary(g, "ResizeBicubic", test::graph::Constant(g, input),
+                      test::graph::Constant(g, shape));
+  return g;
+}
+
+static void BM_ResizeBicubicUint8_4K_To_224(int iters) {
+  testing::ItemsProcessed(static_cast<int64>(iters) * 224 * 224 * 3);
+  testing::UseRealTime();
+  test::Benchmark("cpu", ResizeBicubicUint8(2160, 3840, 224, 224)).Run(iters);
+}
+BENCHMARK(BM_ResizeBicubicUint8_4K_To_224);
+
 }  // end namespace tensorflow
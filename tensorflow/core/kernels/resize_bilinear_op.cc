@@ -18,7 +18,12 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/resize_bilinear_op.h"
 
+#include <math.h>
+#include <algorithm>
 #include <memory>
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -66,6 +71,49 @@ class ResizeBilinearOp : public OpKernel {
 
 // Partial specialization of ResizeBilinear functor for a CPUDevice.
 namespace functor {
+namespace {
+
+// Where one output column reads from in an input row: the offsets of its left
+// and right neighbours (already multiplied by the number of channels) and the
+// weight of the right one.
+struct CachedInterpolation {
+  int64 left;
+  int64 right;
+  float lerp;
+};
+
+// Interpolates one input row horizontally, writing out_width * channels
+// floats to out. Only the input pixels that are actually used are converted
+// to float.
+template <typename T>
+void InterpolateRow(const T* in_row,
+                    const std::vector<CachedInterpolation>& xs, int channels,
+                    float* out) {
+  if (channels == 3) {
+    for (const CachedInterpolation& x : xs) {
+      const T* left = in_row + x.left;
+      const T* right = in_row + x.right;
+      for (int c = 0; c < 3; ++c) {
+        const float l(left[c]);
+        const float r(right[c]);
+        *out++ = l + (r - l) * x.lerp;
+      }
+    }
+    return;
+  }
+  for (const CachedInterpolation& x : xs) {
+    const T* left = in_row + x.left;
+    const T* right = in_row + x.right;
+    for (int c = 0; c < channels; ++c) {
+      const float l(left[c]);
+      const float r(right[c]);
+      *out++ = l + (r - l) * x.lerp;
+    }
+  }
+}
+
+}  // namespace
+
 template <typename T>
 struct ResizeBilinear<CPUDevice, T> {
   void operator()(const CPUDevice& d, typename TTypes<T, 4>::ConstTensor images,
@@ -78,34 +126,70 @@ struct ResizeBilinear<CPUDevice, T> {
 
     const int64 out_height = output.dimension(1);
     const int64 out_width = output.dimension(2);
+    const int64 in_row_size = in_width * channels;
+    const int64 out_row_size = out_width * channels;
+
+    // The resize is separable: every output row is a blend of two input rows
+    // that have been interpolated horizontally, and the horizontal
+    // interpolation is the same for every row, so it is worked out once.
+    std::vector<CachedInterpolation> xs(out_width);
+    for (int64 x = 0; x < out_width; ++x) {
+      const float in_x = x * width_scale;
+      const int64 left_x_index = static_cast<int64>(floorf(in_x));
+      const int64 right_x_index =
+          std::min(static_cast<int64>(ceilf(in_x)), in_width - 1);
+      xs[x].left = left_x_index * channels;
+      xs[x].right = right_x_index * channels;
+      xs[x].lerp = in_x - left_x_index;
+    }
 
-    for (int b = 0; b < batch; ++b) {
-      for (int y = 0; y < out_height; ++y) {
+    const T* input_data = images.data();
+    float* output_data = output.data();
+    auto resize_rows = [&](int64 start, int64 limit) {
+      // Consecutive output rows often blend the same input rows, so the two
+      // most recently interpolated input rows are kept.
+      std::vector<float> rows[2] = {std::vector<float>(out_row_size),
+                                    std::vector<float>(out_row_size)};
+      int64 cached[2] = {-1, -1};
+      int last_used = 0;
+      auto interpolated_row = [&](int64 b, int64 y) -> const float* {
+        const int64 key = b * in_height + y;
+        for (int i = 0; i < 2; ++i) {
+          if (cached[i] == key) {
+            last_used = i;
+            return rows[i].data();
+          }
+        }
+        const int slot = 1 - last_used;
+        InterpolateRow(input_data + key * in_row_size, xs, channels,
+                       rows[slot].data());
+        cached[slot] = key;
+        last_used = slot;
+        return rows[slot].data();
+      };
+      for (int64 row = start; row < limit; ++row) {
+        const int64 b = row / out_height;
+        const int64 y = row % out_height;
         const float in_y = y * height_scale;
         const int64 top_y_index = static_cast<int64>(floorf(in_y));
         const int64 bottom_y_index =
             std::min(static_cast<int64>(ceilf(in_y)), in_height - 1);
         const float y_lerp = in_y - top_y_index;
-        for (int x = 0; x < out_width; ++x) {
-          const float in_x = x * width_scale;
-          const int64 left_x_index = static_cast<int64>(floorf(in_x));
-          const int64 right_x_index =
-              std::min(static_cast<int64>(ceilf(in_x)), in_width - 1);
-          const float x_lerp = in_x - left_x_index;
-          for (int c = 0; c < channels; ++c) {
-            const float top_left(images(b, top_y_index, left_x_index, c));
-            const float top_right(images(b, top_y_index, right_x_index, c));
-            const float bottom_left(images(b, bottom_y_index, left_x_index, c));
-            const float bottom_right(
-                images(b, bottom_y_index, right_x_index, c));
-            const float top = top_left + (top_right - top_left) * x_lerp;
-            const float bottom =
-                bottom_left + (bottom_right - bottom_left) * x_lerp;
-            output(b, y, x, c) = top + (bottom - top) * y_lerp;
-          }
-        }
+        Eigen::Map<const Eigen::ArrayXf> top(interpolated_row(b, top_y_index),
+                                             out_row_size);
+        Eigen::Map<const Eigen::ArrayXf> bottom(
+            interpolated_row(b, bottom_y_index), out_row_size);
+        Eigen::Map<Eigen::ArrayXf>(output_data + row * out_row_size,
+                                   out_row_size) =
+            top + (bottom - top) * y_lerp;
       }
-    }
+    };
+    // Each output row reads (at most) two input rows at two points per
+    // output pixel and writes one row.
+    const Eigen::TensorOpCost cost(4 * out_row_size * sizeof(T),
+                                   out_row_size * sizeof(float),
+                                   8 * out_row_size);
+    d.parallelFor(batch * out_height, cost, resize_rows);
   }
 };
 }  // namespace functor
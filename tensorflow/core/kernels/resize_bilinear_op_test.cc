@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/fake_input.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -26,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 
@@ -301,6 +303,60 @@ TEST_F(ResizeBilinearOpTest, TestBilinear2x2To4x4) {
   test::ExpectTensorEqual<float>(expected, *GetOutput(0));
 }
 
+class ResizeBilinearOpUint8Test : public OpsTestBase {
+ protected:
+  ResizeBilinearOpUint8Test() {
+    TF_EXPECT_OK(NodeDefBuilder("resize_bilinear_op", "ResizeBilinear")
+                     .Input(FakeInput(DT_UINT8))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("align_corners", false)
+                     .Finalize(node_def()));
+    TF_EXPECT_OK(InitOp());
+  }
+};
+
+TEST_F(ResizeBilinearOpUint8Test, TestBilinearRgbDownscale) {
+  // Compare against a direct evaluation of the four-point formula.
+  const int in_height = 13, in_width = 11, out_height = 5, out_width = 4;
+  Tensor input(DT_UINT8, TensorShape({2, in_height, in_width, 3}));
+  auto input_flat = input.flat<uint8>();
+  for (int i = 0; i < input_flat.size(); ++i) {
+    input_flat(i) = static_cast<uint8>((i * 37) % 251);
+  }
+  Tensor expected(DT_FLOAT, TensorShape({2, out_height, out_width, 3}));
+  auto in = input.tensor<uint8, 4>();
+  auto out = expected.tensor<float, 4>();
+  const float height_scale = static_cast<float>(in_height) / out_height;
+  const float width_scale = static_cast<float>(in_width) / out_width;
+  for (int b = 0; b < 2; ++b) {
+    for (int y = 0; y < out_height; ++y) {
+      const float in_y = y * height_scale;
+      const int top = static_cast<int>(floorf(in_y));
+      const int bottom = std::min(static_cast<int>(ceilf(in_y)), in_height - 1);
+      for (int x = 0; x < out_width; ++x) {
+        const float in_x = x * width_scale;
+        const int left = static_cast<int>(floorf(in_x));
+        const int right = std::min(static_cast<int>(ceilf(in_x)), in_width - 1);
+        for (int c = 0; c < 3; ++c) {
+          const float tl = in(b, top, left, c), tr = in(b, top, right, c);
+          const float bl = in(b, bottom, left, c);
+          const float br = in(b, bottom, right, c);
+          const float t = tl + (tr - tl) * (in_x - left);
+          const float bt = bl + (br - bl) * (in_x - left);
+          out(b, y, x, c) = t + (bt - t) * (in_y - top);
+        }
+      }
+    }
+  }
+
+  AddInputFromArray<uint8>(
+      input.shape(),
+      gtl::ArraySlice<uint8>(input_flat.data(), input_flat.size()));
+  AddInputFromArray<int32>(TensorShape({2}), {out_height, out_width});
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
 TEST_F(ResizeBilinearOpTest, TestInvalidInputShape) {
   AddInputFromArray<float>(TensorShape({2, 2, 1}), {1, 2, 3, 4});
   AddInputFromArray<int32>(TensorShape({2}), {4, 4});
@@ -318,4 +374,39 @@ TEST_F(ResizeBilinearOpTest, TestInvalidSizeElements) {
   ASSERT_FALSE(RunOpKernel().ok());
 }
 
+static Graph* ResizeBilinear(DataType type, int in_height, int in_width,
+                             int out_height, int out_width) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor input(type, TensorShape({1, in_height, in_width, 3}));
+  if (type == DT_UINT8) {
+    input.flat<uint8>().setRandom();
+  } else {
+    input.flat<float>().setRandom();
+  }
+  Tensor size(DT_INT32, TensorShape({2}));
+  size.flat<int32>()(0) = out_height;
+  size.flat<int32>()(1) = out_width;
+  test::graph::Binary(g, "ResizeBilinear", test::graph::Constant(g, input),
+                      test::graph::Constant(g, size));
+  return g;
+}
+
+// Downscales of 4K RGB images to 224 x 224, as in input preprocessing, and a
+// 2x upscale.
+#define BM_ResizeBilinearDev(TYPE, IN_H, IN_W, OUT_H, OUT_W)                  \
+  static void BM_ResizeBilinear_##TYPE##_##IN_H##_##IN_W##_##OUT_H##_##OUT_W( \
+      int iters) {                                                            \
+    testing::ItemsProcessed(static_cast<int64>(iters) * OUT_H * OUT_W * 3);  \
+    testing::UseRealTime();                                                   \
+    test::Benchmark("cpu", ResizeBilinear(DataTypeToEnum<TYPE>::value, IN_H,  \
+                                          IN_W, OUT_H, OUT_W))                \
+        .Run(iters);                                                          \
+  }                                                                           \
+  BENCHMARK(BM_ResizeBilinear_##TYPE##_##IN_H##_##IN_W##_##OUT_H##_##OUT_W)
+
+BM_ResizeBilinearDev(uint8, 2160, 3840, 224, 224);
+BM_ResizeBilinearDev(float, 2160, 3840, 224, 224);
+BM_ResizeBilinearDev(uint8, 224, 224, 448, 448);
+BM_ResizeBilinearDev(float, 224, 224, 448, 448);
+
 }  // namespace tensorflow
@@ -30,7 +30,9 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -232,16 +234,86 @@ struct UnsortedSegmentSumFunctor<CPUDevice, T, Index> {
       return;
     }
     const int64 N = segment_ids.dimension(0);
-    auto data_flat = typename TTypes<T, 2>::ConstTensor(data, N, data_size / N);
+    const int64 row_size = data_size / N;
+    auto data_flat = typename TTypes<T, 2>::ConstTensor(data, N, row_size);
+    // Copy and validate the ids first, so that the accumulation below can run
+    // in parallel without checks.
+    std::vector<Index> ids(N);
     for (int64 i = 0; i < N; ++i) {
-      Index j = internal::SubtleMustCopy(segment_ids(i));
-      OP_REQUIRES(ctx, FastBoundsCheck(j, output_rows),
+      ids[i] = internal::SubtleMustCopy(segment_ids(i));
+      OP_REQUIRES(ctx, FastBoundsCheck(ids[i], output_rows),
                   errors::InvalidArgument(
                       "segment_ids", SliceDebugString(segment_ids_shape, i),
-                      " = ", j, " is out of range [0, ", output_rows, ")"));
-      output.template chip<0>(j) += data_flat.template chip<0>(i);
+                      " = ", ids[i], " is out of range [0, ", output_rows,
+                      ")"));
+    }
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    if (static_cast<int64>(output_rows) * kMinInputRowsPerOutputRow <= N) {
+      // Many input rows per output row: the input is split into a few
+      // slices, each summed into its own partial output, and the partial
+      // outputs are then summed into the output, in parallel over its
+      // elements.  There are few enough partials that clearing and adding
+      // them costs at most 1 / kMinInputRowsPerOutputRow of the input.
+      const int64 num_partials = std::min<int64>(
+          worker_threads->num_threads,
+          N / (static_cast<int64>(output_rows) * kMinInputRowsPerOutputRow));
+      Tensor partials;
+      const TensorShape partials_shape(
+          {num_partials, static_cast<int64>(output_rows) * row_size});
+      OP_REQUIRES_OK(ctx, ctx->allocate_temp(DataTypeToEnum<T>::value,
+                                             partials_shape, &partials));
+      auto partials_flat = partials.matrix<T>();
+      auto sum_inputs = [&](int64 first, int64 last) {
+        for (int64 p = first; p < last; ++p) {
+          typename TTypes<T, 2>::Tensor partial(&partials_flat(p, 0),
+                                                output_rows, row_size);
+          partial.setZero();
+          for (int64 i = N * p / num_partials; i < N * (p + 1) / num_partials;
+               ++i) {
+            partial.template chip<0>(ids[i]) += data_flat.template chip<0>(i);
+          }
+        }
+      };
+      Shard(worker_threads->num_threads, worker_threads->workers, num_partials,
+            N / num_partials * row_size, sum_inputs);
+      T* output_data = output.data();
+      auto sum_partials = [&](int64 first, int64 last) {
+        for (int64 p = 0; p < num_partials; ++p) {
+          for (int64 k = first; k < last; ++k) {
+            output_data[k] += partials_flat(p, k);
+          }
+        }
+      };
+      Shard(worker_threads->num_threads, worker_threads->workers,
+            output_rows * row_size, num_partials, sum_partials);
+    } else {
+      // Few input rows per output row: the input rows are bucketed by output
+      // row, and each shard sums the buckets of a range of output rows.
+      std::vector<int64> bucket_starts(output_rows + 1, 0);
+      for (int64 i = 0; i < N; ++i) ++bucket_starts[ids[i] + 1];
+      for (Index j = 0; j < output_rows; ++j) {
+        bucket_starts[j + 1] += bucket_starts[j];
+      }
+      std::vector<int64> rows(N);
+      std::vector<int64> bucket_ends(bucket_starts.begin(),
+                                     bucket_starts.end() - 1);
+      for (int64 i = 0; i < N; ++i) rows[bucket_ends[ids[i]]++] = i;
+      auto sum_outputs = [&](int64 first, int64 last) {
+        for (int64 j = first; j < last; ++j) {
+          for (int64 k = bucket_starts[j]; k < bucket_starts[j + 1]; ++k) {
+            output.template chip<0>(j) += data_flat.template chip<0>(rows[k]);
+          }
+        }
+      };
+      Shard(worker_threads->num_threads, worker_threads->workers, output_rows,
+            (N / output_rows + 1) * row_size, sum_outputs);
     }
   }
+
+ private:
+  // Below this many input rows per output row, per-shard accumulators cost
+  // more to clear and merge than they save.
+  static constexpr int64 kMinInputRowsPerOutputRow = 8;
 };
 
 }  // namespace functor
@@ -379,48 +451,67 @@ class SparseSegmentReductionOpBase : public OpKernel {
                 errors::InvalidArgument("segment ids must be >= 0"));
     auto output_flat = output->flat_outer_dims<T>();
 
-    int64 start = 0, end = 1;
-    OutputRow out_index = internal::SubtleMustCopy(segment_vec(start));
+    // Find where each segment starts. Segment ids are validated up front, so
+    // that the segments can then be reduced in parallel.
+    std::vector<int64> segment_starts;
+    segment_starts.reserve(output_rows + 1);
+    segment_starts.push_back(0);
+    OutputRow out_index = internal::SubtleMustCopy(segment_vec(0));
     OP_REQUIRES(context, out_index == 0,
                 errors::InvalidArgument("segment ids do not start at 0"));
-
-    while (true) {
-      // We initialize next_index to 0 to avoid "warning: 'next_index' may be
-      // used uninitialized in this function" in the Mac build (since the
-      // compiler isn't smart enough to realize the code is safe).
-      OutputRow next_index = 0;
-      if (end < num_indices) {
-        next_index = internal::SubtleMustCopy(segment_vec(end));
-        if (out_index == next_index) {
-          ++end;
-          continue;
-        }
-        // We have a new segment here.  Verify that the segment ids grow by one
-        // each time, so that we cover every possible output value.
-        OP_REQUIRES(
-            context, out_index + 1 == next_index,
-            errors::InvalidArgument("segment ids are not increasing by 1"));
-      }
-
+    for (int64 end = 1; end < num_indices; ++end) {
+      const OutputRow next_index = internal::SubtleMustCopy(segment_vec(end));
+      if (out_index == next_index) continue;
+      // We have a new segment here.  Verify that the segment ids grow by one
+      // each time, so that we cover every possible output value.
       OP_REQUIRES(
-          context, FastBoundsCheck(out_index, output_rows),
+          context, out_index + 1 == next_index,
+          errors::InvalidArgument("segment ids are not increasing by 1"));
+      OP_REQUIRES(
+          context, FastBoundsCheck(next_index, output_rows),
           errors::InvalidArgument(
-              "Segment id ", out_index, " out of range [0, ", output_rows,
+              "Segment id ", next_index, " out of range [0, ", output_rows,
               "), probably because 'segment_ids' input is not sorted."));
-      auto out = output_flat.template chip<0>(out_index);
-      const int bad_offset =
-          Reduce(input_flat, indices_vec, start, end - start, out);
-      OP_REQUIRES(context, bad_offset < 0,
-                  errors::InvalidArgument(
-                      "Bad: indices[", start + bad_offset, "] == ",
-                      indices_vec(start + bad_offset), " out of range [0, ",
-                      input_flat.dimension(0), ")"));
-
-      if (end >= num_indices) break;
-      start = end;
-      ++end;
+      segment_starts.push_back(end);
       out_index = next_index;
     }
+    OP_REQUIRES(
+        context, static_cast<int64>(segment_starts.size()) == output_rows,
+        errors::InvalidArgument(
+            "Segment id ", out_index, " out of range [0, ", output_rows,
+            "), probably because 'segment_ids' input is not sorted."));
+    segment_starts.push_back(num_indices);
+
+    // Each output row is written by exactly one shard. A shard that finds an
+    // invalid index stops, and the earliest invalid position is reported.
+    mutex mu;
+    int64 bad_position = -1;
+    auto reduce_segments = [&](int64 first_segment, int64 last_segment) {
+      for (int64 segment = first_segment; segment < last_segment; ++segment) {
+        const int64 start = segment_starts[segment];
+        const int64 num = segment_starts[segment + 1] - start;
+        auto out = output_flat.template chip<0>(segment);
+        const int64 bad_offset =
+            Reduce(input_flat, indices_vec, start, num, out);
+        if (bad_offset >= 0) {
+          mutex_lock l(mu);
+          if (bad_position < 0 || start + bad_offset < bad_position) {
+            bad_position = start + bad_offset;
+          }
+          return;
+        }
+      }
+    };
+    const int64 cost_per_segment =
+        (num_indices / output_rows + 1) * input_flat.dimension(1);
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, output_rows,
+          cost_per_segment, reduce_segments);
+    OP_REQUIRES(context, bad_position < 0,
+                errors::InvalidArgument(
+                    "Bad: indices[", bad_position, "] == ",
+                    indices_vec(bad_position), " out of range [0, ",
+                    input_flat.dimension(0), ")"));
   }
 
  private:
@@ -166,4 +166,83 @@ static void BM_SparseSegmentMeanGrad_High(int iters, int size) {
 BENCHMARK(BM_SparseSegmentMeanGrad_Low)->Arg(1000)->Arg(100000);
 BENCHMARK(BM_SparseSegmentMeanGrad_High)->Arg(1000)->Arg(100000);
 
+static void SparseSegmentSumHelper(int iters, int num_segments,
+                                   int indices_per_segment) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+
+  const int kRows = 100000;
+  const int kDim = 64;
+  const int kNumIndices = num_segments * indices_per_segment;
+  Tensor input(DT_FLOAT, TensorShape({kRows, kDim}));
+  input.flat<float>().setRandom();
+  Tensor indices(DT_INT32, TensorShape({kNumIndices}));
+  Tensor segments(DT_INT32, TensorShape({kNumIndices}));
+  for (int i = 0; i < kNumIndices; ++i) {
+    indices.flat<int32>()(i) = (i * 7919) % kRows;
+    segments.flat<int32>()(i) = i / indices_per_segment;
+  }
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "SparseSegmentSum")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, indices))
+                  .Input(test::graph::Constant(g, segments))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &node));
+
+  testing::UseRealTime();
+  testing::BytesProcessed(static_cast<int64>(iters) * kNumIndices * kDim *
+                          sizeof(float));
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+static void BM_SparseSegmentSum_Segments(int iters, int num_segments) {
+  return SparseSegmentSumHelper(iters, num_segments, 20);
+}
+
+BENCHMARK(BM_SparseSegmentSum_Segments)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void UnsortedSegmentSumHelper(int iters, int num_rows,
+                                     int num_segments) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+
+  const int kDim = 64;
+  Tensor data(DT_FLOAT, TensorShape({num_rows, kDim}));
+  data.flat<float>().setRandom();
+  Tensor segment_ids(DT_INT32, TensorShape({num_rows}));
+  for (int i = 0; i < num_rows; ++i) {
+    segment_ids.flat<int32>()(i) = (i * 7919) % num_segments;
+  }
+  Tensor num_segments_t(DT_INT32, TensorShape({}));
+  num_segments_t.scalar<int32>()() = num_segments;
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "UnsortedSegmentSum")
+                  .Input(test::graph::Constant(g, data))
+                  .Input(test::graph::Constant(g, segment_ids))
+                  .Input(test::graph::Constant(g, num_segments_t))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &node));
+
+  testing::UseRealTime();
+  testing::BytesProcessed(static_cast<int64>(iters) * num_rows * kDim *
+                          sizeof(float));
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+static void BM_UnsortedSegmentSum_FewSegments(int iters, int num_rows) {
+  return UnsortedSegmentSumHelper(iters, num_rows, 64);
+}
+
+static void BM_UnsortedSegmentSum_ManySegments(int iters, int num_rows) {
+  return UnsortedSegmentSumHelper(iters, num_rows, num_rows / 2);
+}
+
+BENCHMARK(BM_UnsortedSegmentSum_FewSegments)->Arg(10000)->Arg(100000);
+BENCHMARK(BM_UnsortedSegmentSum_ManySegments)->Arg(10000)->Arg(100000);
+
 }  // namespace tensorflow
@@ -143,6 +143,39 @@ class SliceOp : public OpKernel {
       return;
     }
 
+    if (std::is_same<Device, CPUDevice>::value &&
+        output_shape.num_elements() > 0) {
+      const gtl::InlinedVector<int64, 4> strides =
+          RowMajorStrides(input.shape());
+      int64 offset = 0;
+      for (int i = 0; i < input.dims(); ++i) offset += begin[i] * strides[i];
+
+      // The slice is one contiguous run of the input if the dimensions
+      // before the last one that is not taken whole all have size 1.  Then
+      // it can share the input's buffer, as in the dim 0 case above.
+      int last_sliced = input.dims() - 1;
+      while (begin[last_sliced] == 0 &&
+             size[last_sliced] == input.dim_size(last_sliced)) {
+        --last_sliced;  // Stops at a sliced dimension as !is_identity.
+      }
+      bool contiguous = true;
+      for (int i = 0; i < last_sliced; ++i) contiguous &= size[i] == 1;
+      const int64 inner = strides[last_sliced];
+      const TensorShape rows({input.NumElements() / inner, inner});
+      if (contiguous && IsInnerDimsSizeAligned<T>(rows)) {
+        VLOG(1) << "Slice contiguous: " << input.shape().DebugString();
+        Tensor input_rows;
+        CHECK(input_rows.CopyFrom(input, rows));
+        const int64 start_row = offset / inner;
+        Tensor output;
+        CHECK(output.CopyFrom(
+            input_rows.Slice(start_row, start_row + size[last_sliced]),
+            output_shape));
+        context->set_output(0, output);
+        return;
+      }
+    }
+
     Tensor* result = nullptr;
     OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &result));
     const int input_dims = input.dims();
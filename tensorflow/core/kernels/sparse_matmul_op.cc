@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_matmul_op.h"
 
+#include <memory>
 #include <vector>
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/common_runtime/device.h"
@@ -29,9 +30,12 @@ limitations under the License.
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -818,6 +822,195 @@ class SparseMatMul {
   TF_DISALLOW_COPY_AND_ASSIGN(SparseMatMul);
 };
 
+namespace {
+
+// Operands whose sampled fraction of nonzeros is at most this value are
+// multiplied using the CSR path below. At this density the per-block overhead
+// of SparseSlice dominates the actual arithmetic.
+static const float kCsrMaxDensity = 0.05f;
+
+// Operands whose sampled fraction of nonzeros exceeds this value are treated as
+// dense even if they were marked sparse. The block sparse path breaks even
+// with the dense contraction at about 30% zeros.
+static const float kBlockSparseMaxDensity = 0.7f;
+
+// Maximum number of elements inspected by EstimateDensity.
+static const int64 kNumDensitySamples = 1024;
+static const uint64 kDensitySamplingSeed = 0x5eed;
+
+inline float ConvertToFloat(float v) { return v; }
+
+inline float ConvertToFloat(bfloat16 v) {
+  float f;
+  BFloat16ToFloat(&v, &f, 1);
+  return f;
+}
+
+// Returns an estimate of the fraction of nonzero elements in "t". Small tensors
+// are scanned fully, larger ones are sampled at pseudo-random positions from a
+// fixed seed, so that the estimate is deterministic but, unlike a fixed stride,
+// does not follow the columns when the row length divides the stride.
+template <typename T>
+float EstimateDensity(const Tensor& t) {
+  const int64 size = t.NumElements();
+  if (size == 0) return 0;
+  const T* data = t.flat<T>().data();
+  static const T zero(0);
+  int64 num_nonzeros = 0;
+  if (size <= kNumDensitySamples) {
+    for (int64 i = 0; i < size; ++i) {
+      if (!(data[i] == zero)) ++num_nonzeros;
+    }
+    return static_cast<float>(num_nonzeros) / size;
+  }
+  random::PhiloxRandom philox(kDensitySamplingSeed);
+  random::SimplePhilox rnd(&philox);
+  for (int64 i = 0; i < kNumDensitySamples; ++i) {
+    if (!(data[rnd.Uniform64(size)] == zero)) ++num_nonzeros;
+  }
+  return static_cast<float>(num_nonzeros) / kNumDensitySamples;
+}
+
+// Compressed sparse row representation of a float matrix with num_rows rows.
+// The nonzeros of row i are values[row_offsets[i], row_offsets[i + 1]) in
+// columns col_indices[row_offsets[i], row_offsets[i + 1]).
+struct CsrMatrix {
+  int64 num_rows = 0;
+  int64 num_cols = 0;
+  std::vector<int64> row_offsets;
+  std::vector<int32> col_indices;
+  std::vector<float> values;
+};
+
+// Encodes "mat", or its transpose if "transpose" is true, into "csr".
+template <typename T>
+void EncodeCsr(const Tensor& mat, bool transpose, CsrMatrix* csr) {
+  auto m = mat.matrix<T>();
+  const int64 rows = m.dimension(0);
+  const int64 cols = m.dimension(1);
+  static const T zero(0);
+  csr->num_rows = transpose ? cols : rows;
+  csr->num_cols = transpose ? rows : cols;
+  csr->row_offsets.assign(csr->num_rows + 1, 0);
+  csr->col_indices.clear();
+  csr->values.clear();
+  if (!transpose) {
+    for (int64 i = 0; i < rows; ++i) {
+      for (int64 j = 0; j < cols; ++j) {
+        if (m(i, j) == zero) continue;
+        csr->col_indices.push_back(static_cast<int32>(j));
+        csr->values.push_back(ConvertToFloat(m(i, j)));
+      }
+      csr->row_offsets[i + 1] = csr->values.size();
+    }
+    return;
+  }
+  // Count the nonzeros of every column first so that the matrix can be read
+  // in row major order while the transposed rows are filled in.
+  for (int64 i = 0; i < rows; ++i) {
+    for (int64 j = 0; j < cols; ++j) {
+      if (!(m(i, j) == zero)) ++csr->row_offsets[j + 1];
+    }
+  }
+  for (int64 j = 0; j < cols; ++j) {
+    csr->row_offsets[j + 1] += csr->row_offsets[j];
+  }
+  const int64 nnz = csr->row_offsets[cols];
+  csr->col_indices.resize(nnz);
+  csr->values.resize(nnz);
+  std::vector<int64> next(csr->row_offsets.begin(), csr->row_offsets.end() - 1);
+  for (int64 i = 0; i < rows; ++i) {
+    for (int64 j = 0; j < cols; ++j) {
+      if (m(i, j) == zero) continue;
+      const int64 pos = next[j]++;
+      csr->col_indices[pos] = static_cast<int32>(i);
+      csr->values[pos] = ConvertToFloat(m(i, j));
+    }
+  }
+}
+
+// Returns "mat" converted to float and transposed if "transpose" is true, as a
+// row major matrix. Returns "mat" itself when no conversion is needed.
+template <typename T>
+const Tensor* DenseFloatOperand(OpKernelContext* ctx, const Tensor& mat,
+                                bool transpose,
+                                std::unique_ptr<Tensor>* storage) {
+  if (!transpose && std::is_same<T, float>::value) return &mat;
+  const Tensor* src = &mat;
+  std::unique_ptr<Tensor> converted;
+  if (std::is_same<T, bfloat16>::value) {
+    converted.reset(new Tensor(DT_FLOAT, mat.shape()));
+    BFloat16ToFloat(reinterpret_cast<const bfloat16*>(mat.flat<T>().data()),
+                    converted->flat<float>().data(), mat.NumElements());
+    src = converted.get();
+  }
+  if (!transpose) {
+    *storage = std::move(converted);
+    return storage->get();
+  }
+  storage->reset(new Tensor(
+      DT_FLOAT, TensorShape({src->dim_size(1), src->dim_size(0)})));
+  Eigen::array<int, 2> perm({1, 0});
+  (*storage)->matrix<float>().device(ctx->eigen_device<CPUDevice>()) =
+      src->matrix<float>().shuffle(perm);
+  return storage->get();
+}
+
+// Computes output = sparse * dense, where "dense" is a row major float matrix.
+void CsrTimesDense(const CsrMatrix& sparse, const Tensor& dense,
+                   const DeviceBase::CpuWorkerThreads* worker_threads,
+                   MatrixMap* output) {
+  const int64 n = dense.dim_size(1);
+  const float* dense_data = dense.flat<float>().data();
+  float* out_data = output->data();
+  const int64 nnz_per_row =
+      sparse.num_rows == 0 ? 0 : sparse.values.size() / sparse.num_rows;
+  auto work = [&sparse, n, dense_data, out_data](int64 start, int64 limit) {
+    for (int64 i = start; i < limit; ++i) {
+      Eigen::Map<Eigen::ArrayXf> out_row(out_data + i * n, n);
+      out_row.setZero();
+      for (int64 p = sparse.row_offsets[i]; p < sparse.row_offsets[i + 1];
+           ++p) {
+        out_row += sparse.values[p] *
+                   Eigen::Map<const Eigen::ArrayXf>(
+                       dense_data + sparse.col_indices[p] * n, n);
+      }
+    }
+  };
+  Shard(worker_threads->num_threads, worker_threads->workers, sparse.num_rows,
+        (nnz_per_row + 1) * n, work);
+}
+
+// Computes output = dense * sparse, where "dense" is a row major float matrix.
+void DenseTimesCsr(const Tensor& dense, const CsrMatrix& sparse,
+                   const DeviceBase::CpuWorkerThreads* worker_threads,
+                   MatrixMap* output) {
+  const int64 m = dense.dim_size(0);
+  const int64 k = dense.dim_size(1);
+  const int64 n = sparse.num_cols;
+  const float* dense_data = dense.flat<float>().data();
+  float* out_data = output->data();
+  auto work = [&sparse, k, n, dense_data, out_data](int64 start, int64 limit) {
+    for (int64 i = start; i < limit; ++i) {
+      float* out_row = out_data + i * n;
+      std::fill(out_row, out_row + n, 0.0f);
+      const float* dense_row = dense_data + i * k;
+      for (int64 j = 0; j < k; ++j) {
+        const float a = dense_row[j];
+        if (a == 0) continue;
+        for (int64 p = sparse.row_offsets[j]; p < sparse.row_offsets[j + 1];
+             ++p) {
+          out_row[sparse.col_indices[p]] += a * sparse.values[p];
+        }
+      }
+    }
+  };
+  Shard(worker_threads->num_threads, worker_threads->workers, m,
+        k + sparse.values.size(), work);
+}
+
+}  // namespace
+
 template <typename TL, typename TR>
 class SparseMatMulOp : public OpKernel {
   typedef Eigen::Tensor<TR, 2, Eigen::RowMajor> MatrixR;
@@ -854,9 +1047,23 @@ class SparseMatMulOp : public OpKernel {
     OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({m, n}), &output));
     auto out = output->matrix<float>();
 
+    // Pick an algorithm from the sampled densities of the operands. Nearly
+    // empty operands always use the CSR path. The a_is_sparse and b_is_sparse
+    // hints select the block sparse path only if sampling confirms them.
+    const float a_density = EstimateDensity<TL>(a);
+    const float b_density = EstimateDensity<TR>(b);
+    if (std::min(a_density, b_density) <= kCsrMaxDensity) {
+      ComputeCsr(ctx, a, b, a_density <= b_density, &out);
+      return;
+    }
+    const bool a_is_sparse =
+        a_is_sparse_ && a_density <= kBlockSparseMaxDensity;
+    const bool b_is_sparse =
+        b_is_sparse_ && b_density <= kBlockSparseMaxDensity;
+
     std::unique_ptr<Tensor> a_float;
     std::unique_ptr<Tensor> b_float;
-    if (!a_is_sparse_ && !b_is_sparse_) {
+    if (!a_is_sparse && !b_is_sparse) {
       auto left = &a;
       auto right = &b;
       // TODO(agarwal): multi-thread the conversions from bfloat16 to float.
@@ -886,7 +1093,7 @@ class SparseMatMulOp : public OpKernel {
     bool transpose_output = false;
     bool transpose_a = transpose_a_;
     bool transpose_b = transpose_b_;
-    if (!a_is_sparse_) {
+    if (!a_is_sparse) {
       // Swap the order of multiplications using the identity:
       // A * B = (B' *  A')'.
       std::swap(left, right);
@@ -929,6 +1136,27 @@ class SparseMatMulOp : public OpKernel {
   }
 
  private:
+  // Computes out = op(a) * op(b) using a CSR encoding of op(a) if
+  // "sparse_left" is true and of op(b) otherwise.
+  void ComputeCsr(OpKernelContext* ctx, const Tensor& a, const Tensor& b,
+                  bool sparse_left, MatrixMap* out) {
+    const DeviceBase::CpuWorkerThreads* worker_threads =
+        ctx->device()->tensorflow_cpu_worker_threads();
+    std::unique_ptr<Tensor> dense_storage;
+    CsrMatrix csr;
+    if (sparse_left) {
+      EncodeCsr<TL>(a, transpose_a_, &csr);
+      const Tensor* dense =
+          DenseFloatOperand<TR>(ctx, b, transpose_b_, &dense_storage);
+      CsrTimesDense(csr, *dense, worker_threads, out);
+    } else {
+      EncodeCsr<TR>(b, transpose_b_, &csr);
+      const Tensor* dense =
+          DenseFloatOperand<TL>(ctx, a, transpose_a_, &dense_storage);
+      DenseTimesCsr(*dense, csr, worker_threads, out);
+    }
+  }
+
   bool transpose_a_;
   bool transpose_b_;
   bool a_is_sparse_;
@@ -130,6 +130,10 @@ BM_SPARSE_FLOAT(2048, 2048, 2048, 99, 0, false, false);
 // Test sparse a
 BM_SPARSE_FLOAT(2048, 2048, 2048, 0, 50, false, false);
 BM_SPARSE_FLOAT(2048, 2048, 2048, 0, 85, false, false);
+// Test nearly empty inputs
+BM_SPARSE_FLOAT(2048, 2048, 2048, 98, 0, false, false);
+BM_SPARSE_FLOAT(2048, 2048, 2048, 0, 98, false, false);
+BM_SPARSE_FLOAT(2048, 2048, 2048, 98, 0, true, false);
 // Test transposing
 BM_SPARSE_FLOAT(2048, 2048, 2048, 85, 0, true, false);
 BM_SPARSE_FLOAT(2048, 2048, 2048, 85, 0, false, true);
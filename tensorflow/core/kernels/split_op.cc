@@ -151,6 +151,27 @@ class SplitOpCPU : public SplitOpBase<CPUDevice, T> {
     TensorShape output_shape(input_shape);
     output_shape.set_dim(split_dim, split_dim_output_size);
 
+    if (output_shape.num_elements() > 0) {
+      // If all dimensions before split_dim have size 1, each output is a
+      // contiguous run of the input and can share its buffer, as in the
+      // split_dim == 0 case.
+      const TensorShape rows({split_dim_size, suffix_dim_size});
+      if (prefix_dim_size == 1 && IsInnerDimsSizeAligned<T>(rows)) {
+        VLOG(1) << "Split contiguous: " << input_shape.DebugString();
+        Tensor input_rows;
+        CHECK(input_rows.CopyFrom(input, rows));
+        for (int i = 0; i < num_split; ++i) {
+          Tensor output;
+          CHECK(output.CopyFrom(
+              input_rows.Slice(i * split_dim_output_size,
+                               (i + 1) * split_dim_output_size),
+              output_shape));
+          context->set_output(i, output);
+        }
+        return;
+      }
+    }
+
     Eigen::DSizes<Eigen::DenseIndex, 3> indices{0, 0, 0};
     Eigen::DSizes<Eigen::DenseIndex, 3> sizes{
         prefix_dim_size, split_dim_output_size, suffix_dim_size};
@@ -15,28 +15,43 @@ limitations under the License.
 
 // See docs in ../ops/string_ops.cc.
 
+#include <string.h>
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/framework/kernel_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
-#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 namespace {
 
-std::vector<string> Split(const string& str, const string& delimiter) {
-  if (delimiter.size()) {
-    return str_util::Split(str, delimiter[0], str_util::SkipEmpty());
+// Calls fn(token) for each token of `str`, in order.  With a delimiter the
+// tokens are the non-empty runs between delimiters; an empty delimiter makes
+// every character a token.  The delimiter search is done by memchr, which
+// the C library implements with wide vector compares, so long tokens cost
+// far less than a byte at a time.
+template <typename Fn>
+void ForEachToken(StringPiece str, const string& delimiter, Fn fn) {
+  const char* p = str.data();
+  const char* const end = p + str.size();
+  if (delimiter.empty()) {
+    for (; p < end; ++p) fn(StringPiece(p, 1));
+    return;
   }
-  std::vector<string> char_vector(str.size());
-  for (size_t i = 0; i < str.size(); ++i) {
-    char_vector[i] = str[i];
+  const char delim = delimiter[0];
+  while (p < end) {
+    const char* next = static_cast<const char*>(memchr(p, delim, end - p));
+    if (next == nullptr) next = end;
+    if (next > p) fn(StringPiece(p, next - p));
+    p = next + 1;
   }
-  return char_vector;
 }
 
 }  // namespace
@@ -68,46 +83,78 @@ class StringSplitOp : public OpKernel {
                 errors::InvalidArgument("Delimiter must be a character, got",
                                         delimiter));
 
-    std::vector<string> tokens;
-    // Guess that we'll be unpacking a handful of tokens per example.
-    static constexpr int kReserveSize = 4;
-    tokens.reserve(batch_size * kReserveSize);
-
-    int64 output_size = 0;
+    // The input is scanned twice, once to count the tokens of each example
+    // and their bytes, and once to copy them into the output, which holds
+    // all the tokens back to back in one packed string tensor.  Scanning is
+    // much cheaper than allocating a string per token.
+    int64 input_bytes = 0;
+    for (int64 i = 0; i < batch_size; ++i) input_bytes += input_vec(i).size();
+    const int64 cost_per_example =
+        10 * (1 + input_bytes / std::max<int64>(batch_size, 1));
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+
+    // num_indices[i + 1] and num_bytes[i + 1] start out as the token and byte
+    // counts of example i and are then turned into the offsets of the tokens
+    // and bytes of example i + 1 in the output.
+    std::vector<int64> num_indices(batch_size + 1, 0);
+    std::vector<int64> num_bytes(batch_size + 1, 0);
+    Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
+          cost_per_example, [&input_vec, &delimiter, &num_indices, &num_bytes](
+                                int64 start, int64 limit) {
+            for (int64 i = start; i < limit; ++i) {
+              int64 n_entries = 0;
+              int64 n_bytes = 0;
+              ForEachToken(input_vec(i), delimiter,
+                           [&n_entries, &n_bytes](StringPiece token) {
+                             ++n_entries;
+                             n_bytes += token.size();
+                           });
+              num_indices[i + 1] = n_entries;
+              num_bytes[i + 1] = n_bytes;
+            }
+          });
     int64 max_num_entries = 0;
-    std::vector<int64> num_indices(batch_size);
     for (int64 i = 0; i < batch_size; ++i) {
-      std::vector<string> parts = Split(input_vec(i), delimiter);
-      int64 n_entries = parts.size();
-      num_indices[i] = n_entries;
-      output_size += n_entries;
-      max_num_entries = std::max(max_num_entries, n_entries);
-      tokens.insert(tokens.end(), parts.begin(), parts.end());
+      max_num_entries = std::max(max_num_entries, num_indices[i + 1]);
+      num_indices[i + 1] += num_indices[i];
+      num_bytes[i + 1] += num_bytes[i];
     }
+    const int64 output_size = num_indices[batch_size];
 
     Tensor* sp_indices_t;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({output_size, 2}),
                                              &sp_indices_t));
-    Tensor* sp_tokens_t;
-    OP_REQUIRES_OK(
-        ctx, ctx->allocate_output(1, TensorShape({output_size}), &sp_tokens_t));
     Tensor* sp_shape_t;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({2}), &sp_shape_t));
 
     auto sp_indices = sp_indices_t->matrix<int64>();
-    auto sp_tokens = sp_tokens_t->vec<string>();
     auto sp_shape = sp_shape_t->vec<int64>();
     sp_shape(0) = batch_size;
     sp_shape(1) = max_num_entries;
-    size_t c = 0;
-    for (size_t i = 0; i < batch_size; ++i) {
-      for (size_t j = 0; j < num_indices[i]; ++j) {
-        sp_indices(c, 0) = i;
-        sp_indices(c, 1) = j;
-        sp_tokens(c) = tokens[c];
-        ++c;
-      }
-    }
+    std::vector<int64> token_offsets(output_size + 1);
+    token_offsets[output_size] = num_bytes[batch_size];
+    string token_bytes(num_bytes[batch_size], '\0');
+    char* const token_base = &token_bytes[0];
+    Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
+          2 * cost_per_example,
+          [&input_vec, &delimiter, &num_indices, &num_bytes, &sp_indices,
+           &token_offsets, token_base](int64 start, int64 limit) {
+            for (int64 i = start; i < limit; ++i) {
+              int64 c = num_indices[i];
+              int64 offset = num_bytes[i];
+              int64 j = 0;
+              ForEachToken(input_vec(i), delimiter, [&](StringPiece token) {
+                sp_indices(c, 0) = i;
+                sp_indices(c, 1) = j++;
+                token_offsets[c++] = offset;
+                memcpy(token_base + offset, token.data(), token.size());
+                offset += token.size();
+              });
+            }
+          });
+    ctx->set_output(1, tensor::MakePackedStringTensor(
+                           TensorShape({output_size}), &token_offsets,
+                           &token_bytes));
   }
 };
 
@@ -20,6 +20,9 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -286,6 +289,65 @@ std::vector<mutex_lock> MaybeLockMutexesInOrder(
   return locks;
 }
 
+namespace {
+
+// Number of locks in the process-wide table used by sparse updates with
+// use_row_locking.
+constexpr int kNumRowLockStripes = 1024;
+
+// Returns the lock guarding row "row" of the variable whose ref input is
+// protected by "var_mu". Every sparse update of that variable that uses row
+// locking hashes to the same stripe for a row, so concurrent steps only wait
+// on each other when they touch rows in the same stripe.
+mutex* RowLock(const mutex* var_mu, int64 row) {
+  static mutex* stripes = new mutex[kNumRowLockStripes];
+  const uint64 h = Hash64Combine(reinterpret_cast<uintptr_t>(var_mu), row);
+  return &stripes[h % kNumRowLockStripes];
+}
+
+// Copies "indices" into "rows", checking that each one is a valid row of a
+// variable with "first_dim_size" rows.
+template <typename Tindex>
+Status CopyAndValidateIndices(const Tensor& indices, Tindex first_dim_size,
+                              std::vector<Tindex>* rows) {
+  auto indices_vec = indices.vec<Tindex>();
+  rows->resize(indices_vec.size());
+  for (int64 i = 0; i < indices_vec.size(); ++i) {
+    const Tindex index = internal::SubtleMustCopy(indices_vec(i));
+    if (!FastBoundsCheck(index, first_dim_size)) {
+      return errors::InvalidArgument(strings::StrCat(
+          "Index ", index, " at offset ", i, " in indices is out of range"));
+    }
+    (*rows)[i] = index;
+  }
+  return Status::OK();
+}
+
+// Calls "update(i, rows[i])" for every position i. With "use_row_locking" the
+// positions are sharded over the intra-op pool and each update holds its row
+// lock, so repeated rows are applied one at a time in an unspecified order.
+// Otherwise the updates run in order on the calling thread.
+template <typename Tindex, typename Update>
+void ApplyRowUpdates(OpKernelContext* ctx, bool use_row_locking,
+                     const std::vector<Tindex>& rows, int64 cost_per_row,
+                     Update update) {
+  if (!use_row_locking) {
+    for (int64 i = 0; i < rows.size(); ++i) update(i, rows[i]);
+    return;
+  }
+  const mutex* var_mu = ctx->input_ref_mutex(0);
+  auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers, rows.size(),
+        cost_per_row, [&](int64 start, int64 limit) {
+          for (int64 i = start; i < limit; ++i) {
+            mutex_lock l(*RowLock(var_mu, rows[i]));
+            update(i, rows[i]);
+          }
+        });
+}
+
+}  // namespace
+
 template <typename Device, typename T>
 class ApplyGradientDescentOp : public OpKernel {
  public:
@@ -1003,6 +1065,8 @@ class SparseApplyAdagradOp : public OpKernel {
  public:
   explicit SparseApplyAdagradOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_row_locking", &use_row_locking_));
+    if (use_row_locking_) use_exclusive_lock_ = false;
   }
 
   void Compute(OpKernelContext* ctx) override NO_THREAD_SAFETY_ANALYSIS {
@@ -1052,47 +1116,35 @@ class SparseApplyAdagradOp : public OpKernel {
                     "Inner dimension should be greater than zero."));
 
     if (N > 0) {
+      std::vector<Tindex> rows;
+      OP_REQUIRES_OK(ctx, CopyAndValidateIndices<Tindex>(
+                              indices, var.dim_size(0), &rows));
+      T lr_scalar = lr.scalar<T>()();
       if (inner_dim > 1) {
-        const Tindex first_dim_size = var.dim_size(0);
-        auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat_outer_dims<T>();
         auto accum_flat = accum.flat_outer_dims<T>();
         auto grad_flat = grad.flat_outer_dims<T>();
-        T lr_scalar = lr.scalar<T>()();
 
-        // Note(yonghui): It might be worth multi-threading square() and
-        // rsqrt().
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto update = [&](int64 i, Tindex index) {
           auto a = accum_flat.template chip<0>(index);
           auto g = grad_flat.template chip<0>(i);
           auto v = var_flat.template chip<0>(index);
           a += g.square();
           v -= g.constant(lr_scalar) * g * a.rsqrt();
-        }
+        };
+        ApplyRowUpdates(ctx, use_row_locking_, rows, 10 * inner_dim, update);
       } else {
-        auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
         auto accum_flat = accum.flat<T>();
         auto grad_flat = grad.flat<T>();
-        T lr_scalar = lr.scalar<T>()();
-        const Tindex first_dim_size = accum_flat.size();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto update = [&](int64 i, Tindex index) {
           T& a = accum_flat(index);
           const T& g = grad_flat(i);
           a += g * g;
           var_flat(index) -= lr_scalar * g / Eigen::numext::sqrt(a);
-        }
+        };
+        ApplyRowUpdates(ctx, use_row_locking_, rows, 10, update);
       }
     }
 
@@ -1101,6 +1153,7 @@ class SparseApplyAdagradOp : public OpKernel {
 
  private:
   bool use_exclusive_lock_;
+  bool use_row_locking_;
 };
 
 #define REGISTER_KERNELS(T, Tindices)                                \
@@ -1646,6 +1699,8 @@ class SparseApplyFtrlOp : public OpKernel {
  public:
   explicit SparseApplyFtrlOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_row_locking", &use_row_locking_));
+    if (use_row_locking_) use_exclusive_lock_ = false;
   }
 
   void Compute(OpKernelContext* ctx) override NO_THREAD_SAFETY_ANALYSIS {
@@ -1720,9 +1775,10 @@ class SparseApplyFtrlOp : public OpKernel {
                     "Inner dimension should be greater than zero."));
 
     if (N > 0) {
+      std::vector<Tindex> rows;
+      OP_REQUIRES_OK(ctx, CopyAndValidateIndices<Tindex>(
+                              indices, var.dim_size(0), &rows));
       if (inner_dim > 1) {
-        const Tindex first_dim_size = var.dim_size(0);
-        auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat_outer_dims<T>();
         auto accum_flat = accum.flat_outer_dims<T>();
         auto linear_flat = linear.flat_outer_dims<T>();
@@ -1732,12 +1788,7 @@ class SparseApplyFtrlOp : public OpKernel {
         T l2_scalar = l2.scalar<T>()();
         T lr_power_scalar = lr_power.scalar<T>()();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto update = [&](int64 i, Tindex index) {
           auto accum = accum_flat.template chip<0>(index);
           auto linear = linear_flat.template chip<0>(index);
           auto grad = grad_flat.template chip<0>(i);
@@ -1767,9 +1818,9 @@ class SparseApplyFtrlOp : public OpKernel {
           var = (linear.abs() > linear.constant(l1_scalar))
                     .select(var, var.constant(static_cast<T>(0)));
           accum += grad.square();
-        }
+        };
+        ApplyRowUpdates(ctx, use_row_locking_, rows, 40 * inner_dim, update);
       } else {
-        auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
         auto accum_flat = accum.flat<T>();
         auto linear_flat = linear.flat<T>();
@@ -1778,14 +1829,8 @@ class SparseApplyFtrlOp : public OpKernel {
         T l1_scalar = l1.scalar<T>()();
         T l2_scalar = l2.scalar<T>()();
         T lr_power_scalar = lr_power.scalar<T>()();
-        const Tindex first_dim_size = accum_flat.size();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto update = [&](int64 i, Tindex index) {
           T& a = accum_flat(index);
           T& l = linear_flat(index);
           T& v = var_flat(index);
@@ -1800,7 +1845,8 @@ class SparseApplyFtrlOp : public OpKernel {
                           lr_power_scalar);
           a = updated_a;
           l = updated_l;
-        }
+        };
+        ApplyRowUpdates(ctx, use_row_locking_, rows, 40, update);
       }
     }
 
@@ -1809,6 +1855,7 @@ class SparseApplyFtrlOp : public OpKernel {
 
  private:
   bool use_exclusive_lock_;
+  bool use_row_locking_;
 };
 
 #define REGISTER_KERNELS(T, Tindices)                                \
@@ -1925,6 +1972,8 @@ class SparseApplyMomentumOp : public OpKernel {
  public:
   explicit SparseApplyMomentumOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_row_locking", &use_row_locking_));
+    if (use_row_locking_) use_exclusive_lock_ = false;
     OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &use_nesterov_));
   }
 
@@ -1975,20 +2024,16 @@ class SparseApplyMomentumOp : public OpKernel {
                                         momentum.shape().DebugString()));
 
     if (N > 0) {
-      const Tindex first_dim_size = var.dim_size(0);
-      auto indices_vec = indices.vec<Tindex>();
+      std::vector<Tindex> rows;
+      OP_REQUIRES_OK(ctx, CopyAndValidateIndices<Tindex>(
+                              indices, var.dim_size(0), &rows));
       auto var_flat = var.flat_outer_dims<T>();
       auto accum_flat = accum.flat_outer_dims<T>();
       auto grad_flat = grad.flat_outer_dims<T>();
       T lr_scalar = lr.scalar<T>()();
       T momentum_scalar = momentum.scalar<T>()();
 
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-        OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                    errors::InvalidArgument(
-                        strings::StrCat("Index ", index, " at offset ", i,
-                                        " in indices is out of range")));
+      auto update = [&](int64 i, Tindex index) {
         auto a = accum_flat.template chip<0>(index);
         auto g = grad_flat.template chip<0>(i);
         auto v = var_flat.template chip<0>(index);
@@ -1999,7 +2044,9 @@ class SparseApplyMomentumOp : public OpKernel {
         } else {
           v -= a.constant(lr_scalar) * a;
         }
-      }
+      };
+      ApplyRowUpdates(ctx, use_row_locking_, rows, 6 * var_flat.dimension(1),
+                      update);
     }
 
     ctx->forward_ref_input_to_ref_output(0, 0);
@@ -2007,6 +2054,7 @@ class SparseApplyMomentumOp : public OpKernel {
 
  private:
   bool use_exclusive_lock_;
+  bool use_row_locking_;
   bool use_nesterov_;
 };
 
@@ -17,9 +17,21 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/transpose_functor.h"
 
+#include <string.h>
+#include <algorithm>
+#include <numeric>
+
+#ifdef __SSE2__
+#include <xmmintrin.h>
+#endif
+
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+
 namespace tensorflow {
 namespace internal {
 
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
 template <typename Device, typename T>
 void TransposeSimple(const Device& d, const Tensor& in,
                      const gtl::ArraySlice<int32> perm, Tensor* out) {
@@ -59,6 +71,274 @@ void TransposeUsingEigen(const Device& d, const Tensor& in,
   y.device(d) = x.shuffle(p);
 }
 
+namespace {
+
+// Rewrites a transpose of "shape" by "perm" as an equivalent transpose of the
+// smallest rank: dimensions of size one are dropped, and input dimensions that
+// stay adjacent and in order in the output are merged. E.g. NHWC -> NCHW
+// becomes [N, H*W, C] -> [N, C, H*W].
+void ReduceTransposeDimensions(const TensorShape& shape,
+                               gtl::ArraySlice<int32> perm,
+                               gtl::InlinedVector<int64, 8>* new_sizes,
+                               gtl::InlinedVector<int32, 8>* new_perm) {
+  const int ndims = shape.dims();
+  // Drop the dimensions of size one, which don't affect the memory order.
+  gtl::InlinedVector<int32, 8> compact_index(ndims, -1);
+  gtl::InlinedVector<int64, 8> sizes;
+  for (int i = 0; i < ndims; ++i) {
+    if (shape.dim_size(i) != 1) {
+      compact_index[i] = sizes.size();
+      sizes.push_back(shape.dim_size(i));
+    }
+  }
+  gtl::InlinedVector<int32, 8> compact_perm;
+  for (int i = 0; i < ndims; ++i) {
+    if (compact_index[perm[i]] >= 0) {
+      compact_perm.push_back(compact_index[perm[i]]);
+    }
+  }
+  // Consecutive output dimensions that come from consecutive input dimensions
+  // form one group, which can be treated as a single dimension.
+  gtl::InlinedVector<int32, 8> group_start;
+  gtl::InlinedVector<int64, 8> group_size;
+  for (int i = 0; i < compact_perm.size(); ++i) {
+    const int32 d = compact_perm[i];
+    if (i > 0 && d == compact_perm[i - 1] + 1) {
+      group_size.back() *= sizes[d];
+    } else {
+      group_start.push_back(d);
+      group_size.push_back(sizes[d]);
+    }
+  }
+  // Order the groups as they appear in the input.
+  const int num_groups = group_start.size();
+  gtl::InlinedVector<int32, 8> input_order(num_groups);
+  std::iota(input_order.begin(), input_order.end(), 0);
+  std::sort(input_order.begin(), input_order.end(),
+            [&group_start](int32 a, int32 b) {
+              return group_start[a] < group_start[b];
+            });
+  new_sizes->resize(num_groups);
+  new_perm->resize(num_groups);
+  for (int i = 0; i < num_groups; ++i) {
+    (*new_sizes)[i] = group_size[input_order[i]];
+    (*new_perm)[input_order[i]] = i;
+  }
+}
+
+// Side of the square tiles the 2D transposes are blocked into, chosen so that
+// a source and a destination tile fit in L1 together.
+template <typename T>
+constexpr int64 TileSize() {
+  return std::max<int64>(8, std::min<int64>(64, 128 / sizeof(T)));
+}
+
+// Writes the transpose of the "rows" x "cols" matrix at "src" to "dst". Rows of
+// "src" are "src_stride" elements apart and rows of "dst" are "dst_stride"
+// elements apart.
+template <typename T>
+void TransposeBlock(const T* src, int64 src_stride, int64 rows, int64 cols,
+                    T* dst, int64 dst_stride) {
+  for (int64 c = 0; c < cols; ++c) {
+    for (int64 r = 0; r < rows; ++r) {
+      dst[c * dst_stride + r] = src[r * src_stride + c];
+    }
+  }
+}
+
+#ifdef __SSE2__
+// Transposes 4x4 micro-tiles of 32-bit values in SSE registers. The values are
+// only moved around, so reinterpreting them as floats doesn't change them.
+template <>
+void TransposeBlock<uint32>(const uint32* src, int64 src_stride, int64 rows,
+                            int64 cols, uint32* dst, int64 dst_stride) {
+  int64 r = 0;
+  for (; r + 4 <= rows; r += 4) {
+    const float* s = reinterpret_cast<const float*>(src + r * src_stride);
+    float* d = reinterpret_cast<float*>(dst + r);
+    int64 c = 0;
+    for (; c + 4 <= cols; c += 4) {
+      __m128 row0 = _mm_loadu_ps(s + c);
+      __m128 row1 = _mm_loadu_ps(s + src_stride + c);
+      __m128 row2 = _mm_loadu_ps(s + 2 * src_stride + c);
+      __m128 row3 = _mm_loadu_ps(s + 3 * src_stride + c);
+      _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+      _mm_storeu_ps(d + c * dst_stride, row0);
+      _mm_storeu_ps(d + (c + 1) * dst_stride, row1);
+      _mm_storeu_ps(d + (c + 2) * dst_stride, row2);
+      _mm_storeu_ps(d + (c + 3) * dst_stride, row3);
+    }
+    if (c < cols) {
+      TransposeBlock<float>(s + c, src_stride, 4, cols - c, d + c * dst_stride,
+                            dst_stride);
+    }
+  }
+  if (r < rows) {
+    TransposeBlock<float>(reinterpret_cast<const float*>(src + r * src_stride),
+                          src_stride, rows - r, cols,
+                          reinterpret_cast<float*>(dst + r), dst_stride);
+  }
+}
+#endif  // __SSE2__
+
+// Iterates over the multi-dimensional index "index" of a tensor with sizes
+// "sizes", maintaining its offsets in two differently strided layouts.
+class DualIndexIterator {
+ public:
+  DualIndexIterator(gtl::ArraySlice<int64> sizes,
+                    gtl::ArraySlice<int64> strides_a,
+                    gtl::ArraySlice<int64> strides_b, int64 linear_index)
+      : sizes_(sizes),
+        strides_a_(strides_a),
+        strides_b_(strides_b),
+        index_(sizes.size()) {
+    for (int i = sizes_.size() - 1; i >= 0; --i) {
+      index_[i] = linear_index % sizes_[i];
+      linear_index /= sizes_[i];
+      offset_a_ += index_[i] * strides_a_[i];
+      offset_b_ += index_[i] * strides_b_[i];
+    }
+  }
+
+  int64 offset_a() const { return offset_a_; }
+  int64 offset_b() const { return offset_b_; }
+
+  void Next() {
+    for (int i = sizes_.size() - 1; i >= 0; --i) {
+      offset_a_ += strides_a_[i];
+      offset_b_ += strides_b_[i];
+      if (++index_[i] < sizes_[i]) return;
+      offset_a_ -= index_[i] * strides_a_[i];
+      offset_b_ -= index_[i] * strides_b_[i];
+      index_[i] = 0;
+    }
+  }
+
+ private:
+  const gtl::ArraySlice<int64> sizes_;
+  const gtl::ArraySlice<int64> strides_a_;
+  const gtl::ArraySlice<int64> strides_b_;
+  gtl::InlinedVector<int64, 8> index_;
+  int64 offset_a_ = 0;
+  int64 offset_b_ = 0;
+};
+
+// Transposes "in", with dimensions "sizes", into "out" by "perm". Expects the
+// dimensions to have been reduced by ReduceTransposeDimensions().
+template <typename T>
+void TransposeTiled(const CPUDevice& d, const T* in,
+                    gtl::ArraySlice<int64> sizes, gtl::ArraySlice<int32> perm,
+                    T* out) {
+  const int rank = sizes.size();
+  const int64 total =
+      std::accumulate(sizes.begin(), sizes.end(), int64{1},
+                      [](int64 a, int64 b) { return a * b; });
+  if (total == 0) return;
+  if (rank <= 1) {
+    memcpy(out, in, total * sizeof(T));
+    return;
+  }
+  gtl::InlinedVector<int64, 8> in_strides(rank);
+  gtl::InlinedVector<int64, 8> out_sizes(rank);
+  gtl::InlinedVector<int64, 8> out_strides(rank);
+  int64 stride = 1;
+  for (int i = rank - 1; i >= 0; --i) {
+    in_strides[i] = stride;
+    stride *= sizes[i];
+  }
+  stride = 1;
+  for (int i = rank - 1; i >= 0; --i) {
+    out_sizes[i] = sizes[perm[i]];
+    out_strides[i] = stride;
+    stride *= out_sizes[i];
+  }
+
+  if (perm[rank - 1] == rank - 1) {
+    // The innermost dimension stays in place, so the output is assembled from
+    // contiguous runs of the input.
+    const int64 run = sizes[rank - 1];
+    gtl::InlinedVector<int64, 8> outer_sizes(out_sizes.begin(),
+                                             out_sizes.end() - 1);
+    gtl::InlinedVector<int64, 8> outer_in_strides(rank - 1);
+    gtl::InlinedVector<int64, 8> outer_out_strides(rank - 1);
+    for (int i = 0; i < rank - 1; ++i) {
+      outer_in_strides[i] = in_strides[perm[i]];
+      outer_out_strides[i] = out_strides[i];
+    }
+    auto copy_runs = [&](Eigen::Index first, Eigen::Index last) {
+      DualIndexIterator it(outer_sizes, outer_in_strides, outer_out_strides,
+                           first);
+      for (Eigen::Index i = first; i < last; ++i, it.Next()) {
+        memcpy(out + it.offset_b(), in + it.offset_a(), run * sizeof(T));
+      }
+    };
+    const double run_bytes = run * sizeof(T);
+    d.parallelFor(total / run, Eigen::TensorOpCost(run_bytes, run_bytes, 0),
+                  copy_runs);
+    return;
+  }
+
+  // Otherwise each pair of (input innermost, output innermost) dimensions is a
+  // 2D transpose, which is done in tiles. "src_dim" is the input dimension
+  // that becomes innermost in the output, and "dst_dim" is the output
+  // dimension that the innermost input dimension moves to.
+  const int src_dim = perm[rank - 1];
+  const int dst_dim = std::find(perm.begin(), perm.end(), rank - 1) -
+                      perm.begin();
+  const int64 rows = sizes[src_dim];
+  const int64 cols = sizes[rank - 1];
+  const int64 src_stride = in_strides[src_dim];
+  const int64 dst_stride = out_strides[dst_dim];
+  gtl::InlinedVector<int64, 8> outer_sizes;
+  gtl::InlinedVector<int64, 8> outer_in_strides;
+  gtl::InlinedVector<int64, 8> outer_out_strides;
+  for (int i = 0; i < rank - 1; ++i) {
+    if (i == dst_dim) continue;
+    outer_sizes.push_back(out_sizes[i]);
+    outer_in_strides.push_back(in_strides[perm[i]]);
+    outer_out_strides.push_back(out_strides[i]);
+  }
+  const int64 outer_count = total / (rows * cols);
+
+  // Each unit of work transposes a strip of one tile's width of columns.
+  const int64 tile = TileSize<T>();
+  const int64 strips = (cols + tile - 1) / tile;
+  auto transpose_strips = [&](Eigen::Index first, Eigen::Index last) {
+    for (Eigen::Index unit = first; unit < last; ++unit) {
+      const int64 outer = unit / strips;
+      const int64 col_start = (unit % strips) * tile;
+      const int64 strip_cols = std::min(tile, cols - col_start);
+      DualIndexIterator it(outer_sizes, outer_in_strides, outer_out_strides,
+                           outer);
+      const T* src = in + it.offset_a() + col_start;
+      T* dst = out + it.offset_b() + col_start * dst_stride;
+      for (int64 row_start = 0; row_start < rows; row_start += tile) {
+        TransposeBlock<T>(src + row_start * src_stride, src_stride,
+                          std::min(tile, rows - row_start), strip_cols,
+                          dst + row_start, dst_stride);
+      }
+    }
+  };
+  const double strip_bytes = tile * rows * sizeof(T);
+  d.parallelFor(outer_count * strips,
+                Eigen::TensorOpCost(strip_bytes, strip_bytes, tile * rows),
+                transpose_strips);
+}
+
+}  // namespace
+
+template <typename T>
+void TransposeCpu(const CPUDevice& d, const Tensor& in,
+                  const gtl::ArraySlice<int32> perm, Tensor* out) {
+  gtl::InlinedVector<int64, 8> sizes;
+  gtl::InlinedVector<int32, 8> reduced_perm;
+  ReduceTransposeDimensions(in.shape(), perm, &sizes, &reduced_perm);
+  TransposeTiled<T>(
+      d, reinterpret_cast<const T*>(in.tensor_data().data()), sizes,
+      reduced_perm,
+      reinterpret_cast<T*>(const_cast<char*>(out->tensor_data().data())));
+}
+
 }  // end namespace internal
 
 typedef Eigen::ThreadPoolDevice Device;
@@ -76,7 +356,7 @@ Status DoTranspose<Device>(const Device& d, const Tensor& in,
     case DT_QINT8:
     case DT_QUINT8:
     case DT_UINT8:
-      internal::Transpose<Device, uint8>(d, in, perm, out);
+      internal::TransposeCpu<uint8>(d, in, perm, out);
       break;
 
     case DT_BFLOAT16:
@@ -85,23 +365,23 @@ Status DoTranspose<Device>(const Device& d, const Tensor& in,
     case DT_QINT16:
     case DT_QUINT16:
     case DT_UINT16:
-      internal::Transpose<Device, uint16>(d, in, perm, out);
+      internal::TransposeCpu<uint16>(d, in, perm, out);
       break;
 
     case DT_FLOAT:
     case DT_INT32:
     case DT_QINT32:
-      internal::Transpose<Device, uint32>(d, in, perm, out);
+      internal::TransposeCpu<uint32>(d, in, perm, out);
       break;
 
     case DT_COMPLEX64:
     case DT_DOUBLE:
     case DT_INT64:
-      internal::Transpose<Device, uint64>(d, in, perm, out);
+      internal::TransposeCpu<uint64>(d, in, perm, out);
       break;
 
     case DT_COMPLEX128:
-      internal::Transpose<Device, complex128>(d, in, perm, out);
+      internal::TransposeCpu<complex128>(d, in, perm, out);
       break;
 
     case DT_STRING:
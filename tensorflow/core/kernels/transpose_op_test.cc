@@ -0,0 +1,167 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class TransposeOpTest : public OpsTestBase {
+ protected:
+  template <typename T>
+  void RunAndCheck(const TensorShape& shape, const std::vector<int32>& perm) {
+    TF_ASSERT_OK(NodeDefBuilder("myop", "Transpose")
+                     .Input(FakeInput(DataTypeToEnum<T>::value))
+                     .Input(FakeInput(DT_INT32))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+
+    auto value = [](int i) { return static_cast<T>(i % 251); };
+    AddInput<T>(shape, value);
+    AddInputFromArray<int32>(TensorShape({static_cast<int64>(perm.size())}),
+                             perm);
+    TF_ASSERT_OK(RunOpKernel());
+
+    // Compare against a straightforward element-by-element transpose.
+    const int ndims = shape.dims();
+    TensorShape out_shape;
+    for (int i = 0; i < ndims; ++i) out_shape.AddDim(shape.dim_size(perm[i]));
+    std::vector<int64> in_strides(ndims), out_strides(ndims);
+    int64 in_stride = 1, out_stride = 1;
+    for (int i = ndims - 1; i >= 0; --i) {
+      in_strides[i] = in_stride;
+      in_stride *= shape.dim_size(i);
+      out_strides[i] = out_stride;
+      out_stride *= out_shape.dim_size(i);
+    }
+    Tensor expected(DataTypeToEnum<T>::value, out_shape);
+    auto expected_flat = expected.flat<T>();
+    for (int64 o = 0; o < expected_flat.size(); ++o) {
+      int64 i = 0;
+      int64 t = o;
+      for (int d = 0; d < ndims; ++d) {
+        i += (t / out_strides[d]) * in_strides[perm[d]];
+        t %= out_strides[d];
+      }
+      expected_flat(o) = value(i);
+    }
+    test::ExpectTensorEqual<T>(expected, *GetOutput(0));
+  }
+};
+
+TEST_F(TransposeOpTest, Matrix) {
+  RunAndCheck<float>(TensorShape({37, 53}), {1, 0});
+}
+
+TEST_F(TransposeOpTest, MatrixUint8) {
+  RunAndCheck<uint8>(TensorShape({130, 67}), {1, 0});
+}
+
+TEST_F(TransposeOpTest, MatrixInt16) {
+  RunAndCheck<int16>(TensorShape({67, 130}), {1, 0});
+}
+
+TEST_F(TransposeOpTest, MatrixDouble) {
+  RunAndCheck<double>(TensorShape({33, 17}), {1, 0});
+}
+
+TEST_F(TransposeOpTest, NHWCToNCHW) {
+  RunAndCheck<float>(TensorShape({2, 7, 9, 5}), {0, 3, 1, 2});
+}
+
+TEST_F(TransposeOpTest, NCHWToNHWC) {
+  RunAndCheck<float>(TensorShape({2, 5, 7, 9}), {0, 2, 3, 1});
+}
+
+TEST_F(TransposeOpTest, InnermostDimPreserved) {
+  RunAndCheck<float>(TensorShape({3, 4, 5, 6}), {2, 0, 1, 3});
+}
+
+TEST_F(TransposeOpTest, SizeOneDims) {
+  RunAndCheck<float>(TensorShape({1, 6, 1, 7}), {3, 2, 0, 1});
+}
+
+TEST_F(TransposeOpTest, HighRank) {
+  RunAndCheck<int64>(TensorShape({2, 3, 4, 3, 2, 5}), {5, 3, 1, 0, 4, 2});
+}
+
+TEST_F(TransposeOpTest, Empty) {
+  RunAndCheck<float>(TensorShape({0, 4, 3}), {2, 0, 1});
+}
+
+template <typename T>
+static Graph* Transpose(const TensorShape& shape,
+                        const std::vector<int32>& perm) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor input(DataTypeToEnum<T>::value, shape);
+  input.flat<T>().setZero();
+  Tensor perm_tensor(DT_INT32, TensorShape({static_cast<int64>(perm.size())}));
+  for (int i = 0; i < perm.size(); ++i) perm_tensor.flat<int32>()(i) = perm[i];
+  test::graph::Binary(g, "Transpose", test::graph::Constant(g, input),
+                      test::graph::Constant(g, perm_tensor));
+  return g;
+}
+
+template <typename T>
+static void BM_Transpose(int iters, const TensorShape& shape,
+                         const std::vector<int32>& perm) {
+  const int64 tot = static_cast<int64>(iters) * shape.num_elements();
+  testing::ItemsProcessed(tot);
+  testing::BytesProcessed(tot * sizeof(T));
+  testing::UseRealTime();
+  test::Benchmark("cpu", Transpose<T>(shape, perm)).Run(iters);
+}
+
+#define BM_TRANSPOSE_2D(T)                                   \
+  static void BM_cpu_transpose_2d_##T(int iters, int dim) {  \
+    BM_Transpose<T>(iters, TensorShape({dim, dim}), {1, 0}); \
+  }                                                          \
+  BENCHMARK(BM_cpu_transpose_2d_##T)->Arg(64)->Arg(512)->Arg(2048)
+
+BM_TRANSPOSE_2D(uint8);
+BM_TRANSPOSE_2D(int16);
+BM_TRANSPOSE_2D(float);
+BM_TRANSPOSE_2D(double);
+BM_TRANSPOSE_2D(complex128);
+
+// Image layout conversions; "dim" is the spatial size of a batch of 32
+// images with 64 channels.
+#define BM_TRANSPOSE_LAYOUT(T, NAME, D0, D1, D2, D3, P0, P1, P2, P3) \
+  static void BM_cpu_transpose_##NAME##_##T(int iters, int dim) {    \
+    BM_Transpose<T>(iters, TensorShape({D0, D1, D2, D3}),            \
+                    {P0, P1, P2, P3});                               \
+  }                                                                  \
+  BENCHMARK(BM_cpu_transpose_##NAME##_##T)->Arg(8)->Arg(32)->Arg(64)
+
+BM_TRANSPOSE_LAYOUT(float, nhwc_to_nchw, 32, dim, dim, 64, 0, 3, 1, 2);
+BM_TRANSPOSE_LAYOUT(float, nchw_to_nhwc, 32, 64, dim, dim, 0, 2, 3, 1);
+BM_TRANSPOSE_LAYOUT(uint8, nhwc_to_nchw, 32, dim, dim, 64, 0, 3, 1, 2);
+BM_TRANSPOSE_LAYOUT(float, swap_outer, dim, dim, 32, 64, 1, 0, 2, 3);
+BM_TRANSPOSE_LAYOUT(float, reverse, 32, dim, dim, 64, 3, 2, 1, 0);
+
+}  // namespace
+}  // namespace tensorflow
@@ -93,6 +93,23 @@ class UnpackOp : public OpKernel {
     }
     const int64 axis_dim = input_shape.dim_size(axis);
 
+    if (std::is_same<Device, CPUDevice>::value && output_size > 0) {
+      // If all dimensions before axis have size 1, each output is a
+      // contiguous run of the input and can share its buffer, as in the
+      // axis == 0 case.
+      const TensorShape rows({axis_dim, after_dim});
+      if (before_dim == 1 && IsInnerDimsSizeAligned<T>(rows)) {
+        Tensor input_rows;
+        CHECK(input_rows.CopyFrom(input, rows));
+        for (int i = 0; i < num; ++i) {
+          Tensor output;
+          CHECK(output.CopyFrom(input_rows.Slice(i, i + 1), output_shape));
+          context->set_output(i, output);
+        }
+        return;
+      }
+    }
+
     // Except for shape, unpack is a special case of split, so we reuse the
     // same computational kernels.
     auto input_reshaped =
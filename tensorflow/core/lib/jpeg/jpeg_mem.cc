@@ -159,8 +159,42 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
     return nullptr;
   }
 
+  // Work out which part of the decoded image goes to the output.
+  int crop_x = 0;
+  int crop_y = 0;
+  int out_width = cinfo.output_width;
+  int out_height = cinfo.output_height;
+  if (flags.crop) {
+    if (flags.crop_x < 0 || flags.crop_y < 0 || flags.crop_width <= 0 ||
+        flags.crop_height <= 0 ||
+        static_cast<int64>(flags.crop_x) + flags.crop_width >
+            cinfo.image_width ||
+        static_cast<int64>(flags.crop_y) + flags.crop_height >
+            cinfo.image_height) {
+      LOG(ERROR) << "Crop window " << flags.crop_width << " x "
+                 << flags.crop_height << " at (" << flags.crop_x << ", "
+                 << flags.crop_y << ") does not fit in image "
+                 << cinfo.image_width << " x " << cinfo.image_height;
+      jpeg_destroy_decompress(&cinfo);
+      return nullptr;
+    }
+    // Round the window outwards to whole pixels of the scaled image.
+    crop_x = flags.crop_x / ratio;
+    crop_y = flags.crop_y / ratio;
+    out_width = std::min<int64>(
+                    cinfo.output_width,
+                    (static_cast<int64>(flags.crop_x) + flags.crop_width +
+                     ratio - 1) / ratio) -
+                crop_x;
+    out_height = std::min<int64>(
+                     cinfo.output_height,
+                     (static_cast<int64>(flags.crop_y) + flags.crop_height +
+                      ratio - 1) / ratio) -
+                 crop_y;
+  }
+
   // check for compatible stride
-  const int min_stride = cinfo.output_width * components * sizeof(JSAMPLE);
+  const int min_stride = out_width * components * sizeof(JSAMPLE);
   if (stride == 0) {
     stride = min_stride;
   } else if (stride < min_stride) {
@@ -170,62 +204,44 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
   }
 
   // Remember stride and height for use in Uncompress
-  argball->height_ = cinfo.output_height;
+  argball->height_ = out_height;
   argball->stride_ = stride;
 
-  uint8* const dstdata = argball->allocate_output_(
-      cinfo.output_width, cinfo.output_height, components);
+  uint8* const dstdata =
+      argball->allocate_output_(out_width, out_height, components);
   if (dstdata == nullptr) {
     jpeg_destroy_decompress(&cinfo);
     return nullptr;
   }
   JSAMPLE* output_line = static_cast<JSAMPLE*>(dstdata);
 
-  // Temporary buffer used for CMYK -> RGB conversion.
+  // Temporary buffer used for CMYK -> RGB conversion, and to hold whole
+  // scanlines when only part of each one is kept.
   const bool use_cmyk = (cinfo.out_color_space == JCS_CMYK);
-  tempdata = use_cmyk ? new JSAMPLE[cinfo.output_width * 4] : NULL;
+  if (use_cmyk || flags.crop) {
+    tempdata = new JSAMPLE[cinfo.output_width * (use_cmyk ? 4 : components)];
+  }
 
   // If there is an error reading a line, this aborts the reading.
   // Save the fraction of the image that has been read.
-  argball->height_read_ = cinfo.output_height;
-  while (cinfo.output_scanline < cinfo.output_height) {
-    int num_lines_read = 0;
-    if (cinfo.out_color_space == JCS_CMYK) {
-      num_lines_read = jpeg_read_scanlines(&cinfo, &tempdata, 1);
-      // Convert CMYK to RGB
-      for (size_t i = 0; i < cinfo.output_width; ++i) {
-        int c = tempdata[4 * i + 0];
-        int m = tempdata[4 * i + 1];
-        int y = tempdata[4 * i + 2];
-        int k = tempdata[4 * i + 3];
-        int r, g, b;
-        if (cinfo.saw_Adobe_marker) {
-          r = (k * c) / 255;
-          g = (k * m) / 255;
-          b = (k * y) / 255;
-        } else {
-          r = (255 - k) * (255 - c) / 255;
-          g = (255 - k) * (255 - m) / 255;
-          b = (255 - k) * (255 - y) / 255;
-        }
-        output_line[3 * i + 0] = r;
-        output_line[3 * i + 1] = g;
-        output_line[3 * i + 2] = b;
-      }
-    } else {
-      num_lines_read = jpeg_read_scanlines(&cinfo, &output_line, 1);
-    }
+  argball->height_read_ = out_height;
+  const JDIMENSION end_line = crop_y + out_height;
+  while (cinfo.output_scanline < end_line) {
+    const bool in_window = cinfo.output_scanline >= crop_y;
+    JSAMPLE* line = tempdata != nullptr ? tempdata : output_line;
+    const int num_lines_read = jpeg_read_scanlines(&cinfo, &line, 1);
     // Handle error cases
     if (num_lines_read == 0) {
       LOG(ERROR) << "Premature end of JPEG data. Stopped at line "
                  << cinfo.output_scanline << "/" << cinfo.output_height;
+      const int lines_written =
+          std::max(0, static_cast<int>(cinfo.output_scanline) - crop_y);
       if (!flags.try_recover_truncated_jpeg) {
-        argball->height_read_ = cinfo.output_scanline;
+        argball->height_read_ = lines_written;
         error = JPEGERRORS_UNEXPECTED_END_OF_DATA;
       } else {
-        for (size_t line = cinfo.output_scanline; line < cinfo.output_height;
-             ++line) {
-          if (line == 0) {
+        for (int row = lines_written; row < out_height; ++row) {
+          if (row == 0) {
             // If even the first line is missing, fill with black color
             memset(output_line, 0, min_stride);
           } else {
@@ -234,37 +250,67 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
           }
           output_line += stride;
         }
-        argball->height_read_ =
-            cinfo.output_height;  // consider all lines as read
+        argball->height_read_ = out_height;  // consider all lines as read
         // prevent error-on-exit in libjpeg:
         cinfo.output_scanline = cinfo.output_height;
       }
       break;
     }
     DCHECK_EQ(num_lines_read, 1);
+    // Lines above the crop window are decoded only to get past them.
+    if (!in_window) continue;
+    if (use_cmyk) {
+      // Convert CMYK to RGB
+      const JSAMPLE* cmyk_pixel = tempdata + 4 * crop_x;
+      for (int i = 0; i < out_width; ++i, cmyk_pixel += 4) {
+        int c = cmyk_pixel[0];
+        int m = cmyk_pixel[1];
+        int y = cmyk_pixel[2];
+        int k = cmyk_pixel[3];
+        int r, g, b;
+        if (cinfo.saw_Adobe_marker) {
+          r = (k * c) / 255;
+          g = (k * m) / 255;
+          b = (k * y) / 255;
+        } else {
+          r = (255 - k) * (255 - c) / 255;
+          g = (255 - k) * (255 - m) / 255;
+          b = (255 - k) * (255 - y) / 255;
+        }
+        output_line[3 * i + 0] = r;
+        output_line[3 * i + 1] = g;
+        output_line[3 * i + 2] = b;
+      }
+    } else if (tempdata != nullptr) {
+      memcpy(output_line, tempdata + crop_x * components, min_stride);
+    }
     TF_ANNOTATE_MEMORY_IS_INITIALIZED(output_line, min_stride);
     output_line += stride;
   }
   delete[] tempdata;
   tempdata = NULL;
 
+  // Scanlines below the crop window are never read, so the decompression
+  // has to be aborted rather than finished.
+  const bool stopped_early = cinfo.output_scanline < cinfo.output_height;
+
   // Convert the RGB data to RGBA, with alpha set to 0xFF to indicate
   // opacity.
   // RGBRGBRGB... --> RGBARGBARGBA...
   if (components == 4) {
     // Start on the last line.
     JSAMPLE* scanlineptr = static_cast<JSAMPLE*>(
-        dstdata + static_cast<int64>(cinfo.output_height - 1) * stride);
+        dstdata + static_cast<int64>(out_height - 1) * stride);
     const JSAMPLE kOpaque = -1;  // All ones appropriate for JSAMPLE.
-    const int right_rgb = (cinfo.output_width - 1) * 3;
-    const int right_rgba = (cinfo.output_width - 1) * 4;
+    const int right_rgb = (out_width - 1) * 3;
+    const int right_rgba = (out_width - 1) * 4;
 
-    for (int y = cinfo.output_height; y-- > 0;) {
+    for (int y = out_height; y-- > 0;) {
       // We do all the transformations in place, going backwards for each row.
       const JSAMPLE* rgb_pixel = scanlineptr + right_rgb;
       JSAMPLE* rgba_pixel = scanlineptr + right_rgba;
       scanlineptr -= stride;
-      for (int x = cinfo.output_width; x-- > 0;
+      for (int x = out_width; x-- > 0;
            rgba_pixel -= 4, rgb_pixel -= 3) {
         // We copy the 3 bytes at rgb_pixel into the 4 bytes at rgba_pixel
         // The "a" channel is set to be opaque.
@@ -309,7 +355,11 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
   // Handle errors in JPEG
   switch (error) {
     case JPEGERRORS_OK:
-      jpeg_finish_decompress(&cinfo);
+      if (stopped_early) {
+        jpeg_abort(reinterpret_cast<j_common_ptr>(&cinfo));
+      } else {
+        jpeg_finish_decompress(&cinfo);
+      }
       break;
     case JPEGERRORS_UNEXPECTED_END_OF_DATA:
     case JPEGERRORS_BAD_PARAM:
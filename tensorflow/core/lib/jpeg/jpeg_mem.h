@@ -54,6 +54,17 @@ struct UncompressFlags {
   // equal to width*components*sizeof(JSAMPLE).  If 0 is passed, the stride
   // used will be this minimal value.
   int stride = 0;
+
+  // If true, only the window of crop_height x crop_width pixels whose top
+  // left corner is at (crop_y, crop_x) is written to the output.  The window
+  // is given in pixels of the full-size image and is scaled down along with
+  // it when ratio > 1.  Scanlines below the window are not decoded at all,
+  // and the output is sized to the (scaled) window.
+  bool crop = false;
+  int crop_x = 0;
+  int crop_y = 0;
+  int crop_width = 0;
+  int crop_height = 0;
 };
 
 // Uncompress some raw JPEG data given by the pointer srcdata and the length
@@ -262,6 +262,55 @@ TEST(JpegMemTest, ChromaDownsampling) {
   }
 }
 
+TEST(JpegMemTest, Crop) {
+  const string jpegfile = string(kTestData) + "jpeg_merge_test1.jpg";
+  string jpeg;
+  ReadFileToStringOrDie(Env::Default(), jpegfile, &jpeg);
+
+  // A window of 100 x 60 pixels at (x, y) = (10, 20) of the 128 x 256 image.
+  for (const int ratio : {1, 2, 4}) {
+    UncompressFlags flags;
+    flags.components = 3;
+    flags.ratio = ratio;
+    int w, h, c;
+    std::unique_ptr<uint8[]> full(
+        Uncompress(jpeg.c_str(), jpeg.size(), flags, &w, &h, &c, NULL));
+    CHECK(full.get() != NULL);
+
+    flags.crop = true;
+    flags.crop_x = 10;
+    flags.crop_y = 20;
+    flags.crop_width = 100;
+    flags.crop_height = 60;
+    int crop_w, crop_h, crop_c;
+    std::unique_ptr<uint8[]> cropped(Uncompress(
+        jpeg.c_str(), jpeg.size(), flags, &crop_w, &crop_h, &crop_c, NULL));
+    CHECK(cropped.get() != NULL);
+    CHECK_EQ(crop_c, 3);
+    // The window is rounded outwards to whole pixels of the scaled image.
+    const int x0 = 10 / ratio;
+    const int y0 = 20 / ratio;
+    CHECK_EQ(crop_w, (110 + ratio - 1) / ratio - x0);
+    CHECK_EQ(crop_h, (80 + ratio - 1) / ratio - y0);
+    CHECK_EQ(0, ComputeSumAbsoluteDifference(
+                    cropped.get(), full.get() + 3 * (y0 * w + x0), crop_w,
+                    crop_h, 3 * crop_w, 3 * w));
+  }
+
+  // Windows that do not fit in the image are rejected.
+  UncompressFlags flags;
+  flags.components = 3;
+  flags.crop = true;
+  flags.crop_x = 100;
+  flags.crop_y = 0;
+  flags.crop_width = 29;
+  flags.crop_height = 10;
+  int w, h, c;
+  std::unique_ptr<uint8[]> imgdata(
+      Uncompress(jpeg.c_str(), jpeg.size(), flags, &w, &h, &c, NULL));
+  CHECK(imgdata.get() == NULL);
+}
+
 void TestBadJPEG(Env* env, const string& bad_jpeg_file, int expected_width,
                  int expected_height, const string& reference_RGB_file,
                  const bool try_recover_truncated_jpeg) {
@@ -97,6 +97,13 @@ class Counter {
   template <typename... Labels>
   CounterCell* GetCell(const Labels&... labels) LOCKS_EXCLUDED(mu_);
 
+  // Removes the cell for the specified labels, if present, so that it is no
+  // longer collected.  Useful for labels that name short-lived objects.
+  //
+  // REQUIRES: No pointer to the cell is used afterwards.
+  template <typename... Labels>
+  void RemoveCell(const Labels&... labels) LOCKS_EXCLUDED(mu_);
+
  private:
   explicit Counter(
       const MetricDef<MetricKind::kCumulative, int64, NumLabels>& metric_def)
@@ -168,6 +175,19 @@ CounterCell* Counter<NumLabels>::GetCell(const Labels&... labels)
                .first->second);
 }
 
+template <int NumLabels>
+template <typename... Labels>
+void Counter<NumLabels>::RemoveCell(const Labels&... labels)
+    LOCKS_EXCLUDED(mu_) {
+  static_assert(sizeof...(Labels) == NumLabels,
+                "Mismatch between Counter<NumLabels> and number of labels "
+                "provided in RemoveCell(...).");
+
+  const LabelArray& label_array = {labels...};
+  mutex_lock l(mu_);
+  cells_.erase(label_array);
+}
+
 }  // namespace monitoring
 }  // namespace tensorflow
 
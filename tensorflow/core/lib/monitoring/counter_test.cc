@@ -44,6 +44,15 @@ TEST(LabeledCounterTest, GetCell) {
   EXPECT_EQ(100, same_cell->value());
 }
 
+TEST(LabeledCounterTest, RemoveCell) {
+  counter_with_labels->GetCell("RemovedOp")->IncrementBy(42);
+  counter_with_labels->RemoveCell("RemovedOp");
+  EXPECT_EQ(0, counter_with_labels->GetCell("RemovedOp")->value());
+
+  // Removing a missing cell is a no-op.
+  counter_with_labels->RemoveCell("MissingOp");
+}
+
 TEST(LabeledCounterDeathTest, DiesOnDecrement) {
   EXPECT_DEBUG_DEATH(
       { counter_with_labels->GetCell("DyingOp")->IncrementBy(-1); },
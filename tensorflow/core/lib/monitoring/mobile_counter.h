@@ -53,6 +53,9 @@ class Counter {
     return &default_counter_cell_;
   }
 
+  template <typename... Labels>
+  void RemoveCell(const Labels&... labels) {}
+
  private:
   Counter() {}
 
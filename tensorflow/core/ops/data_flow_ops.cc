@@ -211,6 +211,7 @@ REGISTER_OP("RandomShuffleQueue")
     .Attr("component_types: list(type) >= 1")
     .Attr("shapes: list(shape) >= 0 = []")
     .Attr("capacity: int = -1")
+    .Attr("capacity_bytes: int = -1")
     .Attr("min_after_dequeue: int = 0")
     .Attr("seed: int = 0")
     .Attr("seed2: int = 0")
@@ -229,9 +230,14 @@ shapes: The shape of each component in a value. The length of this attr must
   only one element may be dequeued at a time.
 capacity: The upper bound on the number of elements in this queue.
   Negative numbers mean no limit.
+capacity_bytes: The upper bound on the total size in bytes of the elements in
+  this queue. An element larger than this may still be enqueued into an empty
+  queue. Negative numbers mean no limit.
 min_after_dequeue: Dequeue will block unless there would be this
   many elements after the dequeue or the queue is closed. This
-  ensures a minimum level of mixing of elements.
+  ensures a minimum level of mixing of elements. If an enqueue is blocked
+  because the queue has reached capacity_bytes, a dequeue may leave fewer
+  elements than this.
 seed: If either seed or seed2 is set to be non-zero, the random number
   generator is seeded by the given seed.  Otherwise, a random seed is used.
 seed2: A second seed to avoid seed collision.
@@ -248,6 +254,7 @@ REGISTER_OP("FIFOQueue")
     .Attr("capacity: int = -1")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''")
+    .Attr("lock_free: bool = false")
     .SetIsStateful()
     .SetShapeFn(TwoElementOutput)
     .Doc(R"doc(
@@ -265,6 +272,10 @@ container: If non-empty, this queue is placed in the given container.
         Otherwise, a default container is used.
 shared_name: If non-empty, this queue will be shared under the given name
   across multiple sessions.
+lock_free: If true, single-element enqueues and dequeues that do not need to
+  wait for space or for an element do not take the queue's lock, which reduces
+  contention between many concurrent producers and consumers. Requires a
+  bounded capacity.
 )doc");
 
 REGISTER_OP("PaddingFIFOQueue")
@@ -350,6 +350,56 @@ acceptable_fraction: The minimum required fraction of lines before a truncated
 image: 3-D with shape `[height, width, channels]`..
 )doc");
 
+// --------------------------------------------------------------------------
+REGISTER_OP("DecodeJpegCropAndResize")
+    .Input("contents: string")
+    .Input("crop_windows: int32")
+    .Input("size: int32")
+    .Output("resized_images: float")
+    .Attr("channels: int = 3")
+    .Attr("fancy_upscaling: bool = true")
+    .Attr("align_corners: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle contents;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &contents));
+      ShapeHandle crop_windows;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &crop_windows));
+      DimensionHandle batch = c->Dim(contents, 0);
+      TF_RETURN_IF_ERROR(c->Merge(batch, c->Dim(crop_windows, 0), &batch));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(crop_windows, 1), 4, &unused));
+      int32 channels;
+      TF_RETURN_IF_ERROR(c->GetAttr("channels", &channels));
+      return SetOutputToSizedImage(c, batch, 2 /* size_input_idx */,
+                                   c->MakeDim(channels));
+    })
+    .Doc(R"doc(
+Decode a batch of JPEG-encoded images, crop them and resize the crops.
+
+This computes the same result as decoding each image with `DecodeJpeg`,
+cropping it to its window and resizing the crops with `ResizeBilinear`, but
+far more cheaply: images are decoded in parallel, scanlines below the crop
+window are never decoded, only the crop window is kept, and when a window is
+at least 2, 4 or 8 times larger than `size` in both dimensions the image is
+scaled down by that factor while it is decoded, which is much faster than
+decoding it at full size.  Because of that scaling the result may differ
+slightly from resizing the full-size crop.
+
+contents: 1-D.  The JPEG-encoded images.
+crop_windows: 2-D with shape `[batch, 4]`.  Row `i` is the window
+  `[y, x, height, width]` of image `i` to keep, in pixels of the full-size
+  image.  The window must lie within the image.
+size: A 1-D int32 Tensor of 2 elements: `new_height, new_width`.  The size
+  to which every crop is resized.
+channels: Number of color channels for the decoded images, 1 or 3.
+fancy_upscaling: If true use a slower but nicer upscaling of the
+  chroma planes (yuv420/422 only).
+align_corners: If true, rescale each crop by (new_height - 1) / (height - 1),
+  which exactly aligns the 4 corners of the crop and the resized image.  If
+  false, rescale by new_height / height.  Treat similarly the width dimension.
+resized_images: 4-D with shape `[batch, new_height, new_width, channels]`.
+)doc");
+
 // --------------------------------------------------------------------------
 REGISTER_OP("EncodeJpeg")
     .Input("image: uint8")
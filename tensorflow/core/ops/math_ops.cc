@@ -1017,6 +1017,11 @@ The inputs must be two-dimensional matrices and the inner dimension of "a" must
 match the outer dimension of "b". This op is optimized for the case where at
 least one of "a" or "b" is sparse. The breakeven for using this versus a dense
 matrix multiply on one platform was 30% zero values in the sparse matrix.
+
+The kernel samples the density of both inputs on every call. Inputs marked with
+`a_is_sparse` or `b_is_sparse` that turn out to be mostly nonzero are multiplied
+densely, and an input with at most 5% nonzero values is multiplied through a
+compressed sparse row encoding whether or not it was marked sparse.
 )doc");
 
 // --------------------------------------------------------------------------
@@ -314,6 +314,7 @@ REGISTER_OP("SparseApplyAdagrad")
     .Attr("T: numbertype")
     .Attr("Tindices: {int32, int64}")
     .Attr("use_locking: bool = false")
+    .Attr("use_row_locking: bool = false")
     .SetShapeFn([](InferenceContext* c) {
       return ApplyAdagradShapeFn(c, true /* sparse */);
     })
@@ -333,6 +334,10 @@ out: Same as "var".
 use_locking: If `True`, updating of the var and accum tensors will be protected
   by a lock; otherwise the behavior is undefined, but may exhibit less
   contention.
+use_row_locking: If `True`, the update is split across threads by row, and each
+  row of var and its accumulators is updated under a lock shared by all ops
+  that update this var with `use_row_locking`. Takes precedence over
+  `use_locking`.
 )doc");
 
 static Status ApplyAdagradDAShapeFn(InferenceContext* c, bool sparse) {
@@ -521,6 +526,7 @@ REGISTER_OP("SparseApplyFtrl")
     .Attr("T: numbertype")
     .Attr("Tindices: {int32, int64}")
     .Attr("use_locking: bool = false")
+    .Attr("use_row_locking: bool = false")
     .SetShapeFn([](InferenceContext* c) {
       return ApplyFtrlShapeFn(c, true /* sparse */);
     })
@@ -547,6 +553,10 @@ out: Same as "var".
 use_locking: If `True`, updating of the var and accum tensors will be protected
   by a lock; otherwise the behavior is undefined, but may exhibit less
   contention.
+use_row_locking: If `True`, the update is split across threads by row, and each
+  row of var and its accumulators is updated under a lock shared by all ops
+  that update this var with `use_row_locking`. Takes precedence over
+  `use_locking`.
 )doc");
 
 static Status ApplyMomentumShapeFn(InferenceContext* c, bool sparse) {
@@ -608,6 +618,7 @@ REGISTER_OP("SparseApplyMomentum")
     .Attr("Tindices: {int32, int64}")
     .Attr("use_locking: bool = false")
     .Attr("use_nesterov: bool = false")
+    .Attr("use_row_locking: bool = false")
     .SetShapeFn([](InferenceContext* c) {
       return ApplyMomentumShapeFn(c, true /* sparse */);
     })
@@ -633,6 +644,10 @@ use_locking: If `True`, updating of the var and accum tensors will be protected
 use_nesterov: If `True`, the tensor passed to compute grad will be 
 var - lr * momentum * accum, so in the end, the var you get is actually
 var - lr * momentum * accum.
+use_row_locking: If `True`, the update is split across threads by row, and each
+  row of var and its accumulators is updated under a lock shared by all ops
+  that update this var with `use_row_locking`. Takes precedence over
+  `use_locking`.
 )doc");
 
 static Status ApplyAdamShapeFn(InferenceContext* c, bool sparse) {
@@ -45,6 +45,12 @@ private:
 public:
   double _program_start_time;
 
+  /*
+   * Whether TF_TRACE_PATH was set.  Callers should check this before
+   * building the arguments of the Record* calls, which is not free.
+   */
+  bool enabled() const { return _enabled; }
+
   /*
    * params:
    *
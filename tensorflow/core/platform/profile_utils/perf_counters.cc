@@ -0,0 +1,125 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/profile_utils/perf_counters.h"
+
+#include <memory>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace profile_utils {
+
+/* static */ constexpr int64 PerfCounters::UNAVAILABLE;
+
+/* static */ PerfCounters* PerfCounters::ForCurrentThread() {
+  // Opening fails the same way on every thread, so only try it once per
+  // thread and remember the failure.
+  static thread_local bool tried = false;
+  static thread_local std::unique_ptr<PerfCounters> counters;
+  if (!tried) {
+    tried = true;
+    counters.reset(new PerfCounters);
+    if (!counters->Open()) {
+      counters.reset();
+    }
+  }
+  return counters.get();
+}
+
+PerfCounters::PerfCounters() {
+  for (int i = 0; i < NUM_COUNTERS; ++i) fds_[i] = -1;
+}
+
+PerfCounters::~PerfCounters() {
+#if defined(__linux__)
+  for (int i = 0; i < NUM_COUNTERS; ++i) {
+    if (fds_[i] >= 0) close(fds_[i]);
+  }
+#endif
+}
+
+bool PerfCounters::Open() {
+#if defined(__linux__)
+  static const struct {
+    Counter counter;
+    uint32 type;
+    uint64 config;
+  } kEvents[NUM_COUNTERS] = {
+      {CYCLES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+      {INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+      {LLC_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+      {BRANCH_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+  };
+  for (const auto& event : kEvents) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    const int group_fd = fds_[CYCLES];
+    if (group_fd < 0) {
+      // The leader is pinned so that the group either counts all the time
+      // or fails to read, rather than being multiplexed.
+      attr.pinned = 1;
+    }
+    const int fd = syscall(__NR_perf_event_open, &attr, 0 /* this thread */,
+                           -1 /* any cpu */, group_fd, 0);
+    if (fd < 0) {
+      if (group_fd < 0) {
+        VLOG(1) << "perf_event_open failed: " << strerror(errno);
+        return false;
+      }
+      continue;
+    }
+    fds_[event.counter] = fd;
+    order_[num_open_++] = event.counter;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool PerfCounters::Read(int64 values[NUM_COUNTERS]) {
+#if defined(__linux__)
+  // PERF_FORMAT_GROUP: the number of counters, then their values.
+  uint64 buffer[1 + NUM_COUNTERS];
+  const ssize_t size = sizeof(uint64) * (1 + num_open_);
+  if (read(fds_[CYCLES], buffer, size) != size ||
+      buffer[0] != static_cast<uint64>(num_open_)) {
+    return false;
+  }
+  for (int i = 0; i < NUM_COUNTERS; ++i) values[i] = UNAVAILABLE;
+  for (int i = 0; i < num_open_; ++i) values[order_[i]] = buffer[1 + i];
+  return true;
+#else
+  return false;
+#endif
+}
+
+}  // namespace profile_utils
+}  // namespace tensorflow
@@ -0,0 +1,80 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Per-thread hardware performance counters, read through perf_event_open.
+
+#ifndef TENSORFLOW_PLATFORM_PROFILEUTILS_PERF_COUNTERS_H__
+#define TENSORFLOW_PLATFORM_PROFILEUTILS_PERF_COUNTERS_H__
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+namespace profile_utils {
+
+// PerfCounters counts hardware events of the calling thread, in user mode
+// only, so that the difference between two Read() calls on the same thread
+// is what the thread did in between.  Work the thread hands to other
+// threads, e.g. the shards of an intra-op parallel kernel, is not counted.
+//
+// The counters are only available on Linux, and only if the kernel allows
+// it (see /proc/sys/kernel/perf_event_paranoid); counters the CPU or
+// hypervisor does not provide, often LLC_MISSES in VMs, read as
+// UNAVAILABLE.
+class PerfCounters {
+ public:
+  enum Counter {
+    CYCLES = 0,
+    INSTRUCTIONS = 1,
+    LLC_MISSES = 2,
+    BRANCH_MISSES = 3,
+    NUM_COUNTERS = 4,
+  };
+
+  // Value of a counter that could not be opened.
+  static constexpr int64 UNAVAILABLE = -1;
+
+  // Returns the counters of the calling thread, opening them on first use,
+  // or nullptr if they are not available.  The result must only be used on
+  // the calling thread.
+  static PerfCounters* ForCurrentThread();
+
+  ~PerfCounters();
+
+  // Sets 'values' to the current value of each counter.  Returns false if
+  // the counters could not be read.
+  bool Read(int64 values[NUM_COUNTERS]);
+
+ private:
+  PerfCounters();
+
+  // Opens the counters, with CYCLES as the group leader.  Returns false if
+  // not even the leader could be opened.
+  bool Open();
+
+  // File descriptor of each counter, or -1.
+  int fds_[NUM_COUNTERS];
+  // The opened counters, in the order the group read returns them.
+  Counter order_[NUM_COUNTERS];
+  int num_open_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PerfCounters);
+};
+
+}  // namespace profile_utils
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_PLATFORM_PROFILEUTILS_PERF_COUNTERS_H__
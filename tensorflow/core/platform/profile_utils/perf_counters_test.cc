@@ -0,0 +1,68 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/profile_utils/perf_counters.h"
+
+#include <thread>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace profile_utils {
+
+TEST(PerfCountersTest, CountsWork) {
+  PerfCounters* counters = PerfCounters::ForCurrentThread();
+  if (counters == nullptr) {
+    LOG(INFO) << "Performance counters are not available, skipping.";
+    return;
+  }
+  EXPECT_EQ(counters, PerfCounters::ForCurrentThread());
+
+  int64 before[PerfCounters::NUM_COUNTERS];
+  int64 after[PerfCounters::NUM_COUNTERS];
+  ASSERT_TRUE(counters->Read(before));
+  volatile int64 sum = 0;
+  for (int i = 0; i < 1000000; ++i) sum += i;
+  ASSERT_TRUE(counters->Read(after));
+
+  EXPECT_GT(after[PerfCounters::CYCLES], before[PerfCounters::CYCLES]);
+  for (int i = 0; i < PerfCounters::NUM_COUNTERS; ++i) {
+    if (before[i] == PerfCounters::UNAVAILABLE) {
+      EXPECT_EQ(PerfCounters::UNAVAILABLE, after[i]);
+    } else {
+      EXPECT_GE(after[i], before[i]);
+    }
+  }
+  if (before[PerfCounters::INSTRUCTIONS] != PerfCounters::UNAVAILABLE) {
+    // At least an add and a compare per iteration.
+    EXPECT_GT(after[PerfCounters::INSTRUCTIONS] -
+                  before[PerfCounters::INSTRUCTIONS],
+              2000000);
+  }
+}
+
+TEST(PerfCountersTest, PerThread) {
+  PerfCounters* counters = PerfCounters::ForCurrentThread();
+  PerfCounters* other = nullptr;
+  std::thread thread([&other]() { other = PerfCounters::ForCurrentThread(); });
+  thread.join();
+  if (counters != nullptr) {
+    EXPECT_NE(counters, other);
+  }
+}
+
+}  // namespace profile_utils
+}  // namespace tensorflow
@@ -15,11 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/util/stat_summarizer.h"
 
+#include <algorithm>
 #include <iomanip>
 #include <map>
 #include <queue>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
@@ -104,6 +106,26 @@ void StatSummarizer::ProcessStepStats(const StepStats& step_stats) {
         }
       }
 
+      // hardware counters
+      if (ns.has_hardware_counters()) {
+        const HardwareCounters& hc = ns.hardware_counters();
+        CounterDetail* counters = &counter_details_[ns.node_name()];
+        auto accumulate = [](int64 value, int64* sum, int64* runs) {
+          // Unavailable counters are negative.
+          if (value >= 0) {
+            *sum += value;
+            ++*runs;
+          }
+        };
+        accumulate(hc.cycles(), &counters->cycles, &counters->cycles_runs);
+        accumulate(hc.instructions(), &counters->instructions,
+                   &counters->instructions_runs);
+        accumulate(hc.llc_misses(), &counters->llc_misses,
+                   &counters->llc_misses_runs);
+        accumulate(hc.branch_misses(), &counters->branch_misses,
+                   &counters->branch_misses_runs);
+      }
+
       // memory stats
       auto mem_result = memory_details_.emplace(ns.node_name(), Detail());
       bool first = mem_result.second;
@@ -338,6 +360,73 @@ std::string StatSummarizer::GetStatsByOrderOfNodeDefinitions(
   return stream.str();
 }
 
+std::string StatSummarizer::GetHardwareCounterStats(
+    int num_max_nodes_to_print) const {
+  if (counter_details_.empty()) return "";
+
+  std::vector<std::pair<int64, const string*>> by_cycles;
+  for (const auto& entry : counter_details_) {
+    const CounterDetail& c = entry.second;
+    by_cycles.emplace_back(c.cycles_runs > 0 ? c.cycles / c.cycles_runs : 0,
+                           &entry.first);
+  }
+  std::sort(by_cycles.begin(), by_cycles.end(),
+            [](const std::pair<int64, const string*>& a,
+               const std::pair<int64, const string*>& b) {
+              return a.first > b.first;
+            });
+
+  // Averages per run, and misses per thousand instructions, which tell
+  // memory-bound kernels (high LLC MPKI, low IPC) from compute-bound ones.
+  auto average = [](int64 sum, int64 runs) {
+    return runs > 0 ? static_cast<double>(sum) / runs : 0.0;
+  };
+  auto per_instruction = [](int64 sum, int64 runs, int64 instructions,
+                            int64 instruction_runs, double scale) {
+    if (runs == 0 || instruction_runs == 0 || instructions == 0) return -1.0;
+    return scale * (static_cast<double>(sum) / runs) /
+           (static_cast<double>(instructions) / instruction_runs);
+  };
+
+  std::stringstream stream;
+  stream << "============ Hardware counters by cycles (-1: unavailable) "
+            "================="
+         << std::endl;
+  stream << std::setw(12) << "[Kcycles]" << std::setw(12) << "[Kinstr]"
+         << std::setw(8) << "[IPC]" << std::setw(10) << "[LLC MPKI]"
+         << std::setw(10) << "[Br MPKI]";
+  stream << "\t" << std::setw(10) << "[Op]";
+  stream << "\t"
+         << "[Name]" << std::endl;
+  const int num_nodes =
+      std::min<int>(num_max_nodes_to_print, by_cycles.size());
+  for (int i = 0; i < num_nodes; ++i) {
+    const string& name = *by_cycles[i].second;
+    const CounterDetail& c = counter_details_.at(name);
+    stream << std::fixed << std::setprecision(1) << std::setw(12)
+           << average(c.cycles, c.cycles_runs) / 1000.0 << std::setw(12)
+           << average(c.instructions, c.instructions_runs) / 1000.0;
+    stream << std::setprecision(2) << std::setw(8)
+           << per_instruction(c.instructions, c.instructions_runs, c.cycles,
+                              c.cycles_runs, 1.0)
+           << std::setw(10)
+           << per_instruction(c.llc_misses, c.llc_misses_runs,
+                              c.instructions, c.instructions_runs, 1000.0)
+           << std::setw(10)
+           << per_instruction(c.branch_misses, c.branch_misses_runs,
+                              c.instructions, c.instructions_runs, 1000.0);
+    stream << "\t" << std::setw(10);
+    auto op_it = node_types_.find(name);
+    if (op_it != node_types_.end()) {
+      stream << op_it->second;
+    } else {
+      stream << " ";
+    }
+    stream << "\t" << name << std::endl;
+  }
+  return stream.str();
+}
+
 void StatSummarizer::PrintStepStats() const {
   LOG(INFO) << "Total time (us): " << run_total_micros_;
   LOG(INFO) << GetTimingStatsByRunOrder();
@@ -345,6 +434,9 @@ void StatSummarizer::PrintStepStats() const {
   LOG(INFO) << "Total Memory (bytes): " << memory_;
   LOG(INFO) << GetMemoryStatsByRunOrder();
   LOG(INFO) << GetMemoryStatsByUsage();
+  if (!counter_details_.empty()) {
+    LOG(INFO) << GetHardwareCounterStats();
+  }
   LOG(INFO);
 }
 
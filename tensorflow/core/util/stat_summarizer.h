@@ -144,6 +144,12 @@ class StatSummarizer {
   // Summarizes all memory stats in the order of node definitions in the graph.
   std::string GetMemoryStatsByOrderOfNodeDefinitions() const;
 
+  // Summarizes the hardware counters of the nodes that have them, in the
+  // order of cycles spent (high -> low).  Empty if no step collected
+  // hardware counters.
+  std::string GetHardwareCounterStats(
+      int num_max_nodes_to_print = std::numeric_limits<int>::max()) const;
+
   // Deprecated, use GetTimingStatsByOrderOfNodeDefinitions instead
   std::string GetStatsByOrderOfNodeDefinitions() const;
 
@@ -160,6 +166,7 @@ class StatSummarizer {
     memory_.Reset();
     timing_details_.clear();
     memory_details_.clear();
+    counter_details_.clear();
   }
 
   // Returns number of runs.
@@ -176,6 +183,19 @@ class StatSummarizer {
     std::vector<TensorDescription> outputs;
   };
 
+  // Sums of the hardware counters of a node over all runs, and the number
+  // of runs each counter was available in.
+  struct CounterDetail {
+    int64 cycles = 0;
+    int64 instructions = 0;
+    int64 llc_misses = 0;
+    int64 branch_misses = 0;
+    int64 cycles_runs = 0;
+    int64 instructions_runs = 0;
+    int64 llc_misses_runs = 0;
+    int64 branch_misses_runs = 0;
+  };
+
   enum SortingMetric {
     BY_TOTAL,
     BY_RUN_ORDER,
@@ -201,6 +221,7 @@ class StatSummarizer {
   std::vector<string> nodes_in_def_order_;
   std::map<std::string, Detail> timing_details_;
   std::map<std::string, Detail> memory_details_;
+  std::map<std::string, CounterDetail> counter_details_;
   std::map<string, string> node_types_;
 };
 
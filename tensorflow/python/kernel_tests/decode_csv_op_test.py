@@ -176,5 +176,27 @@ class DecodeCSVOpTest(tf.test.TestCase):
                expected_err_re="Quoted field has to end with quote followed.*")
 
 
+  def testLargeBatch(self):
+    records = []
+    expected_out = [[], [], []]
+    for i in range(10000):
+      records.append('%d,"x""%d"",y",%d.5' % (i, i, i))
+      expected_out[0].append(i)
+      expected_out[1].append(('x"%d",y' % i).encode("ascii"))
+      expected_out[2].append(i + 0.5)
+    args = {"records": records, "record_defaults": [[0], [""], [0.0]]}
+
+    self._test(args, expected_out)
+
+  def testLargeBatchReportsFirstError(self):
+    records = ["%d" % i for i in range(10000)]
+    records[7000] = "a"
+    records[3000] = "b"
+    args = {"records": records, "record_defaults": [[0]]}
+
+    self._test(args,
+               expected_err_re="Field 0 in record 3000 is not a valid int32: b")
+
+
 if __name__ == "__main__":
   tf.test.main()
@@ -19,6 +19,7 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import numpy as np
 import tensorflow as tf
 
 
@@ -57,5 +58,14 @@ class DecodeRawOpTest(tf.test.TestCase):
           "size of int16"):
         decode.eval(feed_dict={in_bytes: ["123", "456"]})
 
+  def testSingleLargeStringToFloat32(self):
+    with self.test_session():
+      in_bytes = tf.placeholder(tf.string, shape=[1])
+      decode = tf.decode_raw(in_bytes, out_type=tf.float32) + 1.0
+
+      expected = np.random.rand(1, 1 << 18).astype(np.float32)
+      result = decode.eval(feed_dict={in_bytes: [expected.tostring()]})
+      self.assertAllEqual(expected + 1.0, result)
+
 if __name__ == "__main__":
   tf.test.main()
@@ -40,6 +40,7 @@ class FIFOQueueTest(tf.test.TestCase):
       attr { key: 'capacity' value { i: 10 } }
       attr { key: 'container' value { s: '' } }
       attr { key: 'shared_name' value { s: '' } }
+      attr { key: 'lock_free' value { b: false } }
       """, q.queue_ref.op.node_def)
 
   def testMultiQueueConstructor(self):
@@ -56,6 +57,7 @@ class FIFOQueueTest(tf.test.TestCase):
       attr { key: 'capacity' value { i: 5 } }
       attr { key: 'container' value { s: '' } }
       attr { key: 'shared_name' value { s: 'foo' } }
+      attr { key: 'lock_free' value { b: false } }
       """, q.queue_ref.op.node_def)
 
   def testConstructorWithShapes(self):
@@ -81,6 +83,7 @@ class FIFOQueueTest(tf.test.TestCase):
       attr { key: 'capacity' value { i: 5 } }
       attr { key: 'container' value { s: '' } }
       attr { key: 'shared_name' value { s: '' } }
+      attr { key: 'lock_free' value { b: false } }
       """, q.queue_ref.op.node_def)
 
   def testEnqueue(self):
@@ -337,6 +340,53 @@ class FIFOQueueTest(tf.test.TestCase):
       self.assertAllEqual(elems[0:4], dequeued_t.eval())
       self.assertAllEqual(elems[4:8], dequeued_t.eval())
 
+  def testDequeueManySpanningEnqueuedBatches(self):
+    with self.test_session() as sess:
+      q = tf.FIFOQueue(20, (tf.uint8, tf.int32), shapes=((3,), ()))
+      enqueue_many_op = q.enqueue_many(
+          ([[1, 2, 3], [4, 5, 6], [7, 8, 9], [10, 11, 12], [13, 14, 15]],
+           [1, 2, 3, 4, 5]))
+      enqueue_op = q.enqueue(([16, 17, 18], 6))
+      dequeued_t = q.dequeue_many(2)
+      dequeued_single_t = q.dequeue()
+
+      enqueue_many_op.run()
+      enqueue_op.run()
+      enqueue_many_op.run()
+
+      # Dequeues that start at unaligned offsets within a batch, span the
+      # boundaries between batches and single elements, and take exactly
+      # the remainder of a batch.
+      uint8_val, int_val = sess.run(dequeued_t)
+      self.assertAllEqual([[1, 2, 3], [4, 5, 6]], uint8_val)
+      self.assertAllEqual([1, 2], int_val)
+      uint8_val, int_val = sess.run(dequeued_single_t)
+      self.assertAllEqual([7, 8, 9], uint8_val)
+      self.assertEqual(3, int_val)
+      uint8_val, int_val = sess.run(dequeued_t)
+      self.assertAllEqual([[10, 11, 12], [13, 14, 15]], uint8_val)
+      self.assertAllEqual([4, 5], int_val)
+      uint8_val, int_val = sess.run(dequeued_t)
+      self.assertAllEqual([[16, 17, 18], [1, 2, 3]], uint8_val)
+      self.assertAllEqual([6, 1], int_val)
+      uint8_val, int_val = sess.run(dequeued_t)
+      self.assertAllEqual([[4, 5, 6], [7, 8, 9]], uint8_val)
+      self.assertAllEqual([2, 3], int_val)
+      self.assertEqual(2, q.size().eval())
+
+  def testDequeueManyWholeEnqueuedBatches(self):
+    with self.test_session() as sess:
+      q = tf.FIFOQueue(10, tf.float32, (2,))
+      elems = tf.placeholder(tf.float32, (2, 2))
+      enqueue_op = q.enqueue_many((elems,))
+      dequeued_t = q.dequeue_many(2)
+
+      enqueue_op.run(feed_dict={elems: [[1.0, 2.0], [3.0, 4.0]]})
+      enqueue_op.run(feed_dict={elems: [[5.0, 6.0], [7.0, 8.0]]})
+
+      self.assertAllEqual([[1.0, 2.0], [3.0, 4.0]], sess.run(dequeued_t))
+      self.assertAllEqual([[5.0, 6.0], [7.0, 8.0]], sess.run(dequeued_t))
+
   def testDequeueUpToNoBlocking(self):
     with self.test_session():
       q = tf.FIFOQueue(10, tf.float32, ())
@@ -1181,6 +1231,99 @@ class FIFOQueueTest(tf.test.TestCase):
       with self.assertRaisesOpError("component types"):
         q_f_2.queue_ref.eval()
 
+      q_g_1 = tf.FIFOQueue(10, tf.float32, shared_name="q_g")
+      q_g_2 = tf.FIFOQueue(10, tf.float32, shared_name="q_g", lock_free=True)
+      q_g_1.queue_ref.eval()
+      with self.assertRaisesOpError("lock_free"):
+        q_g_2.queue_ref.eval()
+
+  def testLockFreeRequiresBoundedCapacity(self):
+    with self.test_session():
+      q = tf.FIFOQueue(-1, tf.float32, lock_free=True)
+      with self.assertRaisesOpError("bounded, positive capacity"):
+        q.queue_ref.eval()
+
+  def testLockFreeEnqueueAndDequeue(self):
+    with self.test_session() as sess:
+      q = tf.FIFOQueue(6, (tf.float32, tf.int32), shapes=((), (2,)),
+                       lock_free=True)
+      x = tf.placeholder(tf.float32)
+      y = tf.placeholder(tf.int32)
+      enqueue_op = q.enqueue((x, y))
+      enqueue_many_op = q.enqueue_many(([1.0, 2.0, 3.0],
+                                        [[1, 1], [2, 2], [3, 3]]))
+      dequeued_t = q.dequeue()
+      dequeued_many_t = q.dequeue_many(3)
+
+      enqueue_op.run(feed_dict={x: 0.0, y: [0, 0]})
+      enqueue_many_op.run()
+      enqueue_op.run(feed_dict={x: 4.0, y: [4, 4]})
+      self.assertEqual(5, q.size().eval())
+
+      float_val, int_val = sess.run(dequeued_t)
+      self.assertEqual(0.0, float_val)
+      self.assertAllEqual([0, 0], int_val)
+      float_val, int_val = sess.run(dequeued_many_t)
+      self.assertAllEqual([1.0, 2.0, 3.0], float_val)
+      self.assertAllEqual([[1, 1], [2, 2], [3, 3]], int_val)
+      float_val, int_val = sess.run(dequeued_t)
+      self.assertEqual(4.0, float_val)
+      self.assertAllEqual([4, 4], int_val)
+      self.assertEqual(0, q.size().eval())
+
+  def testLockFreeParallelEnqueueAndDequeue(self):
+    with self.test_session() as sess:
+      q = tf.FIFOQueue(4, tf.float32, shapes=(), lock_free=True)
+      elems = [10.0 * x for x in range(50)]
+      enqueue_ops = [q.enqueue((x,)) for x in elems]
+      dequeued_t = q.dequeue()
+
+      # More producers than the queue has room for, so that some of them
+      # must wait for the consumers.
+      results = []
+      def enqueue(enqueue_op):
+        sess.run(enqueue_op)
+      def dequeue():
+        for _ in xrange(len(elems) // 5):
+          results.append(sess.run(dequeued_t))
+      threads = [self.checkedThread(target=enqueue, args=(e,))
+                 for e in enqueue_ops]
+      threads += [self.checkedThread(target=dequeue) for _ in xrange(5)]
+      for thread in threads:
+        thread.start()
+      for thread in threads:
+        thread.join()
+      self.assertItemsEqual(elems, results)
+
+  def testLockFreeBlockingDequeueAndClose(self):
+    with self.test_session() as sess:
+      q = tf.FIFOQueue(4, tf.float32, shapes=(), lock_free=True)
+      enqueue_op = q.enqueue((10.0,))
+      enqueue_many_op = q.enqueue_many(([20.0, 30.0, 40.0],))
+      dequeued_t = q.dequeue()
+      dequeued_up_to_t = q.dequeue_up_to(4)
+      close_op = q.close()
+
+      def blocking_dequeue():
+        self.assertEqual(10.0, sess.run(dequeued_t))
+      thread = self.checkedThread(target=blocking_dequeue)
+      thread.start()
+      # The enqueue should run after the dequeue has blocked.
+      # TODO(mrry): Figure out how to do this without sleeping.
+      time.sleep(0.1)
+      enqueue_op.run()
+      thread.join()
+
+      enqueue_many_op.run()
+      close_op.run()
+      # The elements left when the queue is closed remain available.
+      self.assertAllEqual([20.0, 30.0, 40.0], dequeued_up_to_t.eval())
+      with self.assertRaisesRegexp(tf.errors.OutOfRangeError,
+                                   "is closed and has insufficient"):
+        dequeued_t.eval()
+      with self.assertRaisesRegexp(tf.errors.CancelledError, "is closed"):
+        enqueue_op.run()
+
   def testSelectQueue(self):
     with self.test_session():
       num_queues = 10
@@ -1365,6 +1508,7 @@ class FIFOQueueDictTest(tf.test.TestCase):
       attr { key: 'capacity' value { i: 5 } }
       attr { key: 'container' value { s: '' } }
       attr { key: 'shared_name' value { s: 'foo' } }
+      attr { key: 'lock_free' value { b: false } }
       """, q.queue_ref.op.node_def)
     self.assertEqual(["i", "j"], q.names)
 
@@ -1391,6 +1535,7 @@ class FIFOQueueDictTest(tf.test.TestCase):
       attr { key: 'capacity' value { i: 5 } }
       attr { key: 'container' value { s: '' } }
       attr { key: 'shared_name' value { s: '' } }
+      attr { key: 'lock_free' value { b: false } }
       """, q.queue_ref.op.node_def)
     self.assertEqual(["i", "f"], q.names)
 
@@ -948,6 +948,21 @@ class ParseTensorOpTest(tf.test.TestCase):
 
       self.assertAllEqual(expected, result)
 
+  def testLargeToFloat32(self):
+    with self.test_session():
+      expected = np.random.rand(256, 1024).astype(np.float32)
+      tensor_proto = tensor_util.make_tensor_proto(expected)
+
+      serialized = tf.placeholder(tf.string)
+      # The parsed tensor may share its buffer with `serialized`; make sure
+      # its values are intact when consumed by a later op.
+      tensor = tf.parse_tensor(serialized, tf.float32) * 2.0
+
+      result = tensor.eval(
+          feed_dict={serialized: tensor_proto.SerializeToString()})
+
+      self.assertAllEqual(expected * 2.0, result)
+
   def testTypeMismatch(self):
     with self.test_session():
       expected = np.random.rand(3, 4, 5).astype(np.uint8)
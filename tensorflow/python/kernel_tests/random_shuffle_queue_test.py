@@ -1142,6 +1142,81 @@ class RandomShuffleQueueTest(tf.test.TestCase):
       with self.assertRaisesOpError("random seeds"):
         q_h_2.queue_ref.eval()
 
+      q_i_1 = tf.RandomShuffleQueue(
+          10, 5, tf.float32, shared_name="q_i")
+      q_i_2 = tf.RandomShuffleQueue(
+          10, 5, tf.float32, shared_name="q_i", capacity_bytes=100)
+      q_i_1.queue_ref.eval()
+      with self.assertRaisesOpError("capacity_bytes"):
+        q_i_2.queue_ref.eval()
+
+  def testCapacityBytesBlocksEnqueue(self):
+    with self.test_session() as sess:
+      # Each element is 32 bytes, so only two fit.
+      q = tf.RandomShuffleQueue(10, 0, tf.int32, ((8,),), capacity_bytes=80)
+      elems = np.arange(24, dtype=np.int32).reshape((3, 8))
+      enqueue_many_op = q.enqueue_many((elems[:2],))
+      blocking_enqueue_op = q.enqueue((elems[2],))
+      dequeued_t = q.dequeue()
+      size_t = q.size()
+
+      enqueue_many_op.run()
+      self.assertEqual(2, size_t.eval())
+
+      def blocking_enqueue():
+        sess.run(blocking_enqueue_op)
+      thread = self.checkedThread(target=blocking_enqueue)
+      thread.start()
+      # The dequeue should run after the blocking enqueue has blocked.
+      # TODO(mrry): Figure out how to do this without sleeping.
+      time.sleep(0.1)
+      self.assertEqual(2, size_t.eval())
+      results = [dequeued_t.eval().tolist()]
+      thread.join()
+      self.assertEqual(2, size_t.eval())
+      results.append(dequeued_t.eval().tolist())
+      results.append(dequeued_t.eval().tolist())
+      self.assertItemsEqual(elems.tolist(), results)
+
+  def testCapacityBytesReachedBeforeMinAfterDequeue(self):
+    with self.test_session() as sess:
+      q = tf.RandomShuffleQueue(10, 5, tf.int32, ((8,),), capacity_bytes=80)
+      elems = np.arange(24, dtype=np.int32).reshape((3, 8))
+      enqueue_many_op = q.enqueue_many((elems,))
+      dequeued_t = q.dequeue()
+
+      # The enqueue can only complete if a dequeue makes room, even though
+      # it leaves fewer than min_after_dequeue elements behind.
+      def enqueue():
+        sess.run(enqueue_many_op)
+      thread = self.checkedThread(target=enqueue)
+      thread.start()
+      self.assertIn(dequeued_t.eval().tolist(), elems.tolist())
+      thread.join()
+      self.assertEqual(2, q.size().eval())
+
+  def testCapacityBytesWithMixedEnqueues(self):
+    with self.test_session() as sess:
+      q = tf.RandomShuffleQueue(
+          100, 0, (tf.float32, tf.string), ((2,), ()), capacity_bytes=1 << 20)
+      enqueue_op = q.enqueue(([-1.0, -2.0], "single"))
+      enqueue_many_op = q.enqueue_many(
+          ([[float(i), float(i)] for i in range(20)],
+           [str(i) * i for i in range(20)]))
+      dequeued_t = q.dequeue_many(21)
+
+      enqueue_op.run()
+      enqueue_many_op.run()
+      floats, strings = sess.run(dequeued_t)
+      self.assertItemsEqual([-1.0] + list(range(20)), floats[:, 0])
+      self.assertItemsEqual(
+          [b"single"] + [(str(i) * i).encode("utf-8") for i in range(20)],
+          strings)
+      for f, s in zip(floats, strings):
+        if f[0] >= 0:
+          self.assertEqual(f[0], f[1])
+          self.assertEqual((str(int(f[0])) * int(f[0])).encode("utf-8"), s)
+
   def testSelectQueue(self):
     with self.test_session():
       num_queues = 10
@@ -208,6 +208,19 @@ class ReduceJoinTest(UnicodeTestCase):
     self._testReduceJoin(input_array, truth_dim_one, truth_shape_dim_one,
                          reduction_indices=1, separator="  ")
 
+  def testPackedInputs(self):
+    # AsString and StringSplit produce packed string tensors, which
+    # ReduceJoin reads in place.
+    with self.test_session():
+      tokens = tf.string_split(["a bb", "ccc"]).values
+      numbers = tf.reshape(tf.as_string([1, 22, 333, 4444]), [2, 2])
+      self.assertAllEqualUnicode(
+          "a-bb-ccc",
+          tf.reduce_join(tokens, reduction_indices=0, separator="-").eval())
+      self.assertAllEqualUnicode(
+          ["122", "3334444"],
+          tf.reduce_join(numbers, reduction_indices=1).eval())
+
   def testUnknownShape(self):
     input_array = [["a"], ["b"]]
     truth = ["ab"]
@@ -305,6 +305,26 @@ class UnsortedSegmentSumTest(SegmentReductionHelper):
     self.assertAllClose(unsorted_jacob_t, sorted_jacob_t, rtol=1e-3, atol=1e-3)
     self.assertAllClose(unsorted_jacob_n, sorted_jacob_n, rtol=1e-3, atol=1e-3)
 
+  def testLargeValues(self):
+    # Covers both many input rows per segment and few input rows per segment,
+    # with enough work to be split across threads.
+    np.random.seed(7)
+    for num_rows, num_segments in (20000, 10), (20000, 15000):
+      indices = np.random.randint(0, num_segments, num_rows)
+      shape = indices.shape + (16,)
+      with self.test_session(use_gpu=self.use_gpu):
+        tf_x, np_x = self._input(shape, dtype=tf.float64)
+        np_ans = self._segmentReduce(indices,
+                                     np_x,
+                                     np.add,
+                                     op2=None,
+                                     num_out_rows=num_segments)
+        s = tf.unsorted_segment_sum(data=tf_x,
+                                    segment_ids=indices,
+                                    num_segments=num_segments)
+        tf_ans = s.eval()
+      self._assertAllClose(indices, np_ans, tf_ans)
+
   def testBadIndices(self):
     # Note: GPU kernel does not return the out-of-range error needed for this
     # test, so this test is marked as cpu-only.
@@ -397,6 +417,34 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
           # and may therefore vary dynamically.
           self.assertAllEqual(np_ans.shape[1:], tf_ans.shape[1:])
 
+  def testManySegments(self):
+    np.random.seed(7)
+    segment_indices = np.repeat(np.arange(3000), 5)
+    num_indices = len(segment_indices)
+    with self.test_session(use_gpu=False):
+      tf_indices, np_indices, tf_x, np_x = self._sparse_input([1000, 32],
+                                                              num_indices,
+                                                              dtype=tf.float32)
+      np_ans = self._sparseSegmentReduce(np_x, np_indices, segment_indices,
+                                         np.add)
+      s = tf.sparse_segment_sum(data=tf_x, indices=tf_indices,
+                                segment_ids=segment_indices)
+      self._assertAllClose(segment_indices, np_ans, s.eval())
+
+  def testIndicesInvalidInLaterSegments(self):
+    # The first invalid index is reported even when several segments, which
+    # may be reduced in parallel, contain invalid indices.
+    tf_x, _ = self._input([10, 4], dtype=tf.float32)
+    segment_indices = np.repeat(np.arange(2000), 3)
+    tf_indices = np.zeros(len(segment_indices), dtype=np.int32)
+    tf_indices[4000::7] = 10
+    with self.test_session(use_gpu=False):
+      s = tf.sparse_segment_sum(data=tf_x, indices=tf_indices,
+                                segment_ids=segment_indices)
+      with self.assertRaisesOpError(
+          r"indices\[4000\] == 10 out of range \[0, 10\)"):
+        s.eval()
+
   def testValid(self):
     # Baseline for the test*Invalid* methods below.
     tf_x, _ = self._input([10, 4], dtype=tf.float32)
@@ -119,6 +119,17 @@ class SliceTest(tf.test.TestCase):
     self._testSliceMatrixDim0(y, 1, 2)
     self._testSliceMatrixDim0(y, 3, 3)
 
+  def testLargeSlices(self):
+    inp = np.random.rand(2, 64, 1024).astype("f")
+    with self.test_session(use_gpu=False):
+      a = tf.constant(inp)
+      # A strided slice, consumed by another op.
+      strided_t = tf.slice(a, [0, 8, 256], [2, 48, 512]) * 2
+      # A contiguous run of the input.
+      contiguous_t = tf.slice(a, [1, 8, 0], [1, 48, 1024])
+      self.assertAllEqual(inp[:, 8:56, 256:768] * 2, strided_t.eval())
+      self.assertAllEqual(inp[1:2, 8:56, :], contiguous_t.eval())
+
   def testSingleElementAll(self):
     for _ in range(10):
       with self.test_session(use_gpu=True):
@@ -92,6 +92,39 @@ class SparseMatMulTest(tf.test.TestCase):
                 self._testCpuMatmul(x, y, tr_a, tr_b, sp_a, sp_b,
                                     x_dtype=x_dtype, y_dtype=y_dtype)
 
+  # Tests matrices that are sparse enough to use the CSR path.
+  def testVerySparse(self):
+    for tr_a in [True, False]:
+      for tr_b in [True, False]:
+        for sp_a in [True, False]:
+          for x_dtype in (tf.float32, tf.bfloat16):
+            for y_dtype in (tf.float32, tf.bfloat16):
+              n, k, m = np.random.randint(1, 100, size=3)
+              x = RandMatrix(n, k, tr_a)
+              y = RandMatrix(k, m, tr_b)
+              if sp_a:
+                x[np.random.uniform(size=x.shape) < 0.98] = 0
+              else:
+                y[np.random.uniform(size=y.shape) < 0.98] = 0
+              self._testCpuMatmul(x, y, tr_a, tr_b, sp_a, not sp_a,
+                                  x_dtype=x_dtype, y_dtype=y_dtype)
+
+  # Tests that updates to a sparse variable input are seen by later steps.
+  def testVerySparseVariable(self):
+    x = RandMatrix(64, 32, False)
+    x[np.random.uniform(size=x.shape) < 0.98] = 0
+    y = RandMatrix(32, 16, False)
+    with self.test_session(use_gpu=False):
+      var = tf.Variable(x)
+      product = tf.matmul(var, y, a_is_sparse=True)
+      tf.initialize_all_variables().run()
+      for _ in range(3):
+        self.assertAllClose(np.dot(x, y), product.eval(), rtol=1e-4,
+                            atol=1e-4)
+      x[0, 0] += 1
+      var.assign(x).eval()
+      self.assertAllClose(np.dot(x, y), product.eval(), rtol=1e-4, atol=1e-4)
+
 
 class MatMulGradientTest(tf.test.TestCase):
 
@@ -111,6 +111,20 @@ class SplitOpTest(tf.test.TestCase):
       self._RunAndVerify(use_gpu=True)
       self._RunAndVerify(use_gpu=True, large_num_splits=True)
 
+  def testLargeSplitCols(self):
+    # Large outputs that are not contiguous in the input, consumed by another
+    # op before being fetched.
+    inp = np.random.rand(64, 1024).astype("f")
+    with self.test_session(use_gpu=False) as sess:
+      tf_ans = [x * 2 for x in tf.split(1, 4, inp)]
+      out = sess.run(tf_ans)
+    for i, np_ans in enumerate(np.split(inp, 4, 1)):
+      self.assertAllEqual(np_ans * 2, out[i])
+
+  def testLargeSplitContiguous(self):
+    inp = np.random.rand(1, 64, 1024).astype("f")
+    self._compare(inp, 1, 4, use_gpu=False)
+
   def _testGradientsSimple(self, use_gpu):
     inp = np.random.rand(4, 4).astype("f")
     with self.test_session(use_gpu=use_gpu):
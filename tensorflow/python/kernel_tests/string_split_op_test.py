@@ -93,5 +93,23 @@ class StringSplitOpTest(tf.test.TestCase):
       self.assertAllEqual(shape, [2, 2])
 
 
+  def testStringSplitLargeBatch(self):
+    strings = [" ".join(["w%d" % j for j in range(i % 7)]) + "  "
+               for i in range(10000)]
+
+    with self.test_session() as sess:
+      tokens = tf.string_split(strings)
+      indices, values, shape = sess.run(tokens)
+      expected_indices = []
+      expected_values = []
+      for i, s in enumerate(strings):
+        for j, token in enumerate(s.split()):
+          expected_indices.append([i, j])
+          expected_values.append(token.encode("ascii"))
+      self.assertAllEqual(indices, expected_indices)
+      self.assertAllEqual(values, expected_values)
+      self.assertAllEqual(shape, [10000, 6])
+
+
 if __name__ == "__main__":
   tf.test.main()
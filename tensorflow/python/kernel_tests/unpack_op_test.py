@@ -108,6 +108,14 @@ class UnpackOpTest(tf.test.TestCase):
 
         self.assertAllEqual(expected, actual)
 
+  def testLargeAxis1(self):
+    # Large outputs that are not contiguous in the input.
+    a = np.random.rand(512, 3, 64).astype(np.float32)
+    expected = np_split_sqeeze(a, 1)
+    with self.test_session(use_gpu=False) as sess:
+      actual = sess.run([x + 1 for x in tf.unpack(a, axis=1)])
+    self.assertAllEqual([x + 1 for x in expected], actual)
+
   def testAxis0Default(self):
     with self.test_session() as sess:
       a = tf.constant([[1, 2, 3], [4, 5, 6]], name='a')
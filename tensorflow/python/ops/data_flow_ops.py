@@ -558,7 +558,7 @@ class RandomShuffleQueue(QueueBase):
 
   def __init__(self, capacity, min_after_dequeue, dtypes, shapes=None,
                names=None, seed=None, shared_name=None,
-               name="random_shuffle_queue"):
+               name="random_shuffle_queue", capacity_bytes=None):
     """Create a queue that dequeues elements in a random order.
 
     A `RandomShuffleQueue` has bounded capacity; supports multiple
@@ -583,6 +583,12 @@ class RandomShuffleQueue(QueueBase):
     enqueued. The `min_after_dequeue` argument is ignored after the
     queue has been closed.
 
+    The optional `capacity_bytes` argument additionally bounds the total
+    size of the queued elements, which suits elements of very different
+    sizes, such as variable-length strings, better than `capacity` alone.
+    When it is reached before `min_after_dequeue` elements are queued,
+    dequeues proceed anyway so that the queue cannot stall.
+
     Args:
       capacity: An integer. The upper bound on the number of elements
         that may be stored in this queue.
@@ -600,10 +606,15 @@ class RandomShuffleQueue(QueueBase):
       shared_name: (Optional.) If non-empty, this queue will be shared under
         the given name across multiple sessions.
       name: Optional name for the queue operation.
+      capacity_bytes: (Optional.) An integer. The upper bound on the total
+        size in bytes of the elements stored in this queue, or `None` for no
+        limit.
     """
     dtypes = _as_type_list(dtypes)
     shapes = _as_shape_list(shapes, dtypes)
     names = _as_name_list(names, dtypes)
+    if capacity_bytes is None:
+      capacity_bytes = -1
     seed1, seed2 = random_seed.get_seed(seed)
     if seed1 is None and seed2 is None:
       seed1, seed2 = 0, 0
@@ -616,8 +627,8 @@ class RandomShuffleQueue(QueueBase):
       seed2 = int(hashlib.md5(string).hexdigest()[:8], 16) & 0x7FFFFFFF
     queue_ref = gen_data_flow_ops._random_shuffle_queue(
         component_types=dtypes, shapes=shapes, capacity=capacity,
-        min_after_dequeue=min_after_dequeue, seed=seed1, seed2=seed2,
-        shared_name=shared_name, name=name)
+        capacity_bytes=capacity_bytes, min_after_dequeue=min_after_dequeue,
+        seed=seed1, seed2=seed2, shared_name=shared_name, name=name)
 
     super(RandomShuffleQueue, self).__init__(dtypes, shapes, names, queue_ref)
 
@@ -632,7 +643,7 @@ class FIFOQueue(QueueBase):
   """
 
   def __init__(self, capacity, dtypes, shapes=None, names=None,
-               shared_name=None, name="fifo_queue"):
+               shared_name=None, name="fifo_queue", lock_free=False):
     """Creates a queue that dequeues elements in a first-in first-out order.
 
     A `FIFOQueue` has bounded capacity; supports multiple concurrent
@@ -661,13 +672,17 @@ class FIFOQueue(QueueBase):
       shared_name: (Optional.) If non-empty, this queue will be shared under
         the given name across multiple sessions.
       name: Optional name for the queue operation.
+      lock_free: (Optional.) If true, `enqueue` and `dequeue` operations that
+        do not have to wait complete without taking the queue's lock, which
+        reduces contention between many concurrent producers and consumers.
+        Requires a positive `capacity`.
     """
     dtypes = _as_type_list(dtypes)
     shapes = _as_shape_list(shapes, dtypes)
     names = _as_name_list(names, dtypes)
     queue_ref = gen_data_flow_ops._fifo_queue(
         component_types=dtypes, shapes=shapes, capacity=capacity,
-        shared_name=shared_name, name=name)
+        shared_name=shared_name, name=name, lock_free=lock_free)
 
     super(FIFOQueue, self).__init__(dtypes, shapes, names, queue_ref)
 
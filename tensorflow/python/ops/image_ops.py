@@ -30,6 +30,7 @@ to be stripped from the image and re-attached using slicing ops.
 
 @@decode_jpeg
 @@encode_jpeg
+@@decode_jpeg_crop_and_resize
 
 @@decode_png
 @@encode_png
@@ -1017,6 +1018,11 @@ ops.RegisterShape('SampleDistortedBoundingBox')(common_shapes.call_cpp_shape_fn)
 def _ResizeShape(op):
   return common_shapes.call_cpp_shape_fn(op, input_tensors_needed=[1])
 
+
+@ops.RegisterShape('DecodeJpegCropAndResize')
+def _DecodeJpegCropAndResizeShape(op):
+  return common_shapes.call_cpp_shape_fn(op, input_tensors_needed=[2])
+
 ops.RegisterShape('DecodeGif')(common_shapes.call_cpp_shape_fn)
 ops.RegisterShape('DecodeJpeg')(common_shapes.call_cpp_shape_fn)
 ops.RegisterShape('DecodePng')(common_shapes.call_cpp_shape_fn)
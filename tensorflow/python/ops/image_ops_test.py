@@ -1719,6 +1719,51 @@ class JpegTest(test_util.TensorFlowTestCase):
         self.assertEqual(image.get_shape().as_list(),
                          [None, None, channels or None])
 
+  def _decodeCropAndResize(self, jpeg, windows, size, ratio=1):
+    """Decodes, crops and resizes jpeg with separate ops."""
+    image = image_ops.decode_jpeg(jpeg, channels=3, ratio=ratio)
+    crops = [image[y // ratio:(y + h) // ratio, x // ratio:(x + w) // ratio]
+             for y, x, h, w in windows]
+    return array_ops.concat(0, [
+        image_ops.resize_bilinear(array_ops.expand_dims(crop, 0), size)
+        for crop in crops])
+
+  def testDecodeJpegCropAndResize(self):
+    path = 'tensorflow/core/lib/jpeg/testdata/jpeg_merge_test1.jpg'
+    with self.test_session() as sess:
+      jpeg = io_ops.read_file(path)
+      # None of the windows is large enough to be scaled down while decoding.
+      windows = [[20, 10, 60, 100], [0, 0, 256, 128], [200, 64, 56, 64]]
+      size = [45, 70]
+      fused = image_ops.decode_jpeg_crop_and_resize(
+          array_ops.pack([jpeg] * 3), windows, size)
+      self.assertEqual(fused.get_shape().as_list(), [3, 45, 70, 3])
+      expected = self._decodeCropAndResize(jpeg, windows, size)
+      fused, expected = sess.run([fused, expected])
+      self.assertAllClose(expected, fused)
+
+  def testDecodeJpegCropAndResizeScalesDown(self):
+    path = 'tensorflow/core/lib/jpeg/testdata/jpeg_merge_test1.jpg'
+    with self.test_session() as sess:
+      jpeg = io_ops.read_file(path)
+      # The 256 x 128 image is at least 8 times as large as the output, so it
+      # is decoded at 1/8 of its size.
+      windows = [[0, 0, 256, 128]]
+      fused = image_ops.decode_jpeg_crop_and_resize(
+          array_ops.pack([jpeg]), windows, [30, 16])
+      expected = self._decodeCropAndResize(jpeg, windows, [30, 16], ratio=8)
+      fused, expected = sess.run([fused, expected])
+      self.assertAllClose(expected, fused)
+
+  def testDecodeJpegCropAndResizeBadWindow(self):
+    path = 'tensorflow/core/lib/jpeg/testdata/jpeg_merge_test1.jpg'
+    with self.test_session():
+      jpeg = io_ops.read_file(path)
+      fused = image_ops.decode_jpeg_crop_and_resize(
+          array_ops.pack([jpeg]), [[200, 0, 57, 128]], [10, 10])
+      with self.assertRaisesOpError('Invalid JPEG data or crop window'):
+        fused.eval()
+
 
 class PngTest(test_util.TensorFlowTestCase):
 
@@ -34,7 +34,7 @@ class AdagradOptimizer(optimizer.Optimizer):
   """
 
   def __init__(self, learning_rate, initial_accumulator_value=0.1,
-               use_locking=False, name="Adagrad"):
+               use_locking=False, name="Adagrad", use_row_locking=False):
     """Construct a new Adagrad optimizer.
 
     Args:
@@ -44,6 +44,10 @@ class AdagradOptimizer(optimizer.Optimizer):
       use_locking: If `True` use locks for update operations.
       name: Optional name prefix for the operations created when applying
         gradients.  Defaults to "Adagrad".
+      use_row_locking: If `True`, sparse updates are split across threads by
+        row and each row is updated under its own lock, rather than under
+        `use_locking`.  Useful for large embedding variables updated by
+        many concurrent steps.
 
     Raises:
       ValueError: If the `initial_accumulator_value` is invalid.
@@ -54,6 +58,7 @@ class AdagradOptimizer(optimizer.Optimizer):
     super(AdagradOptimizer, self).__init__(use_locking, name)
     self._learning_rate = learning_rate
     self._initial_accumulator_value = initial_accumulator_value
+    self._use_row_locking = use_row_locking
     # Created in Initialize.
     self._learning_rate_tensor = None
 
@@ -86,4 +91,5 @@ class AdagradOptimizer(optimizer.Optimizer):
         math_ops.cast(self._learning_rate_tensor, var.dtype.base_dtype),
         grad.values,
         grad.indices,
-        use_locking=self._use_locking)
+        use_locking=self._use_locking,
+        use_row_locking=self._use_row_locking)
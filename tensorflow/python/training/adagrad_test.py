@@ -80,7 +80,7 @@ class AdagradOptimizerTest(tf.test.TestCase):
         self.assertAllCloseAccordingToType(
             np.array([2.715679168701172, 3.715679168701172]), var1.eval())
 
-  def testSparseBasic(self):
+  def doTestSparseBasic(self, use_row_locking=False):
     for dtype in [tf.half, tf.float32, tf.float64]:
       with self.test_session():
         var0 = tf.Variable([[1.0], [2.0]], dtype=dtype)
@@ -93,9 +93,14 @@ class AdagradOptimizerTest(tf.test.TestCase):
             tf.constant([0.01], shape=[1, 1], dtype=dtype),
             tf.constant([1]),
             tf.constant([2, 1]))
-        ada_opt = tf.train.AdagradOptimizer(3.0, initial_accumulator_value=0.1)
+        ada_opt = tf.train.AdagradOptimizer(
+            3.0, initial_accumulator_value=0.1,
+            use_row_locking=use_row_locking)
         ada_update = ada_opt.apply_gradients(zip(
             [grads0, grads1], [var0, var1]))
+        for op in tf.get_default_graph().get_operations():
+          if op.type == "SparseApplyAdagrad":
+            self.assertEqual(use_row_locking, op.get_attr("use_row_locking"))
         tf.initialize_all_variables().run()
         # Fetch params to validate initial values
         self.assertAllClose([[1.0], [2.0]], var0.eval())
@@ -109,6 +114,12 @@ class AdagradOptimizerTest(tf.test.TestCase):
         self.assertAllCloseAccordingToType(
             np.array([[3.0], [3.715679168701172]]), var1.eval())
 
+  def testSparseBasic(self):
+    self.doTestSparseBasic(use_row_locking=False)
+
+  def testSparseBasicRowLocked(self):
+    self.doTestSparseBasic(use_row_locking=True)
+
   def testSparseStability(self):
     for dtype in [tf.half, tf.float32, tf.float64]:
       with self.test_session():
@@ -39,7 +39,7 @@ class FtrlOptimizer(optimizer.Optimizer):
                initial_accumulator_value=0.1,
                l1_regularization_strength=0.0,
                l2_regularization_strength=0.0,
-               use_locking=False, name="Ftrl"):
+               use_locking=False, name="Ftrl", use_row_locking=False):
     """Construct a new FTRL optimizer.
 
     Args:
@@ -54,11 +54,16 @@ class FtrlOptimizer(optimizer.Optimizer):
       use_locking: If `True` use locks for update operations.
       name: Optional name prefix for the operations created when applying
         gradients.  Defaults to "Ftrl".
+      use_row_locking: If `True`, sparse updates are split across threads by
+        row and each row is updated under its own lock, rather than under
+        `use_locking`.  Useful for large embedding variables updated by
+        many concurrent steps.
 
     Raises:
       ValueError: If one of the arguments is invalid.
     """
     super(FtrlOptimizer, self).__init__(use_locking, name)
+    self._use_row_locking = use_row_locking
 
     if initial_accumulator_value <= 0.0:
       raise ValueError("initial_accumulator_value %f needs to be positive" %
@@ -131,4 +136,5 @@ class FtrlOptimizer(optimizer.Optimizer):
         math_ops.cast(self._l2_regularization_strength_tensor,
                       var.dtype.base_dtype),
         math_ops.cast(self._learning_rate_power_tensor, var.dtype.base_dtype),
-        use_locking=self._use_locking)
+        use_locking=self._use_locking,
+        use_row_locking=self._use_row_locking)
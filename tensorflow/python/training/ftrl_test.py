@@ -222,6 +222,29 @@ class FtrlOptimizerTest(tf.test.TestCase):
       self.assertAllCloseAccordingToType(val0, val2)
       self.assertAllCloseAccordingToType(val1, val3)
 
+  def testEquivSparseAdagradRowLocked(self):
+    for dtype in [tf.half, tf.float32]:
+      with self.test_session():
+        val0, val1 = self.applyOptimizer(
+            tf.train.FtrlOptimizer(3.0,
+                                   # Adagrad learning rate
+                                   learning_rate_power=-0.5,
+                                   initial_accumulator_value=0.1,
+                                   l1_regularization_strength=0.0,
+                                   l2_regularization_strength=0.0,
+                                   use_row_locking=True),
+            dtype,
+            is_sparse=True)
+
+      with self.test_session():
+        val2, val3 = self.applyOptimizer(
+            tf.train.AdagradOptimizer(3.0, initial_accumulator_value=0.1,
+                                      use_row_locking=True),
+            dtype, is_sparse=True)
+
+      self.assertAllCloseAccordingToType(val0, val2)
+      self.assertAllCloseAccordingToType(val1, val3)
+
   def testEquivSparseGradientDescentwithoutRegularization(self):
     for dtype in [tf.half, tf.float32]:
       with self.test_session():
@@ -31,7 +31,8 @@ class MomentumOptimizer(optimizer.Optimizer):
   """
 
   def __init__(self, learning_rate, momentum,
-               use_locking=False, name="Momentum", use_nesterov=False):
+               use_locking=False, name="Momentum", use_nesterov=False,
+               use_row_locking=False):
     """Construct a new Momentum optimizer.
 
     Args:
@@ -40,11 +41,17 @@ class MomentumOptimizer(optimizer.Optimizer):
       use_locking: If `True` use locks for update operations.
       name: Optional name prefix for the operations created when applying
         gradients.  Defaults to "Momentum".
+      use_nesterov: If `True` use Nesterov Momentum.
+      use_row_locking: If `True`, sparse updates are split across threads by
+        row and each row is updated under its own lock, rather than under
+        `use_locking`.  Useful for large embedding variables updated by
+        many concurrent steps.
     """
     super(MomentumOptimizer, self).__init__(use_locking, name)
     self._learning_rate = learning_rate
     self._momentum = momentum
     self._use_nesterov = use_nesterov
+    self._use_row_locking = use_row_locking
 
   def _create_slots(self, var_list):
     for v in var_list:
@@ -74,4 +81,5 @@ class MomentumOptimizer(optimizer.Optimizer):
         grad.values, grad.indices,
         math_ops.cast(self._momentum_tensor, var.dtype.base_dtype),
         use_locking=self._use_locking,
-        use_nesterov=self._use_nesterov).op
+        use_nesterov=self._use_nesterov,
+        use_row_locking=self._use_row_locking).op
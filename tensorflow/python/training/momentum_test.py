@@ -257,7 +257,7 @@ class MomentumOptimizerTest(tf.test.TestCase):
         mom_update.run(feed_dict={grads0: db_grad[i]})
         self.assertAllClose(np.array(db_out[i]), var0.eval())
 
-  def testSparse(self):
+  def doTestSparse(self, use_row_locking=False):
     for dtype in [tf.half, tf.float32, tf.float64]:
       with self.test_session():
         var0 = tf.Variable(tf.zeros([4, 2], dtype=dtype))
@@ -269,7 +269,8 @@ class MomentumOptimizerTest(tf.test.TestCase):
                                               dtype=dtype),
                                   tf.constant([2, 3]),
                                   tf.constant([4, 2]))
-        mom_opt = tf.train.MomentumOptimizer(learning_rate=2.0, momentum=0.9)
+        mom_opt = tf.train.MomentumOptimizer(
+            learning_rate=2.0, momentum=0.9, use_row_locking=use_row_locking)
         mom_update = mom_opt.apply_gradients(
             zip([grads0, grads1], [var0, var1]))
         tf.initialize_all_variables().run()
@@ -325,6 +326,12 @@ class MomentumOptimizerTest(tf.test.TestCase):
                       0.98 - ((0.9 * 0.01 + 0.01) * 2.0)]),
             var1.eval()[2])
 
+  def testSparse(self):
+    self.doTestSparse(use_row_locking=False)
+
+  def testSparseRowLocked(self):
+    self.doTestSparse(use_row_locking=True)
+
   def testSharing(self):
     for dtype in [tf.half, tf.float32, tf.float64]:
       with self.test_session():
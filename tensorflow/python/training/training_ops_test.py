@@ -134,7 +134,8 @@ class TrainingOpsTest(TensorFlowTestCase):
       grad = np.arange(100).astype(dtype)
       self._testTypesForFtrl(x, y, z, lr, grad, use_gpu=False, l1=l1, l2=l2)
 
-  def _testTypesForSparseAdagrad(self, x, y, lr, grad, indices):
+  def _testTypesForSparseAdagrad(self, x, y, lr, grad, indices,
+                                 use_row_locking=False):
     self.setUp()
     with self.test_session(use_gpu=False):
       var = variables.Variable(x)
@@ -144,7 +145,8 @@ class TrainingOpsTest(TensorFlowTestCase):
       self.assertAllCloseAccordingToType(x, var.eval())
       sparse_apply_adagrad = training_ops.sparse_apply_adagrad(
           var, accum, lr, grad,
-          constant_op.constant(indices, self._toType(indices.dtype)))
+          constant_op.constant(indices, self._toType(indices.dtype)),
+          use_row_locking=use_row_locking)
       out = sparse_apply_adagrad.eval()
       self.assertShapeEqual(out, sparse_apply_adagrad)
 
@@ -156,7 +158,7 @@ class TrainingOpsTest(TensorFlowTestCase):
                                            accum.eval()[index])
 
   def _testTypesForSparseFtrl(self, x, y, z, lr, grad, indices, l1=0.0, l2=0.0,
-                              lr_power=-0.5):
+                              lr_power=-0.5, use_row_locking=False):
     self.setUp()
     with self.test_session(use_gpu=False):
       var = variables.Variable(x)
@@ -168,7 +170,7 @@ class TrainingOpsTest(TensorFlowTestCase):
       sparse_apply_ftrl = training_ops.sparse_apply_ftrl(
           var, accum, linear, grad,
           constant_op.constant(indices, self._toType(indices.dtype)),
-          lr, l1, l2, lr_power=lr_power)
+          lr, l1, l2, lr_power=lr_power, use_row_locking=use_row_locking)
       out = sparse_apply_ftrl.eval()
       self.assertShapeEqual(out, sparse_apply_ftrl)
 
@@ -221,6 +223,40 @@ class TrainingOpsTest(TensorFlowTestCase):
       indices = np.array([0, 2]).astype(index_type)
       self._testTypesForSparseFtrl(x, y, z, lr, grad, indices)
 
+  def testSparseApplyAdagradRowLocking(self):
+    for (dtype, index_type) in itertools.product(
+        [np.float32, np.float64], [np.int32, np.int64]):
+      x = np.arange(4000).reshape(1000, 4).astype(dtype)
+      y = np.arange(1, 4001).reshape(1000, 4).astype(dtype)
+      lr = np.array(2.0).astype(dtype)
+      indices = np.arange(0, 1000, 3).astype(index_type)
+      grad = np.arange(4 * len(indices)).reshape(-1, 4).astype(dtype)
+      self._testTypesForSparseAdagrad(x, y, lr, grad, indices,
+                                      use_row_locking=True)
+
+  def testSparseApplyAdagradDim1RowLocking(self):
+    for (dtype, index_type) in itertools.product(
+        [np.float32, np.float64], [np.int32, np.int64]):
+      x = np.arange(1000).reshape(1000, 1).astype(dtype)
+      y = np.arange(1, 1001).reshape(1000, 1).astype(dtype)
+      lr = np.array(2.0).astype(dtype)
+      indices = np.arange(0, 1000, 7).astype(index_type)
+      grad = np.arange(len(indices)).reshape(-1, 1).astype(dtype)
+      self._testTypesForSparseAdagrad(x, y, lr, grad, indices,
+                                      use_row_locking=True)
+
+  def testSparseApplyFtrlDim1RowLocking(self):
+    for (dtype, index_type) in itertools.product(
+        [np.float32, np.float64], [np.int32, np.int64]):
+      x = np.zeros((1000, 1)).astype(dtype)
+      y = np.arange(4, 1004).reshape(1000, 1).astype(dtype)
+      z = np.zeros((1000, 1)).astype(dtype)
+      lr = np.array(2.0).astype(dtype)
+      indices = np.arange(0, 1000, 7).astype(index_type)
+      grad = (np.arange(len(indices)) + 1.5).reshape(-1, 1).astype(dtype)
+      self._testTypesForSparseFtrl(x, y, z, lr, grad, indices,
+                                   use_row_locking=True)
+
   def testApplyAdam(self):
     for dtype, use_gpu in itertools.product(
         [np.float16, np.float32, np.float64], [False, True]):
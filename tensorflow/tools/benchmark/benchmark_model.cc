@@ -20,6 +20,9 @@ limitations under the License.
 
 #include "tensorflow/tools/benchmark/benchmark_model.h"
 
+#include <sys/resource.h>
+
+#include <atomic>
 #include <cstdlib>
 #include <memory>
 #include <string>
@@ -31,8 +34,12 @@ limitations under the License.
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/init_main.h"
 #include "tensorflow/core/platform/logging.h"
@@ -45,6 +52,53 @@ limitations under the License.
 namespace tensorflow {
 namespace benchmark_model {
 
+namespace {
+
+Tensor CreateInputTensor(DataType input_data_type,
+                         const TensorShape& input_shape) {
+  Tensor input_tensor(input_data_type, input_shape);
+
+  switch (input_data_type) {
+    case DT_INT32: {
+      auto int_tensor = input_tensor.flat<int32>();
+      int_tensor = int_tensor.constant(0.0);
+      break;
+    }
+    case DT_FLOAT: {
+      auto float_tensor = input_tensor.flat<float>();
+      float_tensor = float_tensor.constant(0.0);
+      break;
+    }
+    case DT_QUINT8: {
+      auto int_tensor = input_tensor.flat<quint8>();
+      int_tensor = int_tensor.constant(0.0);
+      break;
+    }
+    default:
+      LOG(FATAL) << "Unsupported input type: " << input_data_type;
+  }
+  return input_tensor;
+}
+
+// Returns the user plus system CPU time used so far by this process.
+int64 ProcessCpuMicros() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL +
+         usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+void SleepUntil(Env* env, int64 deadline_us) {
+  const int64 now_us = env->NowMicros();
+  if (deadline_us > now_us) {
+    env->SleepForMicroseconds(deadline_us - now_us);
+  }
+}
+
+}  // namespace
+
 Status InitializeSession(int num_threads, const string& graph,
                          std::unique_ptr<Session>* session,
                          std::unique_ptr<StatSummarizer>* stats) {
@@ -80,28 +134,9 @@ Status InitializeSession(int num_threads, const string& graph,
 
 Status RunBenchmark(DataType input_data_type, TensorShape input_shape,
                     const string& input_layer, const string output_layer,
-                    Session* session, StatSummarizer* stats) {
-  Tensor input_tensor(input_data_type, input_shape);
-
-  switch (input_data_type) {
-    case DT_INT32: {
-      auto int_tensor = input_tensor.flat<int32>();
-      int_tensor = int_tensor.constant(0.0);
-      break;
-    }
-    case DT_FLOAT: {
-      auto float_tensor = input_tensor.flat<float>();
-      float_tensor = float_tensor.constant(0.0);
-      break;
-    }
-    case DT_QUINT8: {
-      auto int_tensor = input_tensor.flat<quint8>();
-      int_tensor = int_tensor.constant(0.0);
-      break;
-    }
-    default:
-      LOG(FATAL) << "Unsupported input type: " << input_data_type;
-  }
+                    Session* session, StatSummarizer* stats,
+                    bool hardware_counters) {
+  Tensor input_tensor = CreateInputTensor(input_data_type, input_shape);
 
   std::vector<std::pair<string, tensorflow::Tensor> > input_tensors(
       {{input_layer, input_tensor}});
@@ -113,6 +148,7 @@ Status RunBenchmark(DataType input_data_type, TensorShape input_shape,
 
   RunOptions run_options;
   run_options.set_trace_level(RunOptions::FULL_TRACE);
+  run_options.set_collect_hardware_counters(hardware_counters);
   RunMetadata run_metadata;
 
   s = session->Run(run_options, input_tensors, output_names, {},
@@ -134,7 +170,8 @@ Status RunBenchmark(DataType input_data_type, TensorShape input_shape,
 Status TimeMultipleRuns(double sleep_seconds, int num_runs,
                         DataType input_data_type, TensorShape input_shape,
                         const string& input_layer, const string output_layer,
-                        Session* session, StatSummarizer* stats) {
+                        Session* session, StatSummarizer* stats,
+                        bool hardware_counters) {
   // Convert the run_delay string into a timespec.
   timespec req;
   req.tv_sec = static_cast<time_t>(sleep_seconds);
@@ -143,7 +180,8 @@ Status TimeMultipleRuns(double sleep_seconds, int num_runs,
   LOG(INFO) << "Running benchmark";
   for (int i = 0; i < num_runs; ++i) {
     Status run_status = RunBenchmark(input_data_type, input_shape, input_layer,
-                                     output_layer, session, stats);
+                                     output_layer, session, stats,
+                                     hardware_counters);
     if (!run_status.ok()) {
       LOG(INFO) << "Failed on run " << i;
       return run_status;
@@ -160,6 +198,122 @@ Status TimeMultipleRuns(double sleep_seconds, int num_runs,
   return Status::OK();
 }
 
+string LoadTestResult::ToJson() const {
+  return strings::Printf(
+      "{\"num_requests\": %lld, \"num_errors\": %lld, "
+      "\"wall_seconds\": %.6f, \"throughput_qps\": %.3f, "
+      "\"cpu_utilization\": %.4f, \"latency_us\": {\"mean\": %.1f, "
+      "\"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"p99_9\": %.1f}}",
+      static_cast<long long>(num_requests), static_cast<long long>(num_errors),
+      wall_seconds, throughput_qps, cpu_utilization, latency_us.Average(),
+      latency_us.Percentile(50.0), latency_us.Percentile(90.0),
+      latency_us.Percentile(99.0), latency_us.Percentile(99.9));
+}
+
+Status RunLoadTest(const LoadTestOptions& options, DataType input_data_type,
+                   TensorShape input_shape, const string& input_layer,
+                   const string& output_layer, Session* session,
+                   LoadTestResult* result) {
+  if (options.num_clients < 1) {
+    return errors::InvalidArgument("num_clients must be positive, got ",
+                                   options.num_clients);
+  }
+  if (options.duration_seconds <= 0.0) {
+    return errors::InvalidArgument("duration_seconds must be positive, got ",
+                                   options.duration_seconds);
+  }
+
+  const std::vector<std::pair<string, Tensor> > input_tensors(
+      {{input_layer, CreateInputTensor(input_data_type, input_shape)}});
+  const std::vector<string> output_names({output_layer});
+
+  Env* env = Env::Default();
+  const int64 start_us = env->NowMicros();
+  const int64 measure_start_us =
+      start_us + static_cast<int64>(options.warmup_seconds * 1e6);
+  const int64 end_us =
+      measure_start_us + static_cast<int64>(options.duration_seconds * 1e6);
+  const double interval_us =
+      options.target_qps > 0.0 ? 1e6 / options.target_qps : 0.0;
+
+  // Each client keeps its own latencies; they are merged once all are done.
+  struct ClientStats {
+    std::vector<double> latencies_us;
+    int64 num_errors = 0;
+    Status first_error;
+  };
+  std::vector<ClientStats> clients(options.num_clients);
+  std::atomic<int64> next_request(0);
+
+  LOG(INFO) << "Running load test with " << options.num_clients
+            << " clients";
+  int64 cpu_start_us;
+  int64 cpu_end_us;
+  int64 wall_start_us;
+  int64 wall_end_us;
+  {
+    thread::ThreadPool pool(env, "benchmark_client", options.num_clients);
+    for (int c = 0; c < options.num_clients; ++c) {
+      ClientStats* stats = &clients[c];
+      pool.Schedule([&, stats]() {
+        std::vector<Tensor> output_tensors;
+        while (true) {
+          int64 scheduled_us;
+          if (interval_us > 0.0) {
+            const int64 i = next_request.fetch_add(1);
+            scheduled_us = start_us + static_cast<int64>(i * interval_us);
+            if (scheduled_us >= end_us) break;
+            SleepUntil(env, scheduled_us);
+          } else {
+            scheduled_us = env->NowMicros();
+            if (scheduled_us >= end_us) break;
+          }
+          output_tensors.clear();
+          Status s =
+              session->Run(input_tensors, output_names, {}, &output_tensors);
+          const int64 done_us = env->NowMicros();
+          if (scheduled_us < measure_start_us) continue;
+          if (!s.ok()) {
+            if (stats->num_errors++ == 0) stats->first_error = s;
+            continue;
+          }
+          stats->latencies_us.push_back(done_us - scheduled_us);
+        }
+      });
+    }
+
+    SleepUntil(env, measure_start_us);
+    wall_start_us = env->NowMicros();
+    cpu_start_us = ProcessCpuMicros();
+    SleepUntil(env, end_us);
+    wall_end_us = env->NowMicros();
+    cpu_end_us = ProcessCpuMicros();
+  }  // Waits for the clients to finish their last requests.
+
+  result->num_requests = 0;
+  result->num_errors = 0;
+  result->latency_us.Clear();
+  for (const ClientStats& stats : clients) {
+    for (double latency : stats.latencies_us) {
+      result->latency_us.Add(latency);
+    }
+    result->num_requests += stats.latencies_us.size();
+    if (stats.num_errors > 0 && result->num_errors == 0) {
+      LOG(ERROR) << "Error during inference: " << stats.first_error;
+    }
+    result->num_errors += stats.num_errors;
+  }
+  result->wall_seconds = (wall_end_us - wall_start_us) / 1e6;
+  if (result->wall_seconds > 0.0) {
+    result->throughput_qps = result->num_requests / result->wall_seconds;
+    result->cpu_utilization =
+        (cpu_end_us - cpu_start_us) /
+        ((wall_end_us - wall_start_us) *
+         static_cast<double>(port::NumSchedulableCPUs()));
+  }
+  return Status::OK();
+}
+
 int Main(int argc, char** argv) {
   string graph = "/data/local/tmp/tensorflow_inception_graph.pb";
   string input_layer = "input:0";
@@ -172,21 +326,34 @@ int Main(int argc, char** argv) {
   string benchmark_name = "";
   string output_prefix = "";
   bool show_sizes = false;
+  int num_clients = 0;
+  string target_qps = "0";
+  string warmup_seconds = "2.0";
+  string load_duration_seconds = "10.0";
+  string json_output = "";
+  bool hardware_counters = false;
 
   const bool parse_result = ParseFlags(
-      &argc, argv, {
-                       Flag("graph", &graph),                          //
-                       Flag("input_layer", &input_layer),              //
-                       Flag("input_layer_shape", &input_layer_shape),  //
-                       Flag("input_layer_type", &input_layer_type),    //
-                       Flag("output_layer", &output_layer),            //
-                       Flag("num_runs", &num_runs),                    //
-                       Flag("run_delay", &run_delay),                  //
-                       Flag("num_threads", &num_threads),              //
-                       Flag("benchmark_name", &benchmark_name),        //
-                       Flag("output_prefix", &output_prefix),          //
-                       Flag("show_sizes", &show_sizes),                //
-                   });
+      &argc, argv,
+      {
+          Flag("graph", &graph),                                  //
+          Flag("input_layer", &input_layer),                      //
+          Flag("input_layer_shape", &input_layer_shape),          //
+          Flag("input_layer_type", &input_layer_type),            //
+          Flag("output_layer", &output_layer),                    //
+          Flag("num_runs", &num_runs),                            //
+          Flag("run_delay", &run_delay),                          //
+          Flag("num_threads", &num_threads),                      //
+          Flag("benchmark_name", &benchmark_name),                //
+          Flag("output_prefix", &output_prefix),                  //
+          Flag("show_sizes", &show_sizes),                        //
+          Flag("num_clients", &num_clients),                      //
+          Flag("target_qps", &target_qps),                        //
+          Flag("warmup_seconds", &warmup_seconds),                //
+          Flag("load_duration_seconds", &load_duration_seconds),  //
+          Flag("json_output", &json_output),                      //
+          Flag("hardware_counters", &hardware_counters),          //
+      });
 
   if (!parse_result) {
     LOG(ERROR) << "Error parsing command-line flags.";
@@ -210,6 +377,12 @@ int Main(int argc, char** argv) {
   LOG(INFO) << "Benchmark name: [" << benchmark_name << "]";
   LOG(INFO) << "Output prefix: [" << output_prefix << "]";
   LOG(INFO) << "Show sizes: [" << show_sizes << "]";
+  LOG(INFO) << "Num clients: [" << num_clients << "]";
+  LOG(INFO) << "Target QPS: [" << target_qps << "]";
+  LOG(INFO) << "Warmup (seconds): [" << warmup_seconds << "]";
+  LOG(INFO) << "Load duration (seconds): [" << load_duration_seconds << "]";
+  LOG(INFO) << "JSON output: [" << json_output << "]";
+  LOG(INFO) << "Hardware counters: [" << hardware_counters << "]";
 
   std::unique_ptr<Session> session;
   std::unique_ptr<StatSummarizer> stats;
@@ -231,10 +404,48 @@ int Main(int argc, char** argv) {
     input_shape.AddDim(sizes[i]);
   }
 
+  if (num_clients > 0) {
+    LoadTestOptions load_options;
+    load_options.num_clients = num_clients;
+    load_options.target_qps = std::strtod(target_qps.c_str(), nullptr);
+    load_options.warmup_seconds = std::strtod(warmup_seconds.c_str(), nullptr);
+    load_options.duration_seconds =
+        std::strtod(load_duration_seconds.c_str(), nullptr);
+    LoadTestResult result;
+    Status load_status =
+        RunLoadTest(load_options, input_data_type, input_shape, input_layer,
+                    output_layer, session.get(), &result);
+    if (!load_status.ok()) {
+      LOG(ERROR) << "Load test failed with " << load_status;
+      return -1;
+    }
+    LOG(INFO) << "Requests: " << result.num_requests
+              << ", errors: " << result.num_errors
+              << ", throughput: " << result.throughput_qps << " qps"
+              << ", CPU utilization: " << result.cpu_utilization;
+    LOG(INFO) << "Latency percentiles (us): p50 "
+              << result.latency_us.Percentile(50.0) << ", p90 "
+              << result.latency_us.Percentile(90.0) << ", p99 "
+              << result.latency_us.Percentile(99.0) << ", p99.9 "
+              << result.latency_us.Percentile(99.9);
+    LOG(INFO) << "Latency histogram (us):\n" << result.latency_us.ToString();
+    if (!json_output.empty()) {
+      Status write_status =
+          WriteStringToFile(Env::Default(), json_output, result.ToJson());
+      if (!write_status.ok()) {
+        LOG(ERROR) << "Could not write " << json_output << ": "
+                   << write_status;
+        return -1;
+      }
+    }
+    return result.num_errors > 0 ? -1 : 0;
+  }
+
   const int64 start_time = Env::Default()->NowMicros();
   Status time_status =
       TimeMultipleRuns(sleep_seconds, num_runs, input_data_type, input_shape,
-                       input_layer, output_layer, session.get(), stats.get());
+                       input_layer, output_layer, session.get(), stats.get(),
+                       hardware_counters);
   const int64 end_time = Env::Default()->NowMicros();
   const double wall_time = (end_time - start_time) / 1000000.0;
 
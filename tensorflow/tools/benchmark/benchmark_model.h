@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_TOOLS_BENCHMARK_BENCHMARK_MODEL_H_
 #define TENSORFLOW_TOOLS_BENCHMARK_BENCHMARK_MODEL_H_
 
+#include "tensorflow/core/lib/histogram/histogram.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/util/stat_summarizer.h"
 
@@ -30,13 +31,54 @@ Status InitializeSession(int num_threads, const string& graph,
 // Does a single run of the model that's been loaded into the given session.
 Status RunBenchmark(DataType input_data_type, TensorShape input_shape,
                     const string& input_layer, const string output_layer,
-                    Session* session, StatSummarizer* stats);
+                    Session* session, StatSummarizer* stats,
+                    bool hardware_counters = false);
 
 // Runs the model multiple time, keeping track of timing information.
+// If 'hardware_counters' is true, also collects the hardware performance
+// counters of each node.
 Status TimeMultipleRuns(double sleep_seconds, int num_runs,
                         DataType input_data_type, TensorShape input_shape,
                         const string& input_layer, const string output_layer,
-                        Session* session, StatSummarizer* stats);
+                        Session* session, StatSummarizer* stats,
+                        bool hardware_counters = false);
+
+// Describes a serving-style load test.  'num_clients' threads issue requests
+// for 'warmup_seconds' plus 'duration_seconds'; only the requests started
+// after the warmup are measured.
+//
+// If 'target_qps' is 0 the load is closed-loop: each client issues its next
+// request as soon as the previous one returns.  Otherwise requests are
+// scheduled at a fixed rate regardless of how fast earlier ones complete
+// (open-loop), and latency is measured from the scheduled start time, so
+// that queueing behind slow requests shows up in the percentiles.
+struct LoadTestOptions {
+  int num_clients = 1;
+  double target_qps = 0.0;
+  double warmup_seconds = 0.0;
+  double duration_seconds = 10.0;
+};
+
+// Results of RunLoadTest().
+struct LoadTestResult {
+  int64 num_requests = 0;  // Measured requests, excluding the warmup.
+  int64 num_errors = 0;
+  double wall_seconds = 0.0;
+  double throughput_qps = 0.0;
+  // Process CPU time over the measured period divided by the wall time and
+  // the number of schedulable CPUs, in [0, 1].
+  double cpu_utilization = 0.0;
+  histogram::Histogram latency_us;
+
+  // Returns the results as a JSON object, for regression tracking.
+  string ToJson() const;
+};
+
+// Drives the model in 'session' with the load described by 'options'.
+Status RunLoadTest(const LoadTestOptions& options, DataType input_data_type,
+                   TensorShape input_shape, const string& input_layer,
+                   const string& output_layer, Session* session,
+                   LoadTestResult* result);
 
 // Handles all setup and argument parsing.
 int Main(int argc, char** argv);
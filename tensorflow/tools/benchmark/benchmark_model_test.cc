@@ -26,15 +26,12 @@ limitations under the License.
 namespace tensorflow {
 namespace {
 
-TEST(BenchmarkModelTest, InitializeAndRun) {
-  const string dir = testing::TmpDir();
-  const string filename_pb = io::JoinPath(dir, "graphdef.pb");
-
-  // Create a simple graph and write it to filename_pb.
-  const int input_width = 400;
-  const int input_height = 10;
-  const TensorShape input_shape({input_width, input_height});
-  const TensorShape constant_shape({input_height, input_width});
+// Creates a simple graph, writes it to filename_pb and returns the names of
+// its input and output nodes.
+void CreateTestGraph(const string& filename_pb, const TensorShape& input_shape,
+                     string* input_name, string* output_name) {
+  const TensorShape constant_shape({input_shape.dim_size(1),
+                                    input_shape.dim_size(0)});
 
   Tensor constant_tensor(DT_FLOAT, constant_shape);
   test::FillFn<float>(&constant_tensor, [](int) -> float { return 3.0; });
@@ -42,9 +39,9 @@ TEST(BenchmarkModelTest, InitializeAndRun) {
   auto root = Scope::NewRootScope().ExitOnError();
   auto placeholder =
       ops::Placeholder(root, DT_FLOAT, ops::Placeholder::Shape(input_shape));
-  const string input_name = placeholder.node()->name();
+  *input_name = placeholder.node()->name();
   auto m = ops::MatMul(root, placeholder, constant_tensor);
-  const string output_name = m.node()->name();
+  *output_name = m.node()->name();
 
   GraphDef graph_def;
   TF_ASSERT_OK(root.ToGraphDef(&graph_def));
@@ -52,6 +49,15 @@ TEST(BenchmarkModelTest, InitializeAndRun) {
   graph_def.SerializeToString(&graph_def_serialized);
   TF_ASSERT_OK(
       WriteStringToFile(Env::Default(), filename_pb, graph_def_serialized));
+}
+
+TEST(BenchmarkModelTest, InitializeAndRun) {
+  const string dir = testing::TmpDir();
+  const string filename_pb = io::JoinPath(dir, "graphdef.pb");
+  const TensorShape input_shape({400, 10});
+  string input_name;
+  string output_name;
+  CreateTestGraph(filename_pb, input_shape, &input_name, &output_name);
 
   std::unique_ptr<Session> session;
   std::unique_ptr<StatSummarizer> stats;
@@ -63,5 +69,51 @@ TEST(BenchmarkModelTest, InitializeAndRun) {
                                                  session.get(), stats.get()));
 }
 
+TEST(BenchmarkModelTest, LoadTest) {
+  const string dir = testing::TmpDir();
+  const string filename_pb = io::JoinPath(dir, "load_graphdef.pb");
+  const TensorShape input_shape({400, 10});
+  string input_name;
+  string output_name;
+  CreateTestGraph(filename_pb, input_shape, &input_name, &output_name);
+
+  std::unique_ptr<Session> session;
+  std::unique_ptr<StatSummarizer> stats;
+  TF_ASSERT_OK(
+      benchmark_model::InitializeSession(1, filename_pb, &session, &stats));
+
+  // Closed-loop.
+  benchmark_model::LoadTestOptions options;
+  options.num_clients = 2;
+  options.warmup_seconds = 0.1;
+  options.duration_seconds = 0.5;
+  benchmark_model::LoadTestResult result;
+  TF_ASSERT_OK(benchmark_model::RunLoadTest(options, DT_FLOAT, input_shape,
+                                            input_name, output_name,
+                                            session.get(), &result));
+  EXPECT_GT(result.num_requests, 0);
+  EXPECT_EQ(0, result.num_errors);
+  EXPECT_GT(result.throughput_qps, 0.0);
+  EXPECT_GT(result.latency_us.Percentile(99.0), 0.0);
+  EXPECT_NE(string::npos, result.ToJson().find("\"p99_9\""));
+
+  // Open-loop.  Request i is scheduled at i / target_qps seconds after the
+  // start and is issued however late its client gets to it, so however
+  // loaded the machine is, exactly the requests scheduled in [0.1s, 0.6s)
+  // are measured: requests 2 to 11.
+  options.target_qps = 20.0;
+  TF_ASSERT_OK(benchmark_model::RunLoadTest(options, DT_FLOAT, input_shape,
+                                            input_name, output_name,
+                                            session.get(), &result));
+  EXPECT_EQ(10, result.num_requests);
+  EXPECT_EQ(0, result.num_errors);
+
+  options.num_clients = 0;
+  EXPECT_FALSE(benchmark_model::RunLoadTest(options, DT_FLOAT, input_shape,
+                                            input_name, output_name,
+                                            session.get(), &result)
+                   .ok());
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,83 @@
+# Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+"""Compares the output of a logged benchmark against a baseline.
+
+Both --results and --baseline are TestResults protos as written by
+run_and_gather_logs (e.g. bazel run //tensorflow/tools/test:kernel_benchmarks
+-- --test_log_output=/tmp/results.pbtxt).  Exits with status 1 if any
+benchmark is slower than its baseline by more than --tolerance.
+
+With --update_baseline, copies the results to --baseline instead.  Baselines
+are only meaningful on the machine they were recorded on.
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import tensorflow as tf
+
+from google.protobuf import text_format
+from tensorflow.tools.test import compare_benchmarks_lib
+
+
+FLAGS = tf.app.flags.FLAGS
+
+tf.app.flags.DEFINE_string("results", "", """TestResults to check.""")
+tf.app.flags.DEFINE_string("baseline", "", """Baseline TestResults.""")
+tf.app.flags.DEFINE_float(
+    "tolerance", 0.1, """Relative slowdown allowed before failing.""")
+tf.app.flags.DEFINE_bool(
+    "update_baseline", False, """Write the results to --baseline.""")
+
+
+def main(unused_args):
+  if not FLAGS.results or not FLAGS.baseline:
+    tf.logging.error("--results and --baseline are required.")
+    return 2
+  results = compare_benchmarks_lib.load_test_results(FLAGS.results)
+
+  if FLAGS.update_baseline:
+    tf.gfile.GFile(FLAGS.baseline, "w").write(
+        text_format.MessageToString(results))
+    tf.logging.info("Baseline written to: %s" % FLAGS.baseline)
+    return 0
+
+  baseline = compare_benchmarks_lib.load_test_results(FLAGS.baseline)
+  if (baseline.machine_configuration.hostname and
+      baseline.machine_configuration.hostname !=
+      results.machine_configuration.hostname):
+    tf.logging.warning("Baseline was recorded on %s, results on %s." %
+                       (baseline.machine_configuration.hostname,
+                        results.machine_configuration.hostname))
+
+  comparisons = compare_benchmarks_lib.compare(
+      compare_benchmarks_lib.time_per_iteration(results),
+      compare_benchmarks_lib.time_per_iteration(baseline),
+      FLAGS.tolerance)
+  print(compare_benchmarks_lib.format_report(comparisons))
+  regressed = [c.name for c in comparisons
+               if c.outcome == compare_benchmarks_lib.REGRESSED]
+  if regressed:
+    tf.logging.error("%d benchmarks regressed by more than %.0f%%: %s" %
+                     (len(regressed), FLAGS.tolerance * 100,
+                      ", ".join(regressed)))
+    return 1
+  return 0
+
+
+if __name__ == "__main__":
+  tf.app.run()
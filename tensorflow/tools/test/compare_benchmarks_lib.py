@@ -0,0 +1,107 @@
+# Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+"""Library for comparing benchmark results against a baseline."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import collections
+
+import tensorflow as tf
+
+from google.protobuf import text_format
+from tensorflow.core.util import test_log_pb2
+
+
+# Outcomes of comparing one benchmark against the baseline.
+OK = "ok"
+REGRESSED = "REGRESSED"
+IMPROVED = "improved"
+NEW = "new"
+MISSING = "missing"
+
+Comparison = collections.namedtuple(
+    "Comparison", ["name", "baseline_ns", "ns", "ratio", "outcome"])
+
+
+def load_test_results(path):
+  """Reads a TestResults proto, in text or binary format, from path."""
+  content = tf.gfile.GFile(path, "rb").read()
+  results = test_log_pb2.TestResults()
+  try:
+    text_format.Merge(content.decode("utf-8"), results)
+  except (text_format.ParseError, UnicodeDecodeError):
+    results.Clear()
+    results.ParseFromString(content)
+  return results
+
+
+def time_per_iteration(test_results):
+  """Returns a dict from benchmark name to wall time per iteration, in ns."""
+  times = {}
+  for entry in test_results.entries.entry:
+    if entry.iters > 0:
+      times[entry.name] = entry.wall_time * 1e9 / entry.iters
+  return times
+
+
+def compare(results_ns, baseline_ns, tolerance):
+  """Compares benchmark times against baseline times.
+
+  Args:
+    results_ns: Dict from benchmark name to time per iteration.
+    baseline_ns: Dict from benchmark name to baseline time per iteration.
+    tolerance: Relative slowdown (e.g. 0.1 for 10%) above which a benchmark
+      counts as regressed.  The same speedup counts as an improvement.
+
+  Returns:
+    A list of Comparison tuples, sorted by name.
+  """
+  comparisons = []
+  for name in sorted(set(results_ns) | set(baseline_ns)):
+    ns = results_ns.get(name)
+    base = baseline_ns.get(name)
+    if base is None:
+      comparisons.append(Comparison(name, None, ns, None, NEW))
+      continue
+    if ns is None:
+      comparisons.append(Comparison(name, base, None, None, MISSING))
+      continue
+    ratio = ns / base if base > 0 else float("inf")
+    if ratio > 1.0 + tolerance:
+      outcome = REGRESSED
+    elif ratio < 1.0 / (1.0 + tolerance):
+      outcome = IMPROVED
+    else:
+      outcome = OK
+    comparisons.append(Comparison(name, base, ns, ratio, outcome))
+  return comparisons
+
+
+def format_report(comparisons):
+  """Returns a human-readable table of comparisons."""
+  width = max([len(c.name) for c in comparisons] + [len("Benchmark")])
+  lines = ["%-*s %14s %14s %8s  %s" % (width, "Benchmark", "Baseline(ns)",
+                                       "Time(ns)", "Ratio", "Outcome")]
+  for c in comparisons:
+    lines.append("%-*s %14s %14s %8s  %s" % (
+        width, c.name,
+        "-" if c.baseline_ns is None else "%.0f" % c.baseline_ns,
+        "-" if c.ns is None else "%.0f" % c.ns,
+        "-" if c.ratio is None else "%.3f" % c.ratio,
+        c.outcome))
+  return "\n".join(lines)
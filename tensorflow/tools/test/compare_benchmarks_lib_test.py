@@ -0,0 +1,79 @@
+# Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+"""Tests for compare_benchmarks_lib."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+import tensorflow as tf
+
+from google.protobuf import text_format
+from tensorflow.core.util import test_log_pb2
+from tensorflow.tools.test import compare_benchmarks_lib as lib
+
+
+class CompareBenchmarksLibTest(tf.test.TestCase):
+
+  def testTimePerIteration(self):
+    results = test_log_pb2.TestResults()
+    entry = results.entries.entry.add()
+    entry.name = "BM_A"
+    entry.iters = 100
+    entry.wall_time = 0.5
+    entry = results.entries.entry.add()
+    entry.name = "BM_NoIters"
+    self.assertEqual({"BM_A": 5e6}, lib.time_per_iteration(results))
+
+  def testCompare(self):
+    baseline = {"BM_Same": 100.0, "BM_Slow": 100.0, "BM_Fast": 100.0,
+                "BM_Gone": 100.0}
+    results = {"BM_Same": 105.0, "BM_Slow": 120.0, "BM_Fast": 80.0,
+               "BM_New": 10.0}
+    outcomes = {c.name: c.outcome
+                for c in lib.compare(results, baseline, 0.1)}
+    self.assertEqual({"BM_Same": lib.OK,
+                      "BM_Slow": lib.REGRESSED,
+                      "BM_Fast": lib.IMPROVED,
+                      "BM_Gone": lib.MISSING,
+                      "BM_New": lib.NEW}, outcomes)
+    report = lib.format_report(lib.compare(results, baseline, 0.1))
+    self.assertIn("BM_Slow", report)
+    self.assertIn("1.200", report)
+
+  def testLoadTextAndBinary(self):
+    results = test_log_pb2.TestResults()
+    results.name = "test"
+    entry = results.entries.entry.add()
+    entry.name = "BM_A"
+    entry.iters = 10
+    entry.wall_time = 1.0
+
+    text_path = os.path.join(self.get_temp_dir(), "results.pbtxt")
+    with open(text_path, "w") as f:
+      f.write(text_format.MessageToString(results))
+    self.assertEqual(results, lib.load_test_results(text_path))
+
+    binary_path = os.path.join(self.get_temp_dir(), "results.pb")
+    with open(binary_path, "wb") as f:
+      f.write(results.SerializeToString())
+    self.assertEqual(results, lib.load_test_results(binary_path))
+
+
+if __name__ == "__main__":
+  tf.test.main()
@@ -29,7 +29,8 @@ def tf_cc_logged_benchmark(
       srcs = ["//tensorflow/tools/test:run_and_gather_logs.py"],
       args = [
           "--name=//%s:%s" % (PACKAGE_NAME, name),
-          "--test_name=" + target
+          "--test_name=" + target,
+          "--test_args=--benchmarks=%s" % benchmarks
       ],
       data = [
         target,